@@ -31,6 +31,7 @@ from qgis.core import (QgsApplication,
                        QgsRasterFileWriter,
                        QgsProcessing,
                        QgsProcessingException,
+                       QgsProcessingMultiStepFeedback,
                        QgsProcessingParameterFeatureSource,
                        QgsProcessingParameterNumber,
                        QgsProcessingParameterDistance,
@@ -209,6 +210,9 @@ class Heatmap(QgisAlgorithm):
             raise QgsProcessingException(
                 self.tr('Could not create destination layer'))
 
+        # adding the features, then calculating the surface
+        multi_feedback = QgsProcessingMultiStepFeedback(2, feedback)
+
         request = QgsFeatureRequest()
         request.setSubsetOfAttributes(attrs)
         features = source.getFeatures(request)
@@ -220,9 +224,13 @@ class Heatmap(QgisAlgorithm):
             if kde.addFeature(f) != QgsKernelDensityEstimation.Success:
                 feedback.reportError(self.tr('Error adding feature with ID {} to heatmap').format(f.id()))
 
-            feedback.setProgress(int(current * total))
+            multi_feedback.setProgress(int(current * total))
 
-        if kde.finalise() != QgsKernelDensityEstimation.Success:
+        multi_feedback.setCurrentStep(1)
+        result = kde.finalise(multi_feedback)
+        if result == QgsKernelDensityEstimation.Canceled:
+            return {}
+        elif result != QgsKernelDensityEstimation.Success:
             raise QgsProcessingException(
                 self.tr('Could not save destination layer'))
 
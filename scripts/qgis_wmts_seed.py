@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+
+# Seeds the built-in WMTS tile cache of QGIS Server
+#
+# The tiles are rendered with the same settings as the server processes,
+# QGIS_SERVER_WMTS_CACHE_DIRECTORY must point to the cache directory shared
+# with the server and QGIS_SERVER_WMTS_METATILE_SIZE should match the one of
+# the server so that metatiles are rendered only once.
+
+import os
+import sys
+import xml.etree.ElementTree as ET
+from optparse import OptionParser
+from urllib.parse import urlencode
+
+from qgis.core import QgsApplication
+from qgis.server import QgsServer, QgsBufferServerRequest, QgsBufferServerResponse
+
+WMTS_NS = '{http://www.opengis.net/wmts/1.0}'
+OWS_NS = '{http://www.opengis.net/ows/1.1}'
+
+
+def error(msg):
+    print(msg)
+    sys.exit(1)
+
+
+parser = OptionParser("usage: %prog [options] project")
+parser.add_option("-l", "--layer", dest="layers", action="append", default=[], help="Layer to seed, may be repeated (default: all the layers)")
+parser.add_option("-t", "--tilematrixset", dest="tms", type="string", default="EPSG:3857", help="Tile matrix set")
+parser.add_option("-f", "--format", dest="format", type="choice", choices=("image/png", "image/jpeg"), default="image/png", help="Tile format")
+parser.add_option("-z", "--min-level", dest="minLevel", type="int", default=0, help="First tile matrix to seed")
+parser.add_option("-Z", "--max-level", dest="maxLevel", type="int", default=-1, help="Last tile matrix to seed (default: all)")
+
+(options, args) = parser.parse_args()
+if len(args) != 1:
+    error("Project file path missing")
+if not os.environ.get('QGIS_SERVER_WMTS_CACHE_DIRECTORY'):
+    error("QGIS_SERVER_WMTS_CACHE_DIRECTORY is not set, nothing would be cached")
+
+project = os.path.abspath(args[0])
+metatileSize = max(1, int(os.environ.get('QGIS_SERVER_WMTS_METATILE_SIZE', '1')))
+
+app = QgsApplication([], False)
+app.initQgis()
+server = QgsServer()
+
+
+def query(params):
+    params = dict(params, MAP=project, SERVICE='WMTS', VERSION='1.0.0')
+    request = QgsBufferServerRequest('?' + urlencode(params))
+    response = QgsBufferServerResponse()
+    server.handleRequest(request, response)
+    return response
+
+
+capabilities = ET.fromstring(bytes(query({'REQUEST': 'GetCapabilities'}).body()))
+
+count = 0
+for layer in capabilities.iter(WMTS_NS + 'Layer'):
+    name = layer.find(OWS_NS + 'Identifier').text
+    if options.layers and name not in options.layers:
+        continue
+
+    for link in layer.iter(WMTS_NS + 'TileMatrixSetLink'):
+        if link.find(WMTS_NS + 'TileMatrixSet').text != options.tms:
+            continue
+
+        for limits in link.iter(WMTS_NS + 'TileMatrixLimits'):
+            level = int(limits.find(WMTS_NS + 'TileMatrix').text)
+            if level < options.minLevel or (options.maxLevel >= 0 and level > options.maxLevel):
+                continue
+
+            minCol = int(limits.find(WMTS_NS + 'MinTileCol').text)
+            maxCol = int(limits.find(WMTS_NS + 'MaxTileCol').text)
+            minRow = int(limits.find(WMTS_NS + 'MinTileRow').text)
+            maxRow = int(limits.find(WMTS_NS + 'MaxTileRow').text)
+
+            # One request per metatile, the other tiles of the metatile
+            # are stored in the cache by the server
+            firstCol = (minCol // metatileSize) * metatileSize
+            firstRow = (minRow // metatileSize) * metatileSize
+            for row in range(firstRow, maxRow + 1, metatileSize):
+                for col in range(firstCol, maxCol + 1, metatileSize):
+                    response = query({
+                        'REQUEST': 'GetTile',
+                        'LAYER': name,
+                        'STYLE': '',
+                        'TILEMATRIXSET': options.tms,
+                        'TILEMATRIX': level,
+                        'TILEROW': max(row, minRow),
+                        'TILECOL': max(col, minCol),
+                        'FORMAT': options.format
+                    })
+                    if not response.headers().get('Content-Type', '').startswith('image/'):
+                        print("Failed to render tile %s %d/%d/%d" % (name, level, row, col))
+                    count += 1
+
+            print("%s: level %d seeded" % (name, level))
+
+print("%d requests done" % count)
+app.exitQgis()
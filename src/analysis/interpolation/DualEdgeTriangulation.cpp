@@ -1031,6 +1031,75 @@ bool DualEdgeTriangulation::getTriangle( double x, double y, QgsPoint &p1, int &
   }
 }
 
+bool DualEdgeTriangulation::locateTriangle( double x, double y, int &startEdge, int &n1, int &n2, int &n3 ) const
+{
+  if ( mPointVector.size() < 3 )
+  {
+    return false;
+  }
+
+  //same walk as in 'baseEdgeOfTriangle', but keeping the state local
+  const QgsPoint point( x, y, 0 );
+  int actedge = startEdge < 0 ? static_cast< int >( mEdgeInside ) : startEdge;
+  int counter = 0;//number of consecutive successful left-of-tests
+  int nulls = 0;//number of left-of-tests, which returned 0
+  int edgeWithPoint = -1;
+  int runs = 0;
+
+  while ( true )
+  {
+    if ( runs > MAX_BASE_ITERATIONS )//prevents endless loops
+    {
+      return false;
+    }
+
+    double leftofvalue = MathUtils::leftOf( point, mPointVector[mHalfEdge[mHalfEdge[actedge]->getDual()]->getPoint()], mPointVector[mHalfEdge[actedge]->getPoint()] );
+
+    if ( leftofvalue < leftOfTresh )//point is on the left side, on the line of the edge or numerically unstable
+    {
+      if ( leftofvalue == 0 )
+      {
+        edgeWithPoint = actedge;
+        nulls += 1;
+      }
+      counter += 1;
+      if ( counter == 3 )//three successful passes means that we have found the triangle
+      {
+        break;
+      }
+    }
+    else//point is on the right side
+    {
+      actedge = mHalfEdge[actedge]->getDual();
+      counter = 1;
+      nulls = 0;
+    }
+
+    actedge = mHalfEdge[actedge]->getNext();
+    if ( mHalfEdge[actedge]->getPoint() == -1 )//the half edge points to the virtual point
+    {
+      if ( nulls != 1 )//the point is outside the convex hull
+      {
+        return false;
+      }
+      actedge = edgeWithPoint;//point is exactly on the convex hull
+      break;
+    }
+    runs++;
+  }
+
+  n1 = mHalfEdge[actedge]->getPoint();
+  n2 = mHalfEdge[mHalfEdge[actedge]->getNext()]->getPoint();
+  n3 = mHalfEdge[mHalfEdge[mHalfEdge[actedge]->getNext()]->getNext()]->getPoint();
+  if ( n1 == -1 || n2 == -1 || n3 == -1 )
+  {
+    return false;
+  }
+
+  startEdge = actedge;
+  return true;
+}
+
 bool DualEdgeTriangulation::getTriangle( double x, double y, QgsPoint &p1, QgsPoint &p2, QgsPoint &p3 )
 {
   if ( mPointVector.size() < 3 )
@@ -65,6 +65,17 @@ class ANALYSIS_EXPORT DualEdgeTriangulation: public Triangulation
     int getOppositePoint( int p1, int p2 ) override;
     bool getTriangle( double x, double y, QgsPoint &p1 SIP_OUT, int &n1 SIP_OUT, QgsPoint &p2 SIP_OUT, int &n2 SIP_OUT, QgsPoint &p3 SIP_OUT, int &n3 SIP_OUT ) SIP_PYNAME( getTriangleVertices ) override;
     bool getTriangle( double x, double y, QgsPoint &p1 SIP_OUT, QgsPoint &p2 SIP_OUT, QgsPoint &p3 SIP_OUT ) override;
+
+    /**
+     * Finds the numbers of the three points of the triangle containing the point with coordinates \a x and \a y.
+     * Unlike getTriangle(), this method does not modify the triangulation and may be called concurrently
+     * from several threads, as long as no points or lines are added at the same time.
+     * The search starts at the half edge \a startEdge (or at an arbitrary edge inside the triangulation if it
+     * is negative) and \a startEdge is set to an edge of the found triangle, so that passing it back for the
+     * next nearby point keeps the search short.
+     * \returns FALSE if the point is outside the convex hull or the search failed
+     */
+    bool locateTriangle( double x, double y, int &startEdge, int &n1, int &n2, int &n3 ) const;
     QList<int> getSurroundingTriangles( int pointno ) override;
     //! Returns the largest x-coordinate value of the bounding box
     double getXMax() const override { return xMax; }
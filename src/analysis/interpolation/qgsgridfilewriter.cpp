@@ -21,6 +21,52 @@
 #include "qgsfeedback.h"
 #include <QFile>
 #include <QFileInfo>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+///@cond PRIVATE
+
+namespace
+{
+  //! Interpolates the cells of a single row into a buffer, NaN marking cells which could not be interpolated
+  struct InterpolateRow
+  {
+    QgsInterpolator *interpolator = nullptr;
+    QgsFeedback *feedback = nullptr;
+    double *values = nullptr;
+    int firstRow = 0;
+    int nCols = 0;
+    double xMin = 0;
+    double yMax = 0;
+    double cellSizeX = 0;
+    double cellSizeY = 0;
+
+    void operator()( int row ) const
+    {
+      if ( feedback && feedback->isCanceled() )
+        return;
+
+      double *rowValues = values + static_cast< std::size_t >( row - firstRow ) * nCols;
+      const double y = yMax - ( row + 0.5 ) * cellSizeY; //calculate value in the center of the cell
+      double interpolatedValue;
+      for ( int col = 0; col < nCols; ++col )
+      {
+        const double x = xMin + ( col + 0.5 ) * cellSizeX;
+        if ( interpolator->interpolatePoint( x, y, interpolatedValue, feedback ) == 0 )
+          rowValues[col] = interpolatedValue;
+        else
+          rowValues[col] = std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  };
+}
+
+///@endcond
 
 QgsGridFileWriter::QgsGridFileWriter( QgsInterpolator *i, const QString &outputPath, const QgsRectangle &extent, int nCols, int nRows )
   : mInterpolator( i )
@@ -51,36 +97,68 @@ int QgsGridFileWriter::writeFile( QgsFeedback *feedback )
   outStream.setRealNumberPrecision( 8 );
   writeHeader( outStream );
 
-  double currentYValue = mInterpolationExtent.yMaximum() - mCellSizeY / 2.0; //calculate value in the center of the cell
-  double currentXValue;
+  // the interpolators prepare their base data (cached vertices, triangulation, spatial index) on the first call,
+  // so interpolate a first point before the rows are computed in parallel. Interpolators which are not
+  // thread safe, e.g. ones implemented in Python, compute the rows one after the other
+  const bool parallel = mInterpolator->isThreadSafe();
   double interpolatedValue;
+  mInterpolator->interpolatePoint( mInterpolationExtent.xMinimum() + mCellSizeX / 2.0, mInterpolationExtent.yMaximum() - mCellSizeY / 2.0, interpolatedValue, feedback );
 
-  for ( int i = 0; i < mNumRows; ++i )
+  // rows are computed in parallel chunk by chunk, and written in order once a chunk is complete
+  const int chunkRows = std::max( 1, QThread::idealThreadCount() ) * 4;
+  std::vector< double > values( static_cast< std::size_t >( std::min( chunkRows, mNumRows ) ) * mNumColumns );
+  QVector< int > rows;
+  rows.reserve( chunkRows );
+
+  InterpolateRow interpolateRow;
+  interpolateRow.interpolator = mInterpolator;
+  interpolateRow.feedback = feedback;
+  interpolateRow.values = values.data();
+  interpolateRow.nCols = mNumColumns;
+  interpolateRow.xMin = mInterpolationExtent.xMinimum();
+  interpolateRow.yMax = mInterpolationExtent.yMaximum();
+  interpolateRow.cellSizeX = mCellSizeX;
+  interpolateRow.cellSizeY = mCellSizeY;
+
+  for ( int firstRow = 0; firstRow < mNumRows; firstRow += chunkRows )
   {
-    currentXValue = mInterpolationExtent.xMinimum() + mCellSizeX / 2.0; //calculate value in the center of the cell
-    for ( int j = 0; j < mNumColumns; ++j )
+    rows.clear();
+    for ( int i = firstRow; i < std::min( firstRow + chunkRows, mNumRows ); ++i )
     {
-      if ( mInterpolator->interpolatePoint( currentXValue, currentYValue, interpolatedValue, feedback ) == 0 )
-      {
-        outStream << interpolatedValue << ' ';
-      }
-      else
+      rows << i;
+    }
+    interpolateRow.firstRow = firstRow;
+    if ( parallel )
+      QtConcurrent::blockingMap( rows, interpolateRow );
+    else
+      std::for_each( rows.constBegin(), rows.constEnd(), interpolateRow );
+
+    if ( feedback && feedback->isCanceled() )
+    {
+      outputFile.remove();
+      return 3;
+    }
+
+    const double *value = values.data();
+    for ( int i = 0; i < rows.size(); ++i )
+    {
+      for ( int j = 0; j < mNumColumns; ++j, ++value )
       {
-        outStream << "-9999 ";
+        if ( !std::isnan( *value ) )
+        {
+          outStream << *value << ' ';
+        }
+        else
+        {
+          outStream << "-9999 ";
+        }
       }
-      currentXValue += mCellSizeX;
+      outStream << endl;
     }
-    outStream << endl;
-    currentYValue -= mCellSizeY;
 
     if ( feedback )
     {
-      if ( feedback->isCanceled() )
-      {
-        outputFile.remove();
-        return 3;
-      }
-      feedback->setProgress( 100.0 * i / static_cast< double >( mNumRows ) );
+      feedback->setProgress( 100.0 * ( firstRow + rows.size() ) / static_cast< double >( mNumRows ) );
     }
   }
 
@@ -17,13 +17,63 @@
 
 #include "qgsidwinterpolator.h"
 #include "qgis.h"
+#include "qgsspatialindexkdbushdata.h"
+#include "kdbush.hpp"
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <vector>
+
+///@cond PRIVATE
+
+/**
+ * KD-tree over the cached base data of the interpolator. The id of the
+ * indexed items is the index of the vertex in the cached data.
+ *
+ * Searching the tree does not modify it, so it can be queried from
+ * several threads at once.
+ */
+class QgsIDWVertexIndex : public kdbush::KDBush< std::pair<double, double>, QgsSpatialIndexKDBushData, std::size_t >
+{
+  public:
+
+    explicit QgsIDWVertexIndex( const QVector<QgsInterpolatorVertexData> &vertices )
+    {
+      points.reserve( vertices.size() );
+      for ( int i = 0; i < vertices.size(); ++i )
+      {
+        const QgsInterpolatorVertexData &vertex = vertices.at( i );
+        points.emplace_back( QgsSpatialIndexKDBushData( i, vertex.x, vertex.y ) );
+        xMin = std::min( xMin, vertex.x );
+        xMax = std::max( xMax, vertex.x );
+        yMin = std::min( yMin, vertex.y );
+        yMax = std::max( yMax, vertex.y );
+      }
+
+      if ( !points.empty() )
+        sortKD( 0, points.size() - 1, 0 );
+    }
+
+    std::size_t size() const
+    {
+      return points.size();
+    }
+
+    //! Bounding box of all indexed vertices
+    double xMin = std::numeric_limits<double>::max();
+    double yMin = std::numeric_limits<double>::max();
+    double xMax = -std::numeric_limits<double>::max();
+    double yMax = -std::numeric_limits<double>::max();
+};
+
+///@endcond
 
 QgsIDWInterpolator::QgsIDWInterpolator( const QList<LayerData> &layerData )
   : QgsInterpolator( layerData )
 {}
 
+QgsIDWInterpolator::~QgsIDWInterpolator() = default;
+
 int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result, QgsFeedback *feedback )
 {
   if ( !mDataIsCached )
@@ -34,17 +84,88 @@ int QgsIDWInterpolator::interpolatePoint( double x, double y, double &result, Qg
   double sumCounter = 0;
   double sumDenominator = 0;
 
-  for ( const QgsInterpolatorVertexData &vertex : qgis::as_const( mCachedBaseData ) )
+  if ( mSearchRadius > 0 || mMaxPoints > 0 )
+  {
+    if ( !mIndex )
+    {
+      mIndex = qgis::make_unique< QgsIDWVertexIndex >( mCachedBaseData );
+    }
+    if ( mIndex->size() == 0 )
+    {
+      return 1;
+    }
+
+    // candidate vertices as (squared distance, vertex index) pairs
+    std::vector< std::pair< double, int > > candidates;
+    const auto collect = [&candidates, x, y]( const QgsSpatialIndexKDBushData & data )
+    {
+      const double dx = data.coords.first - x;
+      const double dy = data.coords.second - y;
+      candidates.emplace_back( dx * dx + dy * dy, static_cast< int >( data.id ) );
+    };
+
+    if ( mMaxPoints <= 0 )
+    {
+      mIndex->within( x, y, mSearchRadius, collect );
+    }
+    else
+    {
+      const std::size_t neighbors = std::min( static_cast< std::size_t >( mMaxPoints ), mIndex->size() );
+
+      // any radius beyond the farthest corner of the data extent contains all the vertices
+      const double farX = std::max( std::fabs( x - mIndex->xMin ), std::fabs( x - mIndex->xMax ) );
+      const double farY = std::max( std::fabs( y - mIndex->yMin ), std::fabs( y - mIndex->yMax ) );
+      const double maxRadius = mSearchRadius > 0 ? mSearchRadius : std::sqrt( farX * farX + farY * farY );
+
+      // start with the radius expected to contain the requested number of vertices for
+      // evenly distributed data, and grow it until enough vertices are found
+      const double area = ( mIndex->xMax - mIndex->xMin ) * ( mIndex->yMax - mIndex->yMin );
+      double radius = area > 0 ? std::sqrt( area * neighbors / ( M_PI * mIndex->size() ) ) * 1.5 : maxRadius;
+      while ( true )
+      {
+        radius = std::min( radius, maxRadius );
+        candidates.clear();
+        mIndex->within( x, y, radius, collect );
+        if ( candidates.size() >= neighbors || radius >= maxRadius )
+          break;
+        radius *= 2;
+      }
+
+      if ( candidates.size() > neighbors )
+      {
+        std::nth_element( candidates.begin(), candidates.begin() + neighbors - 1, candidates.end() );
+        candidates.resize( neighbors );
+      }
+    }
+
+    for ( const std::pair< double, int > &candidate : candidates )
+    {
+      const QgsInterpolatorVertexData &vertex = mCachedBaseData.at( candidate.second );
+      double distance = std::sqrt( candidate.first );
+      if ( qgsDoubleNear( distance, 0.0 ) )
+      {
+        result = vertex.z;
+        return 0;
+      }
+      double currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * vertex.z );
+      sumDenominator += currentWeight;
+    }
+  }
+  else
   {
-    double distance = std::sqrt( ( vertex.x - x ) * ( vertex.x - x ) + ( vertex.y - y ) * ( vertex.y - y ) );
-    if ( qgsDoubleNear( distance, 0.0 ) )
+    for ( const QgsInterpolatorVertexData &vertex : qgis::as_const( mCachedBaseData ) )
     {
-      result = vertex.z;
-      return 0;
+      double distance = std::sqrt( ( vertex.x - x ) * ( vertex.x - x ) + ( vertex.y - y ) * ( vertex.y - y ) );
+      if ( qgsDoubleNear( distance, 0.0 ) )
+      {
+        result = vertex.z;
+        return 0;
+      }
+      double currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
+      sumCounter += ( currentWeight * vertex.z );
+      sumDenominator += currentWeight;
     }
-    double currentWeight = 1 / ( std::pow( distance, mDistanceCoefficient ) );
-    sumCounter += ( currentWeight * vertex.z );
-    sumDenominator += currentWeight;
   }
 
   if ( sumDenominator == 0.0 )
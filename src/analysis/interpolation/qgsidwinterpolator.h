@@ -21,6 +21,12 @@
 #include "qgsinterpolator.h"
 #include "qgis_analysis.h"
 
+#include <memory>
+
+#ifndef SIP_RUN
+class QgsIDWVertexIndex;
+#endif
+
 /**
  * \ingroup analysis
  * \class QgsIDWInterpolator
@@ -34,9 +40,18 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
      * Constructor for QgsIDWInterpolator, with the specified \a layerData sources.
      */
     QgsIDWInterpolator( const QList<QgsInterpolator::LayerData> &layerData );
+    ~QgsIDWInterpolator() override;
 
+    /**
+     * Calculates interpolation value for map coordinates x, y.
+     *
+     * Once the base data has been cached (i.e. after the first call), this method
+     * may be called concurrently from several threads.
+     */
     int interpolatePoint( double x, double y, double &result SIP_OUT, QgsFeedback *feedback = nullptr ) override;
 
+    bool isThreadSafe() const override { return true; }
+
     /**
      * Sets the distance \a coefficient, the parameter that sets how the values are
      * weighted with distance. Smaller values mean sharper peaks at the data points.
@@ -60,11 +75,60 @@ class ANALYSIS_EXPORT QgsIDWInterpolator: public QgsInterpolator
     */
     double distanceCoefficient() const { return mDistanceCoefficient; }
 
+    /**
+     * Sets the search \a radius (in map units) around interpolated points. Only data points
+     * within this distance are used for the interpolation, and interpolation fails for points
+     * without any data point inside the radius.
+     *
+     * A radius of 0 (the default) means that the search is not limited.
+     *
+     * \see searchRadius()
+     * \since QGIS 3.10
+    */
+    void setSearchRadius( double radius ) { mSearchRadius = radius; }
+
+    /**
+     * Returns the search radius (in map units) around interpolated points. A radius of
+     * 0 means that the search is not limited.
+     *
+     * \see setSearchRadius()
+     * \since QGIS 3.10
+    */
+    double searchRadius() const { return mSearchRadius; }
+
+    /**
+     * Sets the maximum number of \a points used for interpolating a point. If set, only the
+     * nearest \a points data points (within the searchRadius(), if set) are used.
+     *
+     * A value of 0 (the default) means that all data points are used.
+     *
+     * \see maxPoints()
+     * \since QGIS 3.10
+    */
+    void setMaxPoints( int points ) { mMaxPoints = points; }
+
+    /**
+     * Returns the maximum number of nearest data points used for interpolating a point.
+     * A value of 0 means that all data points are used.
+     *
+     * \see setMaxPoints()
+     * \since QGIS 3.10
+    */
+    int maxPoints() const { return mMaxPoints; }
+
   private:
 
     QgsIDWInterpolator() = delete;
+#ifdef SIP_RUN
+    QgsIDWInterpolator( const QgsIDWInterpolator &rh );
+#endif
 
     double mDistanceCoefficient = 2.0;
+    double mSearchRadius = 0.0;
+    int mMaxPoints = 0;
+
+    //! Spatial index of the cached base data, built on demand when the search is limited
+    std::unique_ptr< QgsIDWVertexIndex > mIndex;
 };
 
 #endif
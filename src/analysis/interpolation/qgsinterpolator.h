@@ -117,6 +117,16 @@ class ANALYSIS_EXPORT QgsInterpolator
      */
     virtual int interpolatePoint( double x, double y, double &result SIP_OUT, QgsFeedback *feedback = nullptr ) = 0;
 
+    /**
+     * Returns TRUE if interpolatePoint() may be called concurrently from several threads,
+     * once a first point has been interpolated. The grid file writer only interpolates
+     * rows in parallel for such interpolators.
+     *
+     * The default implementation returns FALSE.
+     * \since QGIS 3.10
+     */
+    virtual bool isThreadSafe() const { return false; }
+
     //! \note not available in Python bindings
     QList<LayerData> layerData() const { return mLayerData; } SIP_SKIP
 
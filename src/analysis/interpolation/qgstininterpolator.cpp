@@ -58,6 +58,34 @@ int QgsTinInterpolator::interpolatePoint( double x, double y, double &result, Qg
     return 1;
   }
 
+  if ( mInterpolation == Linear )
+  {
+    // searching through the triangle interpolator updates the walk state of the triangulation,
+    // so locate the triangle directly, starting from the last triangle found by this thread
+    if ( !mStartEdges.hasLocalData() )
+    {
+      mStartEdges.setLocalData( -1 );
+    }
+    const DualEdgeTriangulation *triangulation = static_cast< const DualEdgeTriangulation * >( mTriangulation );
+    int n1 = 0;
+    int n2 = 0;
+    int n3 = 0;
+    if ( !triangulation->locateTriangle( x, y, mStartEdges.localData(), n1, n2, n3 ) )
+    {
+      return 2;
+    }
+
+    const QgsPoint *pt1 = triangulation->getPoint( n1 );
+    const QgsPoint *pt2 = triangulation->getPoint( n2 );
+    const QgsPoint *pt3 = triangulation->getPoint( n3 );
+    double a = ( pt1->z() * ( pt2->y() - pt3->y() ) + pt2->z() * ( pt3->y() - pt1->y() ) + pt3->z() * ( pt1->y() - pt2->y() ) ) / ( ( pt1->x() - pt2->x() ) * ( pt2->y() - pt3->y() ) - ( pt2->x() - pt3->x() ) * ( pt1->y() - pt2->y() ) );
+    double b = ( pt1->z() * ( pt2->x() - pt3->x() ) + pt2->z() * ( pt3->x() - pt1->x() ) + pt3->z() * ( pt1->x() - pt2->x() ) ) / ( ( pt1->y() - pt2->y() ) * ( pt2->x() - pt3->x() ) - ( pt2->y() - pt3->y() ) * ( pt1->x() - pt2->x() ) );
+    double c = pt1->z() - a * pt1->x() - b * pt1->y();
+    result = a * x + b * y + c;
+    return 0;
+  }
+
+  QMutexLocker locker( &mMutex );
   QgsPoint r( 0, 0, 0 );
   if ( !mTriangleInterpolator->calcPoint( x, y, r ) )
   {
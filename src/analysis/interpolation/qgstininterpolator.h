@@ -20,6 +20,8 @@
 
 #include "qgsinterpolator.h"
 #include <QString>
+#include <QMutex>
+#include <QThreadStorage>
 #include "qgis_analysis.h"
 
 class QgsFeatureSink;
@@ -53,8 +55,17 @@ class ANALYSIS_EXPORT QgsTinInterpolator: public QgsInterpolator
     QgsTinInterpolator( const QList<QgsInterpolator::LayerData> &inputData, TinInterpolation interpolation = Linear, QgsFeedback *feedback = nullptr );
     ~QgsTinInterpolator() override;
 
+    /**
+     * Calculates interpolation value for map coordinates x, y.
+     *
+     * Once the triangulation has been created (i.e. after the first call), this method
+     * may be called concurrently from several threads. Concurrent calls only run in
+     * parallel for Linear interpolation.
+     */
     int interpolatePoint( double x, double y, double &result SIP_OUT, QgsFeedback *feedback ) override;
 
+    bool isThreadSafe() const override { return true; }
+
     /**
      * Returns the fields output by features when saving the triangulation.
      * These fields should be used when creating
@@ -76,6 +87,10 @@ class ANALYSIS_EXPORT QgsTinInterpolator: public QgsInterpolator
     void setTriangulationSink( QgsFeatureSink *sink );
 
   private:
+#ifdef SIP_RUN
+    QgsTinInterpolator( const QgsTinInterpolator &rh );
+#endif
+
     Triangulation *mTriangulation = nullptr;
     TriangleInterpolator *mTriangleInterpolator = nullptr;
     bool mIsInitialized;
@@ -86,6 +101,11 @@ class ANALYSIS_EXPORT QgsTinInterpolator: public QgsInterpolator
     //! Type of interpolation
     TinInterpolation mInterpolation;
 
+    //! Half edge where the triangle search of each thread starts, for linear interpolation
+    QThreadStorage< int > mStartEdges;
+    //! Serializes Clough-Tocher interpolation, which is not reentrant
+    QMutex mMutex;
+
     //! Create dual edge triangulation
     void initialize();
 
@@ -0,0 +1,194 @@
+/***************************************************************************
+                         qgsalgorithmgeneratevectortiles.cpp
+                         -----------------------------------
+    begin                : September 2019
+    copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsalgorithmgeneratevectortiles.h"
+#include "qgscoordinatetransform.h"
+#include "qgsexception.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectortileencoder.h"
+
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+
+///@cond PRIVATE
+
+QString QgsGenerateVectorTilesAlgorithm::name() const
+{
+  return QStringLiteral( "generatevectortiles" );
+}
+
+QString QgsGenerateVectorTilesAlgorithm::displayName() const
+{
+  return QObject::tr( "Generate vector tiles (XYZ)" );
+}
+
+QStringList QgsGenerateVectorTilesAlgorithm::tags() const
+{
+  return QObject::tr( "tiles,vector,mvt,pbf,xyz,cache,seed" ).split( ',' );
+}
+
+QString QgsGenerateVectorTilesAlgorithm::group() const
+{
+  return QObject::tr( "Vector general" );
+}
+
+QString QgsGenerateVectorTilesAlgorithm::groupId() const
+{
+  return QStringLiteral( "vectorgeneral" );
+}
+
+void QgsGenerateVectorTilesAlgorithm::initAlgorithm( const QVariantMap & )
+{
+  addParameter( new QgsProcessingParameterMultipleLayers( QStringLiteral( "LAYERS" ), QObject::tr( "Input layers" ), QgsProcessing::TypeVectorAnyGeometry ) );
+  addParameter( new QgsProcessingParameterExtent( QStringLiteral( "EXTENT" ), QObject::tr( "Extent" ), QVariant(), true ) );
+  addParameter( new QgsProcessingParameterNumber( QStringLiteral( "ZOOM_MIN" ), QObject::tr( "Minimum zoom" ), QgsProcessingParameterNumber::Integer, 0, false, 0, 24 ) );
+  addParameter( new QgsProcessingParameterNumber( QStringLiteral( "ZOOM_MAX" ), QObject::tr( "Maximum zoom" ), QgsProcessingParameterNumber::Integer, 14, false, 0, 24 ) );
+  addParameter( new QgsProcessingParameterFolderDestination( QStringLiteral( "OUTPUT_DIRECTORY" ), QObject::tr( "Output directory" ) ) );
+  addOutput( new QgsProcessingOutputNumber( QStringLiteral( "TILES" ), QObject::tr( "Number of tiles" ) ) );
+}
+
+QString QgsGenerateVectorTilesAlgorithm::shortHelpString() const
+{
+  return QObject::tr( "This algorithm generates the Mapbox Vector Tiles of a set of vector layers in the XYZ tiling scheme "
+                      "(Web Mercator, EPSG:3857).\n\n"
+                      "Tiles are written to the output directory as {z}/{x}/{y}.pbf files, each input layer being a layer "
+                      "of the tiles. Tiles without features are not written.\n\n"
+                      "If no extent is set, the tiles covering the input layers are generated." );
+}
+
+QgsGenerateVectorTilesAlgorithm *QgsGenerateVectorTilesAlgorithm::createInstance() const
+{
+  return new QgsGenerateVectorTilesAlgorithm();
+}
+
+bool QgsGenerateVectorTilesAlgorithm::prepareAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback * )
+{
+  const QList< QgsMapLayer * > layers = parameterAsLayerList( parameters, QStringLiteral( "LAYERS" ), context );
+  for ( QgsMapLayer *layer : layers )
+  {
+    if ( QgsVectorLayer *vectorLayer = qobject_cast< QgsVectorLayer * >( layer ) )
+      mLayers.emplace_back( vectorLayer->clone() );
+  }
+  if ( mLayers.empty() )
+    throw QgsProcessingException( QObject::tr( "No vector layers specified." ) );
+  return true;
+}
+
+QVariantMap QgsGenerateVectorTilesAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
+{
+  const int zoomMin = parameterAsInt( parameters, QStringLiteral( "ZOOM_MIN" ), context );
+  const int zoomMax = parameterAsInt( parameters, QStringLiteral( "ZOOM_MAX" ), context );
+  if ( zoomMin > zoomMax )
+    throw QgsProcessingException( QObject::tr( "Minimum zoom is greater than maximum zoom." ) );
+
+  const QString directory = parameterAsString( parameters, QStringLiteral( "OUTPUT_DIRECTORY" ), context );
+  if ( directory.isEmpty() || !QDir().mkpath( directory ) )
+    throw QgsProcessingException( QObject::tr( "Could not create output directory %1" ).arg( directory ) );
+
+  const QgsCoordinateReferenceSystem webMercator( QStringLiteral( "EPSG:3857" ) );
+  const QgsRectangle world = QgsVectorTileEncoder::xyzTileExtent( 0, 0, 0 );
+
+  QgsRectangle extent = parameterAsExtent( parameters, QStringLiteral( "EXTENT" ), context, webMercator );
+  if ( extent.isNull() )
+  {
+    for ( const auto &layer : mLayers )
+    {
+      QgsCoordinateTransform transform( layer->crs(), webMercator, context.transformContext() );
+      try
+      {
+        extent.combineExtentWith( transform.transformBoundingBox( layer->extent() ) );
+      }
+      catch ( QgsCsException & )
+      {
+        // Layers covering the poles cannot be transformed
+        extent.combineExtentWith( world );
+      }
+    }
+  }
+  extent = extent.intersect( world );
+  if ( extent.isEmpty() )
+    throw QgsProcessingException( QObject::tr( "Extent does not intersect the tiling scheme." ) );
+
+  // Tile ranges of each zoom level
+  struct TileRange
+  {
+    int xMin, xMax, yMin, yMax;
+  };
+  std::vector< TileRange > ranges;
+  double tileCount = 0;
+  for ( int zoom = zoomMin; zoom <= zoomMax; ++zoom )
+  {
+    const int count = 1 << zoom;
+    const double size = world.width() / count;
+    const auto index = [count]( double value ) { return std::min( count - 1, std::max( 0, static_cast<int>( std::floor( value ) ) ) ); };
+    const TileRange range
+    {
+      index( ( extent.xMinimum() - world.xMinimum() ) / size ),
+      index( ( extent.xMaximum() - world.xMinimum() ) / size ),
+      index( ( world.yMaximum() - extent.yMaximum() ) / size ),
+      index( ( world.yMaximum() - extent.yMinimum() ) / size )
+    };
+    ranges.push_back( range );
+    tileCount += static_cast<double>( range.xMax - range.xMin + 1 ) * ( range.yMax - range.yMin + 1 );
+  }
+
+  feedback->pushInfo( QObject::tr( "Generating up to %1 tiles" ).arg( QString::number( tileCount, 'f', 0 ) ) );
+
+  long long written = 0;
+  double current = 0;
+  for ( int zoom = zoomMin; zoom <= zoomMax && !feedback->isCanceled(); ++zoom )
+  {
+    const TileRange &range = ranges.at( static_cast<size_t>( zoom - zoomMin ) );
+    for ( int x = range.xMin; x <= range.xMax && !feedback->isCanceled(); ++x )
+    {
+      const QString columnPath = QStringLiteral( "%1/%2/%3" ).arg( directory ).arg( zoom ).arg( x );
+      for ( int y = range.yMin; y <= range.yMax; ++y )
+      {
+        if ( feedback->isCanceled() )
+          break;
+
+        feedback->setProgress( 100.0 * current++ / tileCount );
+
+        QgsVectorTileEncoder encoder( QgsVectorTileEncoder::xyzTileExtent( zoom, x, y ), webMercator );
+        encoder.setTransformContext( context.transformContext() );
+        for ( const auto &layer : mLayers )
+        {
+          encoder.addLayer( layer.get(), layer->attributeList(), QgsFeatureRequest(), QString(), feedback );
+        }
+        if ( encoder.featureCount() == 0 )
+          continue;
+
+        QFile file( QStringLiteral( "%1/%2.pbf" ).arg( columnPath ).arg( y ) );
+        const QByteArray content = encoder.encode();
+        if ( !QDir().mkpath( columnPath ) || !file.open( QIODevice::WriteOnly ) || file.write( content ) != content.size() )
+          throw QgsProcessingException( QObject::tr( "Could not write tile %1" ).arg( file.fileName() ) );
+        ++written;
+      }
+    }
+  }
+
+  feedback->pushInfo( QObject::tr( "%1 tiles written" ).arg( written ) );
+
+  QVariantMap outputs;
+  outputs.insert( QStringLiteral( "OUTPUT_DIRECTORY" ), directory );
+  outputs.insert( QStringLiteral( "TILES" ), written );
+  return outputs;
+}
+
+///@endcond
@@ -0,0 +1,62 @@
+/***************************************************************************
+                         qgsalgorithmgeneratevectortiles.h
+                         ---------------------------------
+    begin                : September 2019
+    copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSALGORITHMGENERATEVECTORTILES_H
+#define QGSALGORITHMGENERATEVECTORTILES_H
+
+#define SIP_NO_FILE
+
+#include "qgis_sip.h"
+#include "qgsprocessingalgorithm.h"
+
+///@cond PRIVATE
+
+class QgsVectorLayer;
+
+/**
+ * Native generate vector tiles algorithm.
+ */
+class QgsGenerateVectorTilesAlgorithm : public QgsProcessingAlgorithm
+{
+
+  public:
+
+    QgsGenerateVectorTilesAlgorithm() = default;
+    void initAlgorithm( const QVariantMap &configuration = QVariantMap() ) override;
+    QString name() const override;
+    QString displayName() const override;
+    QStringList tags() const override;
+    QString group() const override;
+    QString groupId() const override;
+    QString shortHelpString() const override;
+    QgsGenerateVectorTilesAlgorithm *createInstance() const override SIP_FACTORY;
+
+  protected:
+
+    bool prepareAlgorithm( const QVariantMap &parameters,
+                           QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+    QVariantMap processAlgorithm( const QVariantMap &parameters,
+                                  QgsProcessingContext &context, QgsProcessingFeedback *feedback ) override;
+
+  private:
+
+    std::vector< std::unique_ptr< QgsVectorLayer > > mLayers;
+
+};
+
+///@endcond PRIVATE
+
+#endif // QGSALGORITHMGENERATEVECTORTILES_H
@@ -98,10 +98,6 @@ QVariantMap QgsZonalHistogramAlgorithm::processAlgorithm( const QVariantMap &par
   if ( !zones )
     throw QgsProcessingException( invalidSourceError( parameters, QStringLiteral( "INPUT_VECTOR" ) ) );
 
-  long count = zones->featureCount();
-  double step = count > 0 ? 100.0 / count : 1;
-  long current = 0;
-
   QList< double > uniqueValues;
   QMap< QgsFeatureId, QHash< double, qgssize > > featuresUniqueValues;
 
@@ -114,54 +110,70 @@ QVariantMap QgsZonalHistogramAlgorithm::processAlgorithm( const QVariantMap &par
   }
   QgsFeatureIterator it = zones->getFeatures( request );
   QgsFeature f;
-  while ( it.nextFeature( f ) )
-  {
-    if ( feedback && feedback->isCanceled() )
-    {
-      break;
-    }
-    feedback->setProgress( current * step );
 
-    if ( !f.hasGeometry() )
-    {
-      current++;
-      continue;
-    }
+  long count = zones->featureCount();
+  double step = count > 0 ? 100.0 / count : 1;
+  long current = 0;
 
-    QgsGeometry featureGeometry = f.geometry();
-    QgsRectangle featureRect = featureGeometry.boundingBox().intersect( mRasterExtent );
-    if ( featureRect.isEmpty() )
+  // zones are collected in chunks, the histograms of all zones of a chunk are then calculated in parallel
+  const int zoneChunkSize = 10000;
+  bool atEnd = false;
+  while ( !atEnd )
+  {
+    const long chunkStart = current;
+    QVector< QgsFeatureId > zoneIds;
+    QVector< QgsGeometry > zoneGeometries;
+    while ( zoneGeometries.size() < zoneChunkSize )
     {
+      if ( !it.nextFeature( f ) )
+      {
+        atEnd = true;
+        break;
+      }
       current++;
-      continue;
-    }
 
-    int nCellsX, nCellsY;
-    QgsRectangle rasterBlockExtent;
-    QgsRasterAnalysisUtils::cellInfoForBBox( mRasterExtent, featureRect, mCellSizeX, mCellSizeY, nCellsX, nCellsY, mNbCellsXProvider, mNbCellsYProvider, rasterBlockExtent );
+      if ( !f.hasGeometry() )
+      {
+        continue;
+      }
 
-    QHash< double, qgssize > fUniqueValues;
-    QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( mRasterInterface.get(), mRasterBand, featureGeometry, nCellsX, nCellsY, mCellSizeX, mCellSizeY,
-    rasterBlockExtent, [ &fUniqueValues]( double value ) { fUniqueValues[value]++; }, false );
+      QgsGeometry featureGeometry = f.geometry();
+      QgsRectangle featureRect = featureGeometry.boundingBox().intersect( mRasterExtent );
+      if ( featureRect.isEmpty() )
+      {
+        continue;
+      }
+
+      zoneIds << f.id();
+      zoneGeometries << featureGeometry;
+    }
 
-    if ( fUniqueValues.count() < 1 )
+    if ( feedback && feedback->isCanceled() )
     {
-      // The cell resolution is probably larger than the polygon area. We switch to slower precise pixel - polygon intersection in this case
-      // TODO: eventually deal with weight if needed
-      QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( mRasterInterface.get(), mRasterBand, featureGeometry, nCellsX, nCellsY, mCellSizeX, mCellSizeY,
-      rasterBlockExtent, [ &fUniqueValues]( double value, double ) { fUniqueValues[value]++; }, false );
+      break;
     }
 
-    for ( auto it = fUniqueValues.constBegin(); it != fUniqueValues.constEnd(); ++it )
+    // each zone is accessed by a single thread only
+    // TODO: eventually deal with weight of precise intersection if needed
+    std::vector< QHash< double, qgssize > > zonesUniqueValues( static_cast< std::size_t >( zoneGeometries.size() ) );
+    QgsRasterAnalysisUtils::statisticsForZones( mRasterInterface.get(), mRasterBand, mRasterExtent, mCellSizeX, mCellSizeY, mNbCellsXProvider, mNbCellsYProvider, zoneGeometries,
+        [ &zonesUniqueValues ]( int zone, double value, double ) { zonesUniqueValues[zone][value]++; },
+        [ &zonesUniqueValues ]( int zone ) { zonesUniqueValues[zone].clear(); },
+        1, false, feedback,
+        [ = ]( int processed ) { feedback->setProgress( ( chunkStart + processed ) * step ); } );
+
+    for ( int zone = 0; zone < zoneIds.size(); ++zone )
     {
-      if ( uniqueValues.indexOf( it.key() ) == -1 )
+      const QHash< double, qgssize > &fUniqueValues = zonesUniqueValues[zone];
+      for ( auto it = fUniqueValues.constBegin(); it != fUniqueValues.constEnd(); ++it )
       {
-        uniqueValues << it.key();
+        if ( uniqueValues.indexOf( it.key() ) == -1 )
+        {
+          uniqueValues << it.key();
+        }
+        featuresUniqueValues[zoneIds.at( zone )][it.key()] += it.value();
       }
-      featuresUniqueValues[f.id()][it.key()] += it.value();
     }
-
-    current++;
   }
 
   std::sort( uniqueValues.begin(), uniqueValues.end() );
@@ -18,11 +18,162 @@
 #include "qgsfeedback.h"
 #include "qgsrasterblock.h"
 #include "qgsrasteriterator.h"
+#include "qgsrasterinterface.h"
+#include "qgsgeometry.h"
 #include "qgsgeos.h"
 #include "qgsprocessingparameters.h"
+#include "qgsgeometrycollection.h"
+#include "qgscurvepolygon.h"
+#include "qgslinestring.h"
+
+#include <QFuture>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include <map>
 ///@cond PRIVATE
 
+namespace
+{
+
+  /**
+   * Scanline rasterization of a (multi)polygon. The edges of all rings are kept
+   * in a table and pixels of a grid row are within the polygon if their center lies
+   * between an odd and even crossing of the row with the edges (even-odd rule).
+   * This is much faster than testing each pixel center with a point in polygon test.
+   */
+  class PolygonScanline
+  {
+    public:
+      explicit PolygonScanline( const QgsGeometry &geometry )
+      {
+        addGeometry( geometry.constGet() );
+        // sorted by top y, rows are processed from top to bottom
+        std::sort( mEdges.begin(), mEdges.end(), []( const Edge & a, const Edge & b ) { return a.y2 > b.y2; } );
+      }
+
+      /**
+       * Calls \a pixel( row, col ) for all pixels of the grid with \a cols columns and \a rows rows
+       * covering \a gridExtent whose centers lie within the polygon.
+       */
+      template <typename Func>
+      void forEachPixel( const QgsRectangle &gridExtent, int cols, int rows, double cellSizeX, double cellSizeY, Func pixel ) const
+      {
+        if ( mEdges.empty() || cols <= 0 || rows <= 0 )
+          return;
+
+        const int firstRow = std::max( 0, static_cast< int >( std::floor( ( gridExtent.yMaximum() - mYMax ) / cellSizeY ) ) );
+        const int lastRow = std::min( rows - 1, static_cast< int >( std::ceil( ( gridExtent.yMaximum() - mYMin ) / cellSizeY ) ) );
+
+        std::vector< const Edge * > active;
+        std::vector< double > crossings;
+        std::size_t nextEdge = 0;
+        for ( int row = firstRow; row <= lastRow; ++row )
+        {
+          const double y = gridExtent.yMaximum() - ( row + 0.5 ) * cellSizeY;
+
+          // edges are half open, y1 <= y < y2, so that vertices are not counted twice
+          while ( nextEdge < mEdges.size() && mEdges[nextEdge].y2 > y )
+          {
+            active.push_back( &mEdges[nextEdge] );
+            nextEdge++;
+          }
+          active.erase( std::remove_if( active.begin(), active.end(), [y]( const Edge * edge ) { return edge->y1 > y; } ), active.end() );
+
+          crossings.clear();
+          for ( const Edge *edge : active )
+          {
+            crossings.push_back( edge->x1 + ( y - edge->y1 ) * ( edge->x2 - edge->x1 ) / ( edge->y2 - edge->y1 ) );
+          }
+          std::sort( crossings.begin(), crossings.end() );
+
+          for ( std::size_t i = 0; i + 1 < crossings.size(); i += 2 )
+          {
+            // columns with cell center strictly between the crossings, like point in polygon "contains" test
+            const int firstCol = std::max( 0, static_cast< int >( std::floor( ( crossings[i] - gridExtent.xMinimum() ) / cellSizeX - 0.5 ) ) + 1 );
+            const int lastCol = std::min( cols - 1, static_cast< int >( std::ceil( ( crossings[i + 1] - gridExtent.xMinimum() ) / cellSizeX - 0.5 ) ) - 1 );
+            for ( int col = firstCol; col <= lastCol; ++col )
+            {
+              pixel( row, col );
+            }
+          }
+        }
+      }
+
+    private:
+
+      struct Edge
+      {
+        double x1;
+        double y1;
+        double x2;
+        double y2;
+      };
+
+      void addGeometry( const QgsAbstractGeometry *geometry )
+      {
+        if ( const QgsGeometryCollection *collection = qgsgeometry_cast< const QgsGeometryCollection * >( geometry ) )
+        {
+          for ( int i = 0; i < collection->numGeometries(); ++i )
+            addGeometry( collection->geometryN( i ) );
+        }
+        else if ( const QgsCurvePolygon *polygon = qgsgeometry_cast< const QgsCurvePolygon * >( geometry ) )
+        {
+          addRing( polygon->exteriorRing() );
+          for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+            addRing( polygon->interiorRing( i ) );
+        }
+      }
+
+      void addRing( const QgsCurve *ring )
+      {
+        if ( !ring )
+          return;
+
+        std::unique_ptr< QgsLineString > segmentized;
+        const QgsLineString *line = qgsgeometry_cast< const QgsLineString * >( ring );
+        if ( !line )
+        {
+          segmentized.reset( ring->curveToLine() );
+          line = segmentized.get();
+        }
+
+        const int count = line->numPoints();
+        if ( count < 3 )
+          return;
+
+        const double *x = line->xData();
+        const double *y = line->yData();
+        for ( int i = 0; i < count; ++i )
+        {
+          // closing edge is added explicitly only if the ring is not closed
+          const int j = i + 1 < count ? i + 1 : 0;
+          if ( y[i] == y[j] )
+            continue; // horizontal edges never cross a row
+
+          if ( y[i] < y[j] )
+            mEdges.push_back( { x[i], y[i], x[j], y[j] } );
+          else
+            mEdges.push_back( { x[j], y[j], x[i], y[i] } );
+
+          mYMin = std::min( mYMin, std::min( y[i], y[j] ) );
+          mYMax = std::max( mYMax, std::max( y[i], y[j] ) );
+        }
+      }
+
+      std::vector< Edge > mEdges;
+      double mYMin = std::numeric_limits< double >::max();
+      double mYMax = std::numeric_limits< double >::lowest();
+  };
+
+}
+
+
 void QgsRasterAnalysisUtils::cellInfoForBBox( const QgsRectangle &rasterBBox, const QgsRectangle &featureBBox, double cellSizeX, double cellSizeY,
     int &nCellsX, int &nCellsY, int rasterWidth, int rasterHeight, QgsRectangle &rasterBlockExtent )
 {
@@ -58,12 +209,7 @@ void QgsRasterAnalysisUtils::cellInfoForBBox( const QgsRectangle &rasterBBox, co
 
 void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox,  const std::function<void( double )> &addValue, bool skipNodata )
 {
-  std::unique_ptr< QgsGeometryEngine > polyEngine( QgsGeometry::createGeometryEngine( poly.constGet( ) ) );
-  if ( !polyEngine )
-  {
-    return;
-  }
-  polyEngine->prepareGeometry();
+  const PolygonScanline scanline( poly );
 
   QgsRasterIterator iter( rasterInterface );
   iter.startRasterRead( rasterBand, nCellsX, nCellsY, rasterBBox );
@@ -77,26 +223,14 @@ void QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( QgsRasterInterface *
   bool isNoData = false;
   while ( iter.readNextRasterPart( rasterBand, iterCols, iterRows, block, iterLeft, iterTop, &blockExtent ) )
   {
-    double cellCenterY = blockExtent.yMaximum() - 0.5 * cellSizeY;
-
-    for ( int row = 0; row < iterRows; ++row )
+    scanline.forEachPixel( blockExtent, iterCols, iterRows, cellSizeX, cellSizeY, [&]( int row, int col )
     {
-      double cellCenterX = blockExtent.xMinimum() + 0.5 * cellSizeX;
-      for ( int col = 0; col < iterCols; ++col )
+      const double pixelValue = block->valueAndNoData( row, col, isNoData );
+      if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
       {
-        const double pixelValue = block->valueAndNoData( row, col, isNoData );
-        if ( validPixel( pixelValue ) && ( !skipNodata || !isNoData ) )
-        {
-          QgsPoint cellCenter( cellCenterX, cellCenterY );
-          if ( polyEngine->contains( &cellCenter ) )
-          {
-            addValue( pixelValue );
-          }
-        }
-        cellCenterX += cellSizeX;
+        addValue( pixelValue );
       }
-      cellCenterY -= cellSizeY;
-    }
+    } );
   }
 }
 
@@ -162,6 +296,332 @@ void QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( QgsRasterInterfa
   }
 }
 
+namespace
+{
+
+  //! Pool of raster interface clones, so that each zonal statistics worker reads with its own interface
+  class RasterInterfacePool
+  {
+    public:
+      RasterInterfacePool( QgsRasterInterface *source, int maximumSize )
+        : mSource( source )
+        , mMaximumSize( maximumSize )
+      {}
+
+      //! Returns a free clone, clones are only created when all existing ones are in use
+      QgsRasterInterface *acquire()
+      {
+        QMutexLocker locker( &mMutex );
+        while ( mFree.empty() )
+        {
+          if ( static_cast< int >( mClones.size() ) < mMaximumSize )
+          {
+            QgsRasterInterface *clone = mSource->clone();
+            if ( clone )
+            {
+              mClones.emplace_back( clone );
+              return clone;
+            }
+            // cannot clone more, wait for one of the existing clones
+            mMaximumSize = static_cast< int >( mClones.size() );
+            if ( mMaximumSize == 0 )
+              return nullptr;
+          }
+          mCondition.wait( &mMutex );
+        }
+        QgsRasterInterface *iface = mFree.back();
+        mFree.pop_back();
+        return iface;
+      }
+
+      void release( QgsRasterInterface *iface )
+      {
+        QMutexLocker locker( &mMutex );
+        mFree.push_back( iface );
+        mCondition.wakeOne();
+      }
+
+    private:
+      QgsRasterInterface *mSource = nullptr;
+      int mMaximumSize = 1;
+      std::vector< std::unique_ptr< QgsRasterInterface > > mClones;
+      std::vector< QgsRasterInterface * > mFree;
+      QMutex mMutex;
+      QWaitCondition mCondition;
+  };
+
+  //! Spatially close zones which are read from a single raster block
+  struct ZoneBatch
+  {
+    std::vector< int > zones;
+    QgsRectangle extent;
+    //! TRUE if the batch is a single zone too large to be read in a single block
+    bool large = false;
+  };
+
+  //! Interleaves bits of x and y, zones sorted by the code are spatially close
+  quint64 mortonCode( quint32 x, quint32 y )
+  {
+    quint64 code = 0;
+    for ( int i = 0; i < 32; ++i )
+    {
+      code |= ( static_cast< quint64 >( x >> i ) & 1 ) << ( 2 * i );
+      code |= ( static_cast< quint64 >( y >> i ) & 1 ) << ( 2 * i + 1 );
+    }
+    return code;
+  }
+
+  struct ZoneStatisticsContext
+  {
+    RasterInterfacePool *pool = nullptr;
+    int rasterBand = 1;
+    QgsRectangle rasterExtent;
+    double cellSizeX = 0;
+    double cellSizeY = 0;
+    int rasterWidth = 0;
+    int rasterHeight = 0;
+    const QVector< QgsGeometry > *zones = nullptr;
+    const std::function<void( int, double, double )> *addValue = nullptr;
+    const std::function<void( int )> *resetZone = nullptr;
+    int minimumMiddlePointCount = 1;
+    bool skipNodata = true;
+    //! Only used by the workers to check for cancellation, it is canceled by the calling thread
+    QgsFeedback *feedback = nullptr;
+    //! Number of processed zones, progress is reported by the calling thread
+    std::atomic< int > processed { 0 };
+    //! Number of finished batches, guarded by progressMutex
+    int finishedBatches = 0;
+    QMutex progressMutex;
+    //! Woken each time a batch is finished
+    QWaitCondition progressCondition;
+  };
+
+  //! Functor for QtConcurrent, processes a batch of zones
+  struct ProcessZoneBatch
+  {
+    explicit ProcessZoneBatch( ZoneStatisticsContext *context )
+      : mContext( context )
+    {}
+
+    void operator()( const ZoneBatch &batch )
+    {
+      processBatch( batch );
+
+      QMutexLocker locker( &mContext->progressMutex );
+      mContext->finishedBatches++;
+      mContext->progressCondition.wakeAll();
+    }
+
+    void processBatch( const ZoneBatch &batch )
+    {
+      ZoneStatisticsContext &c = *mContext;
+      if ( c.feedback && c.feedback->isCanceled() )
+        return;
+
+      QgsRasterInterface *iface = c.pool->acquire();
+      if ( !iface )
+        return;
+
+      std::unique_ptr< QgsRasterBlock > block;
+      int batchCellsX = 0;
+      int batchCellsY = 0;
+      QgsRectangle batchBlockExtent;
+      if ( !batch.large )
+      {
+        QgsRasterAnalysisUtils::cellInfoForBBox( c.rasterExtent, batch.extent, c.cellSizeX, c.cellSizeY, batchCellsX, batchCellsY,
+            c.rasterWidth, c.rasterHeight, batchBlockExtent );
+        if ( batchCellsX > 0 && batchCellsY > 0 )
+          block.reset( iface->block( c.rasterBand, batchBlockExtent, batchCellsX, batchCellsY, c.feedback ) );
+      }
+
+      bool isNoData = false;
+      for ( int zone : batch.zones )
+      {
+        if ( c.feedback && c.feedback->isCanceled() )
+          break;
+
+        const QgsGeometry &geometry = c.zones->at( zone );
+        int middlePointCount = 0;
+        auto addMiddlePointValue = [&]( double value )
+        {
+          ( *c.addValue )( zone, value, 1.0 );
+          middlePointCount++;
+        };
+
+        if ( block )
+        {
+          const PolygonScanline scanline( geometry );
+          scanline.forEachPixel( batchBlockExtent, batchCellsX, batchCellsY, c.cellSizeX, c.cellSizeY, [&]( int row, int col )
+          {
+            const double pixelValue = block->valueAndNoData( row, col, isNoData );
+            if ( QgsRasterAnalysisUtils::validPixel( pixelValue ) && ( !c.skipNodata || !isNoData ) )
+              addMiddlePointValue( pixelValue );
+          } );
+        }
+
+        int nCellsX = 0;
+        int nCellsY = 0;
+        QgsRectangle zoneBlockExtent;
+        QgsRasterAnalysisUtils::cellInfoForBBox( c.rasterExtent, geometry.boundingBox(), c.cellSizeX, c.cellSizeY, nCellsX, nCellsY,
+            c.rasterWidth, c.rasterHeight, zoneBlockExtent );
+
+        if ( !block )
+        {
+          QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( iface, c.rasterBand, geometry, nCellsX, nCellsY, c.cellSizeX, c.cellSizeY,
+              zoneBlockExtent, addMiddlePointValue, c.skipNodata );
+        }
+
+        if ( middlePointCount < c.minimumMiddlePointCount )
+        {
+          // The cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
+          ( *c.resetZone )( zone );
+          QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( iface, c.rasterBand, geometry, nCellsX, nCellsY, c.cellSizeX, c.cellSizeY,
+              zoneBlockExtent, [&]( double value, double weight ) { ( *c.addValue )( zone, value, weight ); }, c.skipNodata );
+        }
+
+        ++c.processed;
+      }
+
+      c.pool->release( iface );
+    }
+
+    typedef void result_type;
+
+    ZoneStatisticsContext *mContext = nullptr;
+  };
+
+}
+
+void QgsRasterAnalysisUtils::statisticsForZones( QgsRasterInterface *rasterInterface, int rasterBand, const QgsRectangle &rasterExtent,
+    double cellSizeX, double cellSizeY, int rasterWidth, int rasterHeight,
+    const QVector< QgsGeometry > &zones,
+    const std::function<void( int, double, double )> &addValue,
+    const std::function<void( int )> &resetZone,
+    int minimumMiddlePointCount, bool skipNodata, QgsFeedback *feedback,
+    const std::function<void( int )> &zonesProcessed )
+{
+  // Maximum number of cells read in a single block for a batch of zones
+  const qgssize maxBatchCells = 2048 * 2048;
+
+  // Sort zones spatially, by the position of their bounding box center in the raster grid
+  std::vector< std::pair< quint64, int > > sortedZones;
+  sortedZones.reserve( zones.size() );
+  for ( int i = 0; i < zones.size(); ++i )
+  {
+    const QgsRectangle bbox = zones.at( i ).boundingBox().intersect( rasterExtent );
+    if ( bbox.isEmpty() )
+      continue;
+
+    const QgsPointXY center = bbox.center();
+    const quint32 col = static_cast< quint32 >( std::max( 0.0, ( center.x() - rasterExtent.xMinimum() ) / cellSizeX ) );
+    const quint32 row = static_cast< quint32 >( std::max( 0.0, ( rasterExtent.yMaximum() - center.y() ) / cellSizeY ) );
+    sortedZones.emplace_back( mortonCode( col, row ), i );
+  }
+  std::sort( sortedZones.begin(), sortedZones.end() );
+
+  // Group neighbouring zones in batches which are read from a single block
+  std::vector< ZoneBatch > batches;
+  auto cellCount = [ = ]( const QgsRectangle & extent )
+  {
+    int nCellsX = 0;
+    int nCellsY = 0;
+    QgsRectangle blockExtent;
+    cellInfoForBBox( rasterExtent, extent, cellSizeX, cellSizeY, nCellsX, nCellsY, rasterWidth, rasterHeight, blockExtent );
+    return static_cast< qgssize >( nCellsX ) * static_cast< qgssize >( nCellsY );
+  };
+
+  ZoneBatch batch;
+  for ( const auto &sortedZone : sortedZones )
+  {
+    const int zone = sortedZone.second;
+    const QgsRectangle bbox = zones.at( zone ).boundingBox().intersect( rasterExtent );
+    if ( cellCount( bbox ) > maxBatchCells )
+    {
+      ZoneBatch largeBatch;
+      largeBatch.zones.push_back( zone );
+      largeBatch.extent = bbox;
+      largeBatch.large = true;
+      batches.emplace_back( largeBatch );
+      continue;
+    }
+
+    if ( !batch.zones.empty() )
+    {
+      QgsRectangle combined = batch.extent;
+      combined.combineExtentWith( bbox );
+      if ( cellCount( combined ) <= maxBatchCells )
+      {
+        batch.zones.push_back( zone );
+        batch.extent = combined;
+        continue;
+      }
+      batches.emplace_back( batch );
+      batch = ZoneBatch();
+    }
+    batch.zones.push_back( zone );
+    batch.extent = bbox;
+  }
+  if ( !batch.zones.empty() )
+    batches.emplace_back( batch );
+
+  if ( batches.empty() )
+    return;
+
+  // clones are created on demand, there are never more of them than running workers
+  RasterInterfacePool pool( rasterInterface, std::min( QThreadPool::globalInstance()->maxThreadCount(), static_cast< int >( batches.size() ) ) );
+
+  // workers never touch the caller's feedback, which may emit signals to objects of the calling thread
+  QgsFeedback workerFeedback;
+
+  ZoneStatisticsContext context;
+  context.pool = &pool;
+  context.rasterBand = rasterBand;
+  context.rasterExtent = rasterExtent;
+  context.cellSizeX = cellSizeX;
+  context.cellSizeY = cellSizeY;
+  context.rasterWidth = rasterWidth;
+  context.rasterHeight = rasterHeight;
+  context.zones = &zones;
+  context.addValue = &addValue;
+  context.resetZone = &resetZone;
+  context.minimumMiddlePointCount = minimumMiddlePointCount;
+  context.skipNodata = skipNodata;
+  context.feedback = &workerFeedback;
+
+  // the cancellation is forwarded to the workers from the thread canceling the feedback
+  if ( feedback )
+  {
+    QObject::connect( feedback, &QgsFeedback::canceled, &workerFeedback, &QgsFeedback::cancel, Qt::DirectConnection );
+    if ( feedback->isCanceled() )
+      workerFeedback.cancel();
+  }
+
+  QFuture< void > future = QtConcurrent::map( batches, ProcessZoneBatch( &context ) );
+
+  // progress is reported from the calling thread each time a batch is finished
+  int reported = 0;
+  const int batchCount = static_cast< int >( batches.size() );
+  context.progressMutex.lock();
+  while ( context.finishedBatches < batchCount )
+  {
+    context.progressCondition.wait( &context.progressMutex );
+    const int processed = context.processed;
+    if ( processed != reported && zonesProcessed )
+    {
+      // the workers must not wait for the progress to be reported
+      context.progressMutex.unlock();
+      zonesProcessed( processed );
+      context.progressMutex.lock();
+    }
+    reported = processed;
+  }
+  context.progressMutex.unlock();
+  future.waitForFinished();
+
+  if ( feedback )
+    QObject::disconnect( feedback, &QgsFeedback::canceled, &workerFeedback, &QgsFeedback::cancel );
+}
+
 bool QgsRasterAnalysisUtils::validPixel( double value )
 {
   return !std::isnan( value );
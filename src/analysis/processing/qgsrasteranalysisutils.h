@@ -22,6 +22,7 @@
 #include <functional>
 #include <memory>
 #include <vector>
+#include <QVector>
 
 #define SIP_NO_FILE
 
@@ -46,10 +47,39 @@ namespace QgsRasterAnalysisUtils
                         int rasterWidth, int rasterHeight,
                         QgsRectangle &rasterBlockExtent );
 
-  //! Returns statistics by considering the pixels where the center point is within the polygon (fast)
+  /**
+   * Returns statistics by considering the pixels where the center point is within the polygon (fast).
+   * Pixels are found by scanline rasterization of the polygon.
+   */
   void statisticsFromMiddlePointTest( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY,
                                       double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const std::function<void( double )> &addValue, bool skipNodata = true );
 
+  /**
+   * Calculates statistics of (multi)polygon \a zones (in raster CRS) in parallel.
+   *
+   * Zones are sorted spatially and split into batches of neighbouring zones. Each batch is processed
+   * by a single thread with its own clone of \a rasterInterface, the raster block covering a batch is read
+   * only once and pixels with center within a zone are found by scanline rasterization of its polygon.
+   *
+   * \a addValue is called with the zone index, the pixel value and the weight of the pixel. All values of
+   * a zone are added from the same thread, but different zones are processed concurrently, so \a addValue must
+   * only modify data belonging to the given zone.
+   *
+   * Zones with less than \a minimumMiddlePointCount pixel centers are reset via \a resetZone and
+   * calculated with precise pixel - polygon intersection instead.
+   *
+   * The \a feedback is only used for cancellation, which is forwarded to the workers. The number of zones
+   * processed so far is reported to \a zonesProcessed each time a batch of zones is done, always from the
+   * calling thread.
+   */
+  void statisticsForZones( QgsRasterInterface *rasterInterface, int rasterBand, const QgsRectangle &rasterExtent,
+                           double cellSizeX, double cellSizeY, int rasterWidth, int rasterHeight,
+                           const QVector< QgsGeometry > &zones,
+                           const std::function<void( int, double, double )> &addValue,
+                           const std::function<void( int )> &resetZone,
+                           int minimumMiddlePointCount, bool skipNodata, QgsFeedback *feedback,
+                           const std::function<void( int )> &zonesProcessed = nullptr );
+
   //! Returns statistics with precise pixel - polygon intersection test (slow)
   void statisticsFromPreciseIntersection( QgsRasterInterface *rasterInterface, int rasterBand, const QgsGeometry &poly, int nCellsX, int nCellsY,
                                           double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const std::function<void( double, double )> &addValue, bool skipNodata = true );
@@ -17,9 +17,25 @@
 #include "qgsfeaturesource.h"
 #include "qgsfeatureiterator.h"
 #include "qgsgeometry.h"
+#include "qgsfeedback.h"
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtConcurrentMap>
+
+#include <atomic>
 
 #define NO_DATA -9999
 
+//! Side of the output tiles the surface is accumulated in, in pixels
+static const int TILE_SIZE = 512;
+
+//! Maximum number of points kept in memory before their kernels are accumulated to the output
+static const std::size_t MAX_PENDING_POINTS = 1 << 20;
+
+//! Maximum number of point references kept by the tiles before the kernels are accumulated to the output
+static const std::size_t MAX_PENDING_TILE_POINTS = 1 << 23;
+
 QgsKernelDensityEstimation::QgsKernelDensityEstimation( const QgsKernelDensityEstimation::Parameters &parameters, const QString &outputFile, const QString &outputFormat )
   : mSource( parameters.source )
   , mOutputFile( outputFile )
@@ -89,6 +105,16 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::prepare()
   if ( !createEmptyLayer( driver, mBounds, rows, cols ) )
     return FileCreationError;
 
+  mRows = rows;
+  mColumns = cols;
+  mTileRows = ( rows + TILE_SIZE - 1 ) / TILE_SIZE;
+  mTileColumns = ( cols + TILE_SIZE - 1 ) / TILE_SIZE;
+  mPoints.clear();
+  mTilePoints.clear();
+  mTilePoints.resize( static_cast< std::size_t >( mTileRows ) * mTileColumns );
+  mPendingTilePoints = 0;
+  mTileWritten.assign( mTilePoints.size(), false );
+
   // open the raster in GA_Update mode
   mDatasetH.reset( GDALOpen( mOutputFile.toUtf8().constData(), GA_Update ) );
   if ( !mDatasetH )
@@ -156,60 +182,205 @@ QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::addFeature( const
       continue;
     }
 
-    // calculate the pixel position
-    unsigned int xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPosition = ( ( ( *pointIt ).y() - mBounds.yMinimum() ) / mPixelSize ) - buffer;
-    unsigned int yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+    // calculate the pixel position of the block covered by the kernel
+    const double xPosition = ( ( ( *pointIt ).x() - mBounds.xMinimum() ) / mPixelSize ) - buffer;
+    const double yPositionIO = ( ( mBounds.yMaximum() - ( *pointIt ).y() ) / mPixelSize ) - buffer;
+    if ( xPosition <= -1 || yPositionIO <= -1
+         || static_cast< int >( xPosition ) + blockSize > mColumns || static_cast< int >( yPositionIO ) + blockSize > mRows )
+    {
+      // the block is not completely inside the raster
+      result = RasterIoError;
+      continue;
+    }
 
+    // the kernel is applied when finalising, tile by tile
+    const int firstTileColumn = static_cast< int >( xPosition ) / TILE_SIZE;
+    const int lastTileColumn = ( static_cast< int >( xPosition ) + blockSize - 1 ) / TILE_SIZE;
+    const int firstTileRow = static_cast< int >( yPositionIO ) / TILE_SIZE;
+    const int lastTileRow = ( static_cast< int >( yPositionIO ) + blockSize - 1 ) / TILE_SIZE;
+    const quint32 pointIndex = static_cast< quint32 >( mPoints.size() );
+    mPoints.push_back( KernelPoint { ( *pointIt ).x(), ( *pointIt ).y(), radius, weight, buffer } );
+    for ( int tileRow = firstTileRow; tileRow <= lastTileRow; ++tileRow )
+    {
+      for ( int tileColumn = firstTileColumn; tileColumn <= lastTileColumn; ++tileColumn )
+      {
+        mTilePoints[ static_cast< std::size_t >( tileRow ) * mTileColumns + tileColumn ].push_back( pointIndex );
+        mPendingTilePoints++;
+      }
+    }
 
-    // get the data
-    float *dataBuffer = ( float * ) CPLMalloc( sizeof( float ) * blockSize * blockSize );
-    if ( GDALRasterIO( mRasterBandH, GF_Read, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
+    // keep memory bounded, whatever the number of points
+    if ( mPoints.size() >= MAX_PENDING_POINTS || mPendingTilePoints >= MAX_PENDING_TILE_POINTS )
     {
-      result = RasterIoError;
+      if ( !accumulateTiles( nullptr ) )
+        result = RasterIoError;
+    }
+  }
+
+  return result;
+}
+
+QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise( QgsFeedback *feedback )
+{
+  Result result = Success;
+  if ( mRasterBandH && !accumulateTiles( feedback ) )
+    result = feedback && feedback->isCanceled() ? Canceled : RasterIoError;
+
+  mPoints.clear();
+  mPoints.shrink_to_fit();
+  mTilePoints.clear();
+  mTilePoints.shrink_to_fit();
+  mTileWritten.clear();
+  mDatasetH.reset();
+  mRasterBandH = nullptr;
+  return result;
+}
+
+bool QgsKernelDensityEstimation::accumulateTiles( QgsFeedback *feedback )
+{
+  QVector< int > tiles;
+  for ( std::size_t i = 0; i < mTilePoints.size(); ++i )
+  {
+    if ( !mTilePoints[i].empty() )
+      tiles << static_cast< int >( i );
+  }
+
+  // each tile is accumulated in its own buffer and written once. Tiles written by a previous
+  // call are read back first, their points are always applied in the order they were added
+  QMutex ioMutex;
+  std::atomic<bool> ioError( false );
+  std::atomic<bool> canceled( false );
+  int processed = 0;
+  QMutex progressMutex;
+  QWaitCondition progressCondition;
+  auto tileDone = [&processed, &progressMutex, &progressCondition]
+  {
+    QMutexLocker locker( &progressMutex );
+    processed++;
+    progressCondition.wakeAll();
+  };
+  auto accumulate = [this, &ioMutex, &ioError, &canceled, &tileDone]( int tileIndex )
+  {
+    if ( canceled )
+    {
+      tileDone();
+      return;
+    }
+
+    const int xOffset = ( tileIndex % mTileColumns ) * TILE_SIZE;
+    const int yOffset = ( tileIndex / mTileColumns ) * TILE_SIZE;
+    const int width = std::min( TILE_SIZE, mColumns - xOffset );
+    const int height = std::min( TILE_SIZE, mRows - yOffset );
+
+    std::vector< float > tile( static_cast< std::size_t >( width ) * height, NO_DATA );
+    if ( mTileWritten[ tileIndex ] )
+    {
+      // GDAL datasets must not be accessed from several threads at once
+      QMutexLocker locker( &ioMutex );
+      if ( GDALRasterIO( mRasterBandH, GF_Read, xOffset, yOffset, width, height,
+                         tile.data(), width, height, GDT_Float32, 0, 0 ) != CE_None )
+      {
+        ioError = true;
+      }
     }
 
-    for ( int xp = 0; xp < blockSize; xp++ )
+    if ( !ioError )
     {
-      for ( int yp = 0; yp < blockSize; yp++ )
+      accumulateTile( mTilePoints[ tileIndex ], xOffset, yOffset, width, height, tile.data() );
+
+      QMutexLocker locker( &ioMutex );
+      if ( GDALRasterIO( mRasterBandH, GF_Write, xOffset, yOffset, width, height,
+                         tile.data(), width, height, GDT_Float32, 0, 0 ) != CE_None )
       {
-        double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
-        double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
+        ioError = true;
+      }
+    }
+    tileDone();
+  };
+
+  if ( !feedback )
+  {
+    QtConcurrent::blockingMap( tiles, accumulate );
+  }
+  else
+  {
+    // the feedback is not used by the workers: the cancellation is forwarded from the thread
+    // canceling the feedback, and progress is reported by the calling thread when tiles are done
+    const QMetaObject::Connection cancelConnection = QObject::connect( feedback, &QgsFeedback::canceled, [&canceled] { canceled = true; } );
+    if ( feedback->isCanceled() )
+      canceled = true;
+
+    QFuture< void > future = QtConcurrent::map( tiles, accumulate );
+    progressMutex.lock();
+    while ( processed < tiles.size() )
+    {
+      progressCondition.wait( &progressMutex );
+      const int done = processed;
+      progressMutex.unlock();
+      feedback->setProgress( 100.0 * done / tiles.size() );
+      progressMutex.lock();
+    }
+    progressMutex.unlock();
+    future.waitForFinished();
+    QObject::disconnect( cancelConnection );
+  }
+
+  for ( int tileIndex : qgis::as_const( tiles ) )
+  {
+    mTileWritten[ tileIndex ] = true;
+    mTilePoints[ tileIndex ].clear();
+  }
+  mPoints.clear();
+  mPendingTilePoints = 0;
+
+  return !ioError && !canceled;
+}
 
-        double distance = std::sqrt( std::pow( pixelCentroidX - ( *pointIt ).x(), 2.0 ) + std::pow( pixelCentroidY - ( *pointIt ).y(), 2.0 ) );
+void QgsKernelDensityEstimation::accumulateTile( const std::vector< quint32 > &points, int xOffset, int yOffset, int width, int height, float *tile ) const
+{
+  for ( quint32 pointIndex : points )
+  {
+    const KernelPoint &point = mPoints[ pointIndex ];
+    const int blockSize = 2 * point.buffer + 1;
+
+    // same pixel positions as the block covered by the kernel in addFeature()
+    unsigned int xPosition = ( ( point.x - mBounds.xMinimum() ) / mPixelSize ) - point.buffer;
+    unsigned int yPosition = ( ( point.y - mBounds.yMinimum() ) / mPixelSize ) - point.buffer;
+    unsigned int yPositionIO = ( ( mBounds.yMaximum() - point.y ) / mPixelSize ) - point.buffer;
+
+    // part of the block inside the tile
+    const int firstXp = std::max( 0, xOffset - static_cast< int >( xPosition ) );
+    const int lastXp = std::min( blockSize, xOffset + width - static_cast< int >( xPosition ) );
+    const int firstYp = std::max( 0, yOffset - static_cast< int >( yPositionIO ) );
+    const int lastYp = std::min( blockSize, yOffset + height - static_cast< int >( yPositionIO ) );
+
+    for ( int yp = firstYp; yp < lastYp; yp++ )
+    {
+      const double pixelCentroidY = ( yPosition + yp + 0.5 ) * mPixelSize + mBounds.yMinimum();
+      const double dy2 = ( pixelCentroidY - point.y ) * ( pixelCentroidY - point.y );
+      float *tileRow = tile + static_cast< std::size_t >( static_cast< int >( yPositionIO ) + yp - yOffset ) * width;
+
+      for ( int xp = firstXp; xp < lastXp; xp++ )
+      {
+        const double pixelCentroidX = ( xPosition + xp + 0.5 ) * mPixelSize + mBounds.xMinimum();
+        const double distance = std::sqrt( ( pixelCentroidX - point.x ) * ( pixelCentroidX - point.x ) + dy2 );
 
         // is pixel outside search bandwidth of feature?
-        if ( distance > radius )
+        if ( distance > point.radius )
         {
           continue;
         }
 
-        double pixelValue = weight * calculateKernelValue( distance, radius, mShape, mOutputValues );
-        int pos = xp + blockSize * yp;
-        if ( dataBuffer[ pos ] == NO_DATA )
+        double pixelValue = point.weight * calculateKernelValue( distance, point.radius, mShape, mOutputValues );
+        float &value = tileRow[ static_cast< int >( xPosition ) + xp - xOffset ];
+        if ( value == NO_DATA )
         {
-          dataBuffer[ pos ] = 0;
+          value = 0;
         }
-        dataBuffer[ pos ] += pixelValue;
+        value += pixelValue;
       }
     }
-    if ( GDALRasterIO( mRasterBandH, GF_Write, xPosition, yPositionIO, blockSize, blockSize,
-                       dataBuffer, blockSize, blockSize, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      result = RasterIoError;
-    }
-    CPLFree( dataBuffer );
   }
-
-  return result;
-}
-
-QgsKernelDensityEstimation::Result QgsKernelDensityEstimation::finalise()
-{
-  mDatasetH.reset();
-  mRasterBandH = nullptr;
-  return Success;
 }
 
 int QgsKernelDensityEstimation::radiusSizeInPixels( double radius ) const
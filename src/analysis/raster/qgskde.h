@@ -19,6 +19,7 @@
 #include "qgsrectangle.h"
 #include "qgsogrutils.h"
 #include <QString>
+#include <vector>
 
 // GDAL includes
 #include <gdal.h>
@@ -28,6 +29,7 @@
 
 class QgsFeatureSource;
 class QgsFeature;
+class QgsFeedback;
 
 
 /**
@@ -65,6 +67,7 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
       InvalidParameters, //!< Input parameters were not valid
       FileCreationError, //!< Error creating output file
       RasterIoError, //!< Error writing to raster
+      Canceled, //!< Calculation was canceled (since QGIS 3.10)
     };
 
     //! KDE parameters
@@ -122,20 +125,38 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
 
     /**
      * Adds a single feature to the KDE surface. prepare() must be called before adding features.
+     *
+     * The feature's points are only collected by this method, the surface is calculated
+     * and written to the output file by finalise().
      * \see prepare()
      * \see finalise()
      */
     Result addFeature( const QgsFeature &feature );
 
     /**
-     * Finalises the output file. Must be called after adding all features via addFeature().
+     * Calculates the surface from all the features added via addFeature() and writes
+     * it to the output file. Must be called after adding all features via addFeature().
+     *
+     * The optional \a feedback is used to report progress and to cancel the calculation.
+     * When canceled, Canceled is returned and the output file is incomplete.
      * \see prepare()
      * \see addFeature()
      */
-    Result finalise();
+    Result finalise( QgsFeedback *feedback = nullptr );
 
   private:
 
+    //! A point added to the surface, with the kernel to apply around it
+    struct KernelPoint
+    {
+      double x;
+      double y;
+      double radius;
+      double weight;
+      //! Kernel radius, in pixels
+      int buffer;
+    };
+
     //! Calculate the value given to a point width a given distance for a specified kernel shape
     double calculateKernelValue( double distance, double bandwidth, KernelShape shape, OutputValues outputType ) const;
     //! Uniform kernel function
@@ -171,6 +192,32 @@ class ANALYSIS_EXPORT QgsKernelDensityEstimation
     gdal::dataset_unique_ptr mDatasetH;
     GDALRasterBandH mRasterBandH;
 
+    int mRows = 0;
+    int mColumns = 0;
+    int mTileRows = 0;
+    int mTileColumns = 0;
+
+    //! Points added since their kernels were last accumulated to the output
+    std::vector< KernelPoint > mPoints;
+
+    //! Indexes in mPoints of the points whose kernels overlap each output tile, in the order they were added
+    std::vector< std::vector< quint32 > > mTilePoints;
+
+    //! Number of point indexes in mTilePoints
+    std::size_t mPendingTilePoints = 0;
+
+    //! TRUE for the output tiles which already contain accumulated kernels
+    std::vector< bool > mTileWritten;
+
+    //! Adds the kernels of the \a points to the \a tile buffer, covering \a width by \a height pixels from pixel \a xOffset, \a yOffset of the output
+    void accumulateTile( const std::vector< quint32 > &points, int xOffset, int yOffset, int width, int height, float *tile ) const;
+
+    /**
+     * Accumulates the kernels of the pending points to the output tiles and clears them.
+     * Returns FALSE if the output could not be read or written, or if the \a feedback was canceled.
+     */
+    bool accumulateTiles( QgsFeedback *feedback );
+
     //! Creates a new raster layer and initializes it to the no data value
     bool createEmptyLayer( GDALDriverH driver, const QgsRectangle &bounds, int rows, int columns ) const;
     int radiusSizeInPixels( double radius ) const;
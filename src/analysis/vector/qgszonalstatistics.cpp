@@ -204,139 +204,153 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
     return 8;
   }
 
+  bool statsStoreValues = ( mStatistics & QgsZonalStatistics::Median ) ||
+                          ( mStatistics & QgsZonalStatistics::StDev ) ||
+                          ( mStatistics & QgsZonalStatistics::Variance );
+  bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
+                              ( mStatistics & QgsZonalStatistics::Majority );
+
   //progress dialog
   long featureCount = vectorProvider->featureCount();
 
-  //iterate over each polygon
+  //zones are collected in chunks, statistics are then calculated for all zones of a chunk in parallel
+  const int zoneChunkSize = 10000;
   QgsFeatureRequest request;
   request.setNoAttributes();
   request.setDestinationCrs( mRasterCrs, QgsProject::instance()->transformContext() );
   QgsFeatureIterator fi = vectorProvider->getFeatures( request );
   QgsFeature f;
-
-  bool statsStoreValues = ( mStatistics & QgsZonalStatistics::Median ) ||
-                          ( mStatistics & QgsZonalStatistics::StDev ) ||
-                          ( mStatistics & QgsZonalStatistics::Variance );
-  bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
-                              ( mStatistics & QgsZonalStatistics::Majority );
-
-  FeatureStats featureStats( statsStoreValues, statsStoreValueCount );
   int featureCounter = 0;
 
   QgsChangedAttributesMap changeMap;
-  while ( fi.nextFeature( f ) )
+  bool atEnd = false;
+  while ( !atEnd )
   {
-    if ( feedback && feedback->isCanceled() )
+    const int chunkStartCounter = featureCounter;
+    QVector< QgsFeatureId > zoneIds;
+    QVector< QgsGeometry > zones;
+    while ( zones.size() < zoneChunkSize )
     {
-      break;
-    }
+      if ( !fi.nextFeature( f ) )
+      {
+        atEnd = true;
+        break;
+      }
+      ++featureCounter;
 
-    if ( feedback )
-    {
-      feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
-    }
+      if ( !f.hasGeometry() )
+      {
+        continue;
+      }
+      QgsGeometry featureGeometry = f.geometry();
 
-    if ( !f.hasGeometry() )
-    {
-      ++featureCounter;
-      continue;
+      QgsRectangle featureRect = featureGeometry.boundingBox().intersect( rasterBBox );
+      if ( featureRect.isEmpty() )
+      {
+        continue;
+      }
+
+      zoneIds.append( f.id() );
+      zones.append( featureGeometry );
     }
-    QgsGeometry featureGeometry = f.geometry();
 
-    QgsRectangle featureRect = featureGeometry.boundingBox().intersect( rasterBBox );
-    if ( featureRect.isEmpty() )
+    if ( feedback && feedback->isCanceled() )
     {
-      ++featureCounter;
-      continue;
+      break;
     }
 
-    int nCellsX, nCellsY;
-    QgsRectangle rasterBlockExtent;
-    QgsRasterAnalysisUtils::cellInfoForBBox( rasterBBox, featureRect, mCellSizeX, mCellSizeY, nCellsX, nCellsY, nCellsXProvider, nCellsYProvider, rasterBlockExtent );
-
-    featureStats.reset();
-    QgsRasterAnalysisUtils::statisticsFromMiddlePointTest( mRasterInterface, mRasterBand, featureGeometry, nCellsX, nCellsY, mCellSizeX, mCellSizeY,
-    rasterBlockExtent, [ &featureStats ]( double value ) { featureStats.addValue( value ); } );
+    // each zone is accessed by a single thread only
+    std::vector< FeatureStats > zoneStats( static_cast< std::size_t >( zones.size() ), FeatureStats( statsStoreValues, statsStoreValueCount ) );
+    QgsRasterAnalysisUtils::statisticsForZones( mRasterInterface, mRasterBand, rasterBBox, mCellSizeX, mCellSizeY, nCellsXProvider, nCellsYProvider, zones,
+        [ &zoneStats ]( int zone, double value, double weight ) { zoneStats[zone].addValue( value, weight ); },
+        [ &zoneStats ]( int zone ) { zoneStats[zone].reset(); },
+        2, true, feedback,
+        [ = ]( int processed )
+    {
+      if ( feedback && featureCount > 0 )
+        feedback->setProgress( 100.0 * static_cast< double >( chunkStartCounter + processed ) / featureCount );
+    } );
 
-    if ( featureStats.count <= 1 )
+    if ( feedback && feedback->isCanceled() )
     {
-      //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
-      featureStats.reset();
-      QgsRasterAnalysisUtils::statisticsFromPreciseIntersection( mRasterInterface, mRasterBand, featureGeometry, nCellsX, nCellsY, mCellSizeX, mCellSizeY,
-      rasterBlockExtent, [ &featureStats ]( double value, double weight ) { featureStats.addValue( value, weight ); } );
+      break;
     }
 
-    //write the statistics value to the vector data provider
-    QgsAttributeMap changeAttributeMap;
-    if ( mStatistics & QgsZonalStatistics::Count )
-      changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
-    if ( mStatistics & QgsZonalStatistics::Sum )
-      changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
-    if ( featureStats.count > 0 )
+    for ( int zone = 0; zone < zones.size(); ++zone )
     {
-      double mean = featureStats.sum / featureStats.count;
-      if ( mStatistics & QgsZonalStatistics::Mean )
-        changeAttributeMap.insert( meanIndex, QVariant( mean ) );
-      if ( mStatistics & QgsZonalStatistics::Median )
+      FeatureStats &featureStats = zoneStats[zone];
+
+      //write the statistics value to the vector data provider
+      QgsAttributeMap changeAttributeMap;
+      if ( mStatistics & QgsZonalStatistics::Count )
+        changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
+      if ( mStatistics & QgsZonalStatistics::Sum )
+        changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
+      if ( featureStats.count > 0 )
       {
-        std::sort( featureStats.values.begin(), featureStats.values.end() );
-        int size = featureStats.values.count();
-        bool even = ( size % 2 ) < 1;
-        double medianValue;
-        if ( even )
+        double mean = featureStats.sum / featureStats.count;
+        if ( mStatistics & QgsZonalStatistics::Mean )
+          changeAttributeMap.insert( meanIndex, QVariant( mean ) );
+        if ( mStatistics & QgsZonalStatistics::Median )
         {
-          medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
+          std::sort( featureStats.values.begin(), featureStats.values.end() );
+          int size = featureStats.values.count();
+          bool even = ( size % 2 ) < 1;
+          double medianValue;
+          if ( even )
+          {
+            medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
+          }
+          else //odd
+          {
+            medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
+          }
+          changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
         }
-        else //odd
+        if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
         {
-          medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
+          double sumSquared = 0;
+          for ( int i = 0; i < featureStats.values.count(); ++i )
+          {
+            double diff = featureStats.values.at( i ) - mean;
+            sumSquared += diff * diff;
+          }
+          double variance = sumSquared / featureStats.values.count();
+          if ( mStatistics & QgsZonalStatistics::StDev )
+          {
+            double stdev = std::pow( variance, 0.5 );
+            changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
+          }
+          if ( mStatistics & QgsZonalStatistics::Variance )
+            changeAttributeMap.insert( varianceIndex, QVariant( variance ) );
         }
-        changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
-      }
-      if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
-      {
-        double sumSquared = 0;
-        for ( int i = 0; i < featureStats.values.count(); ++i )
-        {
-          double diff = featureStats.values.at( i ) - mean;
-          sumSquared += diff * diff;
-        }
-        double variance = sumSquared / featureStats.values.count();
-        if ( mStatistics & QgsZonalStatistics::StDev )
+        if ( mStatistics & QgsZonalStatistics::Min )
+          changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
+        if ( mStatistics & QgsZonalStatistics::Max )
+          changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
+        if ( mStatistics & QgsZonalStatistics::Range )
+          changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
+        if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
         {
-          double stdev = std::pow( variance, 0.5 );
-          changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
+          QList<int> vals = featureStats.valueCount.values();
+          std::sort( vals.begin(), vals.end() );
+          if ( mStatistics & QgsZonalStatistics::Minority )
+          {
+            double minorityKey = featureStats.valueCount.key( vals.first() );
+            changeAttributeMap.insert( minorityIndex, QVariant( minorityKey ) );
+          }
+          if ( mStatistics & QgsZonalStatistics::Majority )
+          {
+            double majKey = featureStats.valueCount.key( vals.last() );
+            changeAttributeMap.insert( majorityIndex, QVariant( majKey ) );
+          }
         }
-        if ( mStatistics & QgsZonalStatistics::Variance )
-          changeAttributeMap.insert( varianceIndex, QVariant( variance ) );
+        if ( mStatistics & QgsZonalStatistics::Variety )
+          changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
       }
-      if ( mStatistics & QgsZonalStatistics::Min )
-        changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Max )
-        changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
-      if ( mStatistics & QgsZonalStatistics::Range )
-        changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
-      {
-        QList<int> vals = featureStats.valueCount.values();
-        std::sort( vals.begin(), vals.end() );
-        if ( mStatistics & QgsZonalStatistics::Minority )
-        {
-          double minorityKey = featureStats.valueCount.key( vals.first() );
-          changeAttributeMap.insert( minorityIndex, QVariant( minorityKey ) );
-        }
-        if ( mStatistics & QgsZonalStatistics::Majority )
-        {
-          double majKey = featureStats.valueCount.key( vals.last() );
-          changeAttributeMap.insert( majorityIndex, QVariant( majKey ) );
-        }
-      }
-      if ( mStatistics & QgsZonalStatistics::Variety )
-        changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
-    }
 
-    changeMap.insert( f.id(), changeAttributeMap );
-    ++featureCounter;
+      changeMap.insert( zoneIds.at( zone ), changeAttributeMap );
+    }
   }
 
   vectorProvider->changeAttributeValues( changeMap );
@@ -31,6 +31,9 @@
 #include "qgswkbtypes.h"
 #include "qgslogger.h"
 
+#include <cmath>
+#include <limits>
+
 std::unique_ptr<QgsAbstractGeometry> QgsGeometryFactory::geomFromWkb( QgsConstWkbPtr &wkbPtr )
 {
   if ( !wkbPtr )
@@ -136,6 +139,301 @@ std::unique_ptr<QgsAbstractGeometry> QgsGeometryFactory::geomFromWkt( const QStr
   return geom;
 }
 
+///@cond PRIVATE
+
+/**
+ * Reads a TWKB buffer, see https://github.com/TWKB/Specification
+ * Coordinates are delta encoded over a whole (multi) geometry, the delta state
+ * is reset by each geometry header.
+ */
+class QgsTwkbReader
+{
+  public:
+
+    explicit QgsTwkbReader( const QByteArray &twkb )
+      : mData( reinterpret_cast< const unsigned char * >( twkb.constData() ) )
+      , mEnd( mData + twkb.size() )
+    {}
+
+    std::unique_ptr< QgsAbstractGeometry > readGeometry()
+    {
+      unsigned char typeAndPrecision = 0;
+      unsigned char metadata = 0;
+      if ( !readByte( typeAndPrecision ) || !readByte( metadata ) )
+        return nullptr;
+
+      const int twkbType = typeAndPrecision & 0x0F;
+      const int precision = zigZagDecode( typeAndPrecision >> 4 );
+      const bool hasBoundingBox = metadata & 0x01;
+      const bool hasSize = metadata & 0x02;
+      const bool hasIdList = metadata & 0x04;
+      const bool hasExtendedDimensions = metadata & 0x08;
+      const bool isEmpty = metadata & 0x10;
+
+      mHasZ = false;
+      mHasM = false;
+      int precisionZ = 0;
+      int precisionM = 0;
+      if ( hasExtendedDimensions )
+      {
+        unsigned char extended = 0;
+        if ( !readByte( extended ) )
+          return nullptr;
+        mHasZ = extended & 0x01;
+        mHasM = extended & 0x02;
+        precisionZ = ( extended >> 2 ) & 0x07;
+        precisionM = ( extended >> 5 ) & 0x07;
+      }
+      mScale[0] = mScale[1] = std::pow( 10.0, -precision );
+      mScale[2] = mHasZ ? std::pow( 10.0, -precisionZ ) : std::pow( 10.0, -precisionM );
+      mScale[3] = std::pow( 10.0, -precisionM );
+      mDimensions = 2 + ( mHasZ ? 1 : 0 ) + ( mHasM ? 1 : 0 );
+      std::fill( std::begin( mLast ), std::end( mLast ), 0 );
+
+      quint64 unsignedValue = 0;
+      qint64 value = 0;
+      if ( hasSize && !readUnsignedVarInt( unsignedValue ) )
+        return nullptr;
+      if ( hasBoundingBox && !isEmpty )
+      {
+        // minimum and delta for each dimension, not needed to build the geometry
+        for ( int i = 0; i < 2 * mDimensions; ++i )
+        {
+          if ( !readVarInt( value ) )
+            return nullptr;
+        }
+      }
+
+      QgsWkbTypes::Type type = QgsWkbTypes::Unknown;
+      switch ( twkbType )
+      {
+        case 1:
+          type = QgsWkbTypes::Point;
+          break;
+        case 2:
+          type = QgsWkbTypes::LineString;
+          break;
+        case 3:
+          type = QgsWkbTypes::Polygon;
+          break;
+        case 4:
+          type = QgsWkbTypes::MultiPoint;
+          break;
+        case 5:
+          type = QgsWkbTypes::MultiLineString;
+          break;
+        case 6:
+          type = QgsWkbTypes::MultiPolygon;
+          break;
+        case 7:
+          type = QgsWkbTypes::GeometryCollection;
+          break;
+        default:
+          return nullptr;
+      }
+      if ( mHasZ )
+        type = QgsWkbTypes::addZ( type );
+      if ( mHasM )
+        type = QgsWkbTypes::addM( type );
+
+      if ( isEmpty )
+        return QgsGeometryFactory::geomFromWkbType( type );
+
+      switch ( twkbType )
+      {
+        case 1:
+          return readPoint();
+        case 2:
+          return readLineString();
+        case 3:
+          return readPolygon();
+        default:
+          break;
+      }
+
+      quint64 partCount = 0;
+      if ( !readUnsignedVarInt( partCount ) || partCount > remaining() )
+        return nullptr;
+      if ( hasIdList )
+      {
+        for ( quint64 i = 0; i < partCount; ++i )
+        {
+          if ( !readVarInt( value ) )
+            return nullptr;
+        }
+      }
+
+      std::unique_ptr< QgsGeometryCollection > collection = QgsGeometryFactory::createCollectionOfType( type );
+      if ( !collection )
+        return nullptr;
+      collection->reserve( static_cast< int >( partCount ) );
+      for ( quint64 i = 0; i < partCount; ++i )
+      {
+        std::unique_ptr< QgsAbstractGeometry > part;
+        switch ( twkbType )
+        {
+          case 4:
+            part = readPoint();
+            break;
+          case 5:
+            part = readLineString();
+            break;
+          case 6:
+            part = readPolygon();
+            break;
+          default:
+            // collection members are complete TWKB geometries
+            part = readGeometry();
+            break;
+        }
+        if ( !part || !collection->addGeometry( part.release() ) )
+          return nullptr;
+      }
+      return std::move( collection );
+    }
+
+  private:
+
+    static int zigZagDecode( quint64 value )
+    {
+      return static_cast< int >( value >> 1 ) ^ -static_cast< int >( value & 1 );
+    }
+
+    quint64 remaining() const
+    {
+      return static_cast< quint64 >( mEnd - mData );
+    }
+
+    bool readByte( unsigned char &value )
+    {
+      if ( mData >= mEnd )
+        return false;
+      value = *mData++;
+      return true;
+    }
+
+    bool readUnsignedVarInt( quint64 &value )
+    {
+      value = 0;
+      for ( int shift = 0; shift < 64; shift += 7 )
+      {
+        unsigned char byte = 0;
+        if ( !readByte( byte ) )
+          return false;
+        value |= static_cast< quint64 >( byte & 0x7F ) << shift;
+        if ( !( byte & 0x80 ) )
+          return true;
+      }
+      return false;
+    }
+
+    bool readVarInt( qint64 &value )
+    {
+      quint64 unsignedValue = 0;
+      if ( !readUnsignedVarInt( unsignedValue ) )
+        return false;
+      value = static_cast< qint64 >( unsignedValue >> 1 ) ^ -static_cast< qint64 >( unsignedValue & 1 );
+      return true;
+    }
+
+    bool readCoordinates( double *coordinates )
+    {
+      for ( int i = 0; i < mDimensions; ++i )
+      {
+        qint64 delta = 0;
+        if ( !readVarInt( delta ) )
+          return false;
+        mLast[i] += delta;
+        coordinates[i] = mLast[i] * mScale[i];
+      }
+      return true;
+    }
+
+    std::unique_ptr< QgsPoint > readPoint()
+    {
+      double coordinates[4] = { 0, 0, 0, 0 };
+      if ( !readCoordinates( coordinates ) )
+        return nullptr;
+
+      QgsWkbTypes::Type type = QgsWkbTypes::Point;
+      if ( mHasZ )
+        type = QgsWkbTypes::addZ( type );
+      if ( mHasM )
+        type = QgsWkbTypes::addM( type );
+      return qgis::make_unique< QgsPoint >( type, coordinates[0], coordinates[1],
+                                           mHasZ ? coordinates[2] : std::numeric_limits<double>::quiet_NaN(),
+                                           mHasM ? coordinates[mHasZ ? 3 : 2] : std::numeric_limits<double>::quiet_NaN() );
+    }
+
+    std::unique_ptr< QgsLineString > readLineString()
+    {
+      quint64 pointCount = 0;
+      // each coordinate takes at least one byte
+      if ( !readUnsignedVarInt( pointCount ) || pointCount * mDimensions > remaining() )
+        return nullptr;
+
+      const int count = static_cast< int >( pointCount );
+      QVector< double > x( count );
+      QVector< double > y( count );
+      QVector< double > z( mHasZ ? count : 0 );
+      QVector< double > m( mHasM ? count : 0 );
+      double coordinates[4] = { 0, 0, 0, 0 };
+      for ( int i = 0; i < count; ++i )
+      {
+        if ( !readCoordinates( coordinates ) )
+          return nullptr;
+        x[i] = coordinates[0];
+        y[i] = coordinates[1];
+        if ( mHasZ )
+          z[i] = coordinates[2];
+        if ( mHasM )
+          m[i] = coordinates[mHasZ ? 3 : 2];
+      }
+      return qgis::make_unique< QgsLineString >( x, y, z, m );
+    }
+
+    std::unique_ptr< QgsPolygon > readPolygon()
+    {
+      quint64 ringCount = 0;
+      if ( !readUnsignedVarInt( ringCount ) || ringCount > remaining() )
+        return nullptr;
+
+      std::unique_ptr< QgsPolygon > polygon = qgis::make_unique< QgsPolygon >();
+      for ( quint64 i = 0; i < ringCount; ++i )
+      {
+        std::unique_ptr< QgsLineString > ring = readLineString();
+        if ( !ring )
+          return nullptr;
+        if ( i == 0 )
+          polygon->setExteriorRing( ring.release() );
+        else
+          polygon->addInteriorRing( ring.release() );
+      }
+      return polygon;
+    }
+
+    const unsigned char *mData = nullptr;
+    const unsigned char *mEnd = nullptr;
+    bool mHasZ = false;
+    bool mHasM = false;
+    int mDimensions = 2;
+    double mScale[4] = { 1, 1, 1, 1 };
+    qint64 mLast[4] = { 0, 0, 0, 0 };
+};
+
+///@endcond
+
+std::unique_ptr<QgsAbstractGeometry> QgsGeometryFactory::geomFromTwkb( const QByteArray &twkb )
+{
+  QgsTwkbReader reader( twkb );
+  std::unique_ptr< QgsAbstractGeometry > geom = reader.readGeometry();
+  if ( !geom )
+  {
+    QgsDebugMsg( QStringLiteral( "Invalid TWKB" ) );
+  }
+  return geom;
+}
+
 std::unique_ptr< QgsAbstractGeometry > QgsGeometryFactory::fromPointXY( const QgsPointXY &point )
 {
   return qgis::make_unique< QgsPoint >( point.x(), point.y() );
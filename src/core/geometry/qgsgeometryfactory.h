@@ -22,6 +22,7 @@
 
 #include "qgis_core.h"
 #include "qgswkbtypes.h"
+#include <QByteArray>
 #include <QString>
 #include <memory>
 
@@ -65,6 +66,15 @@ class CORE_EXPORT QgsGeometryFactory
      */
     static std::unique_ptr< QgsAbstractGeometry > geomFromWkt( const QString &text );
 
+    /**
+     * Construct geometry from a TWKB (Tiny Well-known Binary) \a twkb, as
+     * returned by PostGIS ST_AsTWKB. Coordinates are scaled back from the
+     * precisions encoded in the TWKB header.
+     * Returns nullptr if \a twkb is not a valid TWKB.
+     * \since QGIS 3.10
+     */
+    static std::unique_ptr< QgsAbstractGeometry > geomFromTwkb( const QByteArray &twkb );
+
     //! Construct geometry from a point
     static std::unique_ptr< QgsAbstractGeometry > fromPointXY( const QgsPointXY &point );
     //! Construct geometry from a multipoint
@@ -972,6 +972,15 @@ QgsFeatureIterator QgsProcessingFeatureSource::getFeatures( const QgsFeatureRequ
   return mSource->getFeatures( req );
 }
 
+QList< QgsFeatureIterator > QgsProcessingFeatureSource::getParallelFeatures( const QgsFeatureRequest &request, int count ) const
+{
+  QgsFeatureRequest req( request );
+  req.setInvalidGeometryCheck( mInvalidGeometryCheck );
+  req.setInvalidGeometryCallback( mInvalidGeometryCallback );
+  req.setTransformErrorCallback( mTransformErrorCallback );
+  return mSource->getParallelFeatures( req, count );
+}
+
 QgsCoordinateReferenceSystem QgsProcessingFeatureSource::sourceCrs() const
 {
   return mSource->sourceCrs();
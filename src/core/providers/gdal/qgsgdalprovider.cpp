@@ -869,8 +869,68 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &extent, int pi
     tmpHeight = static_cast<int>( std::round( -1.*srcHeight * srcYRes / yRes ) );
   }
 
+  GDALRasterBandH gdalBand = getBand( bandNo );
+  GDALDataType type = static_cast<GDALDataType>( mGdalDataType.at( bandNo - 1 ) );
+
+  // Window to be read from the band (or its overview)
+  GDALRasterBandH readBand = gdalBand;
+  int readLeft = srcLeft;
+  int readTop = srcTop;
+  int readWidth = srcWidth;
+  int readHeight = srcHeight;
+
   double tmpXMin = mExtent.xMinimum() + srcLeft * srcXRes;
   double tmpYMax = mExtent.yMaximum() + srcTop * srcYRes;
+  double tmpXRes = srcXRes;
+  double tmpYRes = srcYRes; // negative
+
+  if ( tmpWidth < srcWidth || tmpHeight < srcHeight )
+  {
+    // We are zoomed out. Instead of leaving the overview choice to GDALRasterIO(),
+    // which may pick an overview coarser than requested or read the full resolution
+    // band, we select the overview explicitly, i.e. only the blocks covering the window
+    // of that overview are read. The resampling to the requested grid is done below.
+    GDALRasterBandH ovrBand = overviewForResolution( gdalBand, xRes, yRes, srcXRes, srcYRes );
+    if ( ovrBand != gdalBand )
+    {
+      const int ovrXSize = GDALGetRasterBandXSize( ovrBand );
+      const int ovrYSize = GDALGetRasterBandYSize( ovrBand );
+      const double ovrXFactor = static_cast<double>( xSize() ) / ovrXSize;
+      const double ovrYFactor = static_cast<double>( ySize() ) / ovrYSize;
+
+      const int ovrLeft = std::max( 0, static_cast<int>( std::floor( srcLeft / ovrXFactor ) ) );
+      const int ovrTop = std::max( 0, static_cast<int>( std::floor( srcTop / ovrYFactor ) ) );
+      const int ovrRight = std::min( ovrXSize - 1, static_cast<int>( std::ceil( ( srcRight + 1 ) / ovrXFactor ) ) - 1 );
+      const int ovrBottom = std::min( ovrYSize - 1, static_cast<int>( std::ceil( ( srcBottom + 1 ) / ovrYFactor ) ) - 1 );
+
+      if ( ovrRight >= ovrLeft && ovrBottom >= ovrTop )
+      {
+        readBand = ovrBand;
+        readLeft = ovrLeft;
+        readTop = ovrTop;
+        readWidth = ovrRight - ovrLeft + 1;
+        readHeight = ovrBottom - ovrTop + 1;
+        const double ovrXRes = srcXRes * ovrXFactor;
+        const double ovrYRes = srcYRes * ovrYFactor; // negative
+        tmpXMin = mExtent.xMinimum() + readLeft * ovrXRes;
+        tmpYMax = mExtent.yMaximum() + readTop * ovrYRes;
+        // The overview may still be much finer than requested, its window is read
+        // downsampled to the requested resolution so that the temporary block is
+        // not larger than needed
+        tmpWidth = qBound( 1, static_cast<int>( std::round( readWidth * ovrXRes / xRes ) ), readWidth );
+        tmpHeight = qBound( 1, static_cast<int>( std::round( -1. * readHeight * ovrYRes / yRes ) ), readHeight );
+        tmpXRes = readWidth * ovrXRes / tmpWidth;
+        tmpYRes = readHeight * ovrYRes / tmpHeight;
+      }
+    }
+    if ( readBand == gdalBand )
+    {
+      // No suitable overview, GDALRasterIO() will downsample
+      tmpXRes = srcWidth * srcXRes / tmpWidth;
+      tmpYRes = srcHeight * srcYRes / tmpHeight;
+    }
+  }
+
   QgsDebugMsgLevel( QStringLiteral( "tmpXMin = %1 tmpYMax = %2 tmpWidth = %3 tmpHeight = %4" ).arg( tmpXMin ).arg( tmpYMax ).arg( tmpWidth ).arg( tmpHeight ), 5 );
 
   // Allocate temporary block
@@ -890,12 +950,10 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &extent, int pi
     QgsDebugMsgLevel( QStringLiteral( "Couldn't allocate temporary buffer of %1 bytes" ).arg( dataSize * tmpWidth * tmpHeight ), 5 );
     return false;
   }
-  GDALRasterBandH gdalBand = getBand( bandNo );
-  GDALDataType type = static_cast<GDALDataType>( mGdalDataType.at( bandNo - 1 ) );
   CPLErrorReset();
 
-  CPLErr err = gdalRasterIO( gdalBand, GF_Read,
-                             srcLeft, srcTop, srcWidth, srcHeight,
+  CPLErr err = gdalRasterIO( readBand, GF_Read,
+                             readLeft, readTop, readWidth, readHeight,
                              static_cast<void *>( tmpBlock ),
                              tmpWidth, tmpHeight, type,
                              0, 0, feedback );
@@ -911,13 +969,30 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &extent, int pi
     return false;
   }
 
-  double tmpXRes = srcWidth * srcXRes / tmpWidth;
-  double tmpYRes = srcHeight * srcYRes / tmpHeight; // negative
+#ifdef QGISDEBUG
+  {
+    // Report how many native blocks of the band (or overview) were touched by the read
+    int blockXSize = 0;
+    int blockYSize = 0;
+    GDALGetBlockSize( readBand, &blockXSize, &blockYSize );
+    if ( blockXSize > 0 && blockYSize > 0 )
+    {
+      const int blockCols = ( readLeft + readWidth - 1 ) / blockXSize - readLeft / blockXSize + 1;
+      const int blockRows = ( readTop + readHeight - 1 ) / blockYSize - readTop / blockYSize + 1;
+      const qint64 bytes = static_cast<qint64>( blockCols ) * blockRows * blockXSize * blockYSize * GDALGetDataTypeSizeBytes( GDALGetRasterDataType( readBand ) );
+      QgsDebugMsgLevel( QStringLiteral( "read %1 x %2 pixels from %3 (%4 blocks, %5 bytes)" )
+                        .arg( readWidth ).arg( readHeight )
+                        .arg( readBand == gdalBand ? QStringLiteral( "band" ) : QStringLiteral( "overview %1 x %2" ).arg( GDALGetRasterBandXSize( readBand ) ).arg( GDALGetRasterBandYSize( readBand ) ) )
+                        .arg( blockCols * blockRows ).arg( bytes ), 4 );
+    }
+  }
+#endif
 
   double y = rasterExtent.yMaximum() - 0.5 * yRes;
   for ( int row = 0; row < height; row++ )
   {
     int tmpRow = static_cast<int>( std::floor( -1. * ( tmpYMax - y ) / tmpYRes ) );
+    tmpRow = qBound( 0, tmpRow, tmpHeight - 1 );
 
     char *srcRowBlock = tmpBlock + dataSize * tmpRow * tmpWidth;
     char *dstRowBlock = ( char * )data + dataSize * ( top + row ) * pixelWidth;
@@ -932,7 +1007,7 @@ bool QgsGdalProvider::readBlock( int bandNo, QgsRectangle  const &extent, int pi
     for ( int col = 0; col < width; ++col )
     {
       // std::floor() is quite slow! Use just cast to int.
-      tmpCol = static_cast<int>( x );
+      tmpCol = std::min( static_cast<int>( x ), tmpWidth - 1 );
       if ( tmpCol > lastCol )
       {
         src += ( tmpCol - lastCol ) * dataSize;
@@ -3168,6 +3243,39 @@ bool QgsGdalProvider::setEditable( bool enabled )
   return true;
 }
 
+GDALRasterBandH QgsGdalProvider::overviewForResolution( GDALRasterBandH band, double xRes, double yRes, double srcXRes, double srcYRes )
+{
+  GDALRasterBandH bestBand = band;
+  double bestRes = std::max( std::fabs( srcXRes ), std::fabs( srcYRes ) );
+  // the limiting resolution is the finer of the requested ones
+  const double targetRes = std::min( xRes, yRes );
+
+  const int bandXSize = GDALGetRasterBandXSize( band );
+  const int bandYSize = GDALGetRasterBandYSize( band );
+  const int count = gdalGetOverviewCount( band );
+  for ( int i = 0; i < count; i++ )
+  {
+    GDALRasterBandH ovrBand = GDALGetOverview( band, i );
+    if ( !ovrBand )
+      continue;
+    const int ovrXSize = GDALGetRasterBandXSize( ovrBand );
+    const int ovrYSize = GDALGetRasterBandYSize( ovrBand );
+    if ( ovrXSize <= 0 || ovrYSize <= 0 )
+      continue;
+
+    const double ovrXRes = std::fabs( srcXRes ) * bandXSize / ovrXSize;
+    const double ovrYRes = std::fabs( srcYRes ) * bandYSize / ovrYSize;
+    const double ovrRes = std::max( ovrXRes, ovrYRes );
+    // overviews are not necessarily ordered by resolution
+    if ( ovrRes <= targetRes && ovrRes > bestRes )
+    {
+      bestBand = ovrBand;
+      bestRes = ovrRes;
+    }
+  }
+  return bestBand;
+}
+
 GDALRasterBandH QgsGdalProvider::getBand( int bandNo ) const
 {
   QMutexLocker locker( mpMutex );
@@ -302,6 +302,13 @@ class QgsGdalProvider : public QgsRasterDataProvider, QgsGdalProviderBase
     //! Wrapper for GDALGetRasterBand() that takes into account mMaskBandExposedAsAlpha.
     GDALRasterBandH getBand( int bandNo ) const;
 
+    /**
+     * Returns the overview of \a band with the lowest resolution which is still at least
+     * as fine as the requested resolution \a xRes / \a yRes, or \a band itself if
+     * no overview is suitable.
+     */
+    static GDALRasterBandH overviewForResolution( GDALRasterBandH band, double xRes, double yRes, double srcXRes, double srcYRes );
+
     //! \brief Close data set and release related data
     void closeDataset();
 
@@ -21,6 +21,9 @@
 #include <gdal.h>
 #include "qgis_sip.h"
 
+#include <QFileInfo>
+#include <QThread>
+
 ///@cond PRIVATE
 #define SIP_NO_FILE
 
@@ -67,11 +70,24 @@ class QgsOgrConnPoolGroup : public QObject, public QgsConnectionPoolGroup<QgsOgr
 
   public:
     explicit QgsOgrConnPoolGroup( const QString &name )
-      : QgsConnectionPoolGroup<QgsOgrConn*>( name )
+      : QgsConnectionPoolGroup<QgsOgrConn*>( name, maxConcurrentConnections( name ) )
     {
       initTimer( this );
     }
 
+    /**
+     * Returns the maximum number of connections acquired at a time for the connection \a name.
+     * Local files, and in particular GeoPackages whose layers all share the pool of the
+     * file, get one read-only dataset per thread, so that concurrent iterators, e.g. of
+     * layers rendered in parallel, do not wait for each other.
+     */
+    static int maxConcurrentConnections( const QString &name )
+    {
+      if ( QFileInfo( name.left( name.indexOf( QLatin1String( "|" ) ) ) ).isFile() )
+        return std::max( QgsApplication::instance()->maxConcurrentConnectionsPerPool(), QThread::idealThreadCount() );
+      return -1;
+    }
+
     //! QgsOgrConnPoolGroup cannot be copied
     QgsOgrConnPoolGroup( const QgsOgrConnPoolGroup &other ) = delete;
 
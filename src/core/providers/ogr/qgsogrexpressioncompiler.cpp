@@ -17,6 +17,7 @@
 ///@cond PRIVATE
 
 #include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionfunction.h"
 #include "qgsogrprovider.h"
 
 QgsOgrExpressionCompiler::QgsOgrExpressionCompiler( QgsOgrFeatureSource *source )
@@ -73,6 +74,19 @@ QgsSqlExpressionCompiler::Result QgsOgrExpressionCompiler::compileNode( const Qg
     }
 
     case QgsExpressionNode::ntFunction:
+    {
+      const QgsExpressionNodeFunction *n = static_cast<const QgsExpressionNodeFunction *>( node );
+      QgsExpressionFunction *fd = QgsExpression::Functions()[n->fnIndex()];
+      if ( fd->name() == QLatin1String( "$id" ) )
+      {
+        // OGR SQL exposes the feature id as the FID special field
+        result = mSource->mFirstFieldIsFid ? quotedIdentifier( mSource->mFields.at( 0 ).name() ) : QStringLiteral( "FID" );
+        return Complete;
+      }
+      //other functions are not supported by OGR
+      return Fail;
+    }
+
     case QgsExpressionNode::ntCondition:
       //not support by OGR
       return Fail;
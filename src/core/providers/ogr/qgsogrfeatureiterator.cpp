@@ -30,6 +30,9 @@
 
 #include <QTextCodec>
 #include <QFile>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <QTimeZone>
 
 // using from provider:
 // - setRelevantFields(), mRelevantFieldsForNextFeature
@@ -40,6 +43,454 @@
 
 ///@cond PRIVATE
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+
+/**
+ * Reads the features of a layer in batches of columns, through the Arrow C stream
+ * interface of OGR. Values are decoded from the typed buffers of the columns and
+ * geometries from their WKB.
+ */
+class QgsOgrArrowReader
+{
+  public:
+
+    ~QgsOgrArrowReader()
+    {
+      releaseBatch();
+      if ( mSchema.release )
+        mSchema.release( &mSchema );
+      if ( mStream.release )
+        mStream.release( &mStream );
+    }
+
+    /**
+     * Opens the Arrow stream of \a layer, with its current filters and ignored fields.
+     * Returns nullptr if the stream cannot be opened or a column cannot be decoded
+     * into its field.
+     */
+    static std::unique_ptr< QgsOgrArrowReader > open( OGRLayerH layer, const QgsFields &fields, bool firstFieldIsFid, QTextCodec *encoding )
+    {
+      std::unique_ptr< QgsOgrArrowReader > reader( new QgsOgrArrowReader( fields, firstFieldIsFid, encoding ) );
+
+      // Date times keep the components stored in the layer, as the per-feature
+      // reads, instead of being converted to UTC
+      char **options = nullptr;
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,8,0)
+      options = CSLSetNameValue( options, "TIMEZONE", "unknown" );
+#endif
+      const bool opened = OGR_L_GetArrowStream( layer, &reader->mStream, options );
+      CSLDestroy( options );
+      if ( !opened || reader->mStream.get_schema( &reader->mStream, &reader->mSchema ) != 0 )
+      {
+        return nullptr;
+      }
+
+      const QByteArray fidColumn = EQUAL( OGR_L_GetFIDColumn( layer ), "" ) ? QByteArray( "OGC_FID" ) : QByteArray( OGR_L_GetFIDColumn( layer ) );
+      OGRFeatureDefnH featureDefn = OGR_L_GetLayerDefn( layer );
+      for ( int i = 0; i < static_cast< int >( reader->mSchema.n_children ); ++i )
+      {
+        const ArrowSchema *column = reader->mSchema.children[i];
+        const Format format = columnFormat( column );
+        if ( fidColumn == column->name && format >= Format::Int8 && format <= Format::UInt64 )
+        {
+          reader->mFidColumn = { i, -1, format };
+          continue;
+        }
+
+        const int ogrIndex = OGR_FD_GetFieldIndex( featureDefn, column->name );
+        if ( ogrIndex < 0 && reader->mGeometryColumn.index < 0 && ( format == Format::Binary || format == Format::LargeBinary ) )
+        {
+          reader->mGeometryColumn = { i, -1, format };
+          continue;
+        }
+
+        const int fieldIndex = ogrIndex + ( firstFieldIsFid ? 1 : 0 );
+        if ( ogrIndex < 0 || fieldIndex >= fields.count() || !canConvert( format, fields.at( fieldIndex ).type() ) )
+        {
+          QgsDebugMsgLevel( QStringLiteral( "Arrow column %1 with format %2 cannot be decoded" ).arg( column->name, column->format ), 2 );
+          return nullptr;
+        }
+#if GDAL_VERSION_NUM < GDAL_COMPUTE_VERSION(3,8,0)
+        // Without the TIMEZONE option date times with a time zone are converted
+        // to UTC, they are left to the per-feature reads
+        if ( format >= Format::TimestampSeconds && format <= Format::TimestampNanoseconds )
+        {
+          QgsDebugMsgLevel( QStringLiteral( "Arrow column %1 with format %2 is read per feature" ).arg( column->name, column->format ), 2 );
+          return nullptr;
+        }
+#endif
+        reader->mColumns.append( { i, fieldIndex, format, columnTimeZone( column, format ) } );
+      }
+
+      if ( reader->mFidColumn.index < 0 )
+        return nullptr;
+
+      return reader;
+    }
+
+    /**
+     * Reads the id, attributes and geometry of the next feature into \a feature.
+     * Returns false at the end of the stream.
+     */
+    bool nextFeature( QgsFeature &feature )
+    {
+      while ( !mBatch.release || mRow >= mBatch.length )
+      {
+        releaseBatch();
+        if ( mStream.get_next( &mStream, &mBatch ) != 0 )
+        {
+          QgsDebugMsg( QStringLiteral( "Error while reading the Arrow stream: %1" ).arg( mStream.get_last_error( &mStream ) ) );
+          return false;
+        }
+        // the end of the stream is a released array
+        if ( !mBatch.release )
+          return false;
+        mRow = 0;
+      }
+      const int64_t row = mBatch.offset + mRow++;
+
+      feature.setId( integerValue( mFidColumn, row ) );
+      feature.initAttributes( mFields.count() );
+      feature.setFields( mFields ); // allow name-based attribute lookups
+      if ( mFirstFieldIsFid )
+        feature.setAttribute( 0, static_cast< qint64 >( feature.id() ) );
+
+      for ( const Column &column : qgis::as_const( mColumns ) )
+      {
+        feature.setAttribute( column.field, value( column, row ) );
+      }
+
+      if ( mGeometryColumn.index >= 0 && !isNull( mGeometryColumn, row ) )
+      {
+        const QByteArray wkb = binaryValue( mGeometryColumn, row );
+        QgsGeometry geometry;
+        geometry.fromWkb( wkb );
+        if ( geometry.isNull() && !wkb.isEmpty() )
+        {
+          // geometry types without a QGIS equivalent (e.g. TIN) are converted by OGR
+          OGRGeometryH ogrGeometry = nullptr;
+          if ( OGR_G_CreateFromWkb( reinterpret_cast< const unsigned char * >( wkb.constData() ), nullptr, &ogrGeometry, wkb.size() ) == OGRERR_NONE )
+          {
+            geometry = QgsOgrUtils::ogrGeometryToQgsGeometry( ogrGeometry );
+            OGR_G_DestroyGeometry( ogrGeometry );
+          }
+        }
+        feature.setGeometry( geometry );
+      }
+      else
+      {
+        feature.clearGeometry();
+      }
+      return true;
+    }
+
+  private:
+
+    //! Arrow formats of the columns which can be decoded
+    enum class Format
+    {
+      Unsupported,
+      Int8,
+      UInt8,
+      Int16,
+      UInt16,
+      Int32,
+      UInt32,
+      Int64,
+      UInt64,
+      Boolean,
+      Float,
+      Double,
+      Utf8,
+      LargeUtf8,
+      Binary,
+      LargeBinary,
+      Date32,
+      Date64,
+      Time32Milliseconds,
+      TimestampSeconds,
+      TimestampMilliseconds,
+      TimestampMicroseconds,
+      TimestampNanoseconds,
+    };
+
+    struct Column
+    {
+      int index;
+      int field;
+      Format format;
+      //! Time zone of the wall clock time of timestamps, invalid for UTC or unknown time zones
+      QTimeZone timeZone;
+    };
+
+    QgsOgrArrowReader( const QgsFields &fields, bool firstFieldIsFid, QTextCodec *encoding )
+      : mFields( fields )
+      , mFirstFieldIsFid( firstFieldIsFid )
+      , mEncoding( encoding )
+    {
+      memset( &mStream, 0, sizeof( mStream ) );
+      memset( &mSchema, 0, sizeof( mSchema ) );
+      memset( &mBatch, 0, sizeof( mBatch ) );
+    }
+
+    static Format columnFormat( const ArrowSchema *column )
+    {
+      // dictionary encoded columns are not decoded
+      if ( column->dictionary )
+        return Format::Unsupported;
+
+      const QByteArray format( column->format );
+      if ( format == "c" )
+        return Format::Int8;
+      if ( format == "C" )
+        return Format::UInt8;
+      if ( format == "s" )
+        return Format::Int16;
+      if ( format == "S" )
+        return Format::UInt16;
+      if ( format == "i" )
+        return Format::Int32;
+      if ( format == "I" )
+        return Format::UInt32;
+      if ( format == "l" )
+        return Format::Int64;
+      if ( format == "L" )
+        return Format::UInt64;
+      if ( format == "b" )
+        return Format::Boolean;
+      if ( format == "f" )
+        return Format::Float;
+      if ( format == "g" )
+        return Format::Double;
+      if ( format == "u" )
+        return Format::Utf8;
+      if ( format == "U" )
+        return Format::LargeUtf8;
+      if ( format == "z" )
+        return Format::Binary;
+      if ( format == "Z" )
+        return Format::LargeBinary;
+      if ( format == "tdD" )
+        return Format::Date32;
+      if ( format == "tdm" )
+        return Format::Date64;
+      if ( format == "ttm" )
+        return Format::Time32Milliseconds;
+      // timestamps are followed by their time zone, e.g. "tsm:UTC"
+      if ( format.startsWith( "tss:" ) )
+        return Format::TimestampSeconds;
+      if ( format.startsWith( "tsm:" ) )
+        return Format::TimestampMilliseconds;
+      if ( format.startsWith( "tsu:" ) )
+        return Format::TimestampMicroseconds;
+      if ( format.startsWith( "tsn:" ) )
+        return Format::TimestampNanoseconds;
+      return Format::Unsupported;
+    }
+
+    /**
+     * Returns the time zone of the timestamps of \a column, given after the
+     * unit of their format, e.g. "tsm:+02:00". Timestamps are UTC times, except
+     * without time zone where they are the wall clock time.
+     */
+    static QTimeZone columnTimeZone( const ArrowSchema *column, Format format )
+    {
+      if ( format < Format::TimestampSeconds || format > Format::TimestampNanoseconds )
+        return QTimeZone();
+
+      const QByteArray timeZone = QByteArray( column->format ).mid( 4 );
+      if ( timeZone.isEmpty() || timeZone == "UTC" || timeZone == "Etc/UTC" )
+        return QTimeZone();
+
+      // fixed offsets, e.g. "+02:00"
+      const QRegularExpressionMatch match = QRegularExpression( QStringLiteral( "^([+-])(\\d\\d):?(\\d\\d)$" ) ).match( QString::fromLatin1( timeZone ) );
+      if ( match.hasMatch() )
+      {
+        const int offset = match.captured( 2 ).toInt() * 3600 + match.captured( 3 ).toInt() * 60;
+        return QTimeZone( match.captured( 1 ) == QLatin1String( "-" ) ? -offset : offset );
+      }
+      return QTimeZone( timeZone );
+    }
+
+    static bool canConvert( Format format, QVariant::Type type )
+    {
+      switch ( type )
+      {
+        case QVariant::Int:
+        case QVariant::LongLong:
+        case QVariant::Double:
+        case QVariant::Bool:
+          return format >= Format::Int8 && format <= Format::Double;
+        case QVariant::String:
+          return format == Format::Utf8 || format == Format::LargeUtf8;
+        case QVariant::ByteArray:
+          return format == Format::Binary || format == Format::LargeBinary;
+        case QVariant::Date:
+          return format == Format::Date32 || format == Format::Date64;
+        case QVariant::Time:
+          return format == Format::Time32Milliseconds;
+        case QVariant::DateTime:
+          return format >= Format::TimestampSeconds && format <= Format::TimestampNanoseconds;
+        default:
+          return false;
+      }
+    }
+
+    const ArrowArray *array( const Column &column ) const
+    {
+      return mBatch.children[column.index];
+    }
+
+    bool isNull( const Column &column, int64_t row ) const
+    {
+      const ArrowArray *a = array( column );
+      const uint8_t *validity = static_cast< const uint8_t * >( a->buffers[0] );
+      if ( a->null_count == 0 || !validity )
+        return false;
+      const int64_t i = a->offset + row;
+      return !( validity[i / 8] & ( 1 << ( i % 8 ) ) );
+    }
+
+    template <typename T>
+    T typedValue( const Column &column, int64_t row ) const
+    {
+      const ArrowArray *a = array( column );
+      return static_cast< const T * >( a->buffers[1] )[a->offset + row];
+    }
+
+    qint64 integerValue( const Column &column, int64_t row ) const
+    {
+      switch ( column.format )
+      {
+        case Format::Int8:
+          return typedValue< int8_t >( column, row );
+        case Format::UInt8:
+          return typedValue< uint8_t >( column, row );
+        case Format::Int16:
+          return typedValue< int16_t >( column, row );
+        case Format::UInt16:
+          return typedValue< uint16_t >( column, row );
+        case Format::Int32:
+          return typedValue< int32_t >( column, row );
+        case Format::UInt32:
+          return typedValue< uint32_t >( column, row );
+        case Format::Int64:
+          return typedValue< int64_t >( column, row );
+        case Format::UInt64:
+          return static_cast< qint64 >( typedValue< uint64_t >( column, row ) );
+        default:
+          return 0;
+      }
+    }
+
+    QByteArray binaryValue( const Column &column, int64_t row ) const
+    {
+      const ArrowArray *a = array( column );
+      const int64_t i = a->offset + row;
+      int64_t begin = 0;
+      int64_t end = 0;
+      if ( column.format == Format::LargeUtf8 || column.format == Format::LargeBinary )
+      {
+        begin = static_cast< const int64_t * >( a->buffers[1] )[i];
+        end = static_cast< const int64_t * >( a->buffers[1] )[i + 1];
+      }
+      else
+      {
+        begin = static_cast< const int32_t * >( a->buffers[1] )[i];
+        end = static_cast< const int32_t * >( a->buffers[1] )[i + 1];
+      }
+      return QByteArray( static_cast< const char * >( a->buffers[2] ) + begin, static_cast< int >( end - begin ) );
+    }
+
+    QVariant value( const Column &column, int64_t row ) const
+    {
+      if ( isNull( column, row ) )
+        return QVariant( QString() );
+
+      const QVariant::Type type = mFields.at( column.field ).type();
+      QVariant v;
+      switch ( column.format )
+      {
+        case Format::Boolean:
+        {
+          const ArrowArray *a = array( column );
+          const int64_t i = a->offset + row;
+          v = static_cast< bool >( static_cast< const uint8_t * >( a->buffers[1] )[i / 8] & ( 1 << ( i % 8 ) ) );
+          break;
+        }
+        case Format::Float:
+          v = static_cast< double >( typedValue< float >( column, row ) );
+          break;
+        case Format::Double:
+          v = typedValue< double >( column, row );
+          break;
+        case Format::Utf8:
+        case Format::LargeUtf8:
+        {
+          const QByteArray string = binaryValue( column, row );
+          return mEncoding ? mEncoding->toUnicode( string ) : QString::fromUtf8( string );
+        }
+        case Format::Binary:
+        case Format::LargeBinary:
+          return binaryValue( column, row );
+        case Format::Date32:
+          return QDate( 1970, 1, 1 ).addDays( typedValue< int32_t >( column, row ) );
+        case Format::Date64:
+          return QDate( 1970, 1, 1 ).addDays( typedValue< int64_t >( column, row ) / 86400000 );
+        case Format::Time32Milliseconds:
+          return QTime( 0, 0 ).addMSecs( typedValue< int32_t >( column, row ) );
+        case Format::TimestampSeconds:
+        case Format::TimestampMilliseconds:
+        case Format::TimestampMicroseconds:
+        case Format::TimestampNanoseconds:
+        {
+          qint64 msecs = typedValue< int64_t >( column, row );
+          if ( column.format == Format::TimestampSeconds )
+            msecs *= 1000;
+          else if ( column.format == Format::TimestampMicroseconds )
+            msecs /= 1000;
+          else if ( column.format == Format::TimestampNanoseconds )
+            msecs /= 1000000;
+          // like the per-feature reads, the wall clock time is kept without its time zone
+          QDateTime dateTime = QDateTime::fromMSecsSinceEpoch( msecs, Qt::UTC );
+          if ( column.timeZone.isValid() )
+            dateTime = dateTime.toTimeZone( column.timeZone );
+          return QDateTime( dateTime.date(), dateTime.time() );
+        }
+        default:
+          v = integerValue( column, row );
+          break;
+      }
+
+      // numbers are converted to the type of the field
+      if ( v.type() != type )
+        v.convert( type );
+      return v;
+    }
+
+    void releaseBatch()
+    {
+      if ( mBatch.release )
+        mBatch.release( &mBatch );
+      memset( &mBatch, 0, sizeof( mBatch ) );
+    }
+
+    QgsFields mFields;
+    bool mFirstFieldIsFid = false;
+    QTextCodec *mEncoding = nullptr;
+
+    ArrowArrayStream mStream;
+    ArrowSchema mSchema;
+    ArrowArray mBatch;
+    int64_t mRow = 0;
+
+    Column mFidColumn = { -1, -1, Format::Unsupported };
+    Column mGeometryColumn = { -1, -1, Format::Unsupported };
+    QVector< Column > mColumns;
+};
+
+#endif
+
 
 QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsOgrFeatureSource>( source, ownSource, request )
@@ -220,6 +671,18 @@ QgsOgrFeatureIterator::QgsOgrFeatureIterator( QgsOgrFeatureSource *source, bool
     OGR_L_SetAttributeFilter( mOgrLayer, nullptr );
   }
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  // drivers with a fast Arrow stream (e.g. GPKG, FlatGeobuf) return the features in batches
+  // of columns, which are decoded without building an OGRFeature for each feature
+  if ( !mSharedDS && QgsOgrProviderUtils::canDriverShareSameDatasetAmongLayers( mSource->mDriverName ) &&
+       mRequest.filterType() != QgsFeatureRequest::FilterFid && mRequest.filterType() != QgsFeatureRequest::FilterFids &&
+       mSource->mOgrGeometryTypeFilter == wkbUnknown )
+  {
+    const OGRwkbGeometryType layerType = wkbFlatten( OGR_L_GetGeomType( mOgrLayer ) );
+    mUseArrowStream = layerType != wkbUnknown && layerType != wkbGeometryCollection && layerType != wkbTriangle &&
+                      OGR_L_TestCapability( mOgrLayer, OLCFastGetArrowStream );
+  }
+#endif
 
   //start with first feature
   rewind();
@@ -340,6 +803,24 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
     return false;
   }
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  if ( mUseArrowStream )
+  {
+    if ( !mArrowReader )
+    {
+      mArrowReader = QgsOgrArrowReader::open( mOgrLayer, mSource->mFields, mFirstFieldIsFid, mSource->mEncoding );
+      if ( !mArrowReader )
+      {
+        // some columns cannot be decoded: read the features one by one
+        mUseArrowStream = false;
+        OGR_L_ResetReading( mOgrLayer );
+      }
+    }
+    if ( mArrowReader )
+      return fetchArrowFeature( feature );
+  }
+#endif
+
   gdal::ogr_feature_unique_ptr fet;
 
   // OSM layers (especially large ones) need the GDALDataset::GetNextFeature() call rather than OGRLayer::GetNextFeature()
@@ -363,10 +844,14 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
 
     while ( fet.reset( OGR_L_GetNextFeature( mOgrLayer ) ), fet )
     {
+      // Once fetched, the feature does not depend on the shared dataset anymore:
+      // convert it without blocking the other iterators of the transaction
+      locker.unlock();
       if ( checkFeature( fet, feature ) )
       {
         return true;
       }
+      locker.relock();
     }
   }
 
@@ -374,6 +859,44 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
   return false;
 }
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+bool QgsOgrFeatureIterator::fetchArrowFeature( QgsFeature &feature )
+{
+  while ( mArrowReader->nextFeature( feature ) )
+  {
+    if ( feature.hasGeometry() )
+    {
+      QgsGeometry geometry = feature.geometry();
+
+      // Insure that multipart datasets return multipart geometry
+      if ( QgsWkbTypes::isMultiType( mSource->mWkbType ) && !geometry.isMultipart() )
+      {
+        geometry.convertToMultiType();
+        feature.setGeometry( geometry );
+      }
+    }
+
+    if ( !mFilterRect.isNull() )
+    {
+      if ( !feature.hasGeometry() || feature.geometry().isEmpty() )
+        continue;
+      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect ? !feature.geometry().intersects( mFilterRect ) : !feature.geometry().boundingBoxIntersects( mFilterRect ) )
+        continue;
+    }
+
+    if ( !mFetchGeometry )
+      feature.clearGeometry();
+
+    feature.setValid( true );
+    geometryToDestinationCrs( feature, mTransform );
+    return true;
+  }
+
+  close();
+  return false;
+}
+#endif
+
 void QgsOgrFeatureIterator::resetReading()
 {
 #if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(2,2,0)
@@ -396,6 +919,11 @@ bool QgsOgrFeatureIterator::rewind()
   if ( mClosed || !mOgrLayer )
     return false;
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  // the stream is opened again by the next fetch
+  mArrowReader.reset();
+#endif
+
   resetReading();
 
   mFilterFidsIt = mFilterFids.begin();
@@ -406,6 +934,11 @@ bool QgsOgrFeatureIterator::rewind()
 
 bool QgsOgrFeatureIterator::close()
 {
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+  // the stream must be released before its layer
+  mArrowReader.reset();
+#endif
+
   if ( mSharedDS )
   {
     iteratorClosed();
@@ -33,6 +33,10 @@ class QgsOgrProvider;
 class QgsOgrDataset;
 using QgsOgrDatasetSharedPtr = std::shared_ptr< QgsOgrDataset>;
 
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+class QgsOgrArrowReader;
+#endif
+
 class QgsOgrFeatureSource : public QgsAbstractFeatureSource
 {
   public:
@@ -105,6 +109,17 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
     bool fetchFeatureWithId( QgsFeatureId id, QgsFeature &feature ) const;
 
     void resetReading();
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,6,0)
+    //! Fetches the next feature from the batches of columns of mArrowReader
+    bool fetchArrowFeature( QgsFeature &feature );
+
+    //! Sets to true, if the features are read in batches of columns through the Arrow C stream interface
+    bool mUseArrowStream = false;
+
+    //! Arrow C stream of the layer, opened by the first fetch
+    std::unique_ptr< QgsOgrArrowReader > mArrowReader;
+#endif
 };
 
 ///@endcond
@@ -1271,6 +1271,66 @@ QgsFeatureIterator QgsOgrProvider::getFeatures( const QgsFeatureRequest &request
   return QgsFeatureIterator( new QgsOgrFeatureIterator( static_cast<QgsOgrFeatureSource *>( featureSource() ), true, request ) );
 }
 
+QList<QgsFeatureIterator> QgsOgrProvider::getParallelFeatures( const QgsFeatureRequest &request, int count ) const
+{
+  // FID ranges are only read efficiently by the drivers with an indexed FID column.
+  // Attribute filters are not combined with the ranges, which would otherwise
+  // be evaluated locally when the filter cannot be compiled.
+  if ( !mValid || mTransaction || count <= 1 || request.limit() >= 0 ||
+       request.filterType() != QgsFeatureRequest::FilterNone ||
+       ( mGDALDriverName != QLatin1String( "GPKG" ) && mGDALDriverName != QLatin1String( "SQLite" ) ) )
+  {
+    return QgsVectorDataProvider::getParallelFeatures( request, count );
+  }
+
+  const QByteArray fidColumn( mOgrLayer->GetFIDColumn() );
+  if ( fidColumn.isEmpty() )
+  {
+    return QgsVectorDataProvider::getParallelFeatures( request, count );
+  }
+
+  QByteArray sql = "SELECT MIN(" + quotedIdentifier( fidColumn ) + "), MAX(" + quotedIdentifier( fidColumn ) + ")";
+  sql += " FROM " + quotedIdentifier( mOgrLayer->name() );
+  if ( !mSubsetString.isEmpty() )
+  {
+    sql += " WHERE " + textEncoding()->fromUnicode( mSubsetString );
+  }
+
+  QgsOgrLayerUniquePtr l = mOgrLayer->ExecuteSQL( sql );
+  gdal::ogr_feature_unique_ptr f( l ? l->GetNextFeature() : nullptr );
+  if ( !f || !OGR_F_IsFieldSetAndNotNull( f.get(), 0 ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Failed to execute SQL: %1" ).arg( textEncoding()->toUnicode( sql ) ) );
+    return QgsVectorDataProvider::getParallelFeatures( request, count );
+  }
+
+  const qint64 minFid = OGR_F_GetFieldAsInteger64( f.get(), 0 );
+  const qint64 span = OGR_F_GetFieldAsInteger64( f.get(), 1 ) - minFid;
+  const int rangeCount = static_cast<int>( std::min<qint64>( count, span ) );
+  if ( rangeCount <= 1 )
+  {
+    return QgsVectorDataProvider::getParallelFeatures( request, count );
+  }
+
+  // Each iterator acquires its own dataset from the connection pool.
+  // The first and last ranges are open, so that features added in the meantime are not missed
+  QList<QgsFeatureIterator> iterators;
+  QStringList filter;
+  for ( int i = 1; i <= rangeCount; ++i )
+  {
+    const qint64 bound = minFid + span / rangeCount * i;
+    if ( i < rangeCount )
+      filter << QStringLiteral( "$id < %1" ).arg( bound );
+
+    QgsFeatureRequest rangeRequest( request );
+    rangeRequest.setFilterExpression( filter.join( QStringLiteral( " AND " ) ) );
+    iterators << getFeatures( rangeRequest );
+
+    filter = QStringList() << QStringLiteral( "$id >= %1" ).arg( bound );
+  }
+  return iterators;
+}
+
 
 unsigned char *QgsOgrProvider::getGeometryPointer( OGRFeatureH fet )
 {
@@ -109,6 +109,7 @@ class QgsOgrProvider : public QgsVectorDataProvider
     QStringList subLayersWithoutFeatureCount() const;
     QString storageType() const override;
     QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) const override;
+    QList<QgsFeatureIterator> getParallelFeatures( const QgsFeatureRequest &request, int count ) const override;
     QString subsetString() const override;
     bool supportsSubsetString() const override { return true; }
     bool setSubsetString( const QString &theSQL, bool updateFeatureCount = true ) override;
@@ -66,9 +66,14 @@ class QgsConnectionPoolGroup
       QTime lastUsedTime;
     };
 
-    QgsConnectionPoolGroup( const QString &ci )
+    /**
+     * Constructor for QgsConnectionPoolGroup, for the connection \a ci.
+     * At most \a maxConcurrentConnections connections are acquired at a time, or
+     * QgsApplication::maxConcurrentConnectionsPerPool() if it is not positive.
+     */
+    QgsConnectionPoolGroup( const QString &ci, int maxConcurrentConnections = -1 )
       : connInfo( ci )
-      , sem( QgsApplication::instance()->maxConcurrentConnectionsPerPool() + CONN_POOL_SPARE_CONNECTIONS )
+      , sem( ( maxConcurrentConnections > 0 ? maxConcurrentConnections : QgsApplication::instance()->maxConcurrentConnectionsPerPool() ) + CONN_POOL_SPARE_CONNECTIONS )
     {
     }
 
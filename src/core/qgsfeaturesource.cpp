@@ -23,6 +23,12 @@
 #include "qgsvectorlayer.h"
 #include "qgsvectordataprovider.h"
 
+QList< QgsFeatureIterator > QgsFeatureSource::getParallelFeatures( const QgsFeatureRequest &request, int count ) const
+{
+  Q_UNUSED( count )
+  return QList< QgsFeatureIterator >() << getFeatures( request );
+}
+
 QgsFeatureSource::FeatureAvailability QgsFeatureSource::hasFeatures() const
 {
   return FeaturesMaybeAvailable;
@@ -63,6 +63,20 @@ class CORE_EXPORT QgsFeatureSource
      */
     virtual QgsFeatureIterator getFeatures( const QgsFeatureRequest &request = QgsFeatureRequest() ) const = 0;
 
+    /**
+     * Returns up to \a count iterators over disjoint subsets of the features matching
+     * \a request, which together return the same features as getFeatures().
+     * The iterators are independent and can be consumed concurrently from
+     * different threads, e.g. by feature-parallel algorithms.
+     *
+     * Features are not ordered across the iterators, the order by clauses of
+     * \a request only apply within each iterator. Requests with a limit are never split.
+     *
+     * The base class implementation returns a single iterator, as returned by getFeatures().
+     * \since QGIS 3.10
+     */
+    virtual QList< QgsFeatureIterator > getParallelFeatures( const QgsFeatureRequest &request, int count ) const;
+
     /**
      * Returns a friendly display name for the source. The returned value can be an empty string.
      */
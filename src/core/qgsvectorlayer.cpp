@@ -959,6 +959,21 @@ QgsFeatureIterator QgsVectorLayer::getFeatures( const QgsFeatureRequest &request
   return QgsFeatureIterator( new QgsVectorLayerFeatureIterator( new QgsVectorLayerFeatureSource( this ), true, request ) );
 }
 
+QList< QgsFeatureIterator > QgsVectorLayer::getParallelFeatures( const QgsFeatureRequest &request, int count ) const
+{
+  // the provider iterators are only used when they return the features of the layer
+  if ( !mValid || !mDataProvider ||
+       ( mEditBuffer && mEditBuffer->isModified() ) ||
+       mJoinBuffer->containsJoins() ||
+       !mExpressionFieldBuffer->expressions().isEmpty() ||
+       request.invalidGeometryCheck() != QgsFeatureRequest::GeometryNoCheck )
+  {
+    return QgsFeatureSource::getParallelFeatures( request, count );
+  }
+
+  return mDataProvider->getParallelFeatures( request, count );
+}
+
 QgsGeometry QgsVectorLayer::getGeometry( QgsFeatureId fid ) const
 {
   QgsFeature feature;
@@ -1090,6 +1090,20 @@ class CORE_EXPORT QgsVectorLayer : public QgsMapLayer, public QgsExpressionConte
      */
     QgsFeatureIterator getFeatures( const QgsFeatureRequest &request = QgsFeatureRequest() ) const FINAL;
 
+    /**
+     * Queries the layer for features specified in \a request through up to \a count
+     * independent iterators.
+     *
+     * The request is split by the data provider when the layer returns the features of the
+     * provider unchanged, i.e. without edits, joins or expression fields and when the
+     * request does not check the validity of the geometries. Otherwise a single iterator
+     * is returned.
+     *
+     * \see QgsFeatureSource::getParallelFeatures()
+     * \since QGIS 3.10
+     */
+    QList< QgsFeatureIterator > getParallelFeatures( const QgsFeatureRequest &request, int count ) const FINAL;
+
     /**
      * Queries the layer for features matching a given expression.
      */
@@ -0,0 +1,528 @@
+/***************************************************************************
+                              qgsvectortileencoder.cpp
+                              -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsvectortileencoder.h"
+#include "qgscurvepolygon.h"
+#include "qgsfeature.h"
+#include "qgsfeedback.h"
+#include "qgsgeometrycollection.h"
+#include "qgslinestring.h"
+#include "qgsmaptopixelgeometrysimplifier.h"
+#include "qgspoint.h"
+#include "qgsvectorlayer.h"
+
+#include <QPoint>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+///@cond PRIVATE
+namespace
+{
+  //! Half size of the Web Mercator square covered by the XYZ tiles
+  const double WEB_MERCATOR_HALF_SIZE = 20037508.3427892;
+
+  //! Field numbers of the MVT protobuf messages
+  enum TileField { TileLayers = 3 };
+  enum LayerField { LayerName = 1, LayerFeatures = 2, LayerKeys = 3, LayerValues = 4, LayerExtent = 5, LayerVersion = 15 };
+  enum FeatureField { FeatureId = 1, FeatureTags = 2, FeatureType = 3, FeatureGeometry = 4 };
+  enum ValueField { StringValue = 1, DoubleValue = 3, UIntValue = 5, SIntValue = 6, BoolValue = 7 };
+
+  //! MVT geometry types
+  enum GeomType { UnknownType = 0, PointType = 1, LineStringType = 2, PolygonType = 3 };
+
+  //! MVT geometry commands
+  enum Command { MoveTo = 1, LineTo = 2, ClosePath = 7 };
+
+  //! Minimal protobuf writer, only the wire types used by MVT
+  class ProtobufWriter
+  {
+    public:
+      void writeVarint( quint64 value )
+      {
+        while ( value >= 0x80 )
+        {
+          mData.append( static_cast<char>( ( value & 0x7f ) | 0x80 ) );
+          value >>= 7;
+        }
+        mData.append( static_cast<char>( value ) );
+      }
+
+      void writeUInt( int field, quint64 value )
+      {
+        writeKey( field, 0 );
+        writeVarint( value );
+      }
+
+      void writeSInt( int field, qint64 value )
+      {
+        writeKey( field, 0 );
+        writeVarint( ( static_cast<quint64>( value ) << 1 ) ^ static_cast<quint64>( value >> 63 ) );
+      }
+
+      void writeDouble( int field, double value )
+      {
+        writeKey( field, 1 );
+        quint64 bits;
+        std::memcpy( &bits, &value, sizeof( bits ) );
+        for ( int i = 0; i < 8; ++i )
+        {
+          mData.append( static_cast<char>( ( bits >> ( 8 * i ) ) & 0xff ) );
+        }
+      }
+
+      void writeBytes( int field, const QByteArray &bytes )
+      {
+        writeKey( field, 2 );
+        writeVarint( static_cast<quint64>( bytes.size() ) );
+        mData.append( bytes );
+      }
+
+      void writeString( int field, const QString &string )
+      {
+        writeBytes( field, string.toUtf8() );
+      }
+
+      void writePacked( int field, const std::vector<quint32> &values )
+      {
+        ProtobufWriter packed;
+        for ( quint32 value : values )
+        {
+          packed.writeVarint( value );
+        }
+        writeBytes( field, packed.data() );
+      }
+
+      void writeRaw( const QByteArray &bytes )
+      {
+        mData.append( bytes );
+      }
+
+      const QByteArray &data() const { return mData; }
+
+    private:
+      void writeKey( int field, int wireType )
+      {
+        writeVarint( static_cast<quint64>( field << 3 | wireType ) );
+      }
+
+      QByteArray mData;
+  };
+
+  quint32 zigzag( int value )
+  {
+    return ( static_cast<quint32>( value ) << 1 ) ^ static_cast<quint32>( value >> 31 );
+  }
+
+  QByteArray encodeValue( const QVariant &value )
+  {
+    ProtobufWriter writer;
+    switch ( value.type() )
+    {
+      case QVariant::Bool:
+        writer.writeUInt( BoolValue, value.toBool() ? 1 : 0 );
+        break;
+
+      case QVariant::Int:
+      case QVariant::LongLong:
+      {
+        const qint64 integer = value.toLongLong();
+        if ( integer < 0 )
+          writer.writeSInt( SIntValue, integer );
+        else
+          writer.writeUInt( UIntValue, static_cast<quint64>( integer ) );
+        break;
+      }
+
+      case QVariant::UInt:
+      case QVariant::ULongLong:
+        writer.writeUInt( UIntValue, value.toULongLong() );
+        break;
+
+      case QVariant::Double:
+        writer.writeDouble( DoubleValue, value.toDouble() );
+        break;
+
+      default:
+        writer.writeString( StringValue, value.toString() );
+        break;
+    }
+    return writer.data();
+  }
+
+  //! Encodes geometries to MVT commands in tile coordinates
+  class GeometryEncoder
+  {
+    public:
+      GeometryEncoder( const QgsRectangle &extent, int resolution )
+        : mXMin( extent.xMinimum() )
+        , mYMax( extent.yMaximum() )
+        , mScaleX( resolution / extent.width() )
+        , mScaleY( resolution / extent.height() )
+      {}
+
+      const std::vector<quint32> &commands() const { return mCommands; }
+
+      QPoint tilePoint( double x, double y ) const
+      {
+        // Tile coordinates grow downwards
+        return QPoint( static_cast<int>( std::round( ( x - mXMin ) * mScaleX ) ),
+                       static_cast<int>( std::round( ( mYMax - y ) * mScaleY ) ) );
+      }
+
+      void addPoints( const QVector<QPoint> &points )
+      {
+        if ( points.isEmpty() )
+          return;
+
+        addCommand( MoveTo, points.size() );
+        for ( const QPoint &point : points )
+        {
+          addParameters( point );
+        }
+      }
+
+      bool addLine( const QgsCurve &curve )
+      {
+        const QVector<QPoint> points = curvePoints( curve );
+        if ( points.size() < 2 )
+          return false;
+
+        addCommand( MoveTo, 1 );
+        addParameters( points.at( 0 ) );
+        addCommand( LineTo, points.size() - 1 );
+        for ( int i = 1; i < points.size(); ++i )
+        {
+          addParameters( points.at( i ) );
+        }
+        return true;
+      }
+
+      bool addRing( const QgsCurve &curve, bool exterior )
+      {
+        QVector<QPoint> points = curvePoints( curve );
+        if ( points.size() > 1 && points.first() == points.last() )
+          points.removeLast();
+        if ( points.size() < 3 )
+          return false;
+
+        // Surveyor's formula, exterior rings have a positive area in
+        // tile coordinates and interior rings a negative one
+        qint64 area = 0;
+        for ( int i = 0; i < points.size(); ++i )
+        {
+          const QPoint &p1 = points.at( i );
+          const QPoint &p2 = points.at( ( i + 1 ) % points.size() );
+          area += static_cast<qint64>( p1.x() ) * p2.y() - static_cast<qint64>( p2.x() ) * p1.y();
+        }
+        if ( area == 0 )
+          return false;
+        if ( ( area > 0 ) != exterior )
+          std::reverse( points.begin(), points.end() );
+
+        addCommand( MoveTo, 1 );
+        addParameters( points.at( 0 ) );
+        addCommand( LineTo, points.size() - 1 );
+        for ( int i = 1; i < points.size(); ++i )
+        {
+          addParameters( points.at( i ) );
+        }
+        addCommand( ClosePath, 1 );
+        return true;
+      }
+
+    private:
+      QVector<QPoint> curvePoints( const QgsCurve &curve ) const
+      {
+        std::unique_ptr<QgsLineString> line( curve.curveToLine() );
+        QVector<QPoint> points;
+        points.reserve( line->numPoints() );
+        for ( int i = 0; i < line->numPoints(); ++i )
+        {
+          const QPoint point = tilePoint( line->xAt( i ), line->yAt( i ) );
+          // Vertices merged by the quantisation are written once
+          if ( points.isEmpty() || points.last() != point )
+            points << point;
+        }
+        return points;
+      }
+
+      void addCommand( int command, int count )
+      {
+        mCommands.push_back( static_cast<quint32>( ( command & 0x7 ) | ( count << 3 ) ) );
+      }
+
+      void addParameters( const QPoint &point )
+      {
+        mCommands.push_back( zigzag( point.x() - mCursor.x() ) );
+        mCommands.push_back( zigzag( point.y() - mCursor.y() ) );
+        mCursor = point;
+      }
+
+      double mXMin;
+      double mYMax;
+      double mScaleX;
+      double mScaleY;
+      QPoint mCursor;
+      std::vector<quint32> mCommands;
+  };
+
+  //! Returns the parts of a single or multi geometry
+  QVector<const QgsAbstractGeometry *> geometryParts( const QgsAbstractGeometry *geometry )
+  {
+    QVector<const QgsAbstractGeometry *> parts;
+    if ( const QgsGeometryCollection *collection = qgsgeometry_cast<const QgsGeometryCollection *>( geometry ) )
+    {
+      for ( int i = 0; i < collection->numGeometries(); ++i )
+      {
+        parts << collection->geometryN( i );
+      }
+    }
+    else if ( geometry )
+    {
+      parts << geometry;
+    }
+    return parts;
+  }
+}
+///@endcond
+
+QgsVectorTileEncoder::QgsVectorTileEncoder( const QgsRectangle &tileExtent, const QgsCoordinateReferenceSystem &crs, int resolution, int buffer )
+  : mTileExtent( tileExtent )
+  , mCrs( crs )
+  , mResolution( std::max( 1, resolution ) )
+  , mBuffer( std::max( 0, buffer ) )
+{
+}
+
+QgsRectangle QgsVectorTileEncoder::xyzTileExtent( int zoom, int x, int y )
+{
+  const double size = 2 * WEB_MERCATOR_HALF_SIZE / std::pow( 2.0, zoom );
+  return QgsRectangle( -WEB_MERCATOR_HALF_SIZE + x * size, WEB_MERCATOR_HALF_SIZE - ( y + 1 ) * size,
+                       -WEB_MERCATOR_HALF_SIZE + ( x + 1 ) * size, WEB_MERCATOR_HALF_SIZE - y * size );
+}
+
+QString QgsVectorTileEncoder::mimeType()
+{
+  return QStringLiteral( "application/vnd.mapbox-vector-tile" );
+}
+
+void QgsVectorTileEncoder::setTransformContext( const QgsCoordinateTransformContext &context )
+{
+  mTransformContext = context;
+}
+
+bool QgsVectorTileEncoder::addLayer( QgsVectorLayer *layer, const QgsAttributeList &attributes, const QgsFeatureRequest &request, const QString &layerName, QgsFeedback *feedback )
+{
+  if ( !layer || !layer->isSpatial() )
+    return false;
+
+  const QString name = layerName.isEmpty() ? layer->name() : layerName;
+
+  // The iterator transforms the geometries, the filter rectangle
+  // is then in the CRS of the tile
+  QgsFeatureRequest layerRequest( request );
+  layerRequest.setDestinationCrs( mCrs, mTransformContext );
+  QgsRectangle filterRect = clipExtent();
+  if ( !request.filterRect().isNull() )
+    filterRect = filterRect.intersect( request.filterRect() );
+  if ( filterRect.isEmpty() )
+    return true;
+  layerRequest.setFilterRect( filterRect );
+
+  QgsFeatureIterator it = layer->getFeatures( layerRequest );
+  QgsFeature feature;
+  while ( it.nextFeature( feature ) )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return false;
+
+    addFeature( name, feature, attributes );
+  }
+  return !feedback || !feedback->isCanceled();
+}
+
+bool QgsVectorTileEncoder::addFeature( const QString &layerName, const QgsFeature &feature, const QgsAttributeList &attributes )
+{
+  QgsGeometry geometry = feature.geometry();
+  if ( geometry.isNull() )
+    return false;
+
+  const QgsRectangle clip = clipExtent();
+  if ( !clip.intersects( geometry.boundingBox() ) )
+    return false;
+
+  GeometryEncoder encoder( mTileExtent, mResolution );
+  GeomType type = UnknownType;
+  switch ( geometry.type() )
+  {
+    case QgsWkbTypes::PointGeometry:
+    {
+      type = PointType;
+      QVector<QPoint> points;
+      for ( const QgsAbstractGeometry *part : geometryParts( geometry.constGet() ) )
+      {
+        const QgsPoint *point = qgsgeometry_cast<const QgsPoint *>( part );
+        if ( point && clip.contains( QgsPointXY( point->x(), point->y() ) ) )
+          points << encoder.tilePoint( point->x(), point->y() );
+      }
+      encoder.addPoints( points );
+      break;
+    }
+
+    case QgsWkbTypes::LineGeometry:
+    case QgsWkbTypes::PolygonGeometry:
+    {
+      if ( QgsWkbTypes::isCurvedType( geometry.wkbType() ) )
+        geometry.convertToStraightSegment();
+      if ( !clip.contains( geometry.boundingBox() ) )
+        geometry = geometry.clipped( clip );
+
+      // Vertices closer than a tile unit are merged by the quantisation anyway
+      const QgsMapToPixelSimplifier simplifier( QgsMapToPixelSimplifier::SimplifyGeometry, mTileExtent.width() / mResolution );
+      geometry = simplifier.simplify( geometry );
+
+      const QVector<const QgsAbstractGeometry *> parts = geometryParts( geometry.constGet() );
+      if ( geometry.type() == QgsWkbTypes::LineGeometry )
+      {
+        type = LineStringType;
+        for ( const QgsAbstractGeometry *part : parts )
+        {
+          if ( const QgsCurve *curve = qgsgeometry_cast<const QgsCurve *>( part ) )
+            encoder.addLine( *curve );
+        }
+      }
+      else if ( geometry.type() == QgsWkbTypes::PolygonGeometry )
+      {
+        type = PolygonType;
+        for ( const QgsAbstractGeometry *part : parts )
+        {
+          const QgsCurvePolygon *polygon = qgsgeometry_cast<const QgsCurvePolygon *>( part );
+          // Holes of a degenerated polygon are dropped with it
+          if ( !polygon || !polygon->exteriorRing() || !encoder.addRing( *polygon->exteriorRing(), true ) )
+            continue;
+          for ( int i = 0; i < polygon->numInteriorRings(); ++i )
+          {
+            encoder.addRing( *polygon->interiorRing( i ), false );
+          }
+        }
+      }
+      break;
+    }
+
+    case QgsWkbTypes::UnknownGeometry:
+    case QgsWkbTypes::NullGeometry:
+      break;
+  }
+
+  if ( type == UnknownType || encoder.commands().empty() )
+    return false;
+
+  Layer &layer = tileLayer( layerName );
+
+  // Providers may fetch attributes which were not requested, e.g. the
+  // primary key, only the given attributes are written
+  std::vector<quint32> tags;
+  const QgsFields fields = feature.fields();
+  const QgsAttributes featureAttributes = feature.attributes();
+  for ( int i : attributes )
+  {
+    if ( i < 0 || i >= fields.count() || i >= featureAttributes.count() )
+      continue;
+
+    const QVariant &value = featureAttributes.at( i );
+    if ( value.isNull() )
+      continue;
+
+    const QString key = fields.at( i ).name();
+    auto keyIt = layer.keyIndexes.constFind( key );
+    if ( keyIt == layer.keyIndexes.constEnd() )
+    {
+      keyIt = layer.keyIndexes.insert( key, layer.keys.size() );
+      layer.keys << key;
+    }
+
+    const QByteArray encodedValue = encodeValue( value );
+    auto valueIt = layer.valueIndexes.constFind( encodedValue );
+    if ( valueIt == layer.valueIndexes.constEnd() )
+    {
+      valueIt = layer.valueIndexes.insert( encodedValue, layer.values.size() );
+      layer.values << encodedValue;
+    }
+
+    tags.push_back( static_cast<quint32>( keyIt.value() ) );
+    tags.push_back( static_cast<quint32>( valueIt.value() ) );
+  }
+
+  ProtobufWriter featureWriter;
+  if ( feature.id() >= 0 )
+    featureWriter.writeUInt( FeatureId, static_cast<quint64>( feature.id() ) );
+  if ( !tags.empty() )
+    featureWriter.writePacked( FeatureTags, tags );
+  featureWriter.writeUInt( FeatureType, type );
+  featureWriter.writePacked( FeatureGeometry, encoder.commands() );
+
+  ProtobufWriter layerWriter;
+  layerWriter.writeBytes( LayerFeatures, featureWriter.data() );
+  layer.features.append( layerWriter.data() );
+
+  ++mFeatureCount;
+  return true;
+}
+
+QByteArray QgsVectorTileEncoder::encode() const
+{
+  ProtobufWriter tileWriter;
+  for ( const Layer &layer : mLayers )
+  {
+    ProtobufWriter layerWriter;
+    layerWriter.writeUInt( LayerVersion, 2 );
+    layerWriter.writeString( LayerName, layer.name );
+    layerWriter.writeRaw( layer.features );
+    for ( const QString &key : layer.keys )
+    {
+      layerWriter.writeString( LayerKeys, key );
+    }
+    for ( const QByteArray &value : layer.values )
+    {
+      layerWriter.writeBytes( LayerValues, value );
+    }
+    layerWriter.writeUInt( LayerExtent, static_cast<quint64>( mResolution ) );
+    tileWriter.writeBytes( TileLayers, layerWriter.data() );
+  }
+  return tileWriter.data();
+}
+
+QgsVectorTileEncoder::Layer &QgsVectorTileEncoder::tileLayer( const QString &name )
+{
+  auto it = mLayerIndexes.constFind( name );
+  if ( it != mLayerIndexes.constEnd() )
+    return mLayers[ static_cast<size_t>( it.value() ) ];
+
+  mLayerIndexes.insert( name, static_cast<int>( mLayers.size() ) );
+  Layer layer;
+  layer.name = name;
+  mLayers.push_back( layer );
+  return mLayers.back();
+}
+
+QgsRectangle QgsVectorTileEncoder::clipExtent() const
+{
+  const double buffer = mBuffer * mTileExtent.width() / mResolution;
+  return mTileExtent.buffered( buffer );
+}
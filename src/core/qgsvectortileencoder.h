@@ -0,0 +1,148 @@
+/***************************************************************************
+                              qgsvectortileencoder.h
+                              -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSVECTORTILEENCODER_H
+#define QGSVECTORTILEENCODER_H
+
+#include "qgis_core.h"
+#include "qgis_sip.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgscoordinatetransformcontext.h"
+#include "qgsfeaturerequest.h"
+#include "qgsrectangle.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QStringList>
+
+#include <vector>
+
+class QgsFeature;
+class QgsFeedback;
+class QgsVectorLayer;
+
+/**
+ * \ingroup core
+ * \class QgsVectorTileEncoder
+ * \brief Encodes features to a Mapbox Vector Tile (MVT 2.1).
+ *
+ * Features are transformed to the CRS of the tile, clipped to the tile
+ * extent grown by a buffer, simplified to the tile resolution and quantised
+ * to the integer coordinates of the tile. Each vector layer added to the
+ * encoder is written as a layer of the tile, with the attributes of the
+ * features as tags.
+ *
+ * \since QGIS 3.10
+ */
+class CORE_EXPORT QgsVectorTileEncoder
+{
+  public:
+
+    /**
+     * Constructor for QgsVectorTileEncoder.
+     * \param tileExtent extent of the tile, in \a crs units
+     * \param crs CRS of the tile
+     * \param resolution number of integer coordinates along each side of the tile
+     * \param buffer size of the buffer around the tile, in tile coordinates
+     */
+    QgsVectorTileEncoder( const QgsRectangle &tileExtent, const QgsCoordinateReferenceSystem &crs,
+                          int resolution = 4096, int buffer = 64 );
+
+    /**
+     * Returns the extent of the tile in Web Mercator (EPSG:3857) of the
+     * tile \a x, \a y at \a zoom level of the XYZ tiling scheme.
+     */
+    static QgsRectangle xyzTileExtent( int zoom, int x, int y );
+
+    //! Returns the MIME type of the encoded tiles
+    static QString mimeType();
+
+    //! Returns the extent of the tile
+    QgsRectangle tileExtent() const { return mTileExtent; }
+
+    //! Returns the CRS of the tile
+    QgsCoordinateReferenceSystem crs() const { return mCrs; }
+
+    //! Returns the number of integer coordinates along each side of the tile
+    int resolution() const { return mResolution; }
+
+    //! Returns the size of the buffer around the tile, in tile coordinates
+    int buffer() const { return mBuffer; }
+
+    /**
+     * Sets the transform \a context used to transform the features to the
+     * CRS of the tile.
+     */
+    void setTransformContext( const QgsCoordinateTransformContext &context );
+
+    /**
+     * Adds the features of \a layer intersecting the tile. The filter
+     * rectangle of \a request, in the CRS of the tile, is intersected with
+     * the tile extent, its other filters are kept.
+     * \param layer the layer
+     * \param attributes indexes of the attributes written to the tile, the
+     * other attributes of the features are never written
+     * \param request request filtering the features of the layer
+     * \param layerName name of the layer in the tile, the layer name when empty
+     * \param feedback optional feedback to cancel the encoding
+     * \returns FALSE if the layer cannot be added or the encoding was canceled
+     */
+    bool addLayer( QgsVectorLayer *layer, const QgsAttributeList &attributes,
+                   const QgsFeatureRequest &request = QgsFeatureRequest(),
+                   const QString &layerName = QString(), QgsFeedback *feedback = nullptr );
+
+    /**
+     * Adds \a feature to the layer \a layerName of the tile. The geometry of
+     * the feature must be in the CRS of the tile. Only the non null
+     * \a attributes of the feature are written to the tile.
+     * \returns FALSE if the feature is outside of the tile or its geometry
+     * is empty once quantised
+     */
+    bool addFeature( const QString &layerName, const QgsFeature &feature, const QgsAttributeList &attributes );
+
+    //! Returns the number of features added to the tile
+    int featureCount() const { return mFeatureCount; }
+
+    /**
+     * Returns the encoded tile. A tile without features is encoded
+     * as an empty array.
+     */
+    QByteArray encode() const;
+
+  private:
+    struct Layer
+    {
+      QString name;
+      QByteArray features;
+      QStringList keys;
+      QHash<QString, int> keyIndexes;
+      QList<QByteArray> values;
+      QHash<QByteArray, int> valueIndexes;
+    };
+
+    Layer &tileLayer( const QString &name );
+    QgsRectangle clipExtent() const;
+
+    QgsRectangle mTileExtent;
+    QgsCoordinateReferenceSystem mCrs;
+    QgsCoordinateTransformContext mTransformContext;
+    int mResolution = 4096;
+    int mBuffer = 64;
+    std::vector<Layer> mLayers;
+    QHash<QString, int> mLayerIndexes;
+    int mFeatureCount = 0;
+};
+
+#endif // QGSVECTORTILEENCODER_H
@@ -22,6 +22,9 @@
 #include "qgscoordinatetransform.h"
 #include "qgsexception.h"
 
+#include <QCache>
+#include <QMutex>
+
 Q_NOWARN_DEPRECATED_PUSH // because of deprecated members
 QgsRasterProjector::QgsRasterProjector()
   : QgsRasterInterface( nullptr )
@@ -89,6 +92,54 @@ void QgsRasterProjector::setCrs( const QgsCoordinateReferenceSystem &srcCRS, con
   Q_NOWARN_DEPRECATED_POP
 }
 
+/**
+ * Matrix of control points calculated for a destination extent and size,
+ * stored in the cache of matrices shared by all projectors.
+ */
+struct QgsRasterProjectorCPMatrix
+{
+  QList< QList<QgsPointXY> > matrix;
+  QList< QList<bool> > legalMatrix;
+  int rows = 0;
+  int cols = 0;
+  //! FALSE if the matrix did not reach required tolerance and cannot be used for approximation
+  bool withinTolerance = false;
+};
+
+/*
+ * Calculation of the matrix of control points is the most expensive part of ProjectorData
+ * construction, it involves many reprojected points. It is always the same for the same
+ * transformation, extent and size (typically all bands of a multiband raster, tiles requested
+ * repeatedly, map refresh without extent change) so we keep recently calculated matrices.
+ * The cost is the number of control points.
+ */
+static QMutex sCPMatrixCacheMutex;
+static QCache< QString, QgsRasterProjectorCPMatrix > sCPMatrixCache( 1000000 );
+
+static QString cpMatrixCacheKey( const QgsCoordinateTransform &ct, const QgsRectangle &extent, int width, int height )
+{
+  // proj strings drop parts of some definitions (e.g. axis order, datum ensembles) and
+  // may be identical for different CRS, the WKT is not
+  const auto crsKey = []( const QgsCoordinateReferenceSystem & crs )
+  {
+    return QStringLiteral( "%1|%2" ).arg( crs.authid(), crs.toWkt( QgsCoordinateReferenceSystem::WKT2_2018 ) );
+  };
+
+  Q_NOWARN_DEPRECATED_PUSH
+  const QString transformKey = QStringLiteral( "%1|%2|%3|%4|%5" ).arg( crsKey( ct.sourceCrs() ),
+                               crsKey( ct.destinationCrs() ),
+                               ct.coordinateOperation() )
+                               .arg( ct.sourceDatumTransformId() )
+                               .arg( ct.destinationDatumTransformId() );
+  Q_NOWARN_DEPRECATED_POP
+
+  return QStringLiteral( "%1|%2|%3|%4|%5|%6|%7" ).arg( transformKey,
+         QString::number( extent.xMinimum(), 'g', 17 ),
+         QString::number( extent.yMinimum(), 'g', 17 ),
+         QString::number( extent.xMaximum(), 'g', 17 ),
+         QString::number( extent.yMaximum(), 'g', 17 ) )
+         .arg( width ).arg( height );
+}
 
 ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height, QgsRasterInterface *input, const QgsCoordinateTransform &inverseCt, QgsRasterProjector::Precision precision )
   : mApproximate( false )
@@ -152,6 +203,56 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   }
 
   // Always try to calculate mCPMatrix, it is used in calcSrcExtent() for both Approximate and Exact
+  initCPMatrix( inverseCt );
+
+  QgsDebugMsgLevel( QStringLiteral( "CPMatrix size: mCPRows = %1 mCPCols = %2" ).arg( mCPRows ).arg( mCPCols ), 4 );
+  mDestRowsPerMatrixRow = static_cast< double >( mDestRows ) / ( mCPRows - 1 );
+  mDestColsPerMatrixCol = static_cast< double >( mDestCols ) / ( mCPCols - 1 );
+
+  QgsDebugMsgLevel( QStringLiteral( "CPMatrix:" ), 5 );
+  QgsDebugMsgLevel( cpToString(), 5 );
+
+  // init helper points
+  mHelperTopX.resize( mDestCols );
+  mHelperTopY.resize( mDestCols );
+  mHelperBottomX.resize( mDestCols );
+  mHelperBottomY.resize( mDestCols );
+  calcHelper( 0, mHelperTopX.data(), mHelperTopY.data() );
+  calcHelper( 1, mHelperBottomX.data(), mHelperBottomY.data() );
+  mHelperTopRow = 0;
+
+  mRowSrcX.resize( mDestCols );
+  mRowSrcY.resize( mDestCols );
+  if ( !mApproximate )
+    mRowSrcZ.resize( mDestCols );
+
+  // Calculate source dimensions
+  calcSrcExtent();
+  calcSrcRowsCols();
+  mSrcYRes = mSrcExtent.height() / mSrcRows;
+  mSrcXRes = mSrcExtent.width() / mSrcCols;
+}
+
+ProjectorData::~ProjectorData() = default;
+
+void ProjectorData::initCPMatrix( const QgsCoordinateTransform &ct )
+{
+  const QString cacheKey = cpMatrixCacheKey( ct, mDestExtent, mDestCols, mDestRows );
+  {
+    QMutexLocker locker( &sCPMatrixCacheMutex );
+    if ( const QgsRasterProjectorCPMatrix *cached = sCPMatrixCache.object( cacheKey ) )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "CP matrix taken from cache" ), 4 );
+      mCPMatrix = cached->matrix;
+      mCPLegalMatrix = cached->legalMatrix;
+      mCPRows = cached->rows;
+      mCPCols = cached->cols;
+      if ( !cached->withinTolerance )
+        mApproximate = false;
+      return;
+    }
+  }
+
   // Initialize the matrix by corners and middle points
   mCPCols = mCPRows = 3;
   for ( int i = 0; i < mCPRows; i++ )
@@ -170,20 +271,21 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
   }
   for ( int i = 0; i < mCPRows; i++ )
   {
-    calcRow( i, inverseCt );
+    calcRow( i, ct );
   }
 
+  bool withinTolerance = true;
   while ( true )
   {
-    bool myColsOK = checkCols( inverseCt );
+    bool myColsOK = checkCols( ct );
     if ( !myColsOK )
     {
-      insertRows( inverseCt );
+      insertRows( ct );
     }
-    bool myRowsOK = checkRows( inverseCt );
+    bool myRowsOK = checkRows( ct );
     if ( !myRowsOK )
     {
-      insertCols( inverseCt );
+      insertCols( ct );
     }
     if ( myColsOK && myRowsOK )
     {
@@ -197,34 +299,20 @@ ProjectorData::ProjectorData( const QgsRectangle &extent, int width, int height,
     {
       QgsDebugMsgLevel( QStringLiteral( "Too large CP matrix" ), 4 );
       mApproximate = false;
+      withinTolerance = false;
       break;
     }
   }
-  QgsDebugMsgLevel( QStringLiteral( "CPMatrix size: mCPRows = %1 mCPCols = %2" ).arg( mCPRows ).arg( mCPCols ), 4 );
-  mDestRowsPerMatrixRow = static_cast< double >( mDestRows ) / ( mCPRows - 1 );
-  mDestColsPerMatrixCol = static_cast< double >( mDestCols ) / ( mCPCols - 1 );
-
-  QgsDebugMsgLevel( QStringLiteral( "CPMatrix:" ), 5 );
-  QgsDebugMsgLevel( cpToString(), 5 );
 
-  // init helper points
-  pHelperTop = new QgsPointXY[mDestCols];
-  pHelperBottom = new QgsPointXY[mDestCols];
-  calcHelper( 0, pHelperTop );
-  calcHelper( 1, pHelperBottom );
-  mHelperTopRow = 0;
-
-  // Calculate source dimensions
-  calcSrcExtent();
-  calcSrcRowsCols();
-  mSrcYRes = mSrcExtent.height() / mSrcRows;
-  mSrcXRes = mSrcExtent.width() / mSrcCols;
-}
+  std::unique_ptr< QgsRasterProjectorCPMatrix > cached = qgis::make_unique< QgsRasterProjectorCPMatrix >();
+  cached->matrix = mCPMatrix;
+  cached->legalMatrix = mCPLegalMatrix;
+  cached->rows = mCPRows;
+  cached->cols = mCPCols;
+  cached->withinTolerance = withinTolerance;
 
-ProjectorData::~ProjectorData()
-{
-  delete[] pHelperTop;
-  delete[] pHelperBottom;
+  QMutexLocker locker( &sCPMatrixCacheMutex );
+  sCPMatrixCache.insert( cacheKey, cached.release(), mCPRows * mCPCols );
 }
 
 
@@ -406,7 +494,7 @@ inline int ProjectorData::matrixCol( int destCol )
   return static_cast< int >( std::floor( ( destCol + 0.5 ) / mDestColsPerMatrixCol ) );
 }
 
-void ProjectorData::calcHelper( int matrixRow, QgsPointXY *points )
+void ProjectorData::calcHelper( int matrixRow, double *pointsX, double *pointsY )
 {
   // TODO?: should we also precalc dest cell center coordinates for x and y?
   for ( int myDestCol = 0; myDestCol < mDestCols; myDestCol++ )
@@ -422,143 +510,147 @@ void ProjectorData::calcHelper( int matrixRow, QgsPointXY *points )
 
     double xfrac = ( myDestX - myDestXMin ) / ( myDestXMax - myDestXMin );
 
-    QgsPointXY &mySrcPoint0 = mCPMatrix[matrixRow][myMatrixCol];
-    QgsPointXY &mySrcPoint1 = mCPMatrix[matrixRow][myMatrixCol + 1];
-    double s = mySrcPoint0.x() + ( mySrcPoint1.x() - mySrcPoint0.x() ) * xfrac;
-    double t = mySrcPoint0.y() + ( mySrcPoint1.y() - mySrcPoint0.y() ) * xfrac;
-
-    points[myDestCol].setX( s );
-    points[myDestCol].setY( t );
+    const QgsPointXY &mySrcPoint0 = mCPMatrix[matrixRow][myMatrixCol];
+    const QgsPointXY &mySrcPoint1 = mCPMatrix[matrixRow][myMatrixCol + 1];
+    pointsX[myDestCol] = mySrcPoint0.x() + ( mySrcPoint1.x() - mySrcPoint0.x() ) * xfrac;
+    pointsY[myDestCol] = mySrcPoint0.y() + ( mySrcPoint1.y() - mySrcPoint0.y() ) * xfrac;
   }
 }
 
 void ProjectorData::nextHelper()
 {
-  // We just switch pHelperTop and pHelperBottom, memory is not lost
-  QgsPointXY *tmp = nullptr;
-  tmp = pHelperTop;
-  pHelperTop = pHelperBottom;
-  pHelperBottom = tmp;
-  calcHelper( mHelperTopRow + 2, pHelperBottom );
+  // We just switch top and bottom, memory is not lost
+  mHelperTopX.swap( mHelperBottomX );
+  mHelperTopY.swap( mHelperBottomY );
+  calcHelper( mHelperTopRow + 2, mHelperBottomX.data(), mHelperBottomY.data() );
   mHelperTopRow++;
 }
 
-bool ProjectorData::srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
+void ProjectorData::srcIndexesForRow( int destRow, qgssize *srcIndexes )
 {
   if ( mApproximate )
   {
-    return approximateSrcRowCol( destRow, destCol, srcRow, srcCol );
+    approximateSrcRow( destRow );
   }
   else
   {
-    return preciseSrcRowCol( destRow, destCol, srcRow, srcCol );
+    preciseSrcRow( destRow );
   }
+  rowSrcIndexes( srcIndexes );
 }
 
-bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
+void ProjectorData::preciseSrcRow( int destRow )
 {
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QStringLiteral( "theDestRow = %1" ).arg( destRow ), 5 );
-  QgsDebugMsgLevel( QStringLiteral( "theDestRow = %1 mDestExtent.yMaximum() = %2 mDestYRes = %3" ).arg( destRow ).arg( mDestExtent.yMaximum() ).arg( mDestYRes ), 5 );
-#endif
-
-  // Get coordinate of center of destination cell
-  double x = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
-  double y = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-  double z = 0;
+  double *x = mRowSrcX.data();
+  double *y = mRowSrcY.data();
+  double *z = mRowSrcZ.data();
 
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QStringLiteral( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
-
-  if ( mInverseCt.isValid() )
+  // Get coordinates of centers of destination cells
+  const double destY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
   {
-    mInverseCt.transformInPlace( x, y, z );
+    x[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+    y[destCol] = destY;
+    z[destCol] = 0;
   }
 
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QStringLiteral( "x = %1 y = %2" ).arg( x ).arg( y ), 5 );
-#endif
+  if ( !mInverseCt.isValid() )
+    return;
 
-  if ( !mExtent.contains( QgsPointXY( x, y ) ) )
+  // Transform whole row at once, it is much faster than point by point
+  try
   {
-    return false;
+    mInverseCt.transformCoords( mDestCols, x, y, z );
+  }
+  catch ( QgsCsException & )
+  {
+    // Some of the points failed, transform again point by point and skip those which failed
+    for ( int destCol = 0; destCol < mDestCols; ++destCol )
+    {
+      x[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+      y[destCol] = destY;
+      z[destCol] = 0;
+      try
+      {
+        mInverseCt.transformInPlace( x[destCol], y[destCol], z[destCol] );
+      }
+      catch ( QgsCsException & )
+      {
+        x[destCol] = std::numeric_limits<double>::quiet_NaN();
+        y[destCol] = std::numeric_limits<double>::quiet_NaN();
+      }
+    }
   }
-  // Get source row col
-  *srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - y ) / mSrcYRes ) );
-  *srcCol = static_cast< int >( std::floor( ( x - mSrcExtent.xMinimum() ) / mSrcXRes ) );
-#ifdef QGISDEBUG
-  QgsDebugMsgLevel( QStringLiteral( "mSrcExtent.yMinimum() = %1 mSrcExtent.yMaximum() = %2 mSrcYRes = %3" ).arg( mSrcExtent.yMinimum() ).arg( mSrcExtent.yMaximum() ).arg( mSrcYRes ), 5 );
-  QgsDebugMsgLevel( QStringLiteral( "theSrcRow = %1 srcCol = %2" ).arg( *srcRow ).arg( *srcCol ), 5 );
-#endif
-
-  // With epsg 32661 (Polar Stereographic) it was happening that *srcCol == mSrcCols
-  // For now silently correct limits to avoid crashes
-  // TODO: review
-  // should not happen
-  if ( *srcRow >= mSrcRows ) return false;
-  if ( *srcRow < 0 ) return false;
-  if ( *srcCol >= mSrcCols ) return false;
-  if ( *srcCol < 0 ) return false;
-
-  return true;
 }
 
-bool ProjectorData::approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
+void ProjectorData::approximateSrcRow( int destRow )
 {
-  int myMatrixRow = matrixRow( destRow );
-  int myMatrixCol = matrixCol( destCol );
+  const int myMatrixRow = matrixRow( destRow );
 
-  if ( myMatrixRow > mHelperTopRow )
+  while ( myMatrixRow > mHelperTopRow )
   {
     // TODO: make it more robust (for random, not sequential reading)
     nextHelper();
   }
 
-  double myDestY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
-
   // See the schema in javax.media.jai.WarpGrid doc (but up side down)
-  // TODO: use some kind of cache of values which can be reused
+  // The fraction is the same for the whole destination row
+  const double myDestY = mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes;
   double myDestXMin, myDestYMin, myDestXMax, myDestYMax;
+  destPointOnCPMatrix( myMatrixRow + 1, 0, &myDestXMin, &myDestYMin );
+  destPointOnCPMatrix( myMatrixRow, 0, &myDestXMax, &myDestYMax );
+  const double yfrac = ( myDestY - myDestYMin ) / ( myDestYMax - myDestYMin );
 
-  destPointOnCPMatrix( myMatrixRow + 1, myMatrixCol, &myDestXMin, &myDestYMin );
-  destPointOnCPMatrix( myMatrixRow, myMatrixCol + 1, &myDestXMax, &myDestYMax );
+  const double *topX = mHelperTopX.data();
+  const double *topY = mHelperTopY.data();
+  const double *botX = mHelperBottomX.data();
+  const double *botY = mHelperBottomY.data();
+  double *srcX = mRowSrcX.data();
+  double *srcY = mRowSrcY.data();
 
-  double yfrac = ( myDestY - myDestYMin ) / ( myDestYMax - myDestYMin );
-
-  QgsPointXY &myTop = pHelperTop[destCol];
-  QgsPointXY &myBot = pHelperBottom[destCol];
+  // Simple loop over contiguous arrays, vectorized by compiler
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+  {
+    srcX[destCol] = botX[destCol] + ( topX[destCol] - botX[destCol] ) * yfrac;
+    srcY[destCol] = botY[destCol] + ( topY[destCol] - botY[destCol] ) * yfrac;
+  }
+}
 
-  // Warning: this is very SLOW compared to the following code!:
-  //double mySrcX = myBot.x() + (myTop.x() - myBot.x()) * yfrac;
-  //double mySrcY = myBot.y() + (myTop.y() - myBot.y()) * yfrac;
+void ProjectorData::rowSrcIndexes( qgssize *srcIndexes ) const
+{
+  const double *srcX = mRowSrcX.data();
+  const double *srcY = mRowSrcY.data();
 
-  double tx = myTop.x();
-  double ty = myTop.y();
-  double bx = myBot.x();
-  double by = myBot.y();
-  double mySrcX = bx + ( tx - bx ) * yfrac;
-  double mySrcY = by + ( ty - by ) * yfrac;
+  const double extentXMin = mExtent.xMinimum();
+  const double extentXMax = mExtent.xMaximum();
+  const double extentYMin = mExtent.yMinimum();
+  const double extentYMax = mExtent.yMaximum();
+  const double srcXMin = mSrcExtent.xMinimum();
+  const double srcYMax = mSrcExtent.yMaximum();
 
-  if ( !mExtent.contains( QgsPointXY( mySrcX, mySrcY ) ) )
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
   {
-    return false;
-  }
+    const double x = srcX[destCol];
+    const double y = srcY[destCol];
+    srcIndexes[destCol] = OUTSIDE_SOURCE;
 
-  // TODO: check again cell selection (coor is in the middle)
+    // same as mExtent.contains(), also false for NaN
+    if ( !( extentXMin <= x && x <= extentXMax && extentYMin <= y && y <= extentYMax ) )
+      continue;
 
-  *srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - mySrcY ) / mSrcYRes ) );
-  *srcCol = static_cast< int >( std::floor( ( mySrcX - mSrcExtent.xMinimum() ) / mSrcXRes ) );
+    // TODO: check again cell selection (coor is in the middle)
+    const int srcRow = static_cast< int >( std::floor( ( srcYMax - y ) / mSrcYRes ) );
+    const int srcCol = static_cast< int >( std::floor( ( x - srcXMin ) / mSrcXRes ) );
 
-  // For now silently correct limits to avoid crashes
-  // TODO: review
-  // should not happen
-  if ( *srcRow >= mSrcRows ) return false;
-  if ( *srcRow < 0 ) return false;
-  if ( *srcCol >= mSrcCols ) return false;
-  if ( *srcCol < 0 ) return false;
+    // With epsg 32661 (Polar Stereographic) it was happening that srcCol == mSrcCols
+    // For now silently correct limits to avoid crashes
+    // TODO: review
+    // should not happen
+    if ( srcRow < 0 || srcRow >= mSrcRows || srcCol < 0 || srcCol >= mSrcCols )
+      continue;
 
-  return true;
+    srcIndexes[destCol] = static_cast< qgssize >( srcRow ) * static_cast< qgssize >( mSrcCols ) + static_cast< qgssize >( srcCol );
+  }
 }
 
 void ProjectorData::insertRows( const QgsCoordinateTransform &ct )
@@ -828,26 +920,27 @@ QgsRasterBlock *QgsRasterProjector::block( int bandNo, QgsRectangle  const &exte
 
   outputBlock->setIsNoData();
 
-  int srcRow, srcCol;
+  std::vector< qgssize > srcIndexes( static_cast< std::size_t >( width ) );
   for ( int i = 0; i < height; ++i )
   {
     if ( feedback && feedback->isCanceled() )
       break;
+
+    pd.srcIndexesForRow( i, srcIndexes.data() );
+
     for ( int j = 0; j < width; ++j )
     {
-      bool inside = pd.srcRowCol( i, j, &srcRow, &srcCol );
-      if ( !inside ) continue; // we have everything set to no data
-
-      qgssize srcIndex = static_cast< qgssize >( srcRow * pd.srcCols() + srcCol );
+      const qgssize srcIndex = srcIndexes[j];
+      if ( srcIndex == ProjectorData::OUTSIDE_SOURCE ) continue; // we have everything set to no data
 
       // isNoData() may be slow so we check doNoData first
-      if ( doNoData && inputBlock->isNoData( srcRow, srcCol ) )
+      if ( doNoData && inputBlock->isNoData( srcIndex ) )
       {
         outputBlock->setIsNoData( i, j );
         continue;
       }
 
-      qgssize destIndex = static_cast< qgssize >( i * width + j );
+      qgssize destIndex = static_cast< qgssize >( i ) * static_cast< qgssize >( width ) + static_cast< qgssize >( j );
       char *srcBits = inputBlock->bits( srcIndex );
       char *destBits = outputBlock->bits( destIndex );
       if ( !srcBits )
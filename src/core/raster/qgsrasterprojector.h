@@ -34,6 +34,8 @@
 #include "qgsrasterinterface.h"
 
 #include <cmath>
+#include <limits>
+#include <vector>
 
 class QgsPointXY;
 
@@ -132,8 +134,8 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
 
 /**
  * Internal class for reprojection of rasters - either exact or approximate.
- * QgsRasterProjector creates it and then keeps calling srcRowCol() to get source pixel position
- * for every destination pixel position.
+ * QgsRasterProjector creates it and then keeps calling srcIndexesForRow() to get source pixel positions
+ * for every destination row.
  */
 class ProjectorData
 {
@@ -145,12 +147,17 @@ class ProjectorData
     ProjectorData( const ProjectorData &other ) = delete;
     ProjectorData &operator=( const ProjectorData &other ) = delete;
 
+    //! Value set by srcIndexesForRow() for destination pixels falling outside of the source
+    static constexpr qgssize OUTSIDE_SOURCE = std::numeric_limits<qgssize>::max();
+
     /**
-     * Returns the source row and column indexes for current source extent and resolution.
-     * If the source pixel is outside source extent srcRow and srcCol are left unchanged.
-     * \returns TRUE if inside source
+     * Calculates the source pixel indexes (row * srcCols() + col) for all destination
+     * pixels in \a destRow, for current source extent and resolution.
+     * \a srcIndexes must point to an array of at least destination width items.
+     * Pixels outside of source are set to OUTSIDE_SOURCE.
+     * Rows must be requested sequentially when using approximate reprojection.
      */
-    bool srcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    void srcIndexesForRow( int destRow, qgssize *srcIndexes );
 
     QgsRectangle srcExtent() const { return mSrcExtent; }
     int srcRows() const { return mSrcRows; }
@@ -167,11 +174,17 @@ class ProjectorData
     //! Returns the matrix upper left col index for destination col.
     int matrixCol( int destCol );
 
-    //! Returns precise source row and column indexes for current source extent and resolution.
-    inline bool preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    //! Calculates precise source coordinates of destination row cell centers into mRowSrcX / mRowSrcY
+    void preciseSrcRow( int destRow );
+
+    //! Calculates approximate source coordinates of destination row cell centers into mRowSrcX / mRowSrcY
+    void approximateSrcRow( int destRow );
+
+    //! Converts source coordinates in mRowSrcX / mRowSrcY to source pixel indexes
+    void rowSrcIndexes( qgssize *srcIndexes ) const;
 
-    //! Returns approximate source row and column indexes for current source extent and resolution.
-    inline bool approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+    //! Builds the matrix of control points or takes it from the cache of already calculated matrices
+    void initCPMatrix( const QgsCoordinateTransform &ct );
 
     //! \brief insert rows to matrix
     void insertRows( const QgsCoordinateTransform &ct );
@@ -204,8 +217,8 @@ class ProjectorData
       * returns TRUE if within threshold */
     bool checkRows( const QgsCoordinateTransform &ct );
 
-    //! Calculate array of src helper points
-    void calcHelper( int matrixRow, QgsPointXY *points );
+    //! Calculate arrays of src helper points
+    void calcHelper( int matrixRow, double *pointsX, double *pointsY );
 
     //! Calc / switch helper
     void nextHelper();
@@ -267,13 +280,22 @@ class ProjectorData
     /* Same size as mCPMatrix */
     QList< QList<bool> > mCPLegalMatrix;
 
-    //! Array of source points for each destination column on top of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperTop = nullptr;
+    /**
+     * Arrays of source x and y for each destination column on top and bottom of current CPMatrix grid row.
+     * Coordinates are kept in separate contiguous arrays so that the interpolation
+     * loops may be vectorized by the compiler.
+     */
+    std::vector<double> mHelperTopX;
+    std::vector<double> mHelperTopY;
+    std::vector<double> mHelperBottomX;
+    std::vector<double> mHelperBottomY;
+
+    //! Source coordinates of current destination row cell centers
+    std::vector<double> mRowSrcX;
+    std::vector<double> mRowSrcY;
 
-    //! Array of source points for each destination column on bottom of current CPMatrix grid row
-    /* Warning: using QList is slow on access */
-    QgsPointXY *pHelperBottom = nullptr;
+    //! Z values for batched precise transformation of current destination row
+    std::vector<double> mRowSrcZ;
 
     //! Current mHelperTop matrix row
     int mHelperTopRow;
@@ -1288,6 +1288,16 @@ PGresult *QgsPostgresConn::PQgetResult()
   return ::PQgetResult( mConn );
 }
 
+int QgsPostgresConn::PQputCopyData( const QByteArray &buffer )
+{
+  return ::PQputCopyData( mConn, buffer.constData(), buffer.size() );
+}
+
+int QgsPostgresConn::PQputCopyEnd( const QString &errorMessage )
+{
+  return ::PQputCopyEnd( mConn, errorMessage.isEmpty() ? nullptr : errorMessage.toUtf8().constData() );
+}
+
 PGresult *QgsPostgresConn::PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes )
 {
   QMutexLocker locker( &mLock );
@@ -271,6 +271,18 @@ class QgsPostgresConn : public QObject
      */
     PGresult *PQgetResult();
 
+    /**
+     * PQputCopyData sends \a buffer to the server during a COPY FROM STDIN started with PQsendQuery
+     * Thread safety must be ensured by the caller by calling QgsPostgresConn::lock() and QgsPostgresConn::unlock()
+     */
+    int PQputCopyData( const QByteArray &buffer );
+
+    /**
+     * PQputCopyEnd ends a COPY FROM STDIN, the COPY fails with \a errorMessage if it is not empty
+     * Thread safety must be ensured by the caller by calling QgsPostgresConn::lock() and QgsPostgresConn::unlock()
+     */
+    int PQputCopyEnd( const QString &errorMessage = QString() );
+
     bool begin();
     bool commit();
     bool rollback();
@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsgeometry.h"
+#include "qgsgeometryfactory.h"
 #include "qgspostgresconnpool.h"
 #include "qgspostgresexpressioncompiler.h"
 #include "qgspostgresfeatureiterator.h"
@@ -25,6 +26,9 @@
 
 #include <QElapsedTimer>
 #include <QObject>
+#include <QtConcurrentRun>
+
+#include <cmath>
 
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
@@ -47,6 +51,10 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     mIsTransactionConnection = true;
   }
 
+  // Transaction connections are shared with the other iterators and the
+  // provider, so only pooled connections can have a FETCH in flight
+  mPrefetch = !mIsTransactionConnection && QgsSettings().value( QStringLiteral( "PostgreSQL/prefetch_features" ), true, QgsSettings::Providers ).toBool();
+
   if ( !mConn || mConn->PQstatus() != CONNECTION_OK )
   {
     mValid = false;
@@ -260,41 +268,33 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     timer.start();
 #endif
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
-    QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
-
-    lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+    if ( mPrefetching )
     {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+      // The batch was fetched while the previous one was consumed
+      mPrefetchFuture.waitForFinished();
+      mPrefetching = false;
+      mFeatureQueue.swap( mPrefetchQueue );
+      mLastFetch = mPrefetchLastFetch;
     }
-
-    QgsPostgresResult queryResult;
-    for ( ;; )
+    else
     {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
-
-      int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
-
-      mLastFetch = rows < mFeatureQueueSize;
+      lock();
+      sendFetch();
+      mLastFetch = readFetchResult( mFeatureQueue, mFeatureQueueSize );
+      unlock();
+    }
 
-      for ( int row = 0; row < rows; row++ )
+    // Fetch and decode the next batch while this one is consumed
+    if ( mPrefetch && !mLastFetch && !mFeatureQueue.empty() )
+    {
+      sendFetch();
+      mPrefetching = true;
+      const int batchSize = mFeatureQueueSize;
+      mPrefetchFuture = QtConcurrent::run( [this, batchSize]
       {
-        mFeatureQueue.enqueue( QgsFeature() );
-        getFeature( queryResult, row, mFeatureQueue.back() );
-      } // for each row in queue
+        mPrefetchLastFetch = readFetchResult( mPrefetchQueue, batchSize );
+      } );
     }
-    unlock();
 
 #if 0 //disabled dynamic queue size
     if ( timer.elapsed() > 500 && mFeatureQueueSize > 1 )
@@ -328,6 +328,59 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+void QgsPostgresFeatureIterator::sendFetch()
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
+  QgsDebugMsgLevel( QStringLiteral( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
+
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+  }
+}
+
+bool QgsPostgresFeatureIterator::readFetchResult( QQueue<QgsFeature> &queue, int batchSize )
+{
+  int fetched = 0;
+  QgsPostgresResult queryResult;
+  for ( ;; )
+  {
+    queryResult = mConn->PQgetResult();
+    if ( !queryResult.result() )
+      break;
+
+    if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+      break;
+    }
+
+    int rows = queryResult.PQntuples();
+    if ( rows == 0 )
+      continue;
+
+    fetched += rows;
+
+    for ( int row = 0; row < rows; row++ )
+    {
+      queue.enqueue( QgsFeature() );
+      getFeature( queryResult, row, queue.back() );
+    } // for each row in queue
+  }
+
+  return fetched < batchSize;
+}
+
+void QgsPostgresFeatureIterator::cancelPrefetch()
+{
+  if ( !mPrefetching )
+    return;
+
+  mPrefetchFuture.waitForFinished();
+  mPrefetching = false;
+  mPrefetchQueue.clear();
+}
+
 bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   if ( !mExpressionCompiled )
@@ -386,6 +439,8 @@ bool QgsPostgresFeatureIterator::rewind()
   if ( mClosed )
     return false;
 
+  cancelPrefetch();
+
   // move cursor to first record
 
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
@@ -401,6 +456,8 @@ bool QgsPostgresFeatureIterator::close()
   if ( !mConn )
     return false;
 
+  cancelPrefetch();
+
   mConn->closeCursor( mCursorName );
 
   if ( !mIsTransactionConnection )
@@ -589,10 +646,30 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
       }
     }
 
-    geom = QStringLiteral( "%1(%2,'%3')" )
-           .arg( mConn->majorVersion() < 2 ? "asbinary" : "st_asbinary",
-                 geom,
-                 QgsPostgresProvider::endianString() );
+    // Opt-in: geometries to render are transferred as TWKB, with coordinates
+    // rounded to a tenth of a pixel
+    mFetchTwkb = mRequest.simplifyMethod().methodType() == QgsSimplifyMethod::OptimizeForRendering &&
+                 mRequest.simplifyMethod().threshold() > 0 &&
+                 mRequest.simplifyMethod().tolerance() > 0 &&
+                 ( mConn->majorVersion() > 2 || ( mConn->majorVersion() == 2 && mConn->minorVersion() >= 2 ) ) &&
+                 usedGeomType != QgsWkbTypes::Unknown &&
+                 !QgsWkbTypes::isCurvedType( usedGeomType ) &&
+                 QgsWkbTypes::flatType( usedGeomType ) <= QgsWkbTypes::GeometryCollection &&
+                 QgsSettings().value( QStringLiteral( "PostgreSQL/twkb_rendering" ), false, QgsSettings::Providers ).toBool();
+
+    if ( mFetchTwkb )
+    {
+      const double mapUnitsPerPixel = mRequest.simplifyMethod().tolerance() / mRequest.simplifyMethod().threshold();
+      const int precision = qBound( -7, static_cast<int>( std::ceil( -std::log10( mapUnitsPerPixel / 10 ) ) ), 7 );
+      geom = QStringLiteral( "st_astwkb(%1,%2)" ).arg( geom ).arg( precision );
+    }
+    else
+    {
+      geom = QStringLiteral( "%1(%2,'%3')" )
+             .arg( mConn->majorVersion() < 2 ? "asbinary" : "st_asbinary",
+                   geom,
+                   QgsPostgresProvider::endianString() );
+    }
 
     query += delim + geom;
     delim = ',';
@@ -673,7 +750,12 @@ bool QgsPostgresFeatureIterator::getFeature( QgsPostgresResult &queryResult, int
   if ( mFetchGeometry )
   {
     int returnedLength = ::PQgetlength( queryResult.result(), row, col );
-    if ( returnedLength > 0 )
+    if ( returnedLength > 0 && mFetchTwkb )
+    {
+      const QByteArray twkb = QByteArray::fromRawData( PQgetvalue( queryResult.result(), row, col ), returnedLength );
+      feature.setGeometry( QgsGeometry( QgsGeometryFactory::geomFromTwkb( twkb ) ) );
+    }
+    else if ( returnedLength > 0 )
     {
       unsigned char *featureGeom = new unsigned char[returnedLength + 1];
       memcpy( featureGeom, PQgetvalue( queryResult.result(), row, col ), returnedLength );
@@ -854,7 +936,7 @@ void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult
 
 //  ------------------
 
-QgsPostgresFeatureSource::QgsPostgresFeatureSource( const QgsPostgresProvider *p )
+QgsPostgresFeatureSource::QgsPostgresFeatureSource( const QgsPostgresProvider *p, const QString &query, const QString &whereClause )
   : mConnInfo( p->mUri.connectionInfo( false ) )
   , mGeometryColumn( p->mGeometryColumn )
   , mBoundingBoxColumn( p->mBoundingBoxColumn )
@@ -867,13 +949,16 @@ QgsPostgresFeatureSource::QgsPostgresFeatureSource( const QgsPostgresProvider *p
   , mDetectedGeomType( p->mDetectedGeomType )
   , mPrimaryKeyType( p->mPrimaryKeyType )
   , mPrimaryKeyAttrs( p->mPrimaryKeyAttrs )
-  , mQuery( p->mQuery )
+  , mQuery( query.isEmpty() ? p->mQuery : query )
   , mCrs( p->crs() )
   , mShared( p->mShared )
 {
   if ( mSqlWhereClause.startsWith( QLatin1String( " WHERE " ) ) )
     mSqlWhereClause = mSqlWhereClause.mid( 7 );
 
+  if ( !whereClause.isEmpty() )
+    mSqlWhereClause = QgsPostgresUtils::andWhereClauses( mSqlWhereClause, whereClause );
+
   if ( p->mTransaction )
   {
     mTransactionConnection = p->mTransaction->connection();
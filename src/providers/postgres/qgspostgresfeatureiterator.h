@@ -18,6 +18,7 @@
 #include "qgsfeatureiterator.h"
 
 #include <QQueue>
+#include <QFuture>
 
 #include "qgspostgresprovider.h"
 
@@ -29,7 +30,13 @@ class QgsPostgresTransaction;
 class QgsPostgresFeatureSource : public QgsAbstractFeatureSource
 {
   public:
-    explicit QgsPostgresFeatureSource( const QgsPostgresProvider *p );
+
+    /**
+     * Constructor for QgsPostgresFeatureSource. Optional \a query and \a whereClause
+     * replace the FROM clause of the provider and are combined with its filter, to
+     * restrict the source to a part of the layer.
+     */
+    explicit QgsPostgresFeatureSource( const QgsPostgresProvider *p, const QString &query = QString(), const QString &whereClause = QString() );
     ~QgsPostgresFeatureSource() override;
 
     QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) override;
@@ -94,6 +101,19 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
+    //! Sends the FETCH of the next batch of features
+    void sendFetch();
+
+    /**
+     * Decodes the features returned by the FETCH of \a batchSize features sent
+     * with sendFetch() into \a queue. Returns TRUE if the batch is the last one
+     * of the cursor.
+     */
+    bool readFetchResult( QQueue<QgsFeature> &queue, int batchSize );
+
+    //! Waits for the batch of features being prefetched and discards it
+    void cancelPrefetch();
+
     QString mCursorName;
 
     /**
@@ -108,9 +128,27 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Number of retrieved features
     int mFetched = 0;
 
+    //! Sets to true, if the next batch is fetched while the current one is consumed
+    bool mPrefetch = false;
+
+    //! Sets to true, while the next batch is fetched and decoded
+    bool mPrefetching = false;
+
+    //! Fetch and decoding of the next batch, off the consumer thread
+    QFuture<void> mPrefetchFuture;
+
+    //! Next batch of features, swapped with mFeatureQueue once consumed
+    QQueue<QgsFeature> mPrefetchQueue;
+
+    //! Sets to true, if the prefetched batch is the last one
+    bool mPrefetchLastFetch = false;
+
     //! Sets to true, if geometry is in the requested columns
     bool mFetchGeometry = false;
 
+    //! Sets to true, if geometry is fetched as TWKB instead of WKB
+    bool mFetchTwkb = false;
+
     bool mIsTransactionConnection = false;
 
     bool providerCanSimplify( QgsSimplifyMethod::MethodType methodType ) const override;
@@ -28,6 +28,7 @@
 #include "qgsvectorlayer.h"
 
 #include <QMessageBox>
+#include <QtEndian>
 
 #include "qgsvectorlayerexporter.h"
 #include "qgspostgresprovider.h"
@@ -54,6 +55,9 @@ const QString QgsPostgresProvider::POSTGRES_DESCRIPTION = QStringLiteral( "Postg
 
 static const QString EDITOR_WIDGET_STYLES_TABLE = QStringLiteral( "qgis_editor_widget_styles" );
 
+//! Default number of rows sent at once by COPY in addFeatures(), 0 disables COPY
+static const int PG_DEFAULT_COPY_BATCH_SIZE = 1000;
+
 inline qint64 PKINT2FID( qint32 x )
 {
   return QgsPostgresUtils::int32pk_to_fid( x );
@@ -415,6 +419,103 @@ QgsFeatureIterator QgsPostgresProvider::getFeatures( const QgsFeatureRequest &re
   return QgsFeatureIterator( new QgsPostgresFeatureIterator( featureSrc, true, request ) );
 }
 
+QList<QgsFeatureIterator> QgsPostgresProvider::getParallelFeatures( const QgsFeatureRequest &request, int count ) const
+{
+  // Each iterator acquires its own connection from the pool, transaction
+  // connections are shared and would serialize the iterators anyway
+  if ( !mValid || mTransaction || count <= 1 || request.limit() >= 0 ||
+       request.filterType() == QgsFeatureRequest::FilterFid ||
+       request.filterType() == QgsFeatureRequest::FilterFids )
+  {
+    return QgsVectorDataProvider::getParallelFeatures( request, count );
+  }
+
+  const QList<QPair<QString, QString>> scans = parallelScans( count );
+  if ( scans.size() <= 1 )
+  {
+    return QgsVectorDataProvider::getParallelFeatures( request, count );
+  }
+
+  QList<QgsFeatureIterator> iterators;
+  for ( const QPair<QString, QString> &scan : scans )
+  {
+    QgsPostgresFeatureSource *featureSrc = new QgsPostgresFeatureSource( this, scan.first, scan.second );
+    iterators << QgsFeatureIterator( new QgsPostgresFeatureIterator( featureSrc, true, request ) );
+  }
+  return iterators;
+}
+
+QList<QPair<QString, QString>> QgsPostgresProvider::parallelScans( int count ) const
+{
+  QList<QPair<QString, QString>> scans;
+  const Relkind kind = relkind();
+
+  if ( kind == Relkind::PartitionedTable && mPrimaryKeyType != PktCtid && mPrimaryKeyType != PktOid )
+  {
+    QgsPostgresResult partitions( connectionRO()->PQexec( QStringLiteral( "SELECT inhrelid::regclass FROM pg_inherits WHERE inhparent=regclass(%1)::oid ORDER BY inhrelid" ).arg( quotedValue( mQuery ) ) ) );
+    // Attached partitions may not have the column order of the partitioned table
+    QgsPostgresResult columns( connectionRO()->PQexec( QStringLiteral( "SELECT string_agg(quote_ident(attname),',' ORDER BY attnum) FROM pg_attribute WHERE attrelid=regclass(%1)::oid AND attnum>0 AND NOT attisdropped" ).arg( quotedValue( mQuery ) ) ) );
+    if ( partitions.PQresultStatus() == PGRES_TUPLES_OK && partitions.PQntuples() > 1 &&
+         columns.PQresultStatus() == PGRES_TUPLES_OK && columns.PQntuples() == 1 )
+    {
+      const int groupCount = std::min( count, partitions.PQntuples() );
+      QVector<QStringList> groups( groupCount );
+      for ( int i = 0; i < partitions.PQntuples(); ++i )
+      {
+        groups[i % groupCount] << QStringLiteral( "SELECT %1 FROM %2" ).arg( columns.PQgetvalue( 0, 0 ), partitions.PQgetvalue( i, 0 ) );
+      }
+      for ( const QStringList &group : qgis::as_const( groups ) )
+      {
+        scans << qMakePair( QStringLiteral( "(%1) AS %2" ).arg( group.join( QStringLiteral( " UNION ALL " ) ), quotedIdentifier( QStringLiteral( "partitions" ) ) ), QString() );
+      }
+      return scans;
+    }
+  }
+
+  if ( ( mPrimaryKeyType == PktInt || mPrimaryKeyType == PktInt64 ) && mPrimaryKeyAttrs.size() == 1 )
+  {
+    const QString pk = quotedIdentifier( mAttributeFields.at( mPrimaryKeyAttrs.at( 0 ) ).name() );
+    QgsPostgresResult range( connectionRO()->PQexec( QStringLiteral( "SELECT min(%1),max(%1) FROM %2%3" ).arg( pk, mQuery, filterWhereClause() ) ) );
+    if ( range.PQresultStatus() == PGRES_TUPLES_OK && range.PQntuples() == 1 && !range.PQgetisnull( 0, 0 ) )
+    {
+      const qint64 min = range.PQgetvalue( 0, 0 ).toLongLong();
+      const quint64 span = static_cast<quint64>( range.PQgetvalue( 0, 1 ).toLongLong() ) - static_cast<quint64>( min );
+      const int rangeCount = static_cast<int>( std::min<quint64>( count, span ) );
+      // The first and last ranges are open, so that keys inserted in the meantime are not missed
+      QString lowerBound;
+      for ( int i = 1; i <= rangeCount; ++i )
+      {
+        const qint64 bound = static_cast<qint64>( static_cast<quint64>( min ) + span / rangeCount * i );
+        const QString upperBound = i < rangeCount ? QStringLiteral( "%1<%2" ).arg( pk ).arg( bound ) : QString();
+        scans << qMakePair( QString(), QgsPostgresUtils::andWhereClauses( lowerBound, upperBound ) );
+        lowerBound = QStringLiteral( "%1>=%2" ).arg( pk ).arg( bound );
+      }
+      return scans;
+    }
+  }
+
+  // Page ranges are only read efficiently with TID range scans, added in PostgreSQL 14
+  if ( ( kind == Relkind::OrdinaryTable || kind == Relkind::MaterializedView ) && connectionRO()->pgVersion() >= 140000 )
+  {
+    QgsPostgresResult pages( connectionRO()->PQexec( QStringLiteral( "SELECT relpages FROM pg_class WHERE oid=regclass(%1)::oid" ).arg( quotedValue( mQuery ) ) ) );
+    if ( pages.PQresultStatus() == PGRES_TUPLES_OK && pages.PQntuples() == 1 )
+    {
+      const qint64 pageCount = pages.PQgetvalue( 0, 0 ).toLongLong();
+      const int rangeCount = static_cast<int>( std::min<qint64>( count, pageCount ) );
+      QString lowerBound;
+      for ( int i = 1; i <= rangeCount; ++i )
+      {
+        const qint64 bound = pageCount * i / rangeCount;
+        const QString upperBound = i < rangeCount ? QStringLiteral( "ctid<'(%1,0)'::tid" ).arg( bound ) : QString();
+        scans << qMakePair( QString(), QgsPostgresUtils::andWhereClauses( lowerBound, upperBound ) );
+        lowerBound = QStringLiteral( "ctid>='(%1,0)'::tid" ).arg( bound );
+      }
+    }
+  }
+
+  return scans;
+}
+
 
 
 QString QgsPostgresProvider::pkParamWhereClause( int offset, const char *alias ) const
@@ -2102,6 +2203,23 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   {
     conn->begin();
 
+    // Bulk load with COPY when the ids and default values of the added
+    // features are not returned
+    const int copyBatchSize = QgsSettings().value( QStringLiteral( "PostgreSQL/copy_batch_size" ), PG_DEFAULT_COPY_BATCH_SIZE, QgsSettings::Providers ).toInt();
+    QgsAttributeList copiedAttributes;
+    if ( ( flags & QgsFeatureSink::FastInsert ) && copyBatchSize > 0 && copyAttributes( flist, copiedAttributes ) )
+    {
+      copyFeatures( conn, flist, copiedAttributes, copyBatchSize );
+
+      returnvalue &= conn->commit();
+      if ( mTransaction )
+        mTransaction->dirtyLastSavePoint();
+
+      mShared->addFeaturesCounted( flist.size() );
+      conn->unlock();
+      return returnvalue;
+    }
+
     // Prepare the INSERT statement
     QString insert = QStringLiteral( "INSERT INTO %1(" ).arg( mQuery );
     QString values;
@@ -2856,6 +2974,194 @@ bool QgsPostgresProvider::changeAttributeValues( const QgsChangedAttributesMap &
   return returnvalue;
 }
 
+bool QgsPostgresProvider::copyAttributes( const QgsFeatureList &flist, QgsAttributeList &attributes ) const
+{
+  if ( mSpatialColType == SctTopoGeometry )
+    return false;
+
+  // COPY only loads tables, views are edited through their INSERT rules or triggers
+  const Relkind kind = relkind();
+  if ( kind != Relkind::OrdinaryTable && kind != Relkind::PartitionedTable )
+    return false;
+
+  const int attributeCount = std::min( flist.at( 0 ).attributes().count(), mAttributeFields.count() );
+  for ( int idx = 0; idx < attributeCount; ++idx )
+  {
+    const QgsField fld = mAttributeFields.at( idx );
+    if ( fld.name().isEmpty() || fld.name() == mGeometryColumn )
+      continue;
+
+    // Arrays, hstore and json values have no COPY text representation yet
+    if ( fld.type() == QVariant::List || fld.type() == QVariant::StringList || fld.type() == QVariant::Map )
+      return false;
+
+    const QString defVal = defaultValueClause( idx );
+    int defaults = 0;
+    if ( !defVal.isEmpty() )
+    {
+      // NULL is loaded as NULL, except in a single key filled by a sequence
+      // which is left to the sequence as INSERT does
+      const bool nullIsDefault = ( mPrimaryKeyType == PktInt || mPrimaryKeyType == PktFidMap || mPrimaryKeyType == PktUint64 ) &&
+                                 mPrimaryKeyAttrs.size() == 1 && mPrimaryKeyAttrs.at( 0 ) == idx &&
+                                 defVal.startsWith( QLatin1String( "nextval(" ) );
+      for ( const QgsFeature &feature : flist )
+      {
+        const QVariant v = feature.attributes().value( idx, QVariant( QVariant::Int ) );
+        if ( v.isNull() ? nullIsDefault : v.toString() == defVal )
+          defaults++;
+      }
+    }
+
+    // Columns left to their default value are omitted so that COPY evaluates
+    // the default, but a column cannot mix values and defaults
+    if ( defaults == flist.size() )
+      continue;
+    if ( defaults > 0 )
+      return false;
+
+    attributes << idx;
+  }
+
+  return !mGeometryColumn.isNull() || !attributes.isEmpty();
+}
+
+// Returns the COPY text format of a value
+static QByteArray copyValue( const QString &value, bool isNull )
+{
+  if ( isNull )
+    return QByteArrayLiteral( "\\N" );
+
+  const QByteArray utf8 = value.toUtf8();
+  QByteArray escaped;
+  escaped.reserve( utf8.size() );
+  for ( const char c : utf8 )
+  {
+    switch ( c )
+    {
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\t':
+        escaped += "\\t";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      case '\r':
+        escaped += "\\r";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void QgsPostgresProvider::copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist, const QgsAttributeList &attributes, int batchSize ) const
+{
+  QStringList columns;
+  if ( !mGeometryColumn.isNull() )
+    columns << quotedIdentifier( mGeometryColumn );
+  for ( int idx : attributes )
+    columns << quotedIdentifier( mAttributeFields.at( idx ).name() );
+
+  const QString copy = QStringLiteral( "COPY %1(%2) FROM STDIN" ).arg( mQuery, columns.join( ',' ) );
+  QgsDebugMsg( QStringLiteral( "copy addfeatures: %1" ).arg( copy ) );
+
+  if ( !conn->PQsendQuery( copy ) )
+    throw PGException( conn->PQerrorMessage() );
+
+  QgsPostgresResult result( conn->PQgetResult() );
+  if ( result.PQresultStatus() != PGRES_COPY_IN )
+  {
+    PGException e( result );
+    while ( ( result = conn->PQgetResult() ).result() )
+      ;
+    throw e;
+  }
+
+  QByteArray rows;
+  int rowCount = 0;
+  for ( const QgsFeature &feature : flist )
+  {
+    QList<QByteArray> values;
+    if ( !mGeometryColumn.isNull() )
+      values << copyGeometryValue( feature.geometry() );
+
+    const QgsAttributes attrs = feature.attributes();
+    for ( int idx : attributes )
+    {
+      const QVariant value = attrs.value( idx, QVariant( QVariant::Int ) );
+      if ( mAttributeFields.at( idx ).typeName() == QLatin1String( "bytea" ) && !value.isNull() )
+        values << copyValue( QStringLiteral( "\\x" ) + QString::fromLatin1( value.toByteArray().toHex() ), false );
+      else
+        values << copyValue( value.toString(), value.isNull() );
+    }
+
+    rows += values.join( '\t' );
+    rows += '\n';
+
+    if ( ++rowCount % batchSize == 0 || rowCount == flist.size() )
+    {
+      if ( conn->PQputCopyData( rows ) != 1 )
+      {
+        const QString error = conn->PQerrorMessage();
+        conn->PQputCopyEnd( error );
+        while ( ( result = conn->PQgetResult() ).result() )
+          ;
+        throw PGException( error );
+      }
+      rows.clear();
+    }
+  }
+
+  if ( conn->PQputCopyEnd() != 1 )
+    throw PGException( conn->PQerrorMessage() );
+
+  result = conn->PQgetResult();
+  if ( result.PQresultStatus() != PGRES_COMMAND_OK )
+  {
+    PGException e( result );
+    while ( ( result = conn->PQgetResult() ).result() )
+      ;
+    throw e;
+  }
+  while ( ( result = conn->PQgetResult() ).result() )
+    ;
+}
+
+QByteArray QgsPostgresProvider::copyGeometryValue( const QgsGeometry &geom ) const
+{
+  if ( geom.isNull() )
+    return QByteArrayLiteral( "\\N" );
+
+  QgsGeometry convertedGeom( convertToProviderType( geom ) );
+  QByteArray wkb( !convertedGeom.isNull() ? convertedGeom.asWkb() : geom.asWkb() );
+
+  // EWKB: flag the SRID in the geometry type and write it after the type
+  bool ok = false;
+  const quint32 srid = ( mRequestedSrid.isEmpty() ? mDetectedSrid : mRequestedSrid ).toUInt( &ok );
+  if ( ok && srid > 0 && wkb.size() >= 5 )
+  {
+    const bool littleEndian = wkb.at( 0 ) == 1;
+    const quint32 type = ( littleEndian ? qFromLittleEndian<quint32>( wkb.constData() + 1 ) : qFromBigEndian<quint32>( wkb.constData() + 1 ) ) | 0x20000000;
+    char header[8];
+    if ( littleEndian )
+    {
+      qToLittleEndian<quint32>( type, header );
+      qToLittleEndian<quint32>( srid, header + 4 );
+    }
+    else
+    {
+      qToBigEndian<quint32>( type, header );
+      qToBigEndian<quint32>( srid, header + 4 );
+    }
+    wkb.replace( 1, 4, QByteArray( header, 8 ) );
+  }
+
+  return wkb.toHex();
+}
+
 void QgsPostgresProvider::appendGeomParam( const QgsGeometry &geom, QStringList &params ) const
 {
   if ( geom.isNull() )
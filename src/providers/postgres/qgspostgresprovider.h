@@ -103,6 +103,7 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     QString storageType() const override;
     QgsCoordinateReferenceSystem crs() const override;
     QgsFeatureIterator getFeatures( const QgsFeatureRequest &request ) const override;
+    QList<QgsFeatureIterator> getParallelFeatures( const QgsFeatureRequest &request, int count ) const override;
     QgsWkbTypes::Type wkbType() const override;
     QgsLayerMetadata layerMetadata() const override;
 
@@ -242,6 +243,15 @@ class QgsPostgresProvider : public QgsVectorDataProvider
   private:
     Relkind relkind() const;
 
+    /**
+     * Returns the FROM and WHERE clauses of up to \a count disjoint scans covering
+     * the features of the layer: one scan per group of partitions for partitioned
+     * tables, primary key ranges for integer primary keys or, with PostgreSQL >= 14,
+     * page ranges of the table scanned with TID range scans.
+     * Returns an empty list if the layer cannot be split.
+     */
+    QList<QPair<QString, QString>> parallelScans( int count ) const;
+
     bool declareCursor( const QString &cursorName,
                         const QgsAttributeList &fetchAttributes,
                         bool fetchGeometry,
@@ -422,6 +432,10 @@ class QgsPostgresProvider : public QgsVectorDataProvider
           : mWhat( r.PQresultErrorMessage() )
         {}
 
+        explicit PGException( const QString &what )
+          : mWhat( what )
+        {}
+
         QString errorMessage() const
         {
           return mWhat;
@@ -437,6 +451,18 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     QgsVectorDataProvider::Capabilities mEnabledCapabilities = nullptr;
 
     void appendGeomParam( const QgsGeometry &geom, QStringList &param ) const;
+
+    /**
+     * Returns in \a attributes the attributes of \a flist to add with COPY, or
+     * FALSE if COPY cannot be used (e.g. a column mixes values and defaults).
+     */
+    bool copyAttributes( const QgsFeatureList &flist, QgsAttributeList &attributes ) const;
+
+    //! Adds the \a attributes of \a flist with COPY, sending \a batchSize rows at once
+    void copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist, const QgsAttributeList &attributes, int batchSize ) const;
+
+    //! Returns the hex EWKB of \a geom in the provider geometry type for COPY
+    QByteArray copyGeometryValue( const QgsGeometry &geom ) const;
     void appendPkParams( QgsFeatureId fid, QStringList &param ) const;
 
     QString paramValue( const QString &fieldvalue, const QString &defaultValue ) const;
@@ -21,13 +21,82 @@ email                : hugo dot mercier at oslandia dot com
 #include "qgsvirtuallayerblob.h"
 #include "qgsexception.h"
 
+#include <algorithm>
 #include <stdexcept>
+#include <QtConcurrentMap>
 
 static QString quotedColumn( QString name )
 {
   return "\"" + name.replace( QLatin1String( "\"" ), QLatin1String( "\"\"" ) ) + "\"";
 }
 
+// returns the attributes to fetch for a request
+static QgsAttributeList requestedAttributes( const QgsFeatureRequest &request, const QgsFields &fields )
+{
+  if ( !( request.flags() & QgsFeatureRequest::SubsetOfAttributes ) )
+    return fields.allAttributesList();
+
+  // copy only selected fields
+  QgsAttributeList attributes;
+  const auto subsetOfAttributes = request.subsetOfAttributes();
+  for ( int idx : subsetOfAttributes )
+  {
+    attributes << idx;
+  }
+
+  // ensure that all attributes required for expression filter are being fetched
+  if ( request.filterType() == QgsFeatureRequest::FilterExpression )
+  {
+    const auto constReferencedColumns = request.filterExpression()->referencedColumns();
+    for ( const QString &field : constReferencedColumns )
+    {
+      int attrIdx = fields.lookupField( field );
+      if ( !attributes.contains( attrIdx ) )
+        attributes << attrIdx;
+    }
+  }
+
+  // also need attributes required by order by
+  if ( !request.orderBy().isEmpty() )
+  {
+    const auto usedAttributeIndices = request.orderBy().usedAttributeIndices( fields );
+    for ( int attrIdx : usedAttributeIndices )
+    {
+      if ( !attributes.contains( attrIdx ) )
+        attributes << attrIdx;
+    }
+  }
+  return attributes;
+}
+
+static bool isNumeric( const QVariant &value )
+{
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+    case QVariant::Bool:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// compares non null values as SQLite does, numbers come before the other values
+static bool sqliteLessThan( const QVariant &left, const QVariant &right )
+{
+  const bool leftNumeric = isNumeric( left );
+  const bool rightNumeric = isNumeric( right );
+  if ( leftNumeric && rightNumeric )
+    return left.toDouble() < right.toDouble();
+  if ( leftNumeric != rightNumeric )
+    return leftNumeric;
+  return qgsVariantLessThan( left, right );
+}
+
 QgsVirtualLayerFeatureIterator::QgsVirtualLayerFeatureIterator( QgsVirtualLayerFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsVirtualLayerFeatureSource>( source, ownSource, request )
 {
@@ -126,42 +195,7 @@ QgsVirtualLayerFeatureIterator::QgsVirtualLayerFeatureIterator( QgsVirtualLayerF
       }
     }
 
-    if ( request.flags() & QgsFeatureRequest::SubsetOfAttributes )
-    {
-      // copy only selected fields
-      const auto subsetOfAttributes = request.subsetOfAttributes();
-      for ( int idx : subsetOfAttributes )
-      {
-        mAttributes << idx;
-      }
-
-      // ensure that all attributes required for expression filter are being fetched
-      if ( request.filterType() == QgsFeatureRequest::FilterExpression )
-      {
-        const auto constReferencedColumns = request.filterExpression()->referencedColumns();
-        for ( const QString &field : constReferencedColumns )
-        {
-          int attrIdx = mSource->mFields.lookupField( field );
-          if ( !mAttributes.contains( attrIdx ) )
-            mAttributes << attrIdx;
-        }
-      }
-
-      // also need attributes required by order by
-      if ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes && !mRequest.orderBy().isEmpty() )
-      {
-        const auto usedAttributeIndices = mRequest.orderBy().usedAttributeIndices( mSource->mFields );
-        for ( int attrIdx : usedAttributeIndices )
-        {
-          if ( !mAttributes.contains( attrIdx ) )
-            mAttributes << attrIdx;
-        }
-      }
-    }
-    else
-    {
-      mAttributes = mSource->mFields.allAttributesList();
-    }
+    mAttributes = requestedAttributes( request, mSource->mFields );
 
     QString columns;
     {
@@ -341,6 +375,449 @@ bool QgsVirtualLayerFeatureIterator::fetchFeature( QgsFeature &feature )
   return true;
 }
 
+QgsVirtualLayerNativeFeatureIterator::QgsVirtualLayerNativeFeatureIterator( QgsVirtualLayerFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
+  : QgsAbstractFeatureIteratorFromSource<QgsVirtualLayerFeatureSource>( source, ownSource, request )
+{
+  if ( mRequest.destinationCrs().isValid() && mRequest.destinationCrs() != mSource->mCrs )
+  {
+    mTransform = QgsCoordinateTransform( mSource->mCrs, mRequest.destinationCrs(), mRequest.transformContext() );
+  }
+  try
+  {
+    mFilterRect = filterRectToSourceCrs( mTransform );
+  }
+  catch ( QgsCsException & )
+  {
+    // can't reproject mFilterRect
+    close();
+    return;
+  }
+
+  if ( !mFilterRect.isNull() && mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+  {
+    // if an exact intersection is requested, prepare the geometry to intersect
+    QgsGeometry rectGeom = QgsGeometry::fromRect( mFilterRect );
+    mRectEngine.reset( QgsGeometry::createGeometryEngine( rectGeom.constGet() ) );
+    mRectEngine->prepareGeometry();
+  }
+
+  if ( !mSource->mDefinition.uid().isNull() )
+    mUidIndex = mSource->mFields.lookupField( mSource->mDefinition.uid() );
+
+  mAttributes = requestedAttributes( request, mSource->mFields );
+  if ( mUidIndex != -1 && !mAttributes.contains( mUidIndex ) )
+    mAttributes << mUidIndex;
+
+  if ( mRequest.filterType() == QgsFeatureRequest::FilterFid )
+  {
+    mMaxFilterFid = mRequest.filterFid();
+  }
+  else if ( mRequest.filterType() == QgsFeatureRequest::FilterFids && !mRequest.filterFids().isEmpty() )
+  {
+    const QgsFeatureIds &fids = mRequest.filterFids();
+    mMaxFilterFid = *std::max_element( fids.constBegin(), fids.constEnd() );
+  }
+
+  const QgsVirtualLayerNativeQuery::Column &geometryColumn = query().geometry();
+  mFetchGeometry = geometryColumn.table != -1 &&
+                   ( !( request.flags() & QgsFeatureRequest::NoGeometry ) || !mFilterRect.isNull() ||
+                     ( request.filterType() == QgsFeatureRequest::FilterExpression && request.filterExpression()->needsGeometry() ) );
+
+  // requests of the layers
+  QVector<QgsFeatureRequest> requests;
+  QVector<QStringList> fetchedFields;
+  const QVector<QgsVirtualLayerNativeQuery::Table> &tables = query().tables();
+  for ( int i = 0; i < tables.size(); i++ )
+  {
+    QgsFeatureRequest layerRequest;
+    QStringList filters;
+    const QStringList tableFilters = tables.at( i ).filters;
+    for ( const QString &filter : tableFilters )
+      filters << QStringLiteral( "(%1)" ).arg( filter );
+    if ( !filters.isEmpty() )
+      layerRequest.setFilterExpression( filters.join( QStringLiteral( " AND " ) ) );
+
+    const bool joinOnGeometry = query().joinType() == QgsVirtualLayerNativeQuery::SpatialJoin;
+    if ( !joinOnGeometry && !( mFetchGeometry && geometryColumn.table == i ) )
+      layerRequest.setFlags( QgsFeatureRequest::NoGeometry );
+    // the rectangle can be tested on the layer providing the geometry, unless
+    // feature ids are row numbers which must not depend on the rectangle
+    if ( geometryColumn.table == i && !mFilterRect.isNull() && mUidIndex != -1 )
+    {
+      layerRequest.setFilterRect( mFilterRect );
+      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+        layerRequest.setFlags( layerRequest.flags() | QgsFeatureRequest::ExactIntersect );
+    }
+    requests << layerRequest;
+    fetchedFields << QStringList();
+  }
+
+  // attributes of the layers, resolved by name since the fields of the layers may have changed
+  mSourceAttributes.fill( -1, mSource->mFields.count() );
+  for ( int idx : qgis::as_const( mAttributes ) )
+  {
+    if ( idx < 0 || idx >= query().attributes().size() )
+      continue;
+    const QgsVirtualLayerNativeQuery::Column &column = query().attributes().at( idx );
+    // COUNT(*) reads no attribute
+    if ( column.field.isEmpty() )
+      continue;
+    mSourceAttributes[idx] = mSource->mNativeSources.at( column.table )->fields().lookupField( column.field );
+    if ( mSourceAttributes.at( idx ) == -1 )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Field %1 not found in layer %2" ).arg( column.field, tables.at( column.table ).name ), QObject::tr( "VLayer" ) );
+      close();
+      return;
+    }
+    fetchedFields[column.table] << column.field;
+  }
+  if ( query().joinType() == QgsVirtualLayerNativeQuery::EquiJoin )
+  {
+    mProbeJoinField = mSource->mNativeSources.at( 0 )->fields().lookupField( query().joinFields().first );
+    mBuildJoinField = mSource->mNativeSources.at( 1 )->fields().lookupField( query().joinFields().second );
+    if ( mProbeJoinField == -1 || mBuildJoinField == -1 )
+    {
+      close();
+      return;
+    }
+    fetchedFields[0] << query().joinFields().first;
+    fetchedFields[1] << query().joinFields().second;
+  }
+  for ( int i = 0; i < requests.size(); i++ )
+  {
+    requests[i].setSubsetOfAttributes( fetchedFields.at( i ), mSource->mNativeSources.at( i )->fields() );
+  }
+
+  mProbeRequest = requests.at( 0 );
+  if ( requests.size() > 1 )
+    mBuildRequest = requests.at( 1 );
+  if ( query().isAggregate() )
+    mAggregateValues.resize( mSource->mFields.count() );
+  mProbeIterator = mSource->mNativeSources.at( 0 )->getFeatures( mProbeRequest );
+}
+
+QgsVirtualLayerNativeFeatureIterator::~QgsVirtualLayerNativeFeatureIterator()
+{
+  close();
+}
+
+bool QgsVirtualLayerNativeFeatureIterator::rewind()
+{
+  if ( mClosed )
+  {
+    return false;
+  }
+
+  mProbeIterator = mSource->mNativeSources.at( 0 )->getFeatures( mProbeRequest );
+  mPendingFeatures.clear();
+  mAggregateValues.fill( AggregateValue() );
+  mAggregated = false;
+  mFid = 0;
+  return true;
+}
+
+bool QgsVirtualLayerNativeFeatureIterator::close()
+{
+  if ( mClosed )
+  {
+    return false;
+  }
+
+  mProbeIterator.close();
+  mPendingFeatures.clear();
+
+  // this call is absolutely needed
+  iteratorClosed();
+
+  mClosed = true;
+  return true;
+}
+
+void QgsVirtualLayerNativeFeatureIterator::buildJoinTable()
+{
+  mJoinTableBuilt = true;
+
+  QgsFeatureIterator it = mSource->mNativeSources.at( 1 )->getFeatures( mBuildRequest );
+  QgsFeature f;
+  while ( it.nextFeature( f ) )
+  {
+    if ( query().joinType() == QgsVirtualLayerNativeQuery::EquiJoin )
+    {
+      // null values never match
+      const QString key = QgsVirtualLayerNativeQuery::joinKey( f.attribute( mBuildJoinField ) );
+      if ( key.isEmpty() )
+        continue;
+      mHashTable.insert( key, mBuildFeatures.size() );
+    }
+    else
+    {
+      if ( !f.hasGeometry() )
+        continue;
+      mSpatialIndex.addFeature( mBuildFeatures.size(), f.geometry().boundingBox() );
+    }
+    mBuildFeatures << f;
+  }
+}
+
+bool QgsVirtualLayerNativeFeatureIterator::fetchNextBatch()
+{
+  // features of the first layer matched at once
+  const int batchSize = 1000;
+
+  struct Match
+  {
+    QgsFeature feature;
+    QVector<int> matches;
+  };
+  QVector<Match> batch;
+  QgsFeature f;
+  while ( batch.size() < batchSize && mProbeIterator.nextFeature( f ) )
+  {
+    Match match;
+    match.feature = f;
+    batch << match;
+  }
+  if ( batch.isEmpty() )
+  {
+    // the aggregates make a single row, once all the rows have been read
+    if ( query().isAggregate() && !mAggregated )
+    {
+      mAggregated = true;
+      mPendingFeatures.enqueue( createFeature( QgsFeature(), QgsFeature() ) );
+      return true;
+    }
+    return false;
+  }
+
+  if ( query().joinType() == QgsVirtualLayerNativeQuery::NoJoin )
+  {
+    for ( const Match &match : qgis::as_const( batch ) )
+      addRow( match.feature, QgsFeature() );
+    return true;
+  }
+
+  if ( !mJoinTableBuilt )
+    buildJoinTable();
+
+  const QgsVirtualLayerNativeQuery::JoinType joinType = query().joinType();
+  const QMultiHash<QString, int> &hashTable = mHashTable;
+  const QVector<QgsFeature> &buildFeatures = mBuildFeatures;
+  const QgsSpatialIndex &spatialIndex = mSpatialIndex;
+  const int probeJoinField = mProbeJoinField;
+  QtConcurrent::blockingMap( batch, [joinType, &hashTable, &buildFeatures, &spatialIndex, probeJoinField]( Match & match )
+  {
+    if ( joinType == QgsVirtualLayerNativeQuery::EquiJoin )
+    {
+      const QString key = QgsVirtualLayerNativeQuery::joinKey( match.feature.attribute( probeJoinField ) );
+      if ( key.isEmpty() )
+        return;
+      match.matches = hashTable.values( key ).toVector();
+    }
+    else
+    {
+      if ( !match.feature.hasGeometry() )
+        return;
+      const QList<QgsFeatureId> candidates = spatialIndex.intersects( match.feature.geometry().boundingBox() );
+      if ( candidates.isEmpty() )
+        return;
+      std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( match.feature.geometry().constGet() ) );
+      engine->prepareGeometry();
+      for ( QgsFeatureId candidate : candidates )
+      {
+        if ( engine->intersects( buildFeatures.at( static_cast< int >( candidate ) ).geometry().constGet() ) )
+          match.matches << static_cast< int >( candidate );
+      }
+    }
+    // keep the order of the second layer
+    std::sort( match.matches.begin(), match.matches.end() );
+  } );
+
+  for ( const Match &match : qgis::as_const( batch ) )
+  {
+    for ( int index : match.matches )
+      addRow( match.feature, mBuildFeatures.at( index ) );
+  }
+  return true;
+}
+
+void QgsVirtualLayerNativeFeatureIterator::addRow( const QgsFeature &first, const QgsFeature &second )
+{
+  if ( !query().isAggregate() )
+  {
+    mPendingFeatures.enqueue( createFeature( first, second ) );
+    return;
+  }
+
+  for ( int idx : qgis::as_const( mAttributes ) )
+  {
+    if ( idx < 0 || idx >= mAggregateValues.size() )
+      continue;
+    const QgsVirtualLayerNativeQuery::Column &column = query().attributes().at( idx );
+    AggregateValue &aggregate = mAggregateValues[idx];
+    // COUNT(*)
+    if ( column.field.isEmpty() )
+    {
+      aggregate.count++;
+      continue;
+    }
+
+    // null values are ignored, as by SQLite
+    const QVariant value = ( column.table == 0 ? first : second ).attribute( mSourceAttributes.at( idx ) );
+    if ( value.isNull() )
+      continue;
+    if ( column.distinct )
+    {
+      const int distinctCount = aggregate.distinctValues.size();
+      aggregate.distinctValues.insert( QgsVirtualLayerNativeQuery::joinKey( value ) );
+      if ( aggregate.distinctValues.size() == distinctCount )
+        continue;
+    }
+    aggregate.count++;
+
+    switch ( column.aggregate )
+    {
+      case QgsVirtualLayerNativeQuery::Sum:
+      case QgsVirtualLayerNativeQuery::Average:
+        // the sum of integers is an integer
+        if ( isNumeric( value ) && value.type() != QVariant::Double )
+          aggregate.integerSum += value.toLongLong();
+        else
+          aggregate.integerValues = false;
+        aggregate.sum += value.toDouble();
+        break;
+      case QgsVirtualLayerNativeQuery::Minimum:
+        if ( aggregate.value.isNull() || sqliteLessThan( value, aggregate.value ) )
+          aggregate.value = value;
+        break;
+      case QgsVirtualLayerNativeQuery::Maximum:
+        if ( aggregate.value.isNull() || sqliteLessThan( aggregate.value, value ) )
+          aggregate.value = value;
+        break;
+      case QgsVirtualLayerNativeQuery::Count:
+      case QgsVirtualLayerNativeQuery::NoAggregate:
+        break;
+    }
+  }
+}
+
+QgsFeature QgsVirtualLayerNativeFeatureIterator::createFeature( const QgsFeature &first, const QgsFeature &second )
+{
+  QgsFeature feature( mSource->mFields );
+  for ( int idx : qgis::as_const( mAttributes ) )
+  {
+    if ( idx < 0 || idx >= mSourceAttributes.size() )
+      continue;
+    const QgsVirtualLayerNativeQuery::Column &column = query().attributes().at( idx );
+    QVariant value;
+    if ( !query().isAggregate() )
+    {
+      value = ( column.table == 0 ? first : second ).attribute( mSourceAttributes.at( idx ) );
+    }
+    else
+    {
+      // the sum and the average of no value are null
+      const AggregateValue &aggregate = mAggregateValues.at( idx );
+      switch ( column.aggregate )
+      {
+        case QgsVirtualLayerNativeQuery::Count:
+          value = aggregate.count;
+          break;
+        case QgsVirtualLayerNativeQuery::Sum:
+          if ( aggregate.count > 0 )
+            value = aggregate.integerValues ? QVariant( aggregate.integerSum ) : QVariant( aggregate.sum );
+          break;
+        case QgsVirtualLayerNativeQuery::Average:
+          if ( aggregate.count > 0 )
+            value = aggregate.sum / aggregate.count;
+          break;
+        case QgsVirtualLayerNativeQuery::Minimum:
+        case QgsVirtualLayerNativeQuery::Maximum:
+          value = aggregate.value;
+          break;
+        case QgsVirtualLayerNativeQuery::NoAggregate:
+          break;
+      }
+    }
+    // values have the types of the virtual layer fields, as with SQLite
+    mSource->mFields.at( idx ).convertCompatible( value );
+    feature.setAttribute( idx, value );
+  }
+
+  if ( mFetchGeometry )
+  {
+    const QgsFeature &geometryFeature = query().geometry().table == 0 ? first : second;
+    if ( geometryFeature.hasGeometry() )
+      feature.setGeometry( geometryFeature.geometry() );
+  }
+
+  if ( mUidIndex != -1 )
+  {
+    feature.setId( feature.attribute( mUidIndex ).toLongLong() );
+  }
+  else
+  {
+    // no id column => autoincrement
+    feature.setId( mFid++ );
+  }
+  feature.setValid( true );
+  return feature;
+}
+
+bool QgsVirtualLayerNativeFeatureIterator::fetchFeature( QgsFeature &feature )
+{
+  feature.setValid( false );
+
+  if ( mClosed )
+  {
+    return false;
+  }
+
+  while ( true )
+  {
+    if ( mPendingFeatures.isEmpty() && !fetchNextBatch() )
+    {
+      return false;
+    }
+    if ( mPendingFeatures.isEmpty() )
+    {
+      continue;
+    }
+
+    QgsFeature f = mPendingFeatures.dequeue();
+    if ( ( mRequest.filterType() == QgsFeatureRequest::FilterFid && f.id() != mRequest.filterFid() ) ||
+         ( mRequest.filterType() == QgsFeatureRequest::FilterFids && !mRequest.filterFids().contains( f.id() ) ) )
+    {
+      // without id column, ids are row numbers: the last requested feature has been passed
+      if ( mUidIndex == -1 && f.id() > mMaxFilterFid )
+        return false;
+      continue;
+    }
+
+    // the rectangle may already have been tested by the layer providing the geometry
+    if ( !mFilterRect.isNull() )
+    {
+      if ( !f.hasGeometry() )
+        continue;
+      if ( mRequest.flags() & QgsFeatureRequest::ExactIntersect )
+      {
+        if ( !mRectEngine->intersects( f.geometry().constGet() ) )
+          continue;
+      }
+      else if ( !f.geometry().boundingBox().intersects( mFilterRect ) )
+      {
+        continue;
+      }
+    }
+
+    if ( mRequest.flags() & QgsFeatureRequest::NoGeometry && !( mRequest.filterType() == QgsFeatureRequest::FilterExpression && mRequest.filterExpression()->needsGeometry() ) )
+      f.clearGeometry();
+
+    feature = f;
+    geometryToDestinationCrs( feature, mTransform );
+    return true;
+  }
+}
+
 QgsVirtualLayerFeatureSource::QgsVirtualLayerFeatureSource( const QgsVirtualLayerProvider *p )
   : mProvider( p )
   , mDefinition( p->mDefinition )
@@ -350,9 +827,28 @@ QgsVirtualLayerFeatureSource::QgsVirtualLayerFeatureSource( const QgsVirtualLaye
   , mSubset( p->mSubset )
   , mCrs( p->crs() )
 {
+  // the subset string is a SQL filter, only SQLite can apply it
+  if ( p->mNativeQuery && mSubset.isEmpty() )
+  {
+    const QVector<QgsVirtualLayerNativeQuery::Table> &tables = p->mNativeQuery->tables();
+    for ( const QgsVirtualLayerNativeQuery::Table &table : tables )
+    {
+      // the layer has been removed
+      if ( !table.layer )
+      {
+        mNativeSources.clear();
+        break;
+      }
+      mNativeSources.emplace_back( qgis::make_unique< QgsVectorLayerFeatureSource >( table.layer ) );
+    }
+    if ( !mNativeSources.empty() )
+      mNativeQuery = p->mNativeQuery;
+  }
 }
 
 QgsFeatureIterator QgsVirtualLayerFeatureSource::getFeatures( const QgsFeatureRequest &request )
 {
+  if ( mNativeQuery )
+    return QgsFeatureIterator( new QgsVirtualLayerNativeFeatureIterator( this, false, request ) );
   return QgsFeatureIterator( new QgsVirtualLayerFeatureIterator( this, false, request ) );
 }
@@ -19,11 +19,18 @@ email                : hugo dot mercier at oslandia dot com
 
 
 #include "qgsvirtuallayerprovider.h"
+#include "qgsvirtuallayernativequery.h"
 #include "qgsfeatureiterator.h"
 #include "qgsgeometryengine.h"
+#include "qgsspatialindex.h"
+#include "qgsvectorlayerfeatureiterator.h"
 
 #include <memory>
+#include <vector>
+#include <QHash>
 #include <QPointer>
+#include <QQueue>
+#include <QSet>
 
 class QgsVirtualLayerFeatureSource : public QgsAbstractFeatureSource
 {
@@ -49,7 +56,14 @@ class QgsVirtualLayerFeatureSource : public QgsAbstractFeatureSource
     QString mSubset;
     QgsCoordinateReferenceSystem mCrs;
 
+    // query executed on the source layers rather than by SQLite, if supported
+    std::shared_ptr< const QgsVirtualLayerNativeQuery > mNativeQuery;
+    // sources of the layers of the native query
+    std::vector< std::unique_ptr< QgsVectorLayerFeatureSource > > mNativeSources;
+
     friend class QgsVirtualLayerFeatureIterator;
+    friend class QgsVirtualLayerNativeFeatureIterator;
+    friend class QgsVirtualLayerProvider;
 };
 
 class QgsVirtualLayerFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsVirtualLayerFeatureSource>
@@ -78,4 +92,79 @@ class QgsVirtualLayerFeatureIterator : public QgsAbstractFeatureIteratorFromSour
     std::unique_ptr< QgsGeometryEngine > mRectEngine;
 };
 
+/**
+ * Iterator on the result of a native query, which reads the features of the
+ * source layers rather than going through SQLite.
+ * The second layer of a join is loaded in a hash table or a spatial index, the
+ * features of the first one are then matched by batches, in parallel.
+ */
+class QgsVirtualLayerNativeFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsVirtualLayerFeatureSource>
+{
+  public:
+    QgsVirtualLayerNativeFeatureIterator( QgsVirtualLayerFeatureSource *source, bool ownSource, const QgsFeatureRequest &request );
+    ~QgsVirtualLayerNativeFeatureIterator() override;
+
+    bool rewind() override;
+    bool close() override;
+
+  protected:
+
+    bool fetchFeature( QgsFeature &feature ) override;
+
+  private:
+
+    // loads the second layer of a join
+    void buildJoinTable();
+
+    // fills mPendingFeatures with the result of the next batch of features of the first layer
+    bool fetchNextBatch();
+
+    // adds a row of the result, made of a feature of each layer
+    void addRow( const QgsFeature &first, const QgsFeature &second );
+
+    // creates a feature of the virtual layer from a feature of each layer, or from the aggregated values
+    QgsFeature createFeature( const QgsFeature &first, const QgsFeature &second );
+
+    const QgsVirtualLayerNativeQuery &query() const { return *mSource->mNativeQuery; }
+
+    QgsAttributeList mAttributes;
+    // index in its layer of each attribute of the virtual layer, -1 if not fetched
+    QVector<int> mSourceAttributes;
+    bool mFetchGeometry = false;
+    int mUidIndex = -1;
+
+    QgsFeatureRequest mProbeRequest;
+    QgsFeatureIterator mProbeIterator;
+    QQueue<QgsFeature> mPendingFeatures;
+
+    bool mJoinTableBuilt = false;
+    QgsFeatureRequest mBuildRequest;
+    QVector<QgsFeature> mBuildFeatures;
+    QMultiHash<QString, int> mHashTable;
+    int mProbeJoinField = -1;
+    int mBuildJoinField = -1;
+    QgsSpatialIndex mSpatialIndex;
+
+    // values of an aggregate over the rows read so far
+    struct AggregateValue
+    {
+      qlonglong count = 0;
+      double sum = 0;
+      qlonglong integerSum = 0;
+      bool integerValues = true;
+      QVariant value;
+      QSet<QString> distinctValues;
+    };
+    QVector<AggregateValue> mAggregateValues;
+    bool mAggregated = false;
+
+    QgsFeatureId mFid = 0;
+    // last requested id, when ids are row numbers
+    QgsFeatureId mMaxFilterFid = -1;
+    QgsCoordinateTransform mTransform;
+    QgsRectangle mFilterRect;
+
+    std::unique_ptr< QgsGeometryEngine > mRectEngine;
+};
+
 #endif
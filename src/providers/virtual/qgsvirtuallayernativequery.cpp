@@ -0,0 +1,497 @@
+/***************************************************************************
+          qgsvirtuallayernativequery.cpp : Native execution of virtual layer queries
+begin                : Oct 2019
+copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsvirtuallayernativequery.h"
+#include "qgis.h"
+#include "qgsvectorlayer.h"
+#include "qgsexpression.h"
+
+// the vtable of a layer exposes its geometry in a column named "geometry"
+static const QString GEOMETRY_COLUMN = QStringLiteral( "geometry" );
+
+// splits a condition into the terms of its conjunction
+static void splitConjunction( const QgsSQLStatement::Node *node, QList<const QgsSQLStatement::Node *> &terms )
+{
+  if ( node->nodeType() == QgsSQLStatement::ntBinaryOperator )
+  {
+    const QgsSQLStatement::NodeBinaryOperator *op = static_cast<const QgsSQLStatement::NodeBinaryOperator *>( node );
+    if ( op->op() == QgsSQLStatement::boAnd )
+    {
+      splitConjunction( op->opLeft(), terms );
+      splitConjunction( op->opRight(), terms );
+      return;
+    }
+  }
+  terms << node;
+}
+
+std::unique_ptr< QgsVirtualLayerNativeQuery > QgsVirtualLayerNativeQuery::create( const QString &query,
+    const QList< QPair< QString, QgsVectorLayer * > > &layers,
+    const QgsFields &fields,
+    const QString &geometryField )
+{
+  QgsSQLStatement statement( query );
+  if ( statement.hasParserError() || !statement.rootNode() || statement.rootNode()->nodeType() != QgsSQLStatement::ntSelect )
+    return nullptr;
+
+  const QgsSQLStatement::NodeSelect *select = static_cast<const QgsSQLStatement::NodeSelect *>( statement.rootNode() );
+  if ( select->distinct() || !select->orderBy().isEmpty() )
+    return nullptr;
+
+  std::unique_ptr< QgsVirtualLayerNativeQuery > nativeQuery( new QgsVirtualLayerNativeQuery() );
+
+  // tables: a single one, an inner join, or two tables joined by a WHERE term
+  QList<QgsSQLStatement::NodeTableDef *> tableDefs = select->tables();
+  QList<const QgsSQLStatement::Node *> terms;
+  if ( tableDefs.size() == 1 && select->joins().size() == 1 )
+  {
+    const QgsSQLStatement::NodeJoin *join = select->joins().at( 0 );
+    if ( ( join->type() != QgsSQLStatement::jtDefault && join->type() != QgsSQLStatement::jtInner ) ||
+         !join->onExpr() || !join->usingColumns().isEmpty() )
+      return nullptr;
+    tableDefs << join->tableDef();
+    splitConjunction( join->onExpr(), terms );
+  }
+  else if ( tableDefs.isEmpty() || tableDefs.size() > 2 || !select->joins().isEmpty() )
+  {
+    return nullptr;
+  }
+
+  for ( const QgsSQLStatement::NodeTableDef *tableDef : qgis::as_const( tableDefs ) )
+  {
+    Table table;
+    for ( const QPair< QString, QgsVectorLayer * > &layer : layers )
+    {
+      if ( layer.first.compare( tableDef->name(), Qt::CaseInsensitive ) == 0 )
+      {
+        table.layer = layer.second;
+        break;
+      }
+    }
+    // embedded layers are only available to SQLite
+    if ( !table.layer )
+      return nullptr;
+    table.name = tableDef->alias().isEmpty() ? tableDef->name() : tableDef->alias();
+    if ( nativeQuery->tableIndex( table.name ) != -1 )
+      return nullptr;
+    nativeQuery->mTables << table;
+  }
+
+  // filters and join condition
+  if ( select->where() )
+    splitConjunction( select->where(), terms );
+  for ( const QgsSQLStatement::Node *term : qgis::as_const( terms ) )
+  {
+    if ( nativeQuery->mTables.size() == 2 && nativeQuery->mJoinType == NoJoin && nativeQuery->setJoin( term ) )
+      continue;
+
+    int table = -1;
+    QString expression;
+    if ( !nativeQuery->translateFilter( term, table, expression ) )
+      return nullptr;
+    nativeQuery->mTables[ std::max( table, 0 ) ].filters << expression;
+  }
+  // cross joins are left to SQLite
+  if ( nativeQuery->mTables.size() == 2 && nativeQuery->mJoinType == NoJoin )
+    return nullptr;
+
+  // selected columns, with the names SQLite gives them
+  QVector<Column> columns;
+  QStringList names;
+  const QList<QgsSQLStatement::NodeSelectedColumn *> selectedColumns = select->columns();
+  int aggregates = 0;
+  for ( const QgsSQLStatement::NodeSelectedColumn *selectedColumn : selectedColumns )
+  {
+    if ( selectedColumn->column()->nodeType() == QgsSQLStatement::ntFunction )
+    {
+      Column column;
+      if ( !nativeQuery->resolveAggregate( static_cast<const QgsSQLStatement::NodeFunction *>( selectedColumn->column() ), column ) )
+        return nullptr;
+      columns << column;
+      aggregates++;
+      continue;
+    }
+    if ( selectedColumn->column()->nodeType() != QgsSQLStatement::ntColumnRef )
+      return nullptr;
+    const QgsSQLStatement::NodeColumnRef *ref = static_cast<const QgsSQLStatement::NodeColumnRef *>( selectedColumn->column() );
+    if ( ref->distinct() )
+      return nullptr;
+
+    if ( ref->star() )
+    {
+      const int refTable = ref->tableName().isEmpty() ? -1 : nativeQuery->tableIndex( ref->tableName() );
+      if ( !ref->tableName().isEmpty() && refTable == -1 )
+        return nullptr;
+      for ( int i = 0; i < nativeQuery->mTables.size(); i++ )
+      {
+        if ( refTable != -1 && refTable != i )
+          continue;
+        const QgsVectorLayer *layer = nativeQuery->mTables.at( i ).layer;
+        const QgsFields layerFields = layer->fields();
+        for ( const QgsField &field : layerFields )
+        {
+          Column column;
+          column.table = i;
+          column.field = field.name();
+          columns << column;
+          names << field.name();
+        }
+        if ( layer->isSpatial() )
+        {
+          Column column;
+          column.table = i;
+          columns << column;
+          names << GEOMETRY_COLUMN;
+        }
+      }
+    }
+    else
+    {
+      Column column;
+      if ( !nativeQuery->resolveColumn( ref, column ) )
+        return nullptr;
+      columns << column;
+      names << ( selectedColumn->alias().isEmpty() ? ref->name() : selectedColumn->alias() );
+    }
+  }
+
+  if ( aggregates > 0 )
+  {
+    // the other columns would take the values of an arbitrary row
+    if ( aggregates != columns.size() || !geometryField.isEmpty() || fields.count() != columns.size() )
+      return nullptr;
+    // unnamed aggregates are named after their SQL text by SQLite, the fields
+    // come in the order of the columns
+    nativeQuery->mAttributes = columns;
+    nativeQuery->mAggregate = true;
+    return nativeQuery;
+  }
+
+  // each field of the virtual layer must come from exactly one column
+  auto findColumn = [&columns, &names]( const QString & name, Column & column )
+  {
+    int found = 0;
+    for ( int i = 0; i < names.size(); i++ )
+    {
+      if ( names.at( i ).compare( name, Qt::CaseInsensitive ) == 0 )
+      {
+        column = columns.at( i );
+        found++;
+      }
+    }
+    return found == 1;
+  };
+  for ( const QgsField &field : fields )
+  {
+    Column column;
+    if ( !findColumn( field.name(), column ) || column.field.isEmpty() )
+      return nullptr;
+    nativeQuery->mAttributes << column;
+  }
+  if ( !geometryField.isEmpty() )
+  {
+    if ( !findColumn( geometryField, nativeQuery->mGeometry ) || !nativeQuery->mGeometry.field.isEmpty() )
+      return nullptr;
+  }
+
+  return nativeQuery;
+}
+
+QString QgsVirtualLayerNativeQuery::joinKey( const QVariant &value )
+{
+  if ( value.isNull() )
+    return QString();
+
+  // as in SQLite, integer and real values of the same number are equal
+  switch ( value.type() )
+  {
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Bool:
+      return QStringLiteral( "n" ) + QString::number( value.toLongLong() );
+    case QVariant::Double:
+    {
+      const double d = value.toDouble();
+      if ( d == static_cast< double >( static_cast< qlonglong >( d ) ) )
+        return QStringLiteral( "n" ) + QString::number( static_cast< qlonglong >( d ) );
+      return QStringLiteral( "n" ) + QString::number( d, 'g', 17 );
+    }
+    default:
+      return QStringLiteral( "s" ) + value.toString();
+  }
+}
+
+int QgsVirtualLayerNativeQuery::tableIndex( const QString &name ) const
+{
+  for ( int i = 0; i < mTables.size(); i++ )
+  {
+    if ( mTables.at( i ).name.compare( name, Qt::CaseInsensitive ) == 0 )
+      return i;
+  }
+  return -1;
+}
+
+bool QgsVirtualLayerNativeQuery::resolveColumn( const QgsSQLStatement::NodeColumnRef *ref, Column &column ) const
+{
+  column = Column();
+  for ( int i = 0; i < mTables.size(); i++ )
+  {
+    if ( !ref->tableName().isEmpty() && mTables.at( i ).name.compare( ref->tableName(), Qt::CaseInsensitive ) != 0 )
+      continue;
+
+    const QgsVectorLayer *layer = mTables.at( i ).layer;
+    const int fieldIndex = layer->fields().lookupField( ref->name() );
+    if ( fieldIndex == -1 && !( layer->isSpatial() && ref->name().compare( GEOMETRY_COLUMN, Qt::CaseInsensitive ) == 0 ) )
+      continue;
+
+    // ambiguous column
+    if ( column.table != -1 )
+      return false;
+    column.table = i;
+    column.field = fieldIndex == -1 ? QString() : layer->fields().at( fieldIndex ).name();
+  }
+  return column.table != -1;
+}
+
+bool QgsVirtualLayerNativeQuery::resolveAggregate( const QgsSQLStatement::NodeFunction *function, Column &column ) const
+{
+  Aggregate aggregate = NoAggregate;
+  const QString name = function->name().toLower();
+  if ( name == QLatin1String( "count" ) )
+    aggregate = Count;
+  else if ( name == QLatin1String( "sum" ) )
+    aggregate = Sum;
+  else if ( name == QLatin1String( "avg" ) )
+    aggregate = Average;
+  else if ( name == QLatin1String( "min" ) )
+    aggregate = Minimum;
+  else if ( name == QLatin1String( "max" ) )
+    aggregate = Maximum;
+  else
+    return false;
+
+  // MIN and MAX of several values are scalar functions
+  const QList<QgsSQLStatement::Node *> args = function->args() ? function->args()->list() : QList<QgsSQLStatement::Node *>();
+  if ( args.size() != 1 || args.at( 0 )->nodeType() != QgsSQLStatement::ntColumnRef )
+    return false;
+
+  const QgsSQLStatement::NodeColumnRef *ref = static_cast<const QgsSQLStatement::NodeColumnRef *>( args.at( 0 ) );
+  if ( ref->star() )
+  {
+    // COUNT(*), the only aggregate of all the rows accepted by the parser
+    column = Column();
+    column.table = 0;
+  }
+  else if ( !resolveColumn( ref, column ) || column.field.isEmpty() )
+  {
+    return false;
+  }
+  column.aggregate = aggregate;
+  column.distinct = ref->distinct();
+  return true;
+}
+
+bool QgsVirtualLayerNativeQuery::setJoin( const QgsSQLStatement::Node *term )
+{
+  Column left;
+  Column right;
+  JoinType joinType = NoJoin;
+  if ( term->nodeType() == QgsSQLStatement::ntBinaryOperator )
+  {
+    const QgsSQLStatement::NodeBinaryOperator *op = static_cast<const QgsSQLStatement::NodeBinaryOperator *>( term );
+    if ( op->op() != QgsSQLStatement::boEQ ||
+         op->opLeft()->nodeType() != QgsSQLStatement::ntColumnRef ||
+         op->opRight()->nodeType() != QgsSQLStatement::ntColumnRef ||
+         !resolveColumn( static_cast<const QgsSQLStatement::NodeColumnRef *>( op->opLeft() ), left ) ||
+         !resolveColumn( static_cast<const QgsSQLStatement::NodeColumnRef *>( op->opRight() ), right ) ||
+         left.field.isEmpty() || right.field.isEmpty() )
+      return false;
+    joinType = EquiJoin;
+  }
+  else if ( term->nodeType() == QgsSQLStatement::ntFunction )
+  {
+    const QgsSQLStatement::NodeFunction *function = static_cast<const QgsSQLStatement::NodeFunction *>( term );
+    if ( function->name().compare( QLatin1String( "st_intersects" ), Qt::CaseInsensitive ) != 0 &&
+         function->name().compare( QLatin1String( "intersects" ), Qt::CaseInsensitive ) != 0 )
+      return false;
+    const QList<QgsSQLStatement::Node *> args = function->args() ? function->args()->list() : QList<QgsSQLStatement::Node *>();
+    if ( args.size() != 2 ||
+         args.at( 0 )->nodeType() != QgsSQLStatement::ntColumnRef ||
+         args.at( 1 )->nodeType() != QgsSQLStatement::ntColumnRef ||
+         !resolveColumn( static_cast<const QgsSQLStatement::NodeColumnRef *>( args.at( 0 ) ), left ) ||
+         !resolveColumn( static_cast<const QgsSQLStatement::NodeColumnRef *>( args.at( 1 ) ), right ) ||
+         !left.field.isEmpty() || !right.field.isEmpty() )
+      return false;
+    joinType = SpatialJoin;
+  }
+  else
+  {
+    return false;
+  }
+
+  if ( left.table == right.table )
+    return false;
+  if ( left.table == 1 )
+    std::swap( left, right );
+
+  mJoinType = joinType;
+  mJoinFields = qMakePair( left.field, right.field );
+  return true;
+}
+
+bool QgsVirtualLayerNativeQuery::translateFilter( const QgsSQLStatement::Node *node, int &table, QString &expression ) const
+{
+  switch ( node->nodeType() )
+  {
+    case QgsSQLStatement::ntLiteral:
+    {
+      expression = QgsExpression::quotedValue( static_cast<const QgsSQLStatement::NodeLiteral *>( node )->value() );
+      return true;
+    }
+
+    case QgsSQLStatement::ntColumnRef:
+    {
+      const QgsSQLStatement::NodeColumnRef *ref = static_cast<const QgsSQLStatement::NodeColumnRef *>( node );
+      Column column;
+      if ( ref->star() || !resolveColumn( ref, column ) || column.field.isEmpty() )
+        return false;
+      // terms referencing several tables are left to SQLite
+      if ( table != -1 && table != column.table )
+        return false;
+      table = column.table;
+      expression = QgsExpression::quotedColumnRef( column.field );
+      return true;
+    }
+
+    case QgsSQLStatement::ntUnaryOperator:
+    {
+      const QgsSQLStatement::NodeUnaryOperator *op = static_cast<const QgsSQLStatement::NodeUnaryOperator *>( node );
+      QString operand;
+      if ( !translateFilter( op->operand(), table, operand ) )
+        return false;
+      expression = QStringLiteral( "(%1 %2)" ).arg( op->op() == QgsSQLStatement::uoNot ? QStringLiteral( "NOT" ) : QStringLiteral( "-" ), operand );
+      return true;
+    }
+
+    case QgsSQLStatement::ntBinaryOperator:
+    {
+      const QgsSQLStatement::NodeBinaryOperator *op = static_cast<const QgsSQLStatement::NodeBinaryOperator *>( node );
+      QString opText;
+      switch ( op->op() )
+      {
+        case QgsSQLStatement::boOr:
+          opText = QStringLiteral( "OR" );
+          break;
+        case QgsSQLStatement::boAnd:
+          opText = QStringLiteral( "AND" );
+          break;
+        case QgsSQLStatement::boEQ:
+          opText = QStringLiteral( "=" );
+          break;
+        case QgsSQLStatement::boNE:
+          opText = QStringLiteral( "<>" );
+          break;
+        case QgsSQLStatement::boLE:
+          opText = QStringLiteral( "<=" );
+          break;
+        case QgsSQLStatement::boGE:
+          opText = QStringLiteral( ">=" );
+          break;
+        case QgsSQLStatement::boLT:
+          opText = QStringLiteral( "<" );
+          break;
+        case QgsSQLStatement::boGT:
+          opText = QStringLiteral( ">" );
+          break;
+        // LIKE is case insensitive in SQLite
+        case QgsSQLStatement::boLike:
+          opText = QStringLiteral( "ILIKE" );
+          break;
+        case QgsSQLStatement::boNotLike:
+          opText = QStringLiteral( "NOT ILIKE" );
+          break;
+        case QgsSQLStatement::boIs:
+          opText = QStringLiteral( "IS" );
+          break;
+        case QgsSQLStatement::boIsNot:
+          opText = QStringLiteral( "IS NOT" );
+          break;
+        case QgsSQLStatement::boPlus:
+          opText = QStringLiteral( "+" );
+          break;
+        case QgsSQLStatement::boMinus:
+          opText = QStringLiteral( "-" );
+          break;
+        case QgsSQLStatement::boMul:
+          opText = QStringLiteral( "*" );
+          break;
+        case QgsSQLStatement::boMod:
+          opText = QStringLiteral( "%" );
+          break;
+        case QgsSQLStatement::boConcat:
+          opText = QStringLiteral( "||" );
+          break;
+        // SQLite divides integers as integers, and knows no ILIKE or power operator
+        default:
+          return false;
+      }
+      QString left;
+      QString right;
+      if ( !translateFilter( op->opLeft(), table, left ) || !translateFilter( op->opRight(), table, right ) )
+        return false;
+      expression = QStringLiteral( "(%1 %2 %3)" ).arg( left, opText, right );
+      return true;
+    }
+
+    case QgsSQLStatement::ntInOperator:
+    {
+      const QgsSQLStatement::NodeInOperator *op = static_cast<const QgsSQLStatement::NodeInOperator *>( node );
+      QString value;
+      if ( !translateFilter( op->node(), table, value ) )
+        return false;
+      QStringList values;
+      const QList<QgsSQLStatement::Node *> list = op->list()->list();
+      for ( const QgsSQLStatement::Node *item : list )
+      {
+        QString itemExpression;
+        if ( !translateFilter( item, table, itemExpression ) )
+          return false;
+        values << itemExpression;
+      }
+      expression = QStringLiteral( "(%1 %2 (%3))" ).arg( value, op->isNotIn() ? QStringLiteral( "NOT IN" ) : QStringLiteral( "IN" ), values.join( QStringLiteral( ", " ) ) );
+      return true;
+    }
+
+    case QgsSQLStatement::ntBetweenOperator:
+    {
+      const QgsSQLStatement::NodeBetweenOperator *op = static_cast<const QgsSQLStatement::NodeBetweenOperator *>( node );
+      QString value;
+      QString minValue;
+      QString maxValue;
+      if ( !translateFilter( op->node(), table, value ) ||
+           !translateFilter( op->minVal(), table, minValue ) ||
+           !translateFilter( op->maxVal(), table, maxValue ) )
+        return false;
+      expression = QStringLiteral( "(%1(%2 >= %3 AND %2 <= %4))" ).arg( op->isNotBetween() ? QStringLiteral( "NOT " ) : QString(), value, minValue, maxValue );
+      return true;
+    }
+
+    // SQL functions and casts have no direct equivalent in expressions
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,162 @@
+/***************************************************************************
+          qgsvirtuallayernativequery.h : Native execution of virtual layer queries
+begin                : Oct 2019
+copyright            : (C) 2019 by the QGIS project
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSVIRTUALLAYERNATIVEQUERY_H
+#define QGSVIRTUALLAYERNATIVEQUERY_H
+
+#include "qgsfields.h"
+#include "qgssqlstatement.h"
+
+#include <memory>
+#include <QPair>
+#include <QPointer>
+#include <QStringList>
+#include <QVector>
+
+class QgsVectorLayer;
+
+/**
+ * Plan of a virtual layer query executed directly on the features of its
+ * source layers, without going through the SQLite virtual tables.
+ *
+ * Only a common subset of queries is supported, the other ones are run by SQLite:
+ *
+ * - a selection of columns (or *) of one layer,
+ * - or of two layers joined by an equality of columns (hash join) or by the
+ *   intersection of their geometries (join through a spatial index),
+ * - with WHERE and ON terms referring to a single layer, which are pushed to
+ *   the feature requests of the layers as filter expressions,
+ * - or aggregates of the whole result (COUNT, SUM, AVG, MIN and MAX of a column,
+ *   COUNT(*) and COUNT(DISTINCT column)), which make a single row.
+ *
+ * GROUP BY cannot be parsed by QgsSQLStatement, grouped aggregates are left to SQLite.
+ */
+class QgsVirtualLayerNativeQuery
+{
+  public:
+
+    //! Kind of join between the two layers of a query
+    enum JoinType
+    {
+      NoJoin, //!< Single layer
+      EquiJoin, //!< Equality of an attribute of each layer
+      SpatialJoin, //!< Intersection of the geometries of the layers
+    };
+
+    //! Aggregate function computed on a column
+    enum Aggregate
+    {
+      NoAggregate, //!< Value of each row
+      Count, //!< Number of non null values, or of rows for COUNT(*)
+      Sum, //!< Sum of the values
+      Average, //!< Average of the values
+      Minimum, //!< Minimum value
+      Maximum, //!< Maximum value
+    };
+
+    //! A layer of the query
+    struct Table
+    {
+      //! Name of the layer in the query (its alias if any)
+      QString name;
+      QPointer<QgsVectorLayer> layer;
+      //! Filter expressions pushed to the layer request
+      QStringList filters;
+    };
+
+    //! A column of the query result, taken from one of the layers
+    struct Column
+    {
+      //! Index of the table, -1 if the column is not part of the result
+      int table = -1;
+      //! Field name in the layer, empty for the geometry of the layer or for COUNT(*)
+      QString field;
+      //! Aggregate of the values of the field
+      Aggregate aggregate = NoAggregate;
+      //! Whether only the distinct values are aggregated
+      bool distinct = false;
+    };
+
+    /**
+     * Returns the plan of a \a query, or NULLPTR if the query cannot be executed natively.
+     * \param query SQL query of the virtual layer
+     * \param layers the source layers of the virtual layer, with their table names.
+     *        Embedded layers have no vector layer and cannot be used by a native query.
+     * \param fields the fields of the virtual layer, as detected by SQLite
+     * \param geometryField name of the geometry column of the virtual layer, empty if none
+     */
+    static std::unique_ptr< QgsVirtualLayerNativeQuery > create( const QString &query,
+        const QList< QPair< QString, QgsVectorLayer * > > &layers,
+        const QgsFields &fields,
+        const QString &geometryField );
+
+    //! Returns the layers of the query, the first one is the probe side of a join
+    const QVector<Table> &tables() const { return mTables; }
+
+    //! Returns the source column of each field of the virtual layer
+    const QVector<Column> &attributes() const { return mAttributes; }
+
+    //! Returns the source column of the geometry of the virtual layer
+    const Column &geometry() const { return mGeometry; }
+
+    //! Returns how the layers are joined
+    JoinType joinType() const { return mJoinType; }
+
+    //! Returns TRUE if the fields are aggregates, the result is then a single row
+    bool isAggregate() const { return mAggregate; }
+
+    /**
+     * Returns the joined field of each layer for an EquiJoin.
+     * The first one belongs to the first table.
+     */
+    QPair<QString, QString> joinFields() const { return mJoinFields; }
+
+    //! Returns the key of a join value in a hash table, or an empty string if it never matches
+    static QString joinKey( const QVariant &value );
+
+  private:
+
+    QgsVirtualLayerNativeQuery() = default;
+
+    //! Returns the index of the table named \a name, or -1
+    int tableIndex( const QString &name ) const;
+
+    //! Resolves a column reference of the query, returns FALSE if not found or ambiguous
+    bool resolveColumn( const QgsSQLStatement::NodeColumnRef *ref, Column &column ) const;
+
+    //! Resolves an aggregate function of the selected columns, returns FALSE if it is not supported
+    bool resolveAggregate( const QgsSQLStatement::NodeFunction *function, Column &column ) const;
+
+    //! Sets the join from a term of the WHERE or ON clause, returns FALSE if it is not a join condition
+    bool setJoin( const QgsSQLStatement::Node *term );
+
+    /**
+     * Translates a term of the WHERE or ON clause to a filter expression of a single table.
+     * \param node SQL node to translate
+     * \param table index of the table referenced by the node, or -1 if none yet
+     * \param expression translated expression
+     * \returns FALSE if the term cannot be translated, or references several tables
+     */
+    bool translateFilter( const QgsSQLStatement::Node *node, int &table, QString &expression ) const;
+
+    QVector<Table> mTables;
+    QVector<Column> mAttributes;
+    Column mGeometry;
+    JoinType mJoinType = NoJoin;
+    QPair<QString, QString> mJoinFields;
+    bool mAggregate = false;
+};
+
+#endif
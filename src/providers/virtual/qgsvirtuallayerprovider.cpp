@@ -31,6 +31,7 @@ extern "C"
 #include "qgsproject.h"
 #include "qgslogger.h"
 #include "qgsapplication.h"
+#include "qgssettings.h"
 
 #include "qgsvirtuallayerprovider.h"
 #include "qgsvirtuallayersqlitemodule.h"
@@ -267,6 +268,8 @@ bool QgsVirtualLayerProvider::createIt()
     }
   }
 
+  mNativeQuery.reset();
+
   QString path;
   mPath = mDefinition.filePath();
   // use a temporary file if needed
@@ -425,6 +428,18 @@ bool QgsVirtualLayerProvider::createIt()
                       .arg( VIRTUAL_LAYER_QUERY_VIEW,
                             mDefinition.query() );
     Sqlite::Query::exec( mSqlite.get(), viewStr );
+
+    // common queries may be run directly on the source layers rather than by SQLite
+    if ( QgsSettings().value( QStringLiteral( "virtual/native_query_engine" ), false ).toBool() )
+    {
+      QList< QPair< QString, QgsVectorLayer * > > layers;
+      for ( const SourceLayer &layer : qgis::as_const( mLayers ) )
+      {
+        layers << qMakePair( layer.name, layer.layer );
+      }
+      mNativeQuery = QgsVirtualLayerNativeQuery::create( mDefinition.query(), layers, tfields,
+                     noGeometry ? QString() : mDefinition.geometryField() );
+    }
   }
   else
   {
@@ -503,7 +518,10 @@ QgsCoordinateReferenceSystem QgsVirtualLayerProvider::crs() const
 
 QgsFeatureIterator QgsVirtualLayerProvider::getFeatures( const QgsFeatureRequest &request ) const
 {
-  return QgsFeatureIterator( new QgsVirtualLayerFeatureIterator( new QgsVirtualLayerFeatureSource( this ), false, request ) );
+  QgsVirtualLayerFeatureSource *source = new QgsVirtualLayerFeatureSource( this );
+  if ( source->mNativeQuery )
+    return QgsFeatureIterator( new QgsVirtualLayerNativeFeatureIterator( source, true, request ) );
+  return QgsFeatureIterator( new QgsVirtualLayerFeatureIterator( source, true, request ) );
 }
 
 QString QgsVirtualLayerProvider::subsetString() const
@@ -553,6 +571,27 @@ QgsRectangle QgsVirtualLayerProvider::extent() const
 void QgsVirtualLayerProvider::updateStatistics() const
 {
   bool hasGeometry = mDefinition.geometryWkbType() != QgsWkbTypes::NoGeometry;
+  if ( mNativeQuery && mSubset.isEmpty() )
+  {
+    // count the features of the native query rather than running it by SQLite
+    QgsFeatureRequest request;
+    request.setNoAttributes();
+    if ( !hasGeometry )
+      request.setFlags( QgsFeatureRequest::NoGeometry );
+    QgsFeatureIterator it = getFeatures( request );
+    QgsFeature f;
+    mFeatureCount = 0;
+    mExtent = QgsRectangle();
+    while ( it.nextFeature( f ) )
+    {
+      mFeatureCount++;
+      if ( f.hasGeometry() )
+        mExtent.combineExtentWith( f.geometry().boundingBox() );
+    }
+    mCachedStatistics = true;
+    return;
+  }
+
   QString subset = mSubset.isEmpty() ? QString() : " WHERE " + mSubset;
   QString sql = QStringLiteral( "SELECT Count(*)%1 FROM %2%3" )
                 .arg( hasGeometry ? QStringLiteral( ",Min(MbrMinX(%1)),Min(MbrMinY(%1)),Max(MbrMaxX(%1)),Max(MbrMaxY(%1))" ).arg( quotedColumn( mDefinition.geometryField() ) ) : QString(),
@@ -22,6 +22,7 @@ email                : hugo dot mercier at oslandia dot com
 #include "qgscoordinatereferencesystem.h"
 #include "qgsvirtuallayerdefinition.h"
 #include "qgsvirtuallayersqlitehelper.h"
+#include "qgsvirtuallayernativequery.h"
 
 #include "qgsprovidermetadata.h"
 #ifdef HAVE_GUI
@@ -105,6 +106,9 @@ class QgsVirtualLayerProvider: public QgsVectorDataProvider
 
     QString mSubset;
 
+    // query executed directly on the source layers, if enabled and supported
+    std::shared_ptr< const QgsVirtualLayerNativeQuery > mNativeQuery;
+
     void resetSqlite();
 
     mutable bool mCachedStatistics = false;
@@ -470,6 +470,25 @@ int vtableRename( sqlite3_vtab *vtab, const char *newName )
   return SQLITE_OK;
 }
 
+// whether a comparison operator on an attribute can be translated to a filter expression
+bool isExpressionOperator( unsigned char op )
+{
+  switch ( op )
+  {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+    case SQLITE_INDEX_CONSTRAINT_GT:
+    case SQLITE_INDEX_CONSTRAINT_LE:
+    case SQLITE_INDEX_CONSTRAINT_LT:
+    case SQLITE_INDEX_CONSTRAINT_GE:
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+    case SQLITE_INDEX_CONSTRAINT_LIKE:
+#endif
+      return true;
+    default:
+      return false;
+  }
+}
+
 int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
 {
   VTable *vtab = reinterpret_cast< VTable * >( pvtab );
@@ -488,81 +507,106 @@ int vtableBestIndex( sqlite3_vtab *pvtab, sqlite3_index_info *indexInfo )
       indexInfo->needToFreeIdxStr = 0;
       return SQLITE_OK;
     }
+  }
 
-    // request for filter with a comparison operator
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( indexInfo->aConstraint[i].iColumn > 0 ) &&
-         ( indexInfo->aConstraint[i].iColumn <= vtab->fields().count() ) &&
-         ( ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) || // if no PK
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LE ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LT ) ||
-           ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_GE )
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-           || ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_LIKE )
+  // Otherwise, all the constraints that can be translated are pushed to the feature request:
+  // the rtree filter, the comparisons on attributes (including join keys) as a filter
+  // expression the source provider may compile, and the LIMIT of the query.
+  // idxStr describes each argument given to vtableFilter(), separated by ';':
+  // "r" for the rtree filter, "l" and "o" for LIMIT and OFFSET, and
+  // "<column> <operator>" for a comparison, where operator is "in" for a whole IN list
+  QStringList arguments;
+  bool hasRectFilter = false;
+  int expressionCount = 0;
+  bool allConstraintsUsed = true;
+  int limitConstraint = -1;
+  int offsetConstraint = -1;
+  for ( int i = 0; i < indexInfo->nConstraint; i++ )
+  {
+    const int column = indexInfo->aConstraint[i].iColumn;
+    const unsigned char op = indexInfo->aConstraint[i].op;
+#if SQLITE_VERSION_NUMBER >= 3038000
+    if ( op == SQLITE_INDEX_CONSTRAINT_LIMIT )
+    {
+      limitConstraint = i;
+      continue;
+    }
+    if ( op == SQLITE_INDEX_CONSTRAINT_OFFSET )
+    {
+      offsetConstraint = i;
+      continue;
+    }
 #endif
-         ) )
+    if ( !indexInfo->aConstraint[i].usable )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 3; // expression filter
-      indexInfo->estimatedCost = 2.0; // probably better than no index
+      allConstraintsUsed = false;
+      continue;
+    }
 
-      QString expr = QgsExpression::quotedColumnRef( vtab->fields().at( indexInfo->aConstraint[i].iColumn - 1 ).name() );
-      switch ( indexInfo->aConstraint[i].op )
-      {
-        case SQLITE_INDEX_CONSTRAINT_EQ:
-          expr += QLatin1String( " = " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GT:
-          expr += QLatin1String( " > " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LE:
-          expr += QLatin1String( " <= " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_LT:
-          expr += QLatin1String( " < " );
-          break;
-        case SQLITE_INDEX_CONSTRAINT_GE:
-          expr += QLatin1String( " >= " );
-          break;
-#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
-        case SQLITE_INDEX_CONSTRAINT_LIKE:
-          expr += QLatin1String( " LIKE " );
-          break;
+    if ( column == 0 && op == SQLITE_INDEX_CONSTRAINT_EQ && !hasRectFilter )
+    {
+      // request for rtree filtering
+      hasRectFilter = true;
+      arguments << QStringLiteral( "r" );
+    }
+    else if ( column > 0 && column <= vtab->fields().count() && isExpressionOperator( op ) )
+    {
+      // request for filter with a comparison operator
+      QString expressionOp = QString::number( op );
+#if SQLITE_VERSION_NUMBER >= 3038000
+      // get the values of an IN list all at once, rather than with one filter call per value
+      if ( op == SQLITE_INDEX_CONSTRAINT_EQ && sqlite3_vtab_in( indexInfo, i, 1 ) )
+        expressionOp = QStringLiteral( "in" );
 #endif
-        default:
-          break;
-      }
-
-      QByteArray ba = expr.toUtf8();
-      char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
-      memcpy( cp, ba.constData(), ba.size() + 1 );
-
-      indexInfo->idxStr = cp;
-      indexInfo->needToFreeIdxStr = 1;
-      return SQLITE_OK;
+      arguments << QStringLiteral( "%1 %2" ).arg( column ).arg( expressionOp );
+      expressionCount++;
+    }
+    else
+    {
+      allConstraintsUsed = false;
+      continue;
     }
 
-    // request for rtree filtering
-    if ( ( indexInfo->aConstraint[i].usable ) &&
-         ( 0 == indexInfo->aConstraint[i].iColumn ) &&
-         ( indexInfo->aConstraint[i].op == SQLITE_INDEX_CONSTRAINT_EQ ) )
+    indexInfo->aConstraintUsage[i].argvIndex = arguments.size();
+    // for the rtree filter, do not test for equality, since it is used for filtering, not to return an actual value
+    indexInfo->aConstraintUsage[i].omit = 1;
+  }
+
+  // The limit can only be applied by the source if no other constraint is left to SQLite
+  // and the rows are not sorted by SQLite, the source returns them in its own order.
+  // It is not omitted: SQLite still applies LIMIT and OFFSET on the returned rows
+  if ( allConstraintsUsed && indexInfo->nOrderBy == 0 && limitConstraint >= 0 )
+  {
+    arguments << QStringLiteral( "l" );
+    indexInfo->aConstraintUsage[limitConstraint].argvIndex = arguments.size();
+    if ( offsetConstraint >= 0 )
     {
-      indexInfo->aConstraintUsage[i].argvIndex = 1;
-      // do not test for equality, since it is used for filtering, not to return an actual value
-      indexInfo->aConstraintUsage[i].omit = 1;
-      indexInfo->idxNum = 2; // RTree filter
-      indexInfo->estimatedCost = 1.0;
-      indexInfo->idxStr = nullptr;
-      indexInfo->needToFreeIdxStr = 0;
-      return SQLITE_OK;
+      arguments << QStringLiteral( "o" );
+      indexInfo->aConstraintUsage[offsetConstraint].argvIndex = arguments.size();
     }
   }
-  indexInfo->idxNum = 0;
-  indexInfo->estimatedCost = 10.0;
-  indexInfo->idxStr = nullptr;
-  indexInfo->needToFreeIdxStr = 0;
+
+  if ( arguments.isEmpty() )
+  {
+    indexInfo->idxNum = 0;
+    indexInfo->estimatedCost = 10.0;
+    indexInfo->idxStr = nullptr;
+    indexInfo->needToFreeIdxStr = 0;
+    return SQLITE_OK;
+  }
+
+  indexInfo->idxNum = 2; // filters described by idxStr
+  // the rtree filter is selective, each comparison is probably better than no index
+  indexInfo->estimatedCost = hasRectFilter ? 1.0 : 10.0;
+  if ( expressionCount > 0 )
+    indexInfo->estimatedCost = std::min( indexInfo->estimatedCost, 2.0 ) / expressionCount;
+
+  QByteArray ba = arguments.join( ';' ).toUtf8();
+  char *cp = ( char * )sqlite3_malloc( ba.size() + 1 );
+  memcpy( cp, ba.constData(), ba.size() + 1 );
+
+  indexInfo->idxStr = cp;
+  indexInfo->needToFreeIdxStr = 1;
   return SQLITE_OK;
 }
 
@@ -582,9 +626,56 @@ int vtableClose( sqlite3_vtab_cursor *cursor )
   return SQLITE_OK;
 }
 
+// returns the expression literal of a value given to vtableFilter()
+QString expressionLiteral( sqlite3_value *value )
+{
+  switch ( sqlite3_value_type( value ) )
+  {
+    case SQLITE_INTEGER:
+      return QString::number( sqlite3_value_int64( value ) );
+    case SQLITE_FLOAT:
+      return QString::number( sqlite3_value_double( value ), 'g', 17 );
+    case SQLITE_TEXT:
+    {
+      int n = sqlite3_value_bytes( value );
+      const char *t = reinterpret_cast<const char *>( sqlite3_value_text( value ) );
+      return QgsExpression::quotedString( QString::fromUtf8( t, n ) );
+    }
+    case SQLITE_NULL:
+    case SQLITE_BLOB: // comparison to blob ignored
+    default:
+      // a comparison with null is never true, as in SQLite
+      return QStringLiteral( "NULL" );
+  }
+}
+
+// returns the expression operator of a comparison given by vtableBestIndex()
+QString expressionOperator( int op )
+{
+  switch ( op )
+  {
+    case SQLITE_INDEX_CONSTRAINT_EQ:
+      return QStringLiteral( " = " );
+    case SQLITE_INDEX_CONSTRAINT_GT:
+      return QStringLiteral( " > " );
+    case SQLITE_INDEX_CONSTRAINT_LE:
+      return QStringLiteral( " <= " );
+    case SQLITE_INDEX_CONSTRAINT_LT:
+      return QStringLiteral( " < " );
+    case SQLITE_INDEX_CONSTRAINT_GE:
+      return QStringLiteral( " >= " );
+#ifdef SQLITE_INDEX_CONSTRAINT_LIKE
+    case SQLITE_INDEX_CONSTRAINT_LIKE:
+      return QStringLiteral( " LIKE " );
+#endif
+    default:
+      return QString();
+  }
+}
+
 int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, int argc, sqlite3_value **argv )
 {
-  Q_UNUSED( argc )
+  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
 
   QgsFeatureRequest request;
   if ( idxNum == 1 )
@@ -594,42 +685,60 @@ int vtableFilter( sqlite3_vtab_cursor *cursor, int idxNum, const char *idxStr, i
   }
   else if ( idxNum == 2 )
   {
-    // rtree filter
-    const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( argv[0] ) );
-    int bytes = sqlite3_value_bytes( argv[0] );
-    QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
-    request.setFilterRect( r );
-  }
-  else if ( idxNum == 3 )
-  {
-    // comparison operator filter
+    // combination of rtree filter, comparison operator filters and limit
     // build an expression filter and rely on expression compiler if available
-    QString expr = idxStr;
-    switch ( sqlite3_value_type( argv[0] ) )
+    const QStringList arguments = QString::fromUtf8( idxStr ).split( ';' );
+    const QgsFields fields = c->mVtab->fields();
+    QStringList expressions;
+    qint64 limit = -1;
+    qint64 offset = 0;
+    for ( int i = 0; i < arguments.size() && i < argc; i++ )
     {
-      case SQLITE_INTEGER:
-        expr += QString::number( sqlite3_value_int64( argv[0] ) );
-        break;
-      case SQLITE_FLOAT:
-        expr += QString::number( sqlite3_value_double( argv[0] ) );
-        break;
-      case SQLITE_TEXT:
+      const QStringList tokens = arguments.at( i ).split( ' ' );
+      if ( tokens.at( 0 ) == QLatin1String( "r" ) )
       {
-        int n = sqlite3_value_bytes( argv[0] );
-        const char *t = reinterpret_cast<const char *>( sqlite3_value_text( argv[0] ) );
-        QString str = QString::fromUtf8( t, n );
-        expr += QgsExpression::quotedString( str );
-        break;
+        // rtree filter
+        const char *blob = reinterpret_cast< const char * >( sqlite3_value_blob( argv[i] ) );
+        int bytes = sqlite3_value_bytes( argv[i] );
+        QgsRectangle r( spatialiteBlobBbox( blob, bytes ) );
+        request.setFilterRect( r );
+      }
+      else if ( tokens.at( 0 ) == QLatin1String( "l" ) )
+      {
+        limit = sqlite3_value_int64( argv[i] );
+      }
+      else if ( tokens.at( 0 ) == QLatin1String( "o" ) )
+      {
+        offset = std::max( static_cast< qint64 >( sqlite3_value_int64( argv[i] ) ), static_cast< qint64 >( 0 ) );
+      }
+      else
+      {
+        const QString column = QgsExpression::quotedColumnRef( fields.at( tokens.at( 0 ).toInt() - 1 ).name() );
+#if SQLITE_VERSION_NUMBER >= 3038000
+        if ( tokens.value( 1 ) == QLatin1String( "in" ) )
+        {
+          QStringList values;
+          sqlite3_value *value = nullptr;
+          for ( int rc = sqlite3_vtab_in_first( argv[i], &value ); rc == SQLITE_OK && value; rc = sqlite3_vtab_in_next( argv[i], &value ) )
+          {
+            values << expressionLiteral( value );
+          }
+          if ( values.isEmpty() )
+            expressions << QStringLiteral( "FALSE" );
+          else
+            expressions << QStringLiteral( "%1 IN (%2)" ).arg( column, values.join( QStringLiteral( ", " ) ) );
+          continue;
+        }
+#endif
+        expressions << column + expressionOperator( tokens.value( 1 ).toInt() ) + expressionLiteral( argv[i] );
       }
-      case SQLITE_NULL:
-      case SQLITE_BLOB: // comparison to blob ignored
-      default:
-        expr += QLatin1String( " is null" );
-        break;
     }
-    request.setFilterExpression( expr );
+    if ( !expressions.isEmpty() )
+      request.setFilterExpression( expressions.join( QStringLiteral( " AND " ) ) );
+    // SQLite skips the OFFSET first rows itself
+    if ( limit >= 0 )
+      request.setLimit( limit + offset );
   }
-  VTableCursor *c = reinterpret_cast<VTableCursor *>( cursor );
   c->filter( request );
   return SQLITE_OK;
 }
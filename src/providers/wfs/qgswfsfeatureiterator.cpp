@@ -42,6 +42,9 @@
 
 #include <sqlite3.h>
 
+// Maximum number of bytes of a GetFeature response processed at once by the GML parser
+static const int MAX_CHUNK_SIZE = 10 * 1024 * 1024;
+
 QgsWFSFeatureHitsAsyncRequest::QgsWFSFeatureHitsAsyncRequest( QgsWFSDataSourceURI &uri )
   : QgsWfsRequest( uri )
   , mNumberMatched( -1 )
@@ -84,6 +87,37 @@ QString QgsWFSFeatureHitsAsyncRequest::errorMessageWithReason( const QString &re
 
 // -------------------------
 
+QgsWFSFeaturePageRequest::QgsWFSFeaturePageRequest( const QgsWFSDataSourceURI &uri, qint64 startIndex )
+  : QgsWfsRequest( uri )
+  , mStartIndex( startIndex )
+{
+  connect( this, &QgsWfsRequest::downloadFinished, this, &QgsWFSFeaturePageRequest::pageReplyFinished );
+}
+
+void QgsWFSFeaturePageRequest::launch( const QUrl &url )
+{
+  mUrl = url;
+  if ( !sendGET( url,
+                 false, /* synchronous */
+                 true, /* forceRefresh */
+                 false /* cache */ ) )
+  {
+    mFinished = true;
+  }
+}
+
+void QgsWFSFeaturePageRequest::pageReplyFinished()
+{
+  mFinished = true;
+}
+
+QString QgsWFSFeaturePageRequest::errorMessageWithReason( const QString &reason )
+{
+  return tr( "Download of features failed: %1" ).arg( reason );
+}
+
+// -------------------------
+
 QgsWFSFeatureDownloader::QgsWFSFeatureDownloader( QgsWFSSharedData *shared )
   : QgsWfsRequest( shared->mURI )
   , mShared( shared )
@@ -446,6 +480,30 @@ void QgsWFSFeatureDownloader::startHitsRequest()
   }
 }
 
+void QgsWFSFeatureDownloader::requestNextPages( qint64 startIndex, qint64 maxTotalFeatures, qint64 numberMatched )
+{
+  if ( !mPageRequests.empty() )
+    startIndex = mPageRequests.back()->startIndex() + mShared->mPageSize;
+
+  // The page being downloaded counts as one of the concurrent requests
+  while ( static_cast<int>( mPageRequests.size() ) + 1 < mMaxConcurrentPageRequests )
+  {
+    if ( ( maxTotalFeatures > 0 && startIndex >= maxTotalFeatures ) ||
+         ( numberMatched > 0 && startIndex >= numberMatched ) )
+    {
+      break;
+    }
+    int maxFeaturesThisRequest = mShared->mPageSize;
+    if ( maxTotalFeatures > 0 )
+      maxFeaturesThisRequest = static_cast<int>( std::min( maxTotalFeatures - startIndex, static_cast<qint64>( maxFeaturesThisRequest ) ) );
+
+    std::unique_ptr< QgsWFSFeaturePageRequest > request = qgis::make_unique< QgsWFSFeaturePageRequest >( mShared->mURI, startIndex );
+    request->launch( buildURL( startIndex, maxFeaturesThisRequest, false ) );
+    mPageRequests.push_back( std::move( request ) );
+    startIndex += mShared->mPageSize;
+  }
+}
+
 void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
 {
   bool success = true;
@@ -478,8 +536,12 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
   bool truncatedResponse = false;
   QgsSettings s;
   const int maxRetry = s.value( QStringLiteral( "qgis/defaultTileMaxRetry" ), "3" ).toInt();
+  // Number of page requests that may run concurrently in paging mode. While
+  // a page is parsed, the following ones are still being received
+  mMaxConcurrentPageRequests = std::max( 1, s.value( QStringLiteral( "wfs/concurrent_page_requests" ), 4 ).toInt() );
   int retryIter = 0;
   int lastValidTotalDownloadedFeatureCount = 0;
+  qint64 numberMatched = -1;
   int pagingIter = 1;
   QString gmlIdFirstFeatureFirstIter;
   bool disablePaging = false;
@@ -529,17 +591,41 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
       url.addQueryItem( QStringLiteral( "RETRY" ), QString::number( retryIter ) );
     }
 
-    sendGET( url,
-             false, /* synchronous */
-             true, /* forceRefresh */
-             false /* cache */ );
+    // Use the page if it has been requested in advance. Pages requested with
+    // other parameters than the current ones are discarded
+    std::unique_ptr< QgsWFSFeaturePageRequest > pageRequest;
+    if ( !mPageRequests.empty() && mPageRequests.front()->url() == url )
+    {
+      pageRequest = std::move( mPageRequests.front() );
+      mPageRequests.pop_front();
+      connect( pageRequest.get(), &QgsWfsRequest::downloadFinished, &loop, &QEventLoop::quit );
+      mErrorCode = NoError;
+      mErrorMessage.clear();
+    }
+    else
+    {
+      if ( retryIter == 0 )
+        mPageRequests.clear();
+      sendGET( url,
+               false, /* synchronous */
+               true, /* forceRefresh */
+               false /* cache */ );
+    }
+
+    // Once the server has proven to return pages, request the following ones
+    // while this one is downloaded and parsed
+    if ( pagingIter > 1 && mPageSize > 0 && mShared->mPageSize > 0 && maxFeatures != 1 )
+    {
+      requestNextPages( mTotalDownloadedFeatureCount + maxFeaturesThisRequest, maxTotalFeatures, numberMatched );
+    }
 
     int featureCountForThisResponse = 0;
     bool bytesStillAvailableInReply = false;
+    int pageResponseOffset = 0;
     // Loop until there is no data coming from the current request
     while ( true )
     {
-      if ( !bytesStillAvailableInReply )
+      if ( !bytesStillAvailableInReply && !( pageRequest && pageRequest->isFinished() ) )
       {
         loop.exec( QEventLoop::ExcludeUserInputEvents );
       }
@@ -552,11 +638,25 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
 
       QByteArray data;
       bool finished = false;
-      if ( mReply )
+      if ( pageRequest )
+      {
+        // Pages requested in advance are processed once completely received,
+        // in chunks as the replies
+        if ( !pageRequest->isFinished() )
+          continue;
+        const QByteArray response = pageRequest->response();
+        data = response.mid( pageResponseOffset, MAX_CHUNK_SIZE );
+        pageResponseOffset += data.size();
+        finished = pageResponseOffset >= response.size();
+        bytesStillAvailableInReply = !finished;
+        mErrorCode = pageRequest->errorCode();
+        mErrorMessage = pageRequest->errorMessage();
+      }
+      else if ( mReply )
       {
         // Limit the number of bytes to process at once, to avoid the GML parser to
         // create too many objects.
-        data = mReply->read( 10 * 1024 * 1024 );
+        data = mReply->read( MAX_CHUNK_SIZE );
         bytesStillAvailableInReply = mReply->bytesAvailable() > 0;
       }
       else
@@ -618,6 +718,9 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
         break;
       }
 
+      if ( parser->numberMatched() > 0 )
+        numberMatched = parser->numberMatched();
+
       // Consider if we should display a progress dialog
       // We can only do that if we know how many features will be downloaded
       if ( !mTimer && maxFeatures != 1 && mUseProgressDialog )
@@ -843,6 +946,7 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
     ++ pagingIter;
     if ( disablePaging )
     {
+      mPageRequests.clear();
       mShared->mPageSize = mPageSize = 0;
       mTotalDownloadedFeatureCount = 0;
       mShared->mPageSize = 0;
@@ -853,6 +957,8 @@ void QgsWFSFeatureDownloader::run( bool serializeFeatures, int maxFeatures )
     }
   }
 
+  mPageRequests.clear();
+
   {
     QMutexLocker locker( &mMutexCreateProgressDialog );
     mStop = true;
@@ -22,6 +22,7 @@
 #include "qgsgml.h"
 #include "qgsspatialindex.h"
 
+#include <deque>
 #include <memory>
 #include <QProgressDialog>
 #include <QPushButton>
@@ -62,6 +63,37 @@ class QgsWFSFeatureHitsAsyncRequest: public QgsWfsRequest
 };
 
 
+//! Utility class to request in advance a page of a paged GetFeature request
+class QgsWFSFeaturePageRequest: public QgsWfsRequest
+{
+    Q_OBJECT
+  public:
+    QgsWFSFeaturePageRequest( const QgsWFSDataSourceURI &uri, qint64 startIndex );
+
+    void launch( const QUrl &url );
+
+    //! Returns the URL of the request
+    QUrl url() const { return mUrl; }
+
+    //! Returns the index of the first feature of the page
+    qint64 startIndex() const { return mStartIndex; }
+
+    //! Returns whether the response has been completely received, or the request has failed
+    bool isFinished() const { return mFinished; }
+
+  private slots:
+    void pageReplyFinished();
+
+  protected:
+    QString errorMessageWithReason( const QString &reason ) override;
+
+  private:
+    QUrl mUrl;
+    qint64 mStartIndex;
+    bool mFinished = false;
+};
+
+
 //! Utility class for QgsWFSFeatureDownloader
 class QgsWFSProgressDialog: public QProgressDialog
 {
@@ -139,6 +171,12 @@ class QgsWFSFeatureDownloader: public QgsWfsRequest
     void pushError( const QString &errorMsg );
     QString sanitizeFilter( QString filter );
 
+    /**
+     * Requests in advance the pages following the one starting at \a startIndex,
+     * without going beyond \a maxTotalFeatures or \a numberMatched when they are known.
+     */
+    void requestNextPages( qint64 startIndex, qint64 maxTotalFeatures, qint64 numberMatched );
+
     //! Mutable data shared between provider, feature sources and downloader.
     QgsWFSSharedData *mShared = nullptr;
     //! Whether the download should stop
@@ -159,6 +197,10 @@ class QgsWFSFeatureDownloader: public QgsWfsRequest
     QgsWFSFeatureHitsAsyncRequest mFeatureHitsAsyncRequest;
     qint64 mTotalDownloadedFeatureCount;
     QMutex mMutexCreateProgressDialog;
+    //! Maximum number of page requests running at the same time
+    int mMaxConcurrentPageRequests = 1;
+    //! Pages requested in advance, in the order of their start index
+    std::deque< std::unique_ptr< QgsWFSFeaturePageRequest > > mPageRequests;
 };
 
 //! Downloader thread
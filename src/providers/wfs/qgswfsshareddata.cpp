@@ -35,6 +35,9 @@
 
 #include <set>
 
+#include <QCryptographicHash>
+#include <QDateTime>
+
 #include <sqlite3.h>
 
 QgsWFSSharedData::QgsWFSSharedData( const QString &uri )
@@ -63,7 +66,8 @@ QgsWFSSharedData::~QgsWFSSharedData()
 {
   QgsDebugMsgLevel( QStringLiteral( "~QgsWFSSharedData()" ), 4 );
 
-  invalidateCache();
+  // The on-disk cache is kept for the next sessions, if enabled
+  releaseCache( true );
 
   mCacheIdDb.reset();
   if ( !mCacheIdDbname.isEmpty() )
@@ -265,6 +269,36 @@ bool QgsWFSSharedData::createCache()
   if ( mDistinctSelect )
     cacheFields.append( QgsField( QgsWFSConstants::FIELD_MD5, QVariant::String, QStringLiteral( "string" ) ) );
 
+  // Reuse the cache of a previous session, or create it where it will be kept for the next ones.
+  // A cache already used by another layer or QGIS instance is not shared
+  const QString persistentDbname = persistentCacheDbname();
+  if ( !persistentDbname.isEmpty() )
+  {
+    std::unique_ptr< QLockFile > lock = qgis::make_unique< QLockFile >( persistentDbname + QStringLiteral( ".lock" ) );
+    if ( lock->tryLock( 0 ) )
+    {
+      mCacheLock = std::move( lock );
+      mCachePersistent = true;
+      mCacheDbname = persistentDbname;
+      mCacheTablename = QStringLiteral( "features" );
+      if ( QFile::exists( mCacheDbname ) )
+      {
+        if ( mCacheIdDbname.isEmpty() && restoreCacheState() )
+        {
+          QgsDebugMsgLevel( QStringLiteral( "Reusing WFS cache %1" ).arg( mCacheDbname ), 4 );
+          return connectToCache( cacheDirectory, tmpCounter, true );
+        }
+        QFile::remove( mCacheDbname );
+        QFile::remove( mCacheDbname + "-wal" );
+        QFile::remove( mCacheDbname + "-shm" );
+      }
+    }
+    else
+    {
+      QgsDebugMsgLevel( QStringLiteral( "WFS cache %1 is in use. Using a temporary cache" ).arg( persistentDbname ), 4 );
+    }
+  }
+
   bool ogrWaySuccessful = false;
   QString fidName( QStringLiteral( "__ogc_fid" ) );
   QString geometryFieldname( QStringLiteral( "__spatialite_geometry" ) );
@@ -445,6 +479,26 @@ bool QgsWFSSharedData::createCache()
       }
     }
 
+    if ( mCachePersistent )
+    {
+      // Requested regions and state of the cache, restored by the next sessions
+      const QStringList statements
+      {
+        QStringLiteral( "CREATE TABLE wfs_cache_state(created INTEGER, complete INTEGER)" ),
+        QStringLiteral( "INSERT INTO wfs_cache_state VALUES (%1, 0)" ).arg( QDateTime::currentMSecsSinceEpoch() ),
+        QStringLiteral( "CREATE TABLE wfs_cache_regions(xmin REAL, ymin REAL, xmax REAL, ymax REAL, download_limit INTEGER)" )
+      };
+      for ( const QString &statement : statements )
+      {
+        rc = sqlite3_exec( database.get(), statement.toUtf8(), nullptr, nullptr, nullptr );
+        if ( rc != SQLITE_OK )
+        {
+          QgsDebugMsg( QStringLiteral( "%1 failed" ).arg( statement ) );
+          ret = false;
+        }
+      }
+    }
+
     ( void )sqlite3_exec( database.get(), "COMMIT", nullptr, nullptr, nullptr );
   }
   else
@@ -457,6 +511,14 @@ bool QgsWFSSharedData::createCache()
     return false;
   }
 
+  return connectToCache( cacheDirectory, tmpCounter, false );
+}
+
+bool QgsWFSSharedData::connectToCache( const QString &cacheDirectory, int tmpCounter, bool restoredCache )
+{
+  const QString fidName( QStringLiteral( "__ogc_fid" ) );
+  const QString geometryFieldname( QStringLiteral( "__spatialite_geometry" ) );
+
   // Some pragmas to speed-up writing. We don't need much integrity guarantee
   // regarding crashes, since this is a temporary DB
   QgsDataSourceUri dsURI;
@@ -510,9 +572,170 @@ bool QgsWFSSharedData::createCache()
     }
   }
 
+  if ( restoredCache )
+  {
+    // The features of a previous session get their database id as QGIS id
+    QString errorMsg;
+    bool ok = mCacheIdDb.exec( QgsSqlite3Mprintf( "ATTACH DATABASE '%q' AS restored_cache", mCacheDbname.toUtf8().constData() ), errorMsg ) == SQLITE_OK;
+    ok &= mCacheIdDb.exec( QStringLiteral( "INSERT INTO id_cache (gmlid, dbId, qgisId) SELECT %1, %2, %2 FROM restored_cache.%3 WHERE %1 IS NOT NULL AND %1 <> ''" )
+                           .arg( quotedIdentifier( QgsWFSConstants::FIELD_GMLID ), fidName, mCacheTablename ), errorMsg ) == SQLITE_OK;
+    ok &= mCacheIdDb.exec( QStringLiteral( "DETACH DATABASE restored_cache" ), errorMsg ) == SQLITE_OK;
+    if ( !ok )
+    {
+      QgsDebugMsg( errorMsg );
+      return false;
+    }
+
+    int resultCode;
+    auto stmt = mCacheIdDb.prepare( QStringLiteral( "SELECT MAX(qgisId) FROM id_cache" ), resultCode );
+    if ( resultCode == SQLITE_OK && stmt.step() == SQLITE_ROW )
+      mNextCachedIdQgisId = stmt.columnAsInt64( 0 ) + 1;
+  }
+
+  return true;
+}
+
+QString QgsWFSSharedData::persistentCacheDbname() const
+{
+  const QString cacheDirectory = QgsWFSUtils::persistentCacheDirectory();
+  if ( cacheDirectory.isEmpty() )
+    return QString();
+
+  // The cached features depend on the URI and the filter of the layer,
+  // and on the schema and the CRS the server returns them with
+  QCryptographicHash hash( QCryptographicHash::Md5 );
+  hash.addData( mURI.uri().toUtf8() );
+  hash.addData( mWFSVersion.toUtf8() );
+  hash.addData( mWFSFilter.toUtf8() );
+  hash.addData( mSortBy.toUtf8() );
+  hash.addData( srsName().toUtf8() );
+  hash.addData( QStringLiteral( "%1 %2" ).arg( mMaxFeatures ).arg( mDistinctSelect ? 1 : 0 ).toUtf8() );
+  for ( const QgsField &field : qgis::as_const( mFields ) )
+  {
+    hash.addData( QStringLiteral( "%1 %2 %3" ).arg( field.name(), field.typeName() ).arg( static_cast< int >( field.type() ) ).toUtf8() );
+  }
+  return QDir( cacheDirectory ).filePath( QStringLiteral( "wfs_cache_%1.sqlite" ).arg( QString::fromLatin1( hash.result().toHex() ) ) );
+}
+
+bool QgsWFSSharedData::restoreCacheState()
+{
+  sqlite3_database_unique_ptr database;
+  if ( database.open( mCacheDbname ) != SQLITE_OK )
+    return false;
+
+  int resultCode;
+  auto stmt = database.prepare( QStringLiteral( "SELECT created, complete FROM wfs_cache_state" ), resultCode );
+  if ( resultCode != SQLITE_OK || stmt.step() != SQLITE_ROW )
+    return false;
+  if ( QDateTime::currentMSecsSinceEpoch() - stmt.columnAsInt64( 0 ) > QgsWFSUtils::persistentCacheMaxAge() * 1000LL )
+  {
+    QgsDebugMsgLevel( QStringLiteral( "WFS cache %1 has expired" ).arg( mCacheDbname ), 4 );
+    return false;
+  }
+  const bool complete = stmt.columnAsInt64( 1 ) != 0;
+
+  QVector< QgsFeature > regions;
+  QgsSpatialIndex cachedRegions;
+  stmt = database.prepare( QStringLiteral( "SELECT xmin, ymin, xmax, ymax, download_limit FROM wfs_cache_regions" ), resultCode );
+  if ( resultCode != SQLITE_OK )
+    return false;
+  while ( stmt.step() == SQLITE_ROW )
+  {
+    QgsFeature f;
+    f.setGeometry( QgsGeometry::fromRect( QgsRectangle( stmt.columnAsDouble( 0 ), stmt.columnAsDouble( 1 ), stmt.columnAsDouble( 2 ), stmt.columnAsDouble( 3 ) ) ) );
+    f.setId( regions.size() );
+    f.initAttributes( 1 );
+    f.setAttribute( 0, QVariant( stmt.columnAsInt64( 4 ) != 0 ) );
+    regions.push_back( f );
+    cachedRegions.addFeature( f );
+  }
+
+  stmt = database.prepare( QStringLiteral( "SELECT MAX(%1), COUNT(*) FROM %2" ).arg( quotedIdentifier( QgsWFSConstants::FIELD_GEN_COUNTER ), mCacheTablename ), resultCode );
+  if ( resultCode != SQLITE_OK || stmt.step() != SQLITE_ROW )
+    return false;
+  mGenCounter = static_cast< int >( stmt.columnAsInt64( 0 ) ) + 1;
+  mFeatureCount = static_cast< int >( stmt.columnAsInt64( 1 ) );
+  mTotalFeaturesAttemptedToBeCached = mFeatureCount;
+  mFeatureCountExact = complete;
+  mCacheComplete = complete;
+  mRegions = regions;
+  mCachedRegions = cachedRegions;
+
+  // The extent of the cached features is the one of their bounding boxes in the spatial index
+  stmt = database.prepare( QStringLiteral( "SELECT MIN(xmin), MIN(ymin), MAX(xmax), MAX(ymax) FROM %1" )
+                           .arg( quotedIdentifier( QStringLiteral( "idx_%1___spatialite_geometry" ).arg( mCacheTablename ) ) ), resultCode );
+  if ( resultCode == SQLITE_OK && stmt.step() == SQLITE_ROW && mFeatureCount > 0 )
+    mComputedExtent = QgsRectangle( stmt.columnAsDouble( 0 ), stmt.columnAsDouble( 1 ), stmt.columnAsDouble( 2 ), stmt.columnAsDouble( 3 ) );
+
   return true;
 }
 
+void QgsWFSSharedData::saveCacheState()
+{
+  sqlite3_database_unique_ptr database;
+  QString errorMsg;
+  bool ok = database.open( mCacheDbname ) == SQLITE_OK;
+  if ( ok )
+  {
+    // The cache may be written at the same time by a WFS-T edit
+    sqlite3_busy_timeout( database.get(), 5000 );
+
+    ok &= database.exec( QStringLiteral( "BEGIN" ), errorMsg ) == SQLITE_OK;
+    ok &= database.exec( QStringLiteral( "UPDATE wfs_cache_state SET complete = %1" ).arg( mCacheComplete ? 1 : 0 ), errorMsg ) == SQLITE_OK;
+    ok &= database.exec( QStringLiteral( "DELETE FROM wfs_cache_regions" ), errorMsg ) == SQLITE_OK;
+    for ( const QgsFeature &region : qgis::as_const( mRegions ) )
+    {
+      const QgsRectangle rect = region.geometry().boundingBox();
+      ok &= database.exec( QStringLiteral( "INSERT INTO wfs_cache_regions VALUES (%1, %2, %3, %4, %5)" )
+                           .arg( qgsDoubleToString( rect.xMinimum(), 17 ), qgsDoubleToString( rect.yMinimum(), 17 ),
+                                 qgsDoubleToString( rect.xMaximum(), 17 ), qgsDoubleToString( rect.yMaximum(), 17 ) )
+                           .arg( region.attributes().value( 0 ).toBool() ? 1 : 0 ), errorMsg ) == SQLITE_OK;
+    }
+    ok &= database.exec( QStringLiteral( "COMMIT" ), errorMsg ) == SQLITE_OK;
+  }
+  if ( !ok )
+  {
+    QgsMessageLog::logMessage( tr( "Cannot save the state of the WFS cache: %1" ).arg( errorMsg ), tr( "WFS" ) );
+  }
+}
+
+bool QgsWFSSharedData::cacheCoversRequest( const QgsRectangle &rect ) const
+{
+  // All the features of the layer are in the cache
+  if ( mCacheComplete )
+    return true;
+
+  if ( rect.isEmpty() )
+    return false;
+
+  const QList<QgsFeatureId> intersectingRequests = mCachedRegions.intersects( rect );
+  for ( QgsFeatureId id : intersectingRequests )
+  {
+    Q_ASSERT( id >= 0 && id < mRegions.size() ); // by construction, but doesn't hurt to be checked
+
+    // If the requested bbox is inside an already cached rect that didn't
+    // hit the download limit, then we can reuse the cached features without
+    // issuing a new request.
+    if ( mRegions[id].geometry().boundingBox().contains( rect ) &&
+         !mRegions[id].attributes().value( 0 ).toBool() )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Cached features already cover this area of interest" ), 4 );
+      return true;
+    }
+
+    // On the other hand, if the requested bbox is inside an already cached rect,
+    // that hit the download limit, our larger bbox will hit it too, so no need
+    // to re-issue a new request either.
+    if ( rect.contains( mRegions[id].geometry().boundingBox() ) &&
+         mRegions[id].attributes().value( 0 ).toBool() )
+    {
+      QgsDebugMsgLevel( QStringLiteral( "Current request is larger than a smaller request that hit the download limit, so no server download needed." ), 4 );
+      return true;
+    }
+  }
+  return false;
+}
+
 int QgsWFSSharedData::registerToCache( QgsWFSFeatureIterator *iterator, int limit, const QgsRectangle &rect )
 {
   // This locks prevents 2 readers to register at the same time (and particularly
@@ -542,35 +765,7 @@ int QgsWFSSharedData::registerToCache( QgsWFSFeatureIterator *iterator, int limi
   bool newDownloadNeeded = false;
   if ( !rect.isEmpty() && mRect != rect && !( mDownloader && mRect.isEmpty() ) )
   {
-    QList<QgsFeatureId> intersectingRequests = mCachedRegions.intersects( rect );
-    newDownloadNeeded = true;
-    const auto constIntersectingRequests = intersectingRequests;
-    for ( QgsFeatureId id : constIntersectingRequests )
-    {
-      Q_ASSERT( id >= 0 && id < mRegions.size() ); // by construction, but doesn't hurt to be checked
-
-      // If the requested bbox is inside an already cached rect that didn't
-      // hit the download limit, then we can reuse the cached features without
-      // issuing a new request.
-      if ( mRegions[id].geometry().boundingBox().contains( rect ) &&
-           !mRegions[id].attributes().value( 0 ).toBool() )
-      {
-        QgsDebugMsgLevel( QStringLiteral( "Cached features already cover this area of interest" ), 4 );
-        newDownloadNeeded = false;
-        break;
-      }
-
-      // On the other hand, if the requested bbox is inside an already cached rect,
-      // that hit the download limit, our larger bbox will hit it too, so no need
-      // to re-issue a new request either.
-      if ( rect.contains( mRegions[id].geometry().boundingBox() ) &&
-           mRegions[id].attributes().value( 0 ).toBool() )
-      {
-        QgsDebugMsgLevel( QStringLiteral( "Current request is larger than a smaller request that hit the download limit, so no server download needed." ), 4 );
-        newDownloadNeeded = false;
-        break;
-      }
-    }
+    newDownloadNeeded = !cacheCoversRequest( rect );
   }
   // If there's a ongoing download with a BBOX and we request a new download
   // without it, then we need a new download.
@@ -585,6 +780,14 @@ int QgsWFSSharedData::registerToCache( QgsWFSFeatureIterator *iterator, int limi
     newDownloadNeeded = true;
   }
 
+  // The cache restored from a previous session serves the requests of the
+  // regions it holds without downloading anything
+  if ( !mDownloader && cacheCoversRequest( rect ) )
+  {
+    mDownloadFinished = true;
+    return -1;
+  }
+
   if ( newDownloadNeeded || !mDownloader )
   {
     mRect = rect;
@@ -1029,6 +1232,10 @@ void QgsWFSSharedData::serializeFeatures( QVector<QgsWFSFeatureGmlIdPair> &featu
     // That way we will always have a consistent feature id, even in case of
     // paging or BBOX request
     Q_ASSERT( featureListToCache.size() == updatedFeatureList.size() );
+
+    // The ids of the whole batch are updated in a single transaction
+    QString beginErrorMsg;
+    const bool idCacheTransaction = mCacheIdDb.exec( QStringLiteral( "BEGIN" ), beginErrorMsg ) == SQLITE_OK;
     for ( int i = 0; i < updatedFeatureList.size(); i++ )
     {
       int resultCode;
@@ -1095,6 +1302,14 @@ void QgsWFSSharedData::serializeFeatures( QVector<QgsWFSFeatureGmlIdPair> &featu
 
       updatedFeatureList[i].first.setId( qgisId );
     }
+    if ( idCacheTransaction )
+    {
+      QString errorMsg;
+      if ( mCacheIdDb.exec( QStringLiteral( "COMMIT" ), errorMsg ) != SQLITE_OK )
+      {
+        QgsMessageLog::logMessage( tr( "Problem when updating WFS id cache: %1" ).arg( errorMsg ), tr( "WFS" ) );
+      }
+    }
 
     {
       QMutexLocker locker( &mMutex );
@@ -1208,6 +1423,16 @@ void QgsWFSSharedData::endOfDownload( bool success, int featureCount,
     }
   }
 
+  if ( mRect.isEmpty() && success && !bDownloadLimit && mRequestLimit == 0 )
+  {
+    mCacheComplete = true;
+  }
+
+  if ( mCachePersistent && success )
+  {
+    saveCacheState();
+  }
+
   if ( mRect.isEmpty() && success && !bDownloadLimit && mRequestLimit == 0 && !mFeatureCountExact )
   {
     mFeatureCountExact = true;
@@ -1233,9 +1458,16 @@ void QgsWFSSharedData::endOfDownload( bool success, int featureCount,
   }
 }
 
-// This is called by the destructor or QgsWFSProvider::reloadData(). The effect is to invalid
+// This is called by QgsWFSProvider::reloadData(). The effect is to invalid
 // all the caching state, so that a new request results in fresh download
 void QgsWFSSharedData::invalidateCache()
+{
+  releaseCache( false );
+}
+
+// Also called by the destructor, which keeps the on-disk cache for the next
+// sessions if enabled
+void QgsWFSSharedData::releaseCache( bool keepPersistentCache )
 {
   // Cf explanations in registerToCache() for the locking strategy
   QMutexLocker lockerMyself( &mMutexRegisterToCache );
@@ -1257,6 +1489,7 @@ void QgsWFSSharedData::invalidateCache()
   mFeatureCount = 0;
   mFeatureCountExact = false;
   mTotalFeaturesAttemptedToBeCached = 0;
+  mCacheComplete = false;
   if ( !mCacheDbname.isEmpty() && mCacheDataProvider )
   {
     // We need to invalidate connections pointing to the cache, so as to
@@ -1268,11 +1501,16 @@ void QgsWFSSharedData::invalidateCache()
 
   if ( !mCacheDbname.isEmpty() )
   {
-    QFile::remove( mCacheDbname );
-    QFile::remove( mCacheDbname + "-wal" );
-    QFile::remove( mCacheDbname + "-shm" );
+    if ( !keepPersistentCache || !mCachePersistent )
+    {
+      QFile::remove( mCacheDbname );
+      QFile::remove( mCacheDbname + "-wal" );
+      QFile::remove( mCacheDbname + "-shm" );
+    }
     mCacheDbname.clear();
   }
+  mCacheLock.reset();
+  mCachePersistent = false;
 }
 
 void QgsWFSSharedData::setFeatureCount( int featureCount )
@@ -23,6 +23,8 @@
 #include "qgssqliteutils.h"
 
 #include <map>
+#include <memory>
+#include <QLockFile>
 
 /**
  * This class holds data, and logic, shared between QgsWFSProvider, QgsWFSFeatureIterator
@@ -47,6 +49,11 @@
  *
  *  It contains also methods used in WFS-T context to update the cache content,
  *  from the changes initiated by the user.
+ *
+ *  When the wfs/persistent_cache_max_age setting is set, the database is kept
+ *  across sessions, keyed by the URI and the filter of the layer, with the
+ *  requested regions it holds. Requests on these regions are then served from
+ *  the cache without downloading the features again.
  */
 class QgsWFSSharedData : public QObject
 {
@@ -270,6 +277,15 @@ class QgsWFSSharedData : public QObject
     //! Next value for qgisId column
     QgsFeatureId mNextCachedIdQgisId = 1;
 
+    //! Whether the on-disk cache is kept across sessions
+    bool mCachePersistent = false;
+
+    //! Prevents other layers and QGIS instances to use the on-disk cache kept across sessions
+    std::unique_ptr< QLockFile > mCacheLock;
+
+    //! Whether all the features of the layer have been downloaded into the cache
+    bool mCacheComplete = false;
+
     /**
      * Returns the set of gmlIds that have already been downloaded and
         cached, so as to avoid to cache duplicates. */
@@ -283,6 +299,24 @@ class QgsWFSSharedData : public QObject
     //! Create the on-disk cache and connect to it
     bool createCache();
 
+    //! Connect to the on-disk cache, and create the id cache if needed
+    bool connectToCache( const QString &cacheDirectory, int tmpCounter, bool restoredCache );
+
+    //! Returns the filename of the on-disk cache kept across sessions, or an empty string if they are disabled
+    QString persistentCacheDbname() const;
+
+    //! Restores the regions and the state of the on-disk cache kept across sessions. Returns false if the cache is not usable
+    bool restoreCacheState();
+
+    //! Saves the regions and the state of the on-disk cache kept across sessions
+    void saveCacheState();
+
+    //! Returns whether the cached features hold all the features of the area of interest \a rect
+    bool cacheCoversRequest( const QgsRectangle &rect ) const;
+
+    //! Invalidates the caching state. The on-disk cache is deleted, unless \a keepPersistentCache is set and it is kept across sessions
+    void releaseCache( bool keepPersistentCache );
+
     //! Log error to QgsMessageLog and raise it to the provider
     void pushError( const QString &errorMsg );
 };
@@ -28,6 +28,7 @@
 #include <QSharedMemory>
 #include <QDateTime>
 #include <QCryptographicHash>
+#include <QLockFile>
 
 QMutex QgsWFSUtils::sMutex;
 QThread *QgsWFSUtils::sThread = nullptr;
@@ -116,6 +117,26 @@ void QgsWFSUtils::releaseCacheDirectory()
   }
 }
 
+int QgsWFSUtils::persistentCacheMaxAge()
+{
+  return qMax( 0, QgsSettings().value( QStringLiteral( "wfs/persistent_cache_max_age" ), 0 ).toInt() );
+}
+
+QString QgsWFSUtils::persistentCacheDirectory()
+{
+  if ( persistentCacheMaxAge() == 0 )
+    return QString();
+
+  QString baseDirectory( getBaseCacheDirectory( true ) );
+  QMutexLocker locker( &sMutex );
+  if ( !QDir( baseDirectory ).exists( QStringLiteral( "persistent" ) ) )
+  {
+    QgsDebugMsg( QStringLiteral( "Creating persistent cache dir %1/persistent" ).arg( baseDirectory ) );
+    QDir( baseDirectory ).mkpath( QStringLiteral( "persistent" ) );
+  }
+  return QDir( baseDirectory ).filePath( QStringLiteral( "persistent" ) );
+}
+
 bool QgsWFSUtils::removeDir( const QString &dirName )
 {
   QDir dir( dirName );
@@ -294,6 +315,29 @@ void QgsWFSUtils::init()
         }
       }
     }
+
+    // Remove the caches kept across sessions that have expired, or all of them
+    // if they have been disabled. Caches locked by a layer are kept
+    QDir persistentDir( dir.filePath( QStringLiteral( "persistent" ) ) );
+    if ( persistentDir.exists() )
+    {
+      const qint64 maxAge = persistentCacheMaxAge();
+      const QFileInfoList persistentFileList( persistentDir.entryInfoList( QStringList() << QStringLiteral( "*.sqlite" ), QDir::Files ) );
+      for ( const QFileInfo &info : persistentFileList )
+      {
+        if ( maxAge > 0 && info.lastModified().toMSecsSinceEpoch() > currentTimestamp - maxAge * 1000 )
+          continue;
+
+        QLockFile lock( info.absoluteFilePath() + QStringLiteral( ".lock" ) );
+        if ( !lock.tryLock( 0 ) )
+          continue;
+
+        QgsDebugMsgLevel( QStringLiteral( "Removing expired cache %1" ).arg( info.absoluteFilePath() ), 4 );
+        QFile::remove( info.absoluteFilePath() );
+        QFile::remove( info.absoluteFilePath() + QStringLiteral( "-wal" ) );
+        QFile::remove( info.absoluteFilePath() + QStringLiteral( "-shm" ) );
+      }
+    }
   }
 }
 
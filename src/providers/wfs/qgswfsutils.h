@@ -34,6 +34,14 @@ class QgsWFSUtils
     //! To be called when a temporary file is removed from the directory
     static void releaseCacheDirectory();
 
+    /**
+     * Returns the name of the directory of the caches kept across sessions, or an
+        empty string if they are disabled (wfs/persistent_cache_max_age setting is 0). */
+    static QString persistentCacheDirectory();
+
+    //! Returns the maximum age, in seconds, of the caches kept across sessions. 0 if they are disabled.
+    static int persistentCacheMaxAge();
+
     //! Initial cleanup.
     static void init();
 
@@ -25,8 +25,13 @@
 
 #include <fcgi_stdio.h>
 #include <cstdlib>
+#include <memory>
+#include <vector>
 
+#include <QEventLoop>
+#include <QMutex>
 #include <QString>
+#include <QThread>
 
 int fcgi_accept()
 {
@@ -40,6 +45,68 @@ int fcgi_accept()
 #endif
 }
 
+///@cond PRIVATE
+namespace
+{
+
+  /**
+   * Serves FastCGI requests from its own thread, reading and writing
+   * through a FCGX_Request instead of the process wide stdio streams.
+   */
+  class QgsFcgiWorker : public QThread
+  {
+    public:
+      QgsFcgiWorker( QgsServer &server, QMutex &acceptMutex )
+        : mServer( server )
+        , mAcceptMutex( acceptMutex )
+      {}
+
+    protected:
+      void run() override
+      {
+        FCGX_Request fcgiRequest;
+        if ( FCGX_InitRequest( &fcgiRequest, 0, 0 ) != 0 )
+        {
+          QgsMessageLog::logMessage( QStringLiteral( "fcgi: Failed to initialize request" ), QStringLiteral( "Server" ), Qgis::Critical );
+          return;
+        }
+
+        while ( true )
+        {
+          int rc;
+          {
+            // Some platforms do not support concurrent accept() on the same socket
+            QMutexLocker locker( &mAcceptMutex );
+            rc = FCGX_Accept_r( &fcgiRequest );
+          }
+          if ( rc < 0 )
+            break;
+
+          {
+            QgsFcgiServerRequest  request( &fcgiRequest );
+            QgsFcgiServerResponse response( request.method(), &fcgiRequest );
+            if ( ! request.hasError() )
+            {
+              mServer.handleRequest( request, response );
+            }
+            else
+            {
+              response.sendError( 400, "Bad request" );
+            }
+          }
+          FCGX_Finish_r( &fcgiRequest );
+        }
+        FCGX_Free( &fcgiRequest, 1 );
+      }
+
+    private:
+      QgsServer &mServer;
+      QMutex &mAcceptMutex;
+  };
+
+}
+///@endcond
+
 int main( int argc, char *argv[] )
 {
   // Test if the environ variable DISPLAY is defined
@@ -65,18 +132,52 @@ int main( int argc, char *argv[] )
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   server.initPython();
 #endif
-  // Starts FCGI loop
-  while ( fcgi_accept() >= 0 )
+
+  const int threads = server.serverInterface()->serverSettings()->fcgiThreads();
+  if ( threads > 1 && !FCGX_IsCGI() )
   {
-    QgsFcgiServerRequest  request;
-    QgsFcgiServerResponse response( request.method() );
-    if ( ! request.hasError() )
+    // Serve requests concurrently, the workers share the cache of the projects
+    FCGX_Init();
+    QgsMessageLog::logMessage( QStringLiteral( "Serving FastCGI requests from %1 threads" ).arg( threads ), QStringLiteral( "Server" ), Qgis::Info );
+
+    QMutex acceptMutex;
+    QEventLoop loop;
+    int running = threads;
+    std::vector< std::unique_ptr< QgsFcgiWorker > > workers;
+    for ( int i = 0; i < threads; ++i )
     {
-      server.handleRequest( request, response );
+      workers.emplace_back( new QgsFcgiWorker( server, acceptMutex ) );
+      QObject::connect( workers.back().get(), &QThread::finished, &loop, [&loop, &running]
+      {
+        if ( --running == 0 )
+          loop.quit();
+      } );
+      workers.back()->start();
     }
-    else
+
+    // The main thread event loop handles the config cache invalidations
+    // and background project reloads while the workers serve requests
+    loop.exec();
+    for ( const auto &worker : workers )
+    {
+      worker->wait();
+    }
+  }
+  else
+  {
+    // Starts FCGI loop
+    while ( fcgi_accept() >= 0 )
     {
-      response.sendError( 400, "Bad request" );
+      QgsFcgiServerRequest  request;
+      QgsFcgiServerResponse response( request.method() );
+      if ( ! request.hasError() )
+      {
+        server.handleRequest( request, response );
+      }
+      else
+      {
+        response.sendError( 400, "Bad request" );
+      }
     }
   }
   app.exitQgis();
@@ -16,54 +16,357 @@
  ***************************************************************************/
 
 #include "qgsconfigcache.h"
+#include "qgsapplication.h"
 #include "qgsmessagelog.h"
+#include "qgsruntimeprofiler.h"
 #include "qgsserverexception.h"
+#include "qgsserverresponsecache.h"
 #include "qgsstorebadlayerinfo.h"
 
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <functional>
+
+///@cond PRIVATE
+namespace
+{
+  bool isMainThread()
+  {
+    return !QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread();
+  }
+
+  //! Reads a project, returns NULLPTR if it cannot be read
+  std::unique_ptr<QgsProject> readProject( const QString &path, QStringList &badLayers )
+  {
+    std::unique_ptr<QgsProject> prj( new QgsProject() );
+    QgsStoreBadLayerInfo *badLayerHandler = new QgsStoreBadLayerInfo();
+    prj->setBadLayerHandler( badLayerHandler );
+    QgsServerResponseCache::setProjectVersion( prj.get(), path );
+    if ( !prj->read( path ) )
+    {
+      QgsMessageLog::logMessage(
+        QObject::tr( "Error when loading project file '%1': %2 " ).arg( path, prj->error() ),
+        QStringLiteral( "Server" ), Qgis::Critical );
+      return nullptr;
+    }
+    badLayers = badLayerHandler->badLayers();
+    return prj;
+  }
+
+  //! Cached projects may be released last by the thread of any request
+  std::shared_ptr<QgsProject> sharedProject( QgsProject *project )
+  {
+    return std::shared_ptr<QgsProject>( project, []( QgsProject * p )
+    {
+      if ( QThread::currentThread() == p->thread() )
+        delete p;
+      else
+        p->deleteLater();
+    } );
+  }
+
+  class QgsProjectReloadTask : public QRunnable
+  {
+    public:
+      explicit QgsProjectReloadTask( const std::function<void()> &function )
+        : mFunction( function )
+      {}
+
+      void run() override
+      {
+        mFunction();
+      }
+
+    private:
+      std::function<void()> mFunction;
+  };
+}
+///@endcond
+
+///@cond PRIVATE
+//! The copies of a cached project which are not used by a request
+struct QgsConfigCache::ProjectPool
+{
+  QMutex mutex;
+  QList<std::shared_ptr<QgsProject>> idle;
+};
+///@endcond
+
+QgsConfigCache::ProjectLock::ProjectLock( const std::shared_ptr<QgsProject> &project, const std::shared_ptr<ProjectPool> &pool )
+  : mProject( project )
+  , mPool( pool )
+{
+}
+
+QgsConfigCache::ProjectLock::~ProjectLock()
+{
+  // the pool of a removed or reloaded project is released with its last lock
+  QMutexLocker locker( &mPool->mutex );
+  mPool->idle.append( mProject );
+}
 
 QgsConfigCache *QgsConfigCache::instance()
 {
   static QgsConfigCache *sInstance = nullptr;
+  static QMutex sInstanceMutex;
 
+  QMutexLocker locker( &sInstanceMutex );
   if ( !sInstance )
+  {
     sInstance = new QgsConfigCache();
-
+    // file system changes are notified through the event loop of the main thread
+    if ( !isMainThread() )
+      sInstance->moveToThread( QCoreApplication::instance()->thread() );
+  }
   return sInstance;
 }
 
 QgsConfigCache::QgsConfigCache()
+  : mMutex( QMutex::Recursive )
 {
-  QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsConfigCache::removeChangedEntry );
+  // moved with the cache to its thread
+  mFileSystemWatcher.setParent( this );
+  QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsConfigCache::reloadChangedEntry );
 }
 
-const QgsProject *QgsConfigCache::project( const QString &path )
+QgsConfigCache::~QgsConfigCache() = default;
+
+QgsConfigCache::ProjectEntry QgsConfigCache::projectEntry( const QString &path )
 {
-  if ( ! mProjectCache[ path ] )
   {
-    std::unique_ptr<QgsProject> prj( new QgsProject() );
-    QgsStoreBadLayerInfo *badLayerHandler = new QgsStoreBadLayerInfo();
-    prj->setBadLayerHandler( badLayerHandler );
-    if ( prj->read( path ) )
+    // Only one thread reads a project which is not cached yet
+    QMutexLocker loadingLocker( &mLoadingMutex );
+    for ( ;; )
     {
-      if ( !badLayerHandler->badLayers().isEmpty() )
       {
-        QString errorMsg = QStringLiteral( "Layer(s) %1 not valid" ).arg( badLayerHandler->badLayers().join( ',' ) );
-        QgsMessageLog::logMessage( errorMsg, QStringLiteral( "Server" ), Qgis::Critical );
-        throw QgsServerException( QStringLiteral( "Layer(s) not valid" ) );
+        QMutexLocker locker( &mMutex );
+        if ( ProjectEntry *entry = mProjectCache.object( path ) )
+          return *entry;
       }
-      mProjectCache.insert( path, prj.release() );
-      mFileSystemWatcher.addPath( path );
+      if ( !mLoadingProjects.contains( path ) )
+        break;
+      mLoadingCondition.wait( &mLoadingMutex );
+    }
+    mLoadingProjects.insert( path );
+  }
+
+  // The other projects are served while the project is read
+  QStringList badLayers;
+  std::unique_ptr<QgsProject> prj = readProject( path, badLayers );
+  ProjectEntry entry;
+  if ( prj && badLayers.isEmpty() )
+  {
+    // the project belongs to the thread of the cache, as the project reloaded in the background
+    prj->moveToThread( thread() );
+    entry.project = sharedProject( prj.release() );
+    entry.pool = std::make_shared<ProjectPool>();
+    entry.pool->idle.append( entry.project );
+
+    QMutexLocker locker( &mMutex );
+    mProjectCache.insert( path, new ProjectEntry( entry ) );
+    watchPath( path );
+  }
+
+  {
+    QMutexLocker loadingLocker( &mLoadingMutex );
+    mLoadingProjects.remove( path );
+    mLoadingCondition.wakeAll();
+  }
+
+  if ( !badLayers.isEmpty() )
+  {
+    QString errorMsg = QStringLiteral( "Layer(s) %1 not valid" ).arg( badLayers.join( ',' ) );
+    QgsMessageLog::logMessage( errorMsg, QStringLiteral( "Server" ), Qgis::Critical );
+    throw QgsServerException( QStringLiteral( "Layer(s) not valid" ) );
+  }
+  return entry;
+}
+
+const QgsProject *QgsConfigCache::project( const QString &path )
+{
+  const ProjectEntry entry = projectEntry( path );
+  // QgsProject::instance() is not thread safe, it is only set by the main thread
+  if ( isMainThread() )
+    QgsProject::setInstance( entry.project.get() );
+  return entry.project.get();
+}
+
+std::unique_ptr<QgsConfigCache::ProjectLock> QgsConfigCache::lockProject( const QString &path )
+{
+  const ProjectEntry entry = projectEntry( path );
+  if ( !entry.project )
+    return nullptr;
+
+  std::shared_ptr<QgsProject> project;
+  {
+    QMutexLocker locker( &entry.pool->mutex );
+    if ( !entry.pool->idle.isEmpty() )
+      project = entry.pool->idle.takeLast();
+  }
+
+  if ( !project )
+  {
+    // The cached copies are used by other requests, read another one
+    QStringList badLayers;
+    std::unique_ptr<QgsProject> prj = readProject( path, badLayers );
+    if ( !prj )
+      return nullptr;
+
+    if ( !badLayers.isEmpty() )
+    {
+      QString errorMsg = QStringLiteral( "Layer(s) %1 not valid" ).arg( badLayers.join( ',' ) );
+      QgsMessageLog::logMessage( errorMsg, QStringLiteral( "Server" ), Qgis::Critical );
+      throw QgsServerException( QStringLiteral( "Layer(s) not valid" ) );
+    }
+
+    prj->moveToThread( thread() );
+    project = sharedProject( prj.release() );
+  }
+
+  // QgsProject::instance() is not thread safe, it is only set by the main thread
+  if ( isMainThread() )
+    QgsProject::setInstance( project.get() );
+  return std::unique_ptr<ProjectLock>( new ProjectLock( project, entry.pool ) );
+}
+
+void QgsConfigCache::prewarm( const QStringList &paths )
+{
+  // The profiler is not thread safe
+  QgsRuntimeProfiler *profiler = isMainThread() ? QgsApplication::profiler() : nullptr;
+  if ( profiler )
+    profiler->beginGroup( QStringLiteral( "Server project prewarm" ) );
+
+  for ( const QString &path : paths )
+  {
+    QElapsedTimer timer;
+    timer.start();
+    if ( profiler )
+      profiler->start( path );
+
+    const QgsProject *prj = nullptr;
+    try
+    {
+      // not set as QgsProject::instance(), which is not used by the threads serving requests
+      prj = projectEntry( path ).project.get();
+    }
+    catch ( QgsServerException & )
+    {
+      // invalid layers are already logged
+    }
+
+    if ( profiler )
+      profiler->end();
+
+    if ( prj )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Project '%1' loaded in %2 ms" ).arg( path ).arg( timer.elapsed() ),
+                                 QStringLiteral( "Server" ), Qgis::Info );
     }
     else
     {
-      QgsMessageLog::logMessage(
-        tr( "Error when loading project file '%1': %2 " ).arg( path, prj->error() ),
-        QStringLiteral( "Server" ), Qgis::Critical );
+      QgsMessageLog::logMessage( QStringLiteral( "Project '%1' could not be loaded at startup" ).arg( path ),
+                                 QStringLiteral( "Server" ), Qgis::Warning );
     }
   }
-  QgsProject::setInstance( mProjectCache[ path ] );
-  return mProjectCache[ path ];
+
+  if ( profiler )
+    profiler->endGroup();
+}
+
+void QgsConfigCache::reloadProject( const QString &path )
+{
+  QMutexLocker locker( &mMutex );
+  if ( mReloadingProjects.contains( path ) )
+  {
+    // Reload again when the current reload is done
+    mReloadingProjects[ path ] = true;
+    return;
+  }
+  mReloadingProjects.insert( path, false );
+
+  QThread *cacheThread = thread();
+  QThreadPool::globalInstance()->start( new QgsProjectReloadTask( [this, cacheThread, path]
+  {
+    QStringList badLayers;
+    std::unique_ptr<QgsProject> prj = readProject( path, badLayers );
+    if ( prj && !badLayers.isEmpty() )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Layer(s) %1 not valid, keeping the cached project '%2'" ).arg( badLayers.join( ',' ), path ),
+                                 QStringLiteral( "Server" ), Qgis::Critical );
+      prj.reset();
+    }
+
+    // The project is handed over to the thread of the cache
+    if ( prj )
+      prj->moveToThread( cacheThread );
+    QgsProject *project = prj.release();
+    QTimer::singleShot( 0, this, [this, path, project] { reloadFinished( path, project ); } );
+  } ) );
+}
+
+void QgsConfigCache::reloadFinished( const QString &path, QgsProject *project )
+{
+  QMutexLocker locker( &mMutex );
+  const bool changedAgain = mReloadingProjects.take( path );
+
+  // The entry may have been removed during the reload
+  ProjectEntry *entry = mProjectCache.object( path );
+  if ( entry )
+  {
+    if ( project )
+    {
+      if ( QgsProject::instance() == entry->project.get() )
+      {
+        QgsProject::setInstance( project );
+      }
+      // requests still using the previous project keep it until they are done,
+      // and the copies of the previous project are released with them
+      ProjectEntry *reloaded = new ProjectEntry { sharedProject( project ), std::make_shared<ProjectPool>() };
+      reloaded->pool->idle.append( reloaded->project );
+      mProjectCache.insert( path, reloaded );
+      QgsMessageLog::logMessage( QStringLiteral( "Project '%1' reloaded" ).arg( path ), QStringLiteral( "Server" ), Qgis::Info );
+    }
+
+    // Files replaced by a new one are no longer watched
+    watchPath( path );
+
+    if ( changedAgain )
+      reloadProject( path );
+  }
+  else
+  {
+    delete project;
+  }
+}
+
+void QgsConfigCache::watchPath( const QString &path )
+{
+  if ( QThread::currentThread() != thread() )
+  {
+    QTimer::singleShot( 0, this, [this, path] { watchPath( path ); } );
+    return;
+  }
+
+  if ( !mFileSystemWatcher.files().contains( path ) )
+    mFileSystemWatcher.addPath( path );
+}
+
+void QgsConfigCache::unwatchPath( const QString &path )
+{
+  if ( QThread::currentThread() != thread() )
+  {
+    QTimer::singleShot( 0, this, [this, path] { unwatchPath( path ); } );
+    return;
+  }
+
+  mFileSystemWatcher.removePath( path );
 }
 
 QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
@@ -83,6 +386,7 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
   }
 
   // first get cache
+  QMutexLocker locker( &mMutex );
   QDomDocument *xmlDoc = mXmlDocumentCache.object( filePath );
   if ( !xmlDoc )
   {
@@ -98,21 +402,38 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
       return nullptr;
     }
     mXmlDocumentCache.insert( filePath, xmlDoc );
-    mFileSystemWatcher.addPath( filePath );
+    watchPath( filePath );
     xmlDoc = mXmlDocumentCache.object( filePath );
     Q_ASSERT( xmlDoc );
   }
   return xmlDoc;
 }
 
+void QgsConfigCache::reloadChangedEntry( const QString &path )
+{
+  QMutexLocker locker( &mMutex );
+  if ( !mProjectCache.contains( path ) )
+  {
+    removeChangedEntry( path );
+    return;
+  }
+
+  // The cached project is served until the changed one is loaded
+  mXmlDocumentCache.remove( path );
+  reloadProject( path );
+}
+
 void QgsConfigCache::removeChangedEntry( const QString &path )
 {
+  QMutexLocker locker( &mMutex );
+
+  // requests still using the project keep it until they are done
   mProjectCache.remove( path );
 
   //xml document must be removed last, as other config cache destructors may require it
   mXmlDocumentCache.remove( path );
 
-  mFileSystemWatcher.removePath( path );
+  unwatchPath( path );
 }
 
 
@@ -120,4 +441,3 @@ void QgsConfigCache::removeEntry( const QString &path )
 {
   removeChangedEntry( path );
 }
-
@@ -21,9 +21,15 @@
 #include "qgsconfig.h"
 
 #include <QCache>
+#include <QHash>
 #include <QFileSystemWatcher>
 #include <QObject>
 #include <QDomDocument>
+#include <QMutex>
+#include <QSet>
+#include <QWaitCondition>
+
+#include <memory>
 
 #include "qgis_server.h"
 #include "qgis_sip.h"
@@ -39,11 +45,52 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     Q_OBJECT
   public:
 
+#ifndef SIP_RUN
+
+    struct ProjectPool;
+
+    /**
+     * Exclusive use of a cached project by the thread serving a request.
+     *
+     * Services modify the layers of a project while handling a request, so a
+     * project is never used by two requests at the same time. Each cached project
+     * comes with a pool of copies read from the same file: concurrent requests
+     * for the same project are served from different copies, which are kept for
+     * the next requests once released. The project is kept alive until the lock
+     * is destroyed, even if it is removed from the cache or replaced by a reloaded
+     * project meanwhile.
+     *
+     * \note not available in Python bindings
+     * \since QGIS 3.10
+     */
+    class SERVER_EXPORT ProjectLock
+    {
+      public:
+        ~ProjectLock();
+
+        //! Returns the locked project
+        const QgsProject *project() const { return mProject.get(); }
+
+      private:
+        ProjectLock( const std::shared_ptr<QgsProject> &project, const std::shared_ptr<ProjectPool> &pool );
+
+        std::shared_ptr<QgsProject> mProject;
+        std::shared_ptr<ProjectPool> mPool;
+
+        friend class QgsConfigCache;
+    };
+#endif
+
     /**
      * Returns the current instance.
+     *
+     * A single instance is shared by all the threads serving requests, so that
+     * the projects are read once and kept in memory for all of them.
      */
     static QgsConfigCache *instance();
 
+    ~QgsConfigCache() override;
+
     /**
      * Removes an entry from cache.
      * \param path The path of the project
@@ -53,27 +100,106 @@ class SERVER_EXPORT QgsConfigCache : public QObject
     /**
      * If the project is not cached yet, then the project is read thanks to the
      * path. If the project is not available, then NULLPTR is returned.
+     *
+     * When called from the main thread, the project is also set as the
+     * QgsProject::instance(). The threads serving requests concurrently
+     * must use lockProject() instead, as the returned project may be used
+     * by a request at the same time.
      * \param path the filename of the QGIS project
      * \returns the project or NULLPTR if an error happened
      * \since QGIS 3.0
      */
     const QgsProject *project( const QString &path );
 
+#ifndef SIP_RUN
+
+    /**
+     * Returns the project of \a path, read if it is not cached yet, for the
+     * exclusive use of the calling thread until the returned lock is destroyed.
+     * When the cached project is used by other threads, another copy of the
+     * project is read from \a path, so that the requests are not serialized.
+     *
+     * When called from the main thread, the project is also set as the
+     * QgsProject::instance().
+     *
+     * Returns NULLPTR if the project is not available.
+     * \see project()
+     * \note not available in Python bindings
+     * \since QGIS 3.10
+     */
+    std::unique_ptr<ProjectLock> lockProject( const QString &path );
+#endif
+
+    /**
+     * Reads the projects of \a paths and stores them in the cache, so that
+     * the first requests using them do not have to wait for the projects to
+     * be read. Projects which cannot be read are skipped.
+     *
+     * Loading times are logged and, when called from the main thread,
+     * recorded by QgsApplication::profiler().
+     * \since QGIS 3.10
+     */
+    void prewarm( const QStringList &paths );
+
   private:
     QgsConfigCache() SIP_FORCE;
 
+    //! A cached project, with the pool of the copies not used by a request
+    struct ProjectEntry
+    {
+      std::shared_ptr<QgsProject> project;
+      std::shared_ptr<ProjectPool> pool;
+    };
+
+    /**
+     * Returns the cached entry of \a path, reading the project if needed.
+     * The project is read without locking the cache, the threads requesting
+     * the same project meanwhile wait for it. The cache mutex must not be locked.
+     */
+    ProjectEntry projectEntry( const QString &path );
+
+    /**
+     * Reads the project from \a path in the background and replaces the
+     * cached project once it is loaded with valid layers. The cached
+     * project is served until then.
+     */
+    void reloadProject( const QString &path );
+
+    //! Replaces the cached project of \a path with the reloaded \a project
+    void reloadFinished( const QString &path, QgsProject *project );
+
+    //! Watches \a path for changes, from the thread of the cache
+    void watchPath( const QString &path );
+
+    //! Stops watching \a path, from the thread of the cache
+    void unwatchPath( const QString &path );
+
     //! Check for configuration file updates (remove entry from cache if file changes)
     QFileSystemWatcher mFileSystemWatcher;
 
     //! Returns xml document for project file / sld or 0 in case of errors
     QDomDocument *xmlDocument( const QString &filePath );
 
+    //! Protects the caches, which are used by all the threads serving requests
+    QMutex mMutex;
+
     QCache<QString, QDomDocument> mXmlDocumentCache;
-    QCache<QString, QgsProject> mProjectCache;
+    QCache<QString, ProjectEntry> mProjectCache;
+
+    //! Paths of the projects being reloaded, with TRUE if they changed again since
+    QHash<QString, bool> mReloadingProjects;
+
+    //! Protects the paths of the projects read for a first request, not recursive to be waited for
+    QMutex mLoadingMutex;
+    QWaitCondition mLoadingCondition;
+    QSet<QString> mLoadingProjects;
 
   private slots:
     //! Removes changed entry from this cache
     void removeChangedEntry( const QString &path );
+
+    //! Reloads changed project in the background, or removes other changed entries
+    void reloadChangedEntry( const QString &path );
 };
 
 #endif // QGSCONFIGCACHE_H
@@ -24,16 +24,37 @@
 #include <fcgi_stdio.h>
 #include <QDebug>
 
+#include <algorithm>
+
 QgsFcgiServerRequest::QgsFcgiServerRequest()
 {
+  init();
+}
+
+QgsFcgiServerRequest::QgsFcgiServerRequest( FCGX_Request *request )
+  : mRequest( request )
+{
+  init();
+}
+
+const char *QgsFcgiServerRequest::param( const char *name ) const
+{
+  if ( mRequest )
+  {
+    return FCGX_GetParam( name, mRequest->envp );
+  }
+  return getenv( name );
+}
 
+void QgsFcgiServerRequest::init()
+{
   // Get the REQUEST_URI from the environment
   QUrl url;
-  QString uri = getenv( "REQUEST_URI" );
+  QString uri = param( "REQUEST_URI" );
 
   if ( uri.isEmpty() )
   {
-    uri = getenv( "SCRIPT_NAME" );
+    uri = param( "SCRIPT_NAME" );
   }
 
   url.setUrl( uri );
@@ -41,13 +62,13 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   // Check if host is defined
   if ( url.host().isEmpty() )
   {
-    url.setHost( getenv( "SERVER_NAME" ) );
+    url.setHost( param( "SERVER_NAME" ) );
   }
 
   // Port ?
   if ( url.port( -1 ) == -1 )
   {
-    QString portString = getenv( "SERVER_PORT" );
+    QString portString = param( "SERVER_PORT" );
     if ( !portString.isEmpty() )
     {
       bool portOk;
@@ -62,7 +83,7 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   // scheme
   if ( url.scheme().isEmpty() )
   {
-    QString( getenv( "HTTPS" ) ).compare( QLatin1String( "on" ), Qt::CaseInsensitive ) == 0
+    QString( param( "HTTPS" ) ).compare( QLatin1String( "on" ), Qt::CaseInsensitive ) == 0
     ? url.setScheme( QStringLiteral( "https" ) )
     : url.setScheme( QStringLiteral( "http" ) );
   }
@@ -73,7 +94,7 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   // OGC parameters are passed with the query string, which is normally part of
   // the REQUEST_URI, we override the query string url in case it is defined
   // independently of REQUEST_URI
-  const char *qs = getenv( "QUERY_STRING" );
+  const char *qs = param( "QUERY_STRING" );
   if ( qs )
   {
     url.setQuery( qs );
@@ -86,7 +107,7 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   QgsServerRequest::Method method = GetMethod;
 
   // Get method
-  const char *me = getenv( "REQUEST_METHOD" );
+  const char *me = param( "REQUEST_METHOD" );
 
   if ( me )
   {
@@ -118,12 +139,24 @@ QgsFcgiServerRequest::QgsFcgiServerRequest()
   setMethod( method );
 
   // Get accept header for content-type negotiation
-  const char *accept = getenv( "HTTP_ACCEPT" );
+  const char *accept = param( "HTTP_ACCEPT" );
   if ( accept )
   {
     setHeader( QStringLiteral( "Accept" ), accept );
   }
 
+  // Conditional request headers for cached responses
+  const char *ifNoneMatch = param( "HTTP_IF_NONE_MATCH" );
+  if ( ifNoneMatch )
+  {
+    setHeader( QStringLiteral( "If-None-Match" ), ifNoneMatch );
+  }
+  const char *ifModifiedSince = param( "HTTP_IF_MODIFIED_SINCE" );
+  if ( ifModifiedSince )
+  {
+    setHeader( QStringLiteral( "If-Modified-Since" ), ifModifiedSince );
+  }
+
   // Output debug infos
   Qgis::MessageLevel logLevel = QgsServerLogger::instance()->logLevel();
   if ( logLevel <= Qgis::Info )
@@ -141,7 +174,7 @@ QByteArray QgsFcgiServerRequest::data() const
 void QgsFcgiServerRequest::readData()
 {
   // Check if we have CONTENT_LENGTH defined
-  const char *lengthstr = getenv( "CONTENT_LENGTH" );
+  const char *lengthstr = param( "CONTENT_LENGTH" );
   if ( lengthstr )
   {
     bool success = false;
@@ -161,7 +194,17 @@ void QgsFcgiServerRequest::readData()
 #ifdef QGISDEBUG
     qDebug() << "fcgi: reading " << lengthstr << " bytes from " << ( request_body ? "REQUEST_BODY" : "stdin" );
 #endif
-    if ( success )
+    if ( success && mRequest )
+    {
+      if ( length > 0 )
+      {
+        const int offset = mData.size();
+        mData.resize( offset + length );
+        const int read = FCGX_GetStr( mData.data() + offset, length, mRequest->in );
+        mData.resize( offset + std::max( read, 0 ) );
+      }
+    }
+    else if ( success )
     {
       // XXX This not efficient at all  !!
       for ( int i = 0; i < length; ++i )
@@ -215,9 +258,10 @@ void QgsFcgiServerRequest::printRequestInfos( const QUrl &url )
 
   for ( const auto &envVar : envVars )
   {
-    if ( getenv( envVar.toStdString().c_str() ) )
+    const char *value = param( envVar.toStdString().c_str() );
+    if ( value )
     {
-      QgsMessageLog::logMessage( QStringLiteral( "%1: %2" ).arg( envVar ).arg( QString( getenv( envVar.toStdString().c_str() ) ) ), QStringLiteral( "Server" ), Qgis::Info );
+      QgsMessageLog::logMessage( QStringLiteral( "%1: %2" ).arg( envVar ).arg( QString( value ) ), QStringLiteral( "Server" ), Qgis::Info );
     }
   }
 }
@@ -22,6 +22,9 @@
 
 #include "qgsserverrequest.h"
 
+#ifndef SIP_RUN
+struct FCGX_Request;
+#endif
 
 /**
  * \ingroup server
@@ -34,6 +37,16 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
   public:
     QgsFcgiServerRequest();
 
+    /**
+     * Constructor for QgsFcgiServerRequest reading the parameters and the body
+     * of the request from \a request, as accepted with FCGX_Accept_r().
+     *
+     * This allows to serve several FastCGI requests concurrently from
+     * different threads, as the CGI environment of the process is left untouched.
+     * \since QGIS 3.10
+     */
+    QgsFcgiServerRequest( FCGX_Request *request ) SIP_SKIP;
+
     QByteArray data() const override;
 
     /**
@@ -42,8 +55,14 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
     bool hasError() const { return mHasError; }
 
   private:
+    void init();
+
     void readData();
 
+    // Returns the value of a CGI parameter, either from the
+    // FastCGI request or from the process environment
+    const char *param( const char *name ) const;
+
     // Log request info: print debug infos
     // about the request
     void printRequestInfos( const QUrl &url );
@@ -51,6 +70,7 @@ class SERVER_EXPORT QgsFcgiServerRequest: public QgsServerRequest
 
     QByteArray mData;
     bool       mHasError = false;
+    FCGX_Request *mRequest = nullptr;
 };
 
 #endif
@@ -27,6 +27,8 @@
 
 #include <QBuffer>
 
+struct FCGX_Request;
+
 /**
  * \ingroup server
  * \class QgsFcgiServerResponse
@@ -43,6 +45,15 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
      */
     QgsFcgiServerResponse( QgsServerRequest::Method method = QgsServerRequest::GetMethod );
 
+    /**
+     * Constructor for QgsFcgiServerResponse writing to the output stream
+     * of \a request, as accepted with FCGX_Accept_r().
+     * \param method The HTTP method
+     * \param request The FastCGI request to respond to
+     * \since QGIS 3.10
+     */
+    QgsFcgiServerResponse( QgsServerRequest::Method method, FCGX_Request *request );
+
     void setHeader( const QString &key, const QString &value ) override;
 
     void removeHeader( const QString &key ) override;
@@ -77,12 +88,15 @@ class SERVER_EXPORT QgsFcgiServerResponse: public QgsServerResponse
     void setDefaultHeaders();
 
   private:
+    void writeOutput( const char *data, int size );
+
     QMap<QString, QString> mHeaders;
     QBuffer mBuffer;
     bool mFinished    = false;
     bool mHeadersSent = false;
     QgsServerRequest::Method mMethod;
     int mStatusCode = 0;
+    FCGX_Request *mRequest = nullptr;
 };
 
 #endif
@@ -37,6 +37,7 @@
 #include "qgsserverapi.h"
 #include "qgsserverapicontext.h"
 #include "qgsserverparameters.h"
+#include "qgsserverresponsecache.h"
 #include "qgsapplication.h"
 
 #include <QDomDocument>
@@ -72,7 +73,6 @@ QgsServer::QgsServer()
     abort();
   }
   init();
-  mConfigCache = QgsConfigCache::instance();
 }
 
 QString &QgsServer::serverName()
@@ -280,6 +280,9 @@ bool QgsServer::init()
   qDebug() << "Initializing server modules from " << modulePath << endl;
   sServiceRegistry->init( modulePath,  sServerInterface );
 
+  // Read the projects in advance so that the first requests do not wait for them
+  QgsConfigCache::instance()->prewarm( sSettings.projectPrewarm() );
+
   sInitialized = true;
   QgsMessageLog::logMessage( QStringLiteral( "Server initialized" ), QStringLiteral( "Server" ), Qgis::Info );
   return true;
@@ -302,7 +305,10 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
   Qgis::MessageLevel logLevel = QgsServerLogger::instance()->logLevel();
   QTime time; //used for measuring request time if loglevel < 1
 
-  qApp->processEvents();
+  // Process pending events (i.e. config cache invalidations) when requests
+  // are served from the main thread, otherwise the main thread event loop
+  // processes them
+  QCoreApplication::processEvents();
 
   if ( logLevel == Qgis::Info )
   {
@@ -316,6 +322,9 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
   //Request handler
   QgsRequestHandler requestHandler( request, response );
 
+  // Exclusive use of the cached project until the response is complete
+  std::unique_ptr<QgsConfigCache::ProjectLock> projectLock;
+
   try
   {
     // TODO: split parse input into plain parse and processing from specific services
@@ -371,7 +380,9 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
         QString configFilePath = configPath( *sConfigFilePath, params.map() );
 
         // load the project if needed and not empty
-        project = mConfigCache->project( configFilePath );
+        // the project is not used by the other requests until it is released
+        projectLock = QgsConfigCache::instance()->lockProject( configFilePath );
+        project = projectLock ? projectLock->project() : nullptr;
       }
 
       if ( project )
@@ -385,7 +396,23 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
       if ( params.service().isEmpty() && ( api = sServiceRegistry->apiForRequest( request ) ) )
       {
         QgsServerApiContext context { api->rootPath(), &request, &responseDecorator, project, sServerInterface };
-        api->executeRequest( context );
+        // Built-in response cache, for the tiles only
+        QgsServerResponseCache *responseCache = QgsServerResponseCache::isApiCacheable( request, project ) ? QgsServerResponseCache::instance( sSettings ) : nullptr;
+        QStringList accessControlKey;
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+        if ( responseCache && sServerInterface->accessControls() && !sServerInterface->accessControls()->fillCacheKey( accessControlKey ) )
+        {
+          responseCache = nullptr;
+        }
+#endif
+        if ( responseCache )
+        {
+          responseCache->executeApiRequest( api, context, accessControlKey );
+        }
+        else
+        {
+          api->executeRequest( context );
+        }
       }
       else
       {
@@ -406,7 +433,24 @@ void QgsServer::handleRequest( QgsServerRequest &request, QgsServerResponse &res
         QgsService *service = sServiceRegistry->getService( params.service(), params.version() );
         if ( service )
         {
-          service->executeRequest( request, responseDecorator, project );
+          // Built-in response cache, only when the access control rules
+          // allow caching
+          QgsServerResponseCache *responseCache = QgsServerResponseCache::isCacheable( request, params ) ? QgsServerResponseCache::instance( sSettings ) : nullptr;
+          QStringList accessControlKey;
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+          if ( responseCache && sServerInterface->accessControls() && !sServerInterface->accessControls()->fillCacheKey( accessControlKey ) )
+          {
+            responseCache = nullptr;
+          }
+#endif
+          if ( responseCache )
+          {
+            responseCache->executeRequest( service, request, responseDecorator, project, accessControlKey );
+          }
+          else
+          {
+            service->executeRequest( request, responseDecorator, project );
+          }
         }
         else
         {
@@ -142,9 +142,6 @@ class SERVER_EXPORT QgsServer
 
     static QgsServerSettings sSettings;
 
-    //! cache
-    QgsConfigCache *mConfigCache = nullptr;
-
     //! Initialize locale
     static void initLocale();
 };
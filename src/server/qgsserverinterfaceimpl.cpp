@@ -20,13 +20,16 @@
 #include "qgsserverinterfaceimpl.h"
 #include "qgsconfigcache.h"
 
+#include <QCoreApplication>
+#include <QThread>
+#include <QTimer>
+
 //! Constructor
 QgsServerInterfaceImpl::QgsServerInterfaceImpl( QgsCapabilitiesCache *capCache, QgsServiceRegistry *srvRegistry, QgsServerSettings *settings )
   : mCapabilitiesCache( capCache )
   , mServiceRegistry( srvRegistry )
   , mServerSettings( settings )
 {
-  mRequestHandler = nullptr;
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   mAccessControls = new QgsAccessControl();
   mCacheManager = new QgsServerCacheManager();
@@ -50,17 +53,41 @@ QgsServerInterfaceImpl::~QgsServerInterfaceImpl()
 
 void QgsServerInterfaceImpl::clearRequestHandler()
 {
-  mRequestHandler = nullptr;
+  mRequestState.localData().requestHandler = nullptr;
 }
 
 void QgsServerInterfaceImpl::setRequestHandler( QgsRequestHandler *requestHandler )
 {
-  mRequestHandler = requestHandler;
+  mRequestState.localData().requestHandler = requestHandler;
+}
+
+QgsCapabilitiesCache *QgsServerInterfaceImpl::capabilitiesCache()
+{
+  if ( !QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread() )
+  {
+    return mCapabilitiesCache;
+  }
+
+  // Capabilities documents are handed out by pointer, give each worker
+  // thread its own cache, deleted when the thread finishes
+  if ( !mThreadCapabilitiesCaches.hasLocalData() )
+  {
+    QgsCapabilitiesCache *cache = new QgsCapabilitiesCache();
+    QObject::connect( cache, &QObject::destroyed, [this, cache]
+    {
+      QMutexLocker locker( &mThreadCapabilitiesCachesMutex );
+      mThreadCapabilitiesCacheList.removeAll( cache );
+    } );
+    QMutexLocker locker( &mThreadCapabilitiesCachesMutex );
+    mThreadCapabilitiesCacheList.append( cache );
+    mThreadCapabilitiesCaches.setLocalData( cache );
+  }
+  return mThreadCapabilitiesCaches.localData();
 }
 
 void QgsServerInterfaceImpl::setConfigFilePath( const QString &configFilePath )
 {
-  mConfigFilePath = configFilePath;
+  mRequestState.localData().configFilePath = configFilePath;
 }
 
 void QgsServerInterfaceImpl::registerFilter( QgsServerFilter *filter, int priority )
@@ -104,8 +131,33 @@ void QgsServerInterfaceImpl::removeConfigCacheEntry( const QString &path )
 {
   if ( mCapabilitiesCache )
   {
-    mCapabilitiesCache->removeCapabilitiesDocument( path );
+    if ( QThread::currentThread() == mCapabilitiesCache->thread() )
+    {
+      mCapabilitiesCache->removeCapabilitiesDocument( path );
+    }
+    else
+    {
+      QgsCapabilitiesCache *cache = mCapabilitiesCache;
+      QTimer::singleShot( 0, cache, [cache, path] { cache->removeCapabilitiesDocument( path ); } );
+    }
+  }
+
+  {
+    // Caches of the worker threads are updated from their own event loop
+    QMutexLocker locker( &mThreadCapabilitiesCachesMutex );
+    for ( QgsCapabilitiesCache *cache : qgis::as_const( mThreadCapabilitiesCacheList ) )
+    {
+      if ( QThread::currentThread() == cache->thread() )
+      {
+        cache->removeCapabilitiesDocument( path );
+      }
+      else
+      {
+        QTimer::singleShot( 0, cache, [cache, path] { cache->removeCapabilitiesDocument( path ); } );
+      }
+    }
   }
+
   QgsConfigCache::instance()->removeEntry( path );
 }
 
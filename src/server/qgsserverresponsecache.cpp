@@ -0,0 +1,414 @@
+/***************************************************************************
+                              qgsserverresponsecache.cpp
+                            -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsserverresponsecache.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsmessagelog.h"
+#include "qgsproject.h"
+#include "qgsserverapi.h"
+#include "qgsserverapicontext.h"
+#include "qgsserverparameters.h"
+#include "qgsserverrequest.h"
+#include "qgsserverresponse.h"
+#include "qgsserversettings.h"
+#include "qgsservice.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+
+///@cond PRIVATE
+namespace
+{
+  // Version of the cached response files
+  const quint32 FILE_MAGIC = 0x51525331;
+
+  // Dynamic property of the projects holding their version
+  const char *PROJECT_VERSION_PROPERTY = "_qgis_server_version";
+
+  // Share of the disk cache size kept when it is pruned
+  const double PRUNE_RATIO = 0.8;
+
+  QString httpDate( const QDateTime &dateTime )
+  {
+    return QLocale::c().toString( dateTime.toUTC(), QStringLiteral( "ddd, dd MMM yyyy hh:mm:ss 'GMT'" ) );
+  }
+
+  QDateTime fromHttpDate( const QString &value )
+  {
+    QDateTime dateTime = QLocale::c().toDateTime( value.trimmed(), QStringLiteral( "ddd, dd MMM yyyy hh:mm:ss 'GMT'" ) );
+    dateTime.setTimeSpec( Qt::UTC );
+    return dateTime;
+  }
+}
+///@endcond
+
+QgsServerResponseCache::QgsServerResponseCache( const QString &directory, qint64 memorySize, qint64 diskSize, int maxAge )
+  : mDirectory( directory )
+  , mDiskSize( diskSize )
+  , mMaxAge( maxAge )
+{
+  // QCache costs are int, count kilobytes
+  mMemoryCache.setMaxCost( static_cast<int>( std::min<qint64>( memorySize / 1024, std::numeric_limits<int>::max() ) ) );
+}
+
+QgsServerResponseCache *QgsServerResponseCache::instance( const QgsServerSettings &settings )
+{
+  const QString directory = settings.responseCacheDirectory();
+  const qint64 memorySize = settings.responseCacheSize();
+  const qint64 diskSize = settings.responseCacheDiskSize();
+  if ( directory.isEmpty() && memorySize <= 0 )
+    return nullptr;
+  const int maxAge = std::max( 0, settings.responseCacheMaxAge() );
+
+  // One cache per configuration, settings may be reloaded at runtime
+  static QMutex sMutex;
+  static std::map< QString, std::unique_ptr< QgsServerResponseCache > > sCaches;
+
+  const QString configuration = QStringLiteral( "%1|%2|%3|%4" ).arg( directory ).arg( memorySize ).arg( diskSize ).arg( maxAge );
+  QMutexLocker locker( &sMutex );
+  std::unique_ptr< QgsServerResponseCache > &cache = sCaches[ configuration ];
+  if ( !cache )
+    cache.reset( new QgsServerResponseCache( directory, memorySize, diskSize, maxAge ) );
+  return cache.get();
+}
+
+bool QgsServerResponseCache::isCacheable( const QgsServerRequest &request, const QgsServerParameters &params )
+{
+  if ( request.method() != QgsServerRequest::GetMethod )
+    return false;
+
+  // Feature requests are streamed and may return any amount of data,
+  // prints and exports are not requested repeatedly
+  static const QSet<QString> sRequests
+  {
+    QStringLiteral( "WMS:GETCAPABILITIES" ),
+    QStringLiteral( "WMS:GETMAP" ),
+    QStringLiteral( "WMS:GETLEGENDGRAPHIC" ),
+    QStringLiteral( "WMS:GETLEGENDGRAPHICS" ),
+    QStringLiteral( "WMTS:GETCAPABILITIES" ),
+    QStringLiteral( "WMTS:GETTILE" ),
+    QStringLiteral( "WFS:GETCAPABILITIES" ),
+    QStringLiteral( "WFS:DESCRIBEFEATURETYPE" )
+  };
+  return sRequests.contains( QStringLiteral( "%1:%2" ).arg( params.service().toUpper(), params.request().toUpper() ) );
+}
+
+void QgsServerResponseCache::setProjectVersion( QgsProject *project, const QString &path )
+{
+  const QFileInfo fileInfo( path );
+  if ( fileInfo.exists() )
+  {
+    project->setProperty( PROJECT_VERSION_PROPERTY, fileInfo.lastModified() );
+  }
+}
+
+QDateTime QgsServerResponseCache::projectVersion( const QgsProject *project )
+{
+  // The file is only checked for projects which were not read by the server
+  const QDateTime version = project->property( PROJECT_VERSION_PROPERTY ).toDateTime();
+  return version.isValid() ? version : project->lastModified();
+}
+
+QString QgsServerResponseCache::cacheKey( const QgsServerRequest &request, const QgsProject *project, const QStringList &accessControlKey )
+{
+  QStringList key;
+  key << request.url().adjusted( QUrl::RemoveQuery | QUrl::RemoveFragment ).toString()
+      << project->fileName()
+      << projectVersion( project ).toString( Qt::ISODateWithMs )
+      << accessControlKey.join( '-' );
+
+  // Parameters are sorted by name
+  const QgsServerRequest::Parameters parameters = request.parameters();
+  for ( auto it = parameters.constBegin(); it != parameters.constEnd(); ++it )
+  {
+    key << QStringLiteral( "%1=%2" ).arg( it.key(), it.value() );
+  }
+
+  return QCryptographicHash::hash( key.join( '\n' ).toUtf8(), QCryptographicHash::Sha1 ).toHex();
+}
+
+bool QgsServerResponseCache::isApiCacheable( const QgsServerRequest &request, const QgsProject *project )
+{
+  // Tiles are requested repeatedly and have a bounded size
+  static const QRegularExpression sTilesRx( QStringLiteral( "/collections/[^/]+/tiles/" ) );
+  return project && request.method() == QgsServerRequest::GetMethod && sTilesRx.match( request.url().path() ).hasMatch();
+}
+
+void QgsServerResponseCache::executeRequest( QgsService *service, const QgsServerRequest &request, QgsServerResponse &response,
+    const QgsProject *project, const QStringList &accessControlKey )
+{
+  execute( [service, &request, project]( QgsServerResponse & bufferResponse )
+  {
+    service->executeRequest( request, bufferResponse, project );
+  }, request, response, project, accessControlKey );
+}
+
+void QgsServerResponseCache::executeApiRequest( QgsServerApi *api, const QgsServerApiContext &context, const QStringList &accessControlKey )
+{
+  execute( [api, &context]( QgsServerResponse & bufferResponse )
+  {
+    QgsServerApiContext bufferContext( context.apiRootPath(), context.request(), &bufferResponse, context.project(), context.serverInterface() );
+    api->executeRequest( bufferContext );
+  }, *context.request(), *context.response(), context.project(), accessControlKey );
+}
+
+void QgsServerResponseCache::execute( const std::function<void( QgsServerResponse & )> &function, const QgsServerRequest &request,
+                                      QgsServerResponse &response, const QgsProject *project, const QStringList &accessControlKey )
+{
+  const QString key = cacheKey( request, project, accessControlKey );
+
+  Entry cached;
+  if ( !entry( key, cached ) )
+  {
+    QgsBufferServerResponse bufferResponse;
+    function( bufferResponse );
+
+    const QByteArray content = bufferResponse.body() + bufferResponse.data();
+    if ( bufferResponse.statusCode() != 200 || content.isEmpty() )
+    {
+      // Not cached, forwarded as is
+      const QMap<QString, QString> headers = bufferResponse.headers();
+      for ( auto it = headers.constBegin(); it != headers.constEnd(); ++it )
+      {
+        response.setHeader( it.key(), it.value() );
+      }
+      response.setStatusCode( bufferResponse.statusCode() );
+      response.write( content );
+      return;
+    }
+
+    cached.headers = bufferResponse.headers();
+    cached.content = content;
+    cached.etag = QStringLiteral( "\"%1\"" ).arg( QString( QCryptographicHash::hash( content, QCryptographicHash::Sha1 ).toHex() ) );
+    cached.lastModified = project->property( PROJECT_VERSION_PROPERTY ).toDateTime();
+    if ( !cached.lastModified.isValid() )
+      cached.lastModified = QDateTime::currentDateTimeUtc();
+    cached.created = QDateTime::currentDateTime();
+    setEntry( key, cached );
+  }
+
+  for ( auto it = cached.headers.constBegin(); it != cached.headers.constEnd(); ++it )
+  {
+    response.setHeader( it.key(), it.value() );
+  }
+  response.setHeader( QStringLiteral( "ETag" ), cached.etag );
+  response.setHeader( QStringLiteral( "Last-Modified" ), httpDate( cached.lastModified ) );
+
+  // Conditional requests, If-None-Match takes precedence over If-Modified-Since
+  bool notModified = false;
+  const QString ifNoneMatch = request.header( QStringLiteral( "If-None-Match" ) );
+  if ( !ifNoneMatch.isEmpty() )
+  {
+    const QStringList etags = ifNoneMatch.split( ',' );
+    for ( const QString &etag : etags )
+    {
+      const QString tag = etag.trimmed();
+      if ( tag == QLatin1String( "*" ) || tag == cached.etag || tag == QStringLiteral( "W/" ) + cached.etag )
+      {
+        notModified = true;
+        break;
+      }
+    }
+  }
+  else
+  {
+    const QDateTime ifModifiedSince = fromHttpDate( request.header( QStringLiteral( "If-Modified-Since" ) ) );
+    notModified = ifModifiedSince.isValid() && cached.lastModified.toSecsSinceEpoch() <= ifModifiedSince.toSecsSinceEpoch();
+  }
+
+  if ( notModified )
+  {
+    response.setStatusCode( 304 );
+  }
+  else
+  {
+    response.write( cached.content );
+  }
+}
+
+bool QgsServerResponseCache::entry( const QString &key, Entry &entry )
+{
+  {
+    QMutexLocker locker( &mMutex );
+    if ( Entry *cached = mMemoryCache.object( key ) )
+    {
+      if ( !isExpired( cached->created ) )
+      {
+        entry = *cached;
+        return true;
+      }
+      mMemoryCache.remove( key );
+    }
+  }
+
+  if ( mDirectory.isEmpty() )
+    return false;
+
+  const QString path = filePath( key );
+  const QDateTime created = QFileInfo( path ).lastModified();
+  if ( !created.isValid() )
+    return false;
+  if ( isExpired( created ) )
+  {
+    // Another process may remove it at the same time
+    QFile::remove( path );
+    return false;
+  }
+
+  QFile file( path );
+  if ( !file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_9 );
+  quint32 magic = 0;
+  stream >> magic;
+  if ( magic != FILE_MAGIC )
+    return false;
+
+  stream >> entry.headers >> entry.etag >> entry.lastModified >> entry.content;
+  if ( stream.status() != QDataStream::Ok )
+    return false;
+  entry.created = created;
+
+  if ( mMemoryCache.maxCost() > 0 )
+  {
+    QMutexLocker locker( &mMutex );
+    mMemoryCache.insert( key, new Entry( entry ), entry.content.size() / 1024 + 1 );
+  }
+  return true;
+}
+
+void QgsServerResponseCache::setEntry( const QString &key, const Entry &entry )
+{
+  if ( mMemoryCache.maxCost() > 0 )
+  {
+    QMutexLocker locker( &mMutex );
+    mMemoryCache.insert( key, new Entry( entry ), entry.content.size() / 1024 + 1 );
+  }
+
+  if ( mDirectory.isEmpty() )
+    return;
+
+  // Several processes may write the same response, QSaveFile replaces
+  // the file atomically so that readers never get a partial response
+  const QString path = filePath( key );
+  if ( !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot create response cache directory for %1" ).arg( path ), QStringLiteral( "Server" ), Qgis::Warning );
+    return;
+  }
+
+  QSaveFile file( path );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot write cached response %1" ).arg( path ), QStringLiteral( "Server" ), Qgis::Warning );
+    return;
+  }
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_9 );
+  stream << FILE_MAGIC << entry.headers << entry.etag << entry.lastModified << entry.content;
+  if ( stream.status() != QDataStream::Ok || !file.commit() )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot write cached response %1" ).arg( path ), QStringLiteral( "Server" ), Qgis::Warning );
+    return;
+  }
+
+  if ( mDiskSize <= 0 && mMaxAge <= 0 )
+    return;
+
+  // A single thread prunes the directory at a time, the others keep serving responses
+  {
+    QMutexLocker locker( &mMutex );
+    if ( mDiskUsage >= 0 )
+      mDiskUsage += QFileInfo( path ).size();
+    const bool oversized = mDiskSize > 0 && ( mDiskUsage < 0 || mDiskUsage > mDiskSize );
+    const bool outdated = mMaxAge > 0 && ( !mLastPrune.isValid() || mLastPrune.secsTo( QDateTime::currentDateTime() ) > mMaxAge );
+    if ( mPruning || ( !oversized && !outdated ) )
+      return;
+    mPruning = true;
+  }
+
+  const qint64 usage = pruneDirectory();
+
+  QMutexLocker locker( &mMutex );
+  mDiskUsage = usage;
+  mLastPrune = QDateTime::currentDateTime();
+  mPruning = false;
+}
+
+QString QgsServerResponseCache::filePath( const QString &key ) const
+{
+  // Spread the responses in sub-directories to keep them small
+  return QStringLiteral( "%1/%2/%3.response" ).arg( mDirectory, key.left( 2 ), key.mid( 2 ) );
+}
+
+bool QgsServerResponseCache::isExpired( const QDateTime &created ) const
+{
+  return mMaxAge > 0 && created.secsTo( QDateTime::currentDateTime() ) > mMaxAge;
+}
+
+qint64 QgsServerResponseCache::pruneDirectory() const
+{
+  // The directory may be shared with other processes, its content is listed
+  // again instead of relying on what this process wrote
+  QList<QFileInfo> files;
+  qint64 usage = 0;
+  QDirIterator it( mDirectory, QStringList() << QStringLiteral( "*.response" ), QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() )
+  {
+    it.next();
+    const QFileInfo fileInfo = it.fileInfo();
+    if ( isExpired( fileInfo.lastModified() ) )
+    {
+      QFile::remove( fileInfo.absoluteFilePath() );
+      continue;
+    }
+    files << fileInfo;
+    usage += fileInfo.size();
+  }
+
+  if ( mDiskSize > 0 && usage > mDiskSize )
+  {
+    // Oldest responses first
+    std::sort( files.begin(), files.end(), []( const QFileInfo & f1, const QFileInfo & f2 )
+    {
+      return f1.lastModified() < f2.lastModified();
+    } );
+
+    const qint64 target = static_cast<qint64>( mDiskSize * PRUNE_RATIO );
+    for ( const QFileInfo &fileInfo : qgis::as_const( files ) )
+    {
+      if ( usage <= target )
+        break;
+      if ( QFile::remove( fileInfo.absoluteFilePath() ) )
+        usage -= fileInfo.size();
+    }
+  }
+  return usage;
+}
@@ -0,0 +1,168 @@
+/***************************************************************************
+                              qgsserverresponsecache.h
+                            -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSSERVERRESPONSECACHE_H
+#define QGSSERVERRESPONSECACHE_H
+
+#define SIP_NO_FILE
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+class QgsProject;
+class QgsServerApi;
+class QgsServerApiContext;
+class QgsServerParameters;
+class QgsServerRequest;
+class QgsServerResponse;
+class QgsServerSettings;
+class QgsService;
+
+/**
+ * \ingroup server
+ * \class QgsServerResponseCache
+ * \brief Built-in cache of the responses of the OWS services.
+ *
+ * Responses are kept in memory by each server process and can also be stored
+ * in a directory shared by all the server processes. The cached responses
+ * are sent with an ETag and a Last-Modified header, and conditional requests
+ * are answered with a 304 status when the client copy is up to date.
+ *
+ * Responses are identified by the request parameters, the service URL, the
+ * project file and its modification time when it was read, and the access
+ * control cache key. The responses of a reloaded project are thus never
+ * served, they are removed from the cache when it is full. Responses older
+ * than the maximum age are executed again, as they may depend on data which
+ * changed since. The cache is thread safe.
+ * \since QGIS 3.10
+ */
+class QgsServerResponseCache
+{
+  public:
+
+    /**
+     * Constructor for QgsServerResponseCache.
+     * \param directory the directory of the disk cache, empty to disable it
+     * \param memorySize the size in bytes of the in-memory cache, 0 to disable it
+     * \param diskSize the maximum size in bytes of the disk cache, 0 for no limit
+     * \param maxAge the maximum age in seconds of the cached responses, 0 for no limit
+     */
+    QgsServerResponseCache( const QString &directory, qint64 memorySize, qint64 diskSize, int maxAge = 0 );
+
+    /**
+     * Returns the cache configured by the server \a settings, or NULLPTR
+     * if the response cache is disabled.
+     */
+    static QgsServerResponseCache *instance( const QgsServerSettings &settings );
+
+    /**
+     * Returns TRUE if the response of \a request can be cached. Only GET
+     * requests whose response depends on the project and the request
+     * parameters only are cached.
+     */
+    static bool isCacheable( const QgsServerRequest &request, const QgsServerParameters &params );
+
+    /**
+     * Records the modification time of the file of \a project, to be called
+     * before the project is read. Cached responses are identified by this
+     * time, so that the responses of a project are no longer used once the
+     * project is reloaded from a modified file.
+     */
+    static void setProjectVersion( QgsProject *project, const QString &path );
+
+    /**
+     * Returns the modification time of the file of \a project recorded when
+     * it was read, or the modification time of the file if none was recorded.
+     * \see setProjectVersion()
+     */
+    static QDateTime projectVersion( const QgsProject *project );
+
+    /**
+     * Writes the response of \a request to \a response, from the cache if
+     * available or executed by \a service and stored in the cache otherwise.
+     * \param service the service executing the request
+     * \param request the request
+     * \param response the response
+     * \param project the project of the request
+     * \param accessControlKey the cache key of the access control rules
+     */
+    void executeRequest( QgsService *service, const QgsServerRequest &request, QgsServerResponse &response,
+                         const QgsProject *project, const QStringList &accessControlKey );
+
+    /**
+     * Returns TRUE if the response of the API \a request can be cached. Only
+     * GET requests of tiles, whose response depends on the project and the
+     * request URL only, are cached.
+     */
+    static bool isApiCacheable( const QgsServerRequest &request, const QgsProject *project );
+
+    /**
+     * Writes the response of the API request of \a context to the response
+     * of \a context, from the cache if available or executed by \a api and
+     * stored in the cache otherwise.
+     * \param api the API executing the request
+     * \param context the context of the request
+     * \param accessControlKey the cache key of the access control rules
+     */
+    void executeApiRequest( QgsServerApi *api, const QgsServerApiContext &context, const QStringList &accessControlKey );
+
+  private:
+    //! A cached response
+    struct Entry
+    {
+      QMap<QString, QString> headers;
+      QByteArray content;
+      QString etag;
+      QDateTime lastModified;
+      QDateTime created;
+    };
+
+    void execute( const std::function<void( QgsServerResponse & )> &function, const QgsServerRequest &request,
+                  QgsServerResponse &response, const QgsProject *project, const QStringList &accessControlKey );
+    static QString cacheKey( const QgsServerRequest &request, const QgsProject *project, const QStringList &accessControlKey );
+    bool entry( const QString &key, Entry &entry );
+    void setEntry( const QString &key, const Entry &entry );
+    QString filePath( const QString &key ) const;
+
+    //! Returns TRUE if a response cached at \a created is too old to be served
+    bool isExpired( const QDateTime &created ) const;
+
+    /**
+     * Removes the expired responses from the directory, then the oldest ones until
+     * its size is below the maximum size. The directory is scanned without holding
+     * the cache lock.
+     * \returns the size of the directory
+     */
+    qint64 pruneDirectory() const;
+
+    QMutex mMutex;
+    QCache<QString, Entry> mMemoryCache;
+    QString mDirectory;
+    qint64 mDiskSize = 0;
+    int mMaxAge = 0;
+    //! Size of the directory, -1 if unknown
+    qint64 mDiskUsage = -1;
+    QDateTime mLastPrune;
+    bool mPruning = false;
+};
+
+#endif // QGSSERVERRESPONSECACHE_H
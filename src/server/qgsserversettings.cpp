@@ -208,6 +208,150 @@ void QgsServerSettings::initSettings()
                                    };
 
   mSettings[ sApiWfs3MaxLimit.envVar ] = sApiWfs3MaxLimit;
+
+  // FastCGI threads
+  const Setting sFcgiThreads = { QgsServerSettingsEnv::QGIS_SERVER_FCGI_THREADS,
+                                 QgsServerSettingsEnv::DEFAULT_VALUE,
+                                 QStringLiteral( "Number of FastCGI requests served concurrently by a server process" ),
+                                 QStringLiteral( "/qgis/server_fcgi_threads" ),
+                                 QVariant::Int,
+                                 QVariant( 1 ),
+                                 QVariant()
+                               };
+
+  mSettings[ sFcgiThreads.envVar ] = sFcgiThreads;
+
+  // Number of tiles along each side of a WMTS metatile
+  const Setting sWmtsMetatileSize = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_SIZE,
+                                      QgsServerSettingsEnv::DEFAULT_VALUE,
+                                      QStringLiteral( "Number of tiles along each side of a WMTS metatile" ),
+                                      QStringLiteral( "/qgis/server_wmts_metatile_size" ),
+                                      QVariant::Int,
+                                      QVariant( 1 ),
+                                      QVariant()
+                                    };
+
+  mSettings[ sWmtsMetatileSize.envVar ] = sWmtsMetatileSize;
+
+  // Buffer in pixels around a WMTS metatile
+  const Setting sWmtsMetatileBuffer = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_BUFFER,
+                                        QgsServerSettingsEnv::DEFAULT_VALUE,
+                                        QStringLiteral( "Buffer in pixels around a WMTS metatile" ),
+                                        QStringLiteral( "/qgis/server_wmts_metatile_buffer" ),
+                                        QVariant::Int,
+                                        QVariant( 64 ),
+                                        QVariant()
+                                      };
+
+  mSettings[ sWmtsMetatileBuffer.envVar ] = sWmtsMetatileBuffer;
+
+  // Directory of the WMTS tile cache
+  const Setting sWmtsCacheDirectory = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_DIRECTORY,
+                                        QgsServerSettingsEnv::DEFAULT_VALUE,
+                                        QStringLiteral( "Directory of the WMTS tile cache" ),
+                                        QStringLiteral( "/qgis/server_wmts_cache_directory" ),
+                                        QVariant::String,
+                                        QVariant( "" ),
+                                        QVariant()
+                                      };
+
+  mSettings[ sWmtsCacheDirectory.envVar ] = sWmtsCacheDirectory;
+
+  // Size in bytes of the WMTS in-memory tile cache
+  const Setting sWmtsCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_SIZE,
+                                   QgsServerSettingsEnv::DEFAULT_VALUE,
+                                   QStringLiteral( "Size in bytes of the WMTS in-memory tile cache" ),
+                                   QStringLiteral( "/qgis/server_wmts_cache_size" ),
+                                   QVariant::LongLong,
+                                   QVariant( 0 ),
+                                   QVariant()
+                                 };
+
+  mSettings[ sWmtsCacheSize.envVar ] = sWmtsCacheSize;
+
+  // Projects loaded at startup
+  const Setting sProjectPrewarm = { QgsServerSettingsEnv::QGIS_SERVER_PROJECT_PREWARM,
+                                    QgsServerSettingsEnv::DEFAULT_VALUE,
+                                    QStringLiteral( "Projects loaded at startup" ),
+                                    QStringLiteral( "/qgis/server_project_prewarm" ),
+                                    QVariant::String,
+                                    QVariant( "" ),
+                                    QVariant()
+                                  };
+
+  mSettings[ sProjectPrewarm.envVar ] = sProjectPrewarm;
+
+  // Size in bytes of the in-memory response cache
+  const Setting sResponseCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_SIZE,
+                                       QgsServerSettingsEnv::DEFAULT_VALUE,
+                                       QStringLiteral( "Size in bytes of the in-memory response cache" ),
+                                       QStringLiteral( "/qgis/server_response_cache_size" ),
+                                       QVariant::LongLong,
+                                       QVariant( 0 ),
+                                       QVariant()
+                                     };
+
+  mSettings[ sResponseCacheSize.envVar ] = sResponseCacheSize;
+
+  // Directory of the response cache
+  const Setting sResponseCacheDirectory = { QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_DIRECTORY,
+                                            QgsServerSettingsEnv::DEFAULT_VALUE,
+                                            QStringLiteral( "Directory of the response cache" ),
+                                            QStringLiteral( "/qgis/server_response_cache_directory" ),
+                                            QVariant::String,
+                                            QVariant( "" ),
+                                            QVariant()
+                                          };
+
+  mSettings[ sResponseCacheDirectory.envVar ] = sResponseCacheDirectory;
+
+  // Maximum size in bytes of the response cache directory
+  const Setting sResponseCacheDiskSize = { QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_DISK_SIZE,
+                                           QgsServerSettingsEnv::DEFAULT_VALUE,
+                                           QStringLiteral( "Maximum size in bytes of the response cache directory" ),
+                                           QStringLiteral( "/qgis/server_response_cache_disk_size" ),
+                                           QVariant::LongLong,
+                                           QVariant( 50 * 1024 * 1024 ),
+                                           QVariant()
+                                         };
+
+  mSettings[ sResponseCacheDiskSize.envVar ] = sResponseCacheDiskSize;
+
+  // Maximum size in bytes of the WMTS tile cache directory
+  const Setting sWmtsCacheDiskSize = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_DISK_SIZE,
+                                       QgsServerSettingsEnv::DEFAULT_VALUE,
+                                       QStringLiteral( "Maximum size in bytes of the WMTS tile cache directory" ),
+                                       QStringLiteral( "/qgis/server_wmts_cache_disk_size" ),
+                                       QVariant::LongLong,
+                                       QVariant( 500 * 1024 * 1024 ),
+                                       QVariant()
+                                     };
+
+  mSettings[ sWmtsCacheDiskSize.envVar ] = sWmtsCacheDiskSize;
+
+  // Maximum age in seconds of the cached WMTS tiles
+  const Setting sWmtsCacheMaxAge = { QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_MAX_AGE,
+                                     QgsServerSettingsEnv::DEFAULT_VALUE,
+                                     QStringLiteral( "Maximum age in seconds of the cached WMTS tiles" ),
+                                     QStringLiteral( "/qgis/server_wmts_cache_max_age" ),
+                                     QVariant::Int,
+                                     QVariant( 0 ),
+                                     QVariant()
+                                   };
+
+  mSettings[ sWmtsCacheMaxAge.envVar ] = sWmtsCacheMaxAge;
+
+  // Maximum age in seconds of the cached responses
+  const Setting sResponseCacheMaxAge = { QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_MAX_AGE,
+                                         QgsServerSettingsEnv::DEFAULT_VALUE,
+                                         QStringLiteral( "Maximum age in seconds of the cached responses" ),
+                                         QStringLiteral( "/qgis/server_response_cache_max_age" ),
+                                         QVariant::Int,
+                                         QVariant( 3600 ),
+                                         QVariant()
+                                       };
+
+  mSettings[ sResponseCacheMaxAge.envVar ] = sResponseCacheMaxAge;
 }
 
 void QgsServerSettings::load()
@@ -418,3 +562,63 @@ qlonglong QgsServerSettings::apiWfs3MaxLimit() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_API_WFS3_MAX_LIMIT ).toLongLong();
 }
+
+int QgsServerSettings::fcgiThreads() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_FCGI_THREADS ).toInt();
+}
+
+int QgsServerSettings::wmtsMetatileSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_SIZE ).toInt();
+}
+
+int QgsServerSettings::wmtsMetatileBuffer() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_METATILE_BUFFER ).toInt();
+}
+
+QString QgsServerSettings::wmtsCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_DIRECTORY ).toString();
+}
+
+qint64 QgsServerSettings::wmtsCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_SIZE ).toLongLong();
+}
+
+QStringList QgsServerSettings::projectPrewarm() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_PROJECT_PREWARM ).toString().split( QDir::listSeparator(), QString::SkipEmptyParts );
+}
+
+qint64 QgsServerSettings::responseCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_SIZE ).toLongLong();
+}
+
+QString QgsServerSettings::responseCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_DIRECTORY ).toString();
+}
+
+qint64 QgsServerSettings::responseCacheDiskSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_DISK_SIZE ).toLongLong();
+}
+
+qint64 QgsServerSettings::wmtsCacheDiskSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_DISK_SIZE ).toLongLong();
+}
+
+int QgsServerSettings::wmtsCacheMaxAge() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_WMTS_CACHE_MAX_AGE ).toInt();
+}
+
+int QgsServerSettings::responseCacheMaxAge() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_RESPONSE_CACHE_MAX_AGE ).toInt();
+}
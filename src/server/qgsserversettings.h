@@ -66,7 +66,19 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_SERVER_WMS_MAX_HEIGHT, //! Maximum height for a WMS request. The most conservative between this and the project one is used (since QGIS 3.8)
       QGIS_SERVER_WMS_MAX_WIDTH, //! Maximum width for a WMS request. The most conservative between this and the project one is used (since QGIS 3.8)
       QGIS_SERVER_API_RESOURCES_DIRECTORY, //! Base directory where HTML templates and static assets (e.g. images, js and css files) are searched for (since QGIS 3.10).
-      QGIS_SERVER_API_WFS3_MAX_LIMIT //! Maximum value for "limit" in a features request, defaults to 10000 (since QGIS 3.10).
+      QGIS_SERVER_API_WFS3_MAX_LIMIT, //! Maximum value for "limit" in a features request, defaults to 10000 (since QGIS 3.10).
+      QGIS_SERVER_FCGI_THREADS, //! Number of FastCGI requests served concurrently by a server process, defaults to 1 (since QGIS 3.10).
+      QGIS_SERVER_WMTS_METATILE_SIZE, //! Number of tiles along each side of the metatiles rendered for WMTS GetTile requests, defaults to 1 (since QGIS 3.10).
+      QGIS_SERVER_WMTS_METATILE_BUFFER, //! Buffer in pixels around WMTS metatiles, defaults to 64 (since QGIS 3.10).
+      QGIS_SERVER_WMTS_CACHE_DIRECTORY, //! Directory of the WMTS tile cache, defaults to empty (since QGIS 3.10).
+      QGIS_SERVER_WMTS_CACHE_SIZE, //! Size in bytes of the WMTS in-memory tile cache, defaults to 0 (since QGIS 3.10).
+      QGIS_SERVER_PROJECT_PREWARM, //! Projects loaded in the cache at startup, separated by the path list separator (since QGIS 3.10).
+      QGIS_SERVER_RESPONSE_CACHE_SIZE, //! Size in bytes of the in-memory response cache, defaults to 0 (since QGIS 3.10).
+      QGIS_SERVER_RESPONSE_CACHE_DIRECTORY, //! Directory of the response cache, defaults to empty (since QGIS 3.10).
+      QGIS_SERVER_RESPONSE_CACHE_DISK_SIZE, //! Maximum size in bytes of the response cache directory, defaults to 50 MB (since QGIS 3.10).
+      QGIS_SERVER_WMTS_CACHE_DISK_SIZE, //! Maximum size in bytes of the WMTS tile cache directory, defaults to 500 MB (since QGIS 3.10).
+      QGIS_SERVER_WMTS_CACHE_MAX_AGE, //! Maximum age in seconds of the cached WMTS tiles, defaults to 0 (since QGIS 3.10).
+      QGIS_SERVER_RESPONSE_CACHE_MAX_AGE //! Maximum age in seconds of the cached responses, defaults to 3600 (since QGIS 3.10).
     };
     Q_ENUM( EnvVar )
 };
@@ -222,6 +234,143 @@ class SERVER_EXPORT QgsServerSettings
      */
     qlonglong apiWfs3MaxLimit() const;
 
+    /**
+     * Returns the number of FastCGI requests served concurrently by a server process,
+     * each in its own thread.
+     *
+     * The default value is 1, this value can be changed by setting the environment
+     * variable QGIS_SERVER_FCGI_THREADS.
+     *
+     * \since QGIS 3.10
+     */
+    int fcgiThreads() const;
+
+    /**
+     * Returns the number of tiles along each side of the metatiles rendered to
+     * answer WMTS GetTile requests. A value of 1 disables metatiling, which
+     * is only used when the WMTS tile cache is enabled.
+     *
+     * The default value is 1, this value can be changed by setting the environment
+     * variable QGIS_SERVER_WMTS_METATILE_SIZE.
+     *
+     * \since QGIS 3.10
+     */
+    int wmtsMetatileSize() const;
+
+    /**
+     * Returns the buffer in pixels rendered around WMTS metatiles, so that labels
+     * and symbols crossing the metatile edges are not clipped.
+     *
+     * The default value is 64, this value can be changed by setting the environment
+     * variable QGIS_SERVER_WMTS_METATILE_BUFFER.
+     *
+     * \since QGIS 3.10
+     */
+    int wmtsMetatileBuffer() const;
+
+    /**
+     * Returns the directory where the WMTS tiles are cached, shared by all the
+     * server processes. An empty value disables the disk cache.
+     *
+     * The default value is empty, this value can be changed by setting the environment
+     * variable QGIS_SERVER_WMTS_CACHE_DIRECTORY.
+     *
+     * \since QGIS 3.10
+     */
+    QString wmtsCacheDirectory() const;
+
+    /**
+     * Returns the size in bytes of the in-memory WMTS tile cache of a server
+     * process. A value of 0 disables the in-memory cache.
+     *
+     * The default value is 0, this value can be changed by setting the environment
+     * variable QGIS_SERVER_WMTS_CACHE_SIZE.
+     *
+     * \since QGIS 3.10
+     */
+    qint64 wmtsCacheSize() const;
+
+    /**
+     * Returns the projects loaded in the project cache when the server starts,
+     * so that the first requests do not have to wait for them to be read.
+     *
+     * The value is a list of project paths separated by the path list separator
+     * of the platform (':' on Unix, ';' on Windows). The default value is an empty
+     * list, this value can be changed by setting the environment variable
+     * QGIS_SERVER_PROJECT_PREWARM.
+     *
+     * \since QGIS 3.10
+     */
+    QStringList projectPrewarm() const;
+
+    /**
+     * Returns the size in bytes of the in-memory cache of the responses of a
+     * server process. A value of 0 disables the in-memory cache.
+     *
+     * The default value is 0, this value can be changed by setting the environment
+     * variable QGIS_SERVER_RESPONSE_CACHE_SIZE.
+     *
+     * \since QGIS 3.10
+     */
+    qint64 responseCacheSize() const;
+
+    /**
+     * Returns the directory where the responses are cached on disk, the directory
+     * may be shared by several server processes. An empty value disables the disk cache.
+     *
+     * The default value is empty, this value can be changed by setting the
+     * environment variable QGIS_SERVER_RESPONSE_CACHE_DIRECTORY.
+     *
+     * \since QGIS 3.10
+     */
+    QString responseCacheDirectory() const;
+
+    /**
+     * Returns the maximum size in bytes of the response cache directory. The
+     * oldest responses are removed when it is exceeded.
+     *
+     * The default value is 50 MB, this value can be changed by setting the
+     * environment variable QGIS_SERVER_RESPONSE_CACHE_DISK_SIZE.
+     *
+     * \since QGIS 3.10
+     */
+    qint64 responseCacheDiskSize() const;
+
+    /**
+     * Returns the maximum size in bytes of the WMTS tile cache directory. The
+     * oldest tiles are removed when it is exceeded, a value of 0 disables the limit.
+     *
+     * The default value is 500 MB, this value can be changed by setting the
+     * environment variable QGIS_SERVER_WMTS_CACHE_DISK_SIZE.
+     *
+     * \since QGIS 3.10
+     */
+    qint64 wmtsCacheDiskSize() const;
+
+    /**
+     * Returns the maximum age in seconds of the cached WMTS tiles, older tiles
+     * are rendered again. A value of 0 keeps the tiles until the project changes.
+     *
+     * The default value is 0, this value can be changed by setting the
+     * environment variable QGIS_SERVER_WMTS_CACHE_MAX_AGE.
+     *
+     * \since QGIS 3.10
+     */
+    int wmtsCacheMaxAge() const;
+
+    /**
+     * Returns the maximum age in seconds of the cached responses, older
+     * responses are executed again. The responses also depend on the data of
+     * the layers, which may change without the project. A value of 0 keeps
+     * the responses until the project changes.
+     *
+     * The default value is 3600, this value can be changed by setting the
+     * environment variable QGIS_SERVER_RESPONSE_CACHE_MAX_AGE.
+     *
+     * \since QGIS 3.10
+     */
+    int responseCacheMaxAge() const;
+
   private:
     void initSettings();
     QVariant value( QgsServerSettingsEnv::EnvVar envVar ) const;
@@ -38,6 +38,10 @@
 
 #include "qgswfsgetfeature.h"
 
+#include <QXmlStreamWriter>
+
+#include <nlohmann/json.hpp>
+
 namespace QgsWfs
 {
 
@@ -58,15 +62,32 @@ namespace QgsWfs
       const QString &geometryName;
 
       const QgsCoordinateReferenceSystem &outputCrs;
+
+      //! Transform from the layer crs to EPSG:4326 for GeoJSON output
+      const QgsCoordinateTransform &geoJsonTransform;
     };
 
-    QString createFeatureGeoJSON( const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes );
+    // Size of the content buffered before being flushed to the client
+    const qint64 FLUSH_SIZE = 64 * 1024;
+
+    // GeoJSON coordinates precision, the RFC 7946 recommends 6 decimal places
+    const int GEOJSON_PRECISION = 6;
+
+    void writeFeatureGeoJSON( QByteArray &content, const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes );
 
     QString encodeValueToText( const QVariant &value, const QgsEditorWidgetSetup &setup );
 
-    QDomElement createFeatureGML2( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes );
+    void writeFeatureGML2( QXmlStreamWriter &writer, const QgsFeature &feature, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes );
 
-    QDomElement createFeatureGML3( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes );
+    void writeFeatureGML3( QXmlStreamWriter &writer, const QgsFeature &feature, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes );
+
+    void writeDomElement( QXmlStreamWriter &writer, const QDomElement &element );
+
+    QString encodeDomText( const QString &text, bool attribute );
+
+    void writeDomAttribute( QXmlStreamWriter &writer, const QString &name, const QString &value );
+
+    void writeDomCharacters( QXmlStreamWriter &writer, const QString &text );
 
     void hitGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project,
                         QgsWfsParameters::Format format, int numberOfFeatures, const QStringList &typeNames );
@@ -82,8 +103,6 @@ namespace QgsWfs
 
     QgsServerRequest::Parameters mRequestParameters;
     QgsWfsParameters mWfsParameters;
-    /* GeoJSON Exporter */
-    QgsJsonExporter mJsonExporter;
   }
 
   void writeGetFeature( QgsServerInterface *serverIface, const QgsProject *project,
@@ -397,13 +416,20 @@ namespace QgsWfs
       }
       else
       {
+        QgsCoordinateTransform geoJsonTransform;
+        if ( aRequest.outputFormat == QgsWfsParameters::Format::GeoJSON )
+        {
+          geoJsonTransform = QgsCoordinateTransform( layerCrs, QgsCoordinateReferenceSystem( 4326, QgsCoordinateReferenceSystem::EpsgCrsId ), project );
+        }
+
         const createFeatureParams cfp = { layerPrecision,
                                           layerCrs,
                                           attrIndexes,
                                           typeName,
                                           withGeom,
                                           geometryName,
-                                          outputCrs
+                                          outputCrs,
+                                          geoJsonTransform
                                         };
         while ( fit.nextFeature( feature ) && ( aRequest.maxFeatures == -1 || sentFeatures < aRequest.maxFeatures ) )
         {
@@ -1184,41 +1210,44 @@ namespace QgsWfs
       if ( !feature.isValid() )
         return;
 
+      QByteArray content;
       if ( format == QgsWfsParameters::Format::GeoJSON )
       {
-        QString fcString;
         if ( featIdx == 0 )
-          fcString += QLatin1String( "  " );
+          content += "  ";
         else
-          fcString += QLatin1String( " ," );
-        mJsonExporter.setSourceCrs( params.crs );
-        mJsonExporter.setIncludeGeometry( false );
-        mJsonExporter.setIncludeAttributes( !params.attributeIndexes.isEmpty() );
-        mJsonExporter.setAttributes( params.attributeIndexes );
-        fcString += createFeatureGeoJSON( feature, params, pkAttributes );
-        fcString += QLatin1String( "\n" );
+          content += " ,";
+        writeFeatureGeoJSON( content, feature, params, pkAttributes );
+        content += '\n';
 
-        response.write( fcString.toUtf8() );
+        response.write( content );
       }
       else
       {
-        QDomDocument gmlDoc;
-        QDomElement featureElement;
+        // Features are streamed, only geometries go through a DOM
+        QXmlStreamWriter writer( &content );
+        writer.setAutoFormatting( true );
+        writer.setAutoFormattingIndent( 1 );
         if ( format == QgsWfsParameters::Format::GML3 )
         {
-          featureElement = createFeatureGML3( feature, gmlDoc, params, project, pkAttributes );
-          gmlDoc.appendChild( featureElement );
+          writeFeatureGML3( writer, feature, params, project, pkAttributes );
         }
         else
         {
-          featureElement = createFeatureGML2( feature, gmlDoc, params, project, pkAttributes );
-          gmlDoc.appendChild( featureElement );
+          writeFeatureGML2( writer, feature, params, project, pkAttributes );
         }
-        response.write( gmlDoc.toByteArray() );
+        content += '\n';
+
+        // The writer starts the fragment with a line break
+        const int offset = content.startsWith( '\n' ) ? 1 : 0;
+        response.write( content.constData() + offset, content.size() - offset );
       }
 
-      // Stream partial content
-      response.flush();
+      // Stream partial content by chunks
+      if ( response.io() && response.io()->size() >= FLUSH_SIZE )
+      {
+        response.flush();
+      }
     }
 
     void endGetFeature( QgsServerResponse &response, QgsWfsParameters::Format format )
@@ -1237,44 +1266,96 @@ namespace QgsWfs
     }
 
 
-    QString createFeatureGeoJSON( const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes )
+    void writeFeatureGeoJSON( QByteArray &content, const QgsFeature &feature, const createFeatureParams &params, const QgsAttributeList &pkAttributes )
     {
-      QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
-      //QgsJsonExporter force transform geometry to ESPG:4326
-      //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
-      //Q_UNUSED( prec )
+      // Members are written in the same order and with the same number
+      // formatting as QgsJsonExporter, without building a JSON object
+      // for each feature
+      const QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
+
+      content += '{';
 
-      //copy feature so we can modify its geometry as required
-      QgsFeature f( feature );
       QgsGeometry geom = feature.geometry();
       if ( !geom.isNull() && params.withGeom && params.geometryName != QLatin1String( "NONE" ) )
       {
-        mJsonExporter.setIncludeGeometry( true );
         if ( params.geometryName == QLatin1String( "EXTENT" ) )
         {
-          QgsRectangle box = geom.boundingBox();
-          f.setGeometry( QgsGeometry::fromRect( box ) );
+          geom = QgsGeometry::fromRect( geom.boundingBox() );
         }
         else if ( params.geometryName == QLatin1String( "CENTROID" ) )
         {
-          f.setGeometry( geom.centroid() );
+          geom = geom.centroid();
+        }
+
+        // GeoJSON geometries are always in EPSG:4326
+        if ( params.crs.isValid() )
+        {
+          try
+          {
+            QgsGeometry transformed = geom;
+            if ( transformed.transform( params.geoJsonTransform ) == 0 )
+              geom = transformed;
+          }
+          catch ( QgsCsException &cse )
+          {
+            Q_UNUSED( cse )
+          }
+        }
+
+        if ( QgsWkbTypes::flatType( geom.wkbType() ) != QgsWkbTypes::Point )
+        {
+          const QgsRectangle box = geom.boundingBox();
+          const json bbox
+          {
+            qgsRound( box.xMinimum(), GEOJSON_PRECISION ),
+            qgsRound( box.yMinimum(), GEOJSON_PRECISION ),
+            qgsRound( box.xMaximum(), GEOJSON_PRECISION ),
+            qgsRound( box.yMaximum(), GEOJSON_PRECISION )
+          };
+          content += "\"bbox\":";
+          content += QByteArray::fromStdString( bbox.dump() );
+          content += ',';
         }
+        content += "\"geometry\":";
+        content += geom.asJson( GEOJSON_PRECISION ).toUtf8();
+        content += ',';
+      }
+      else
+      {
+        content += "\"geometry\":null,";
       }
 
-      return mJsonExporter.exportFeature( f, QVariantMap(), id );
+      content += "\"id\":";
+      content += QByteArray::fromStdString( json( id.toStdString() ).dump() );
+
+      // Properties are sorted by name, null without attributes
+      json properties;
+      if ( !params.attributeIndexes.isEmpty() )
+      {
+        const QgsAttributes featureAttributes = feature.attributes();
+        const QgsFields fields = feature.fields();
+        for ( int i = 0; i < fields.count(); ++i )
+        {
+          if ( params.attributeIndexes.contains( i ) )
+            properties[ fields.at( i ).name().toStdString() ] = QgsJsonUtils::jsonFromVariant( featureAttributes.at( i ) );
+        }
+      }
+      content += ",\"properties\":";
+      content += QByteArray::fromStdString( properties.dump() );
+
+      content += ",\"type\":\"Feature\"}";
     }
 
 
-    QDomElement createFeatureGML2( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes )
+    void writeFeatureGML2( QXmlStreamWriter &writer, const QgsFeature &feature, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes )
     {
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      writer.writeStartElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
+      writer.writeStartElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
       QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
-      typeNameElement.setAttribute( QStringLiteral( "fid" ), id );
-      featureElement.appendChild( typeNameElement );
+      writeDomAttribute( writer, QStringLiteral( "fid" ), id );
 
       //add geometry column (as gml)
       QgsGeometry geom = feature.geometry();
@@ -1299,7 +1380,8 @@ namespace QgsWfs
           Q_UNUSED( cse )
         }
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
+        // GML geometries are only available as DOM elements
+        QDomDocument doc;
         QDomElement gmlElem;
         if ( params.geometryName == QLatin1String( "EXTENT" ) )
         {
@@ -1323,7 +1405,6 @@ namespace QgsWfs
         if ( !gmlElem.isNull() )
         {
           QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
           QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
 
           if ( crs.isValid() )
@@ -1332,11 +1413,13 @@ namespace QgsWfs
             gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
+          writer.writeStartElement( QStringLiteral( "gml:boundedBy" ) );
+          writeDomElement( writer, boxElem );
+          writer.writeEndElement();
 
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          writer.writeStartElement( QStringLiteral( "qgs:geometry" ) );
+          writeDomElement( writer, gmlElem );
+          writer.writeEndElement();
         }
       }
 
@@ -1354,29 +1437,28 @@ namespace QgsWfs
         const QgsEditorWidgetSetup setup = field.editorWidgetSetup();
         QString attributeName = field.name();
 
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
-        QDomText fieldText = doc.createTextNode( encodeValueToText( featureAttributes[idx], setup ) );
+        writer.writeStartElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
         if ( featureAttributes[idx].isNull() )
         {
-          fieldElem.setAttribute( QStringLiteral( "xsi:nil" ), QStringLiteral( "true" ) );
+          writer.writeAttribute( QStringLiteral( "xsi:nil" ), QStringLiteral( "true" ) );
         }
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+        writeDomCharacters( writer, encodeValueToText( featureAttributes[idx], setup ) );
+        writer.writeEndElement();
       }
 
-      return featureElement;
+      writer.writeEndElement();
+      writer.writeEndElement();
     }
 
-    QDomElement createFeatureGML3( const QgsFeature &feature, QDomDocument &doc, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes )
+    void writeFeatureGML3( QXmlStreamWriter &writer, const QgsFeature &feature, const createFeatureParams &params, const QgsProject *project, const QgsAttributeList &pkAttributes )
     {
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      writer.writeStartElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
+      writer.writeStartElement( "qgs:" + params.typeName /*qgs:%TYPENAME%*/ );
       QString id = QStringLiteral( "%1.%2" ).arg( params.typeName, QgsServerFeatureId::getServerFid( feature, pkAttributes ) );
-      typeNameElement.setAttribute( QStringLiteral( "gml:id" ), id );
-      featureElement.appendChild( typeNameElement );
+      writeDomAttribute( writer, QStringLiteral( "gml:id" ), id );
 
       //add geometry column (as gml)
       QgsGeometry geom = feature.geometry();
@@ -1401,7 +1483,8 @@ namespace QgsWfs
           Q_UNUSED( cse )
         }
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
+        // GML geometries are only available as DOM elements
+        QDomDocument doc;
         QDomElement gmlElem;
         if ( params.geometryName == QLatin1String( "EXTENT" ) )
         {
@@ -1425,7 +1508,6 @@ namespace QgsWfs
         if ( !gmlElem.isNull() )
         {
           QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
           QDomElement boxElem = QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec );
 
           if ( crs.isValid() )
@@ -1434,11 +1516,13 @@ namespace QgsWfs
             gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
           }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
+          writer.writeStartElement( QStringLiteral( "gml:boundedBy" ) );
+          writeDomElement( writer, boxElem );
+          writer.writeEndElement();
 
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
+          writer.writeStartElement( QStringLiteral( "qgs:geometry" ) );
+          writeDomElement( writer, gmlElem );
+          writer.writeEndElement();
         }
       }
 
@@ -1458,17 +1542,113 @@ namespace QgsWfs
 
         QString attributeName = field.name();
 
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
-        QDomText fieldText = doc.createTextNode( encodeValueToText( featureAttributes[idx], setup ) );
+        writer.writeStartElement( "qgs:" + attributeName.replace( ' ', '_' ).replace( cleanTagNameRegExp, QString() ) );
         if ( featureAttributes[idx].isNull() )
         {
-          fieldElem.setAttribute( QStringLiteral( "xsi:nil" ), QStringLiteral( "true" ) );
+          writer.writeAttribute( QStringLiteral( "xsi:nil" ), QStringLiteral( "true" ) );
         }
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+        writeDomCharacters( writer, encodeValueToText( featureAttributes[idx], setup ) );
+        writer.writeEndElement();
+      }
+
+      writer.writeEndElement();
+      writer.writeEndElement();
+    }
+
+    void writeDomElement( QXmlStreamWriter &writer, const QDomElement &element )
+    {
+      // Same output as QDomDocument serialization: elements created with
+      // a namespace declare it, whatever their parent
+      if ( element.prefix().isEmpty() )
+        writer.writeStartElement( element.tagName() );
+      else
+        writer.writeStartElement( element.prefix() + ':' + element.tagName() );
+      if ( !element.namespaceURI().isEmpty() )
+      {
+        if ( element.prefix().isEmpty() )
+          writer.writeAttribute( QStringLiteral( "xmlns" ), element.namespaceURI() );
+        else
+          writer.writeAttribute( QStringLiteral( "xmlns:" ) + element.prefix(), element.namespaceURI() );
+      }
+
+      const QDomNamedNodeMap attributes = element.attributes();
+      for ( int i = 0; i < attributes.count(); ++i )
+      {
+        const QDomAttr attribute = attributes.item( i ).toAttr();
+        if ( attribute.prefix().isEmpty() )
+          writeDomAttribute( writer, attribute.name(), attribute.value() );
+        else
+          writeDomAttribute( writer, attribute.prefix() + ':' + attribute.name(), attribute.value() );
       }
 
-      return featureElement;
+      for ( QDomNode child = element.firstChild(); !child.isNull(); child = child.nextSibling() )
+      {
+        if ( child.isElement() )
+        {
+          writeDomElement( writer, child.toElement() );
+        }
+        else if ( child.isCDATASection() )
+        {
+          writer.writeCDATA( child.toCDATASection().data() );
+        }
+        else if ( child.isText() )
+        {
+          writeDomCharacters( writer, child.toText().data() );
+        }
+      }
+
+      writer.writeEndElement();
+    }
+
+    QString encodeDomText( const QString &text, bool attribute )
+    {
+      // Same escaping as QDomDocument serialization, which differs from
+      // QXmlStreamWriter for quotes, greater-than signs and whitespaces
+      QString encoded;
+      encoded.reserve( text.size() );
+      for ( const QChar c : text )
+      {
+        switch ( c.unicode() )
+        {
+          case '<':
+            encoded += QLatin1String( "&lt;" );
+            break;
+          case '&':
+            encoded += QLatin1String( "&amp;" );
+            break;
+          case '"':
+            encoded += attribute ? QStringLiteral( "&quot;" ) : QStringLiteral( "\"" );
+            break;
+          case '>':
+            // only the end of CDATA sections is escaped
+            encoded += encoded.endsWith( QLatin1String( "]]" ) ) ? QStringLiteral( "&gt;" ) : QStringLiteral( ">" );
+            break;
+          case '\t':
+          case '\n':
+            encoded += attribute ? QStringLiteral( "&#x%1;" ).arg( c.unicode(), 0, 16 ) : QString( c );
+            break;
+          case '\r':
+            encoded += QLatin1String( "&#xd;" );
+            break;
+          default:
+            encoded += c;
+            break;
+        }
+      }
+      return encoded;
+    }
+
+    void writeDomAttribute( QXmlStreamWriter &writer, const QString &name, const QString &value )
+    {
+      // The writer writes the start tag to its device as soon as it is opened
+      writer.device()->write( QStringLiteral( " %1=\"%2\"" ).arg( name, encodeDomText( value, true ) ).toUtf8() );
+    }
+
+    void writeDomCharacters( QXmlStreamWriter &writer, const QString &text )
+    {
+      // Closes the start tag, the content is then written to the device
+      writer.writeCharacters( QString() );
+      writer.device()->write( encodeDomText( text, false ).toUtf8() );
     }
 
     QString encodeValueToText( const QVariant &value, const QgsEditorWidgetSetup &setup )
@@ -38,6 +38,7 @@ class QgsWfs3Module: public QgsServiceModule
       // Register handlers
       wfs3Api->registerHandler<QgsWfs3CollectionsItemsHandler>();
       wfs3Api->registerHandler<QgsWfs3CollectionsFeatureHandler>();
+      wfs3Api->registerHandler<QgsWfs3CollectionTilesHandler>();
       wfs3Api->registerHandler<QgsWfs3CollectionsHandler>();
       wfs3Api->registerHandler<QgsWfs3DescribeCollectionHandler>();
       wfs3Api->registerHandler<QgsWfs3ConformanceHandler>();
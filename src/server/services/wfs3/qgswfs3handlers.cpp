@@ -24,18 +24,22 @@
 #include "qgsfeaturerequest.h"
 #include "qgsjsonutils.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
 #include "qgsmessagelog.h"
 #include "qgsbufferserverrequest.h"
 #include "qgsserverprojectutils.h"
 #include "qgsserverinterface.h"
 #include "qgsexpressioncontext.h"
 #include "qgsexpressioncontextutils.h"
+#include "qgsvectortileencoder.h"
+#include "qgssettings.h"
 
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
 #include "qgsfilterrestorer.h"
 #include "qgsaccesscontrol.h"
 #endif
 
+#include <QDateTime>
 #include <QMimeDatabase>
 
 
@@ -69,6 +73,9 @@ void QgsWfs3APIHandler::handleRequest( const QgsServerApiContext &context ) cons
         }, {
           { "name", "Features" },
           { "description", "Access to data (features)." }
+        }, {
+          { "name", "Tiles" },
+          { "description", "Access to data (features) as vector tiles." }
         }
       }
     },
@@ -787,6 +794,12 @@ QList<QgsServerQueryStringParameter> QgsWfs3CollectionsItemsHandler::parameters(
 
   params.push_back( offset );
 
+  // Cursor
+  QgsServerQueryStringParameter cursor { QStringLiteral( "cursor" ), false,
+                                         QgsServerQueryStringParameter::Type::String,
+                                         QStringLiteral( "Key of the last feature of the previous page" ) };
+  params.push_back( cursor );
+
   // BBOX
   QgsServerQueryStringParameter bbox { QStringLiteral( "bbox" ), false,
                                        QgsServerQueryStringParameter::Type::String,
@@ -842,6 +855,7 @@ json QgsWfs3CollectionsItemsHandler::schema( const QgsServerApiContext &context
     json parameters = {{
         {{ "$ref", "#/components/parameters/limit" }},
         {{ "$ref", "#/components/parameters/offset" }},
+        {{ "$ref", "#/components/parameters/cursor" }},
         {{ "$ref", "#/components/parameters/resultType" }},
         {{ "$ref", "#/components/parameters/bbox" }},
         {{ "$ref", "#/components/parameters/bbox-crs" }},
@@ -1011,12 +1025,37 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
 
     // limit & offset
     // Apparently the standard set limits 0-10000 (and does not implement paging,
-    // so we do our own paging with "offset")
+    // so we do our own paging with "offset" or "cursor")
     const qlonglong offset { params.value( QStringLiteral( "offset" ) ).toLongLong( &ok ) };
 
     // TODO: make the max limit configurable
     const qlonglong limit {  params.value( QStringLiteral( "limit" ) ).toLongLong( &ok ) };
 
+    // Keyset paging: pages start after the key of the last feature of the previous page.
+    // The features must come in the order of the key without being sorted in memory,
+    // which would read the whole collection for every page: the key is the numeric
+    // primary key of the providers compiling the ordering into their query, or the
+    // feature id of OGR which returns the features in their natural FID order. Offset
+    // paging is kept for explicit offsets and the other collections.
+    const QString cursor { params.value( QStringLiteral( "cursor" ) ).toString() };
+    const QgsAttributeList pkAttributes { mapLayer->dataProvider()->pkAttributeIndexes() };
+    const QString providerType { mapLayer->dataProvider()->name() };
+    static const QStringList sOrderCompilingProviders { QStringLiteral( "spatialite" ), QStringLiteral( "mssql" ), QStringLiteral( "DB2" ) };
+    const bool keyOrder { pkAttributes.size() == 1 && mapLayer->fields().at( pkAttributes.first() ).isNumeric()
+                          && sOrderCompilingProviders.contains( providerType )
+                          && QgsSettings().value( QStringLiteral( "qgis/compileExpressions" ), true ).toBool() };
+    const bool fidOrder { pkAttributes.isEmpty() && providerType == QLatin1String( "ogr" ) };
+    const bool keysetPaging { offset == 0 && ( keyOrder || fidOrder ) };
+    if ( ! cursor.isEmpty() && offset != 0 )
+    {
+      throw QgsServerApiBadRequestException( QStringLiteral( "cursor cannot be combined with offset" ) );
+    }
+    if ( ! cursor.isEmpty() && ! keysetPaging )
+    {
+      throw QgsServerApiBadRequestException( QStringLiteral( "cursor is not supported by this collection" ) );
+    }
+    const int keyIndex { pkAttributes.size() == 1 ? pkAttributes.first() : -1 };
+
     // TODO: implement time
     const QString time { context.request()->queryParameter( QStringLiteral( "time" ) ) };
     if ( ! time.isEmpty() )
@@ -1059,24 +1098,123 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
       featureRequest.setFilterExpression( filterExpression );
     }
 
+    // Matched features are counted without paging
+    QgsFeatureRequest countRequest { featureRequest };
+
     // WFS3 core specs only serves 4326
     featureRequest.setDestinationCrs( crs, context.project()->transformContext() );
-    // Add offset to limit because paging is not supported by QgsFeatureRequest
-    featureRequest.setLimit( limit + offset );
     QgsJsonExporter exporter { mapLayer };
     exporter.setAttributes( featureRequest.subsetOfAttributes() );
     exporter.setAttributeDisplayName( true );
     exporter.setSourceCrs( mapLayer->crs() );
+
+    if ( keysetPaging )
+    {
+      QString cursorExpression;
+      if ( keyIndex >= 0 )
+      {
+        const QgsField keyField { mapLayer->fields().at( keyIndex ) };
+        const QString keyColumn { QgsExpression::quotedColumnRef( keyField.name() ) };
+        if ( ! cursor.isEmpty() )
+        {
+          QVariant cursorValue { cursor };
+          if ( ! keyField.convertCompatible( cursorValue ) )
+          {
+            throw QgsServerApiBadRequestException( QStringLiteral( "cursor is not valid" ) );
+          }
+          cursorExpression = QStringLiteral( "%1 > %2" ).arg( keyColumn, QgsExpression::quotedValue( cursorValue ) );
+        }
+        // Compiled into the query of the provider
+        featureRequest.addOrderBy( keyColumn );
+        // The key of the last feature is the cursor of the next page
+        if ( featureRequest.flags() & QgsFeatureRequest::SubsetOfAttributes && ! featureRequest.subsetOfAttributes().contains( keyIndex ) )
+        {
+          QgsAttributeList attributes { featureRequest.subsetOfAttributes() };
+          attributes.push_back( keyIndex );
+          featureRequest.setSubsetOfAttributes( attributes );
+        }
+      }
+      else
+      {
+        // Without primary key the features are paged by feature id, in the
+        // order OGR returns them
+        if ( ! cursor.isEmpty() )
+        {
+          const QgsFeatureId cursorId { cursor.toLongLong( &ok ) };
+          if ( ! ok )
+          {
+            throw QgsServerApiBadRequestException( QStringLiteral( "cursor is not valid" ) );
+          }
+          cursorExpression = QStringLiteral( "$id > %1" ).arg( cursorId );
+        }
+      }
+
+      if ( ! cursorExpression.isEmpty() )
+      {
+        if ( featureRequest.filterExpression() && ! featureRequest.filterExpression()->expression().isEmpty() )
+        {
+          cursorExpression = QStringLiteral( "( %1 ) AND %2" ).arg( featureRequest.filterExpression()->expression(), cursorExpression );
+        }
+        featureRequest.setFilterExpression( cursorExpression );
+      }
+      // Fetch one more feature to know if there is a next page
+      featureRequest.setLimit( limit + 1 );
+    }
+    else
+    {
+      // Add offset to limit because paging is not supported by QgsFeatureRequest
+      featureRequest.setLimit( limit + offset );
+    }
+
+    // GeoJSON is streamed while the features are fetched, HTML templates need
+    // the whole feature collection
+    const QgsServerOgcApi::ContentType contentType { contentTypeFromRequest( context.request() ) };
+    const bool streamed { contentType != QgsServerOgcApi::ContentType::HTML };
+    QgsServerResponse *response { context.response() };
+    if ( streamed )
+    {
+      response->setStatusCode( 200 );
+      response->setHeader( QStringLiteral( "Content-Type" ), QgsServerOgcApi::contentTypeMimes().value( contentType ) );
+      response->write( R"raw({"features":[)raw" );
+    }
+
     QgsFeatureList featureList;
     QgsFeatureIterator features { mapLayer->getFeatures( featureRequest ) };
     QgsFeature feat;
+    QVariant lastKey;
+    bool hasNextPage { false };
+    long returnedFeaturesCount { 0 };
     long i { 0 };
     while ( features.nextFeature( feat ) )
     {
       // Ignore records before offset
-      if ( i >= offset )
+      if ( i++ < offset )
+        continue;
+
+      if ( returnedFeaturesCount == limit )
+      {
+        hasNextPage = true;
+        break;
+      }
+
+      lastKey = keyIndex >= 0 ? feat.attribute( keyIndex ) : QVariant( feat.id() );
+      if ( streamed )
+      {
+        if ( returnedFeaturesCount > 0 )
+        {
+          response->write( "," );
+        }
+        response->write( exporter.exportFeatureToJsonObject( feat ).dump() );
+        if ( ( returnedFeaturesCount + 1 ) % 1000 == 0 )
+        {
+          response->flush();
+        }
+      }
+      else
+      {
         featureList << feat;
-      i++;
+      }
+      returnedFeaturesCount++;
     }
 
     // Count features
@@ -1089,29 +1227,28 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
     {
       if ( filterExpression.isEmpty() )
       {
-        featureRequest.setNoAttributes();
+        countRequest.setNoAttributes();
       }
-      featureRequest.setFlags( QgsFeatureRequest::Flag::NoGeometry );
-      featureRequest.setLimit( -1 );
-      features = mapLayer->getFeatures( featureRequest );
+      countRequest.setFlags( QgsFeatureRequest::Flag::NoGeometry );
+      features = mapLayer->getFeatures( countRequest );
       while ( features.nextFeature( feat ) )
       {
         matchedFeaturesCount++;
       }
     }
 
-    json data = exporter.exportFeaturesToJsonObject( featureList );
+    json data = streamed ? json::object() : exporter.exportFeaturesToJsonObject( featureList );
 
     // Add some metadata
     data["numberMatched"] = matchedFeaturesCount;
-    data["numberReturned"] = featureList.count();
+    data["numberReturned"] = returnedFeaturesCount;
     data["links"] = links( context );
 
     // Current url
     const QUrl url { context.request()->url() };
 
-    // Url without offset and limit
-    QString cleanedUrl { url.toString().replace( QRegularExpression( R"raw(&?(offset|limit)(=\d+)*)raw" ), QString() ) };
+    // Url without offset, limit and cursor
+    QString cleanedUrl { url.toString().replace( QRegularExpression( R"raw(&?(offset|limit)(=\d+)*|&?cursor(=[^&]*)?)raw" ), QString() ) };
 
     if ( ! url.hasQuery() )
     {
@@ -1132,21 +1269,51 @@ void QgsWfs3CollectionsItemsHandler::handleRequest( const QgsServerApiContext &c
     Q_ASSERT( !selfLink.is_null() );
 
     // Add prev - next links
-    if ( offset != 0 )
+    if ( keysetPaging )
     {
-      json prevLink = selfLink;
-      prevLink["href"] = QStringLiteral( "%1&offset=%2&limit=%3" ).arg( cleanedUrl ).arg( std::max<long>( 0, limit - offset ) ).arg( limit ).toStdString();
-      prevLink["rel"] = "prev";
-      prevLink["name"] = "Previous page";
-      data["links"].push_back( prevLink );
+      // Cursors only go forward
+      if ( hasNextPage && lastKey.isValid() )
+      {
+        json nextLink = selfLink;
+        nextLink["href"] = QStringLiteral( "%1&cursor=%2&limit=%3" ).arg( cleanedUrl, QString::fromUtf8( QUrl::toPercentEncoding( lastKey.toString() ) ) ).arg( limit ).toStdString();
+        nextLink["rel"] = "next";
+        nextLink["name"] = "Next page";
+        data["links"].push_back( nextLink );
+      }
     }
-    if ( limit + offset < matchedFeaturesCount )
+    else
     {
-      json nextLink = selfLink;
-      nextLink["href"] = QStringLiteral( "%1&offset=%2&limit=%3" ).arg( cleanedUrl ).arg( std::min<long>( matchedFeaturesCount, limit + offset ) ).arg( limit ).toStdString();
-      nextLink["rel"] = "next";
-      nextLink["name"] = "Next page";
-      data["links"].push_back( nextLink );
+      if ( offset != 0 )
+      {
+        json prevLink = selfLink;
+        prevLink["href"] = QStringLiteral( "%1&offset=%2&limit=%3" ).arg( cleanedUrl ).arg( std::max<long>( 0, limit - offset ) ).arg( limit ).toStdString();
+        prevLink["rel"] = "prev";
+        prevLink["name"] = "Previous page";
+        data["links"].push_back( prevLink );
+      }
+      if ( limit + offset < matchedFeaturesCount )
+      {
+        json nextLink = selfLink;
+        nextLink["href"] = QStringLiteral( "%1&offset=%2&limit=%3" ).arg( cleanedUrl ).arg( std::min<long>( matchedFeaturesCount, limit + offset ) ).arg( limit ).toStdString();
+        nextLink["rel"] = "next";
+        nextLink["name"] = "Next page";
+        data["links"].push_back( nextLink );
+      }
+    }
+
+    if ( streamed )
+    {
+      data["type"] = "FeatureCollection";
+      QDateTime time { QDateTime::currentDateTime() };
+      time.setTimeSpec( Qt::TimeSpec::UTC );
+      data["timeStamp"] = time.toString( Qt::DateFormat::ISODate ).toStdString() ;
+      // The remaining members follow "features" in the key order of the
+      // collection: close the features array and append them
+      std::string metadata { data.dump() };
+      metadata[0] = ',';
+      response->write( "]" );
+      response->write( metadata );
+      return;
     }
 
     json navigation = json::array();
@@ -1351,3 +1518,125 @@ void QgsWfs3StaticHandler::handleRequest( const QgsServerApiContext &context ) c
   context.response()->write( content );
 }
 
+void QgsWfs3CollectionTilesHandler::handleRequest( const QgsServerApiContext &context ) const
+{
+  if ( ! context.project() )
+  {
+    throw QgsServerApiImproperlyConfiguredException( QStringLiteral( "Project is invalid or undefined" ) );
+  }
+
+  if ( context.request()->method() != QgsServerRequest::Method::GetMethod )
+  {
+    throw QgsServerApiNotImplementedException( QStringLiteral( "Only GET method is implemented." ) );
+  }
+
+  // Check collectionId
+  const QRegularExpressionMatch match { path().match( context.request()->url().path( ) ) };
+  if ( ! match.hasMatch() )
+  {
+    throw QgsServerApiNotFoundError( QStringLiteral( "Collection was not found" ) );
+  }
+
+  const QString collectionId { match.captured( QStringLiteral( "collectionId" ) ) };
+  // May throw if not found
+  QgsVectorLayer *mapLayer { layerFromCollectionId( context, collectionId ) };
+  Q_ASSERT( mapLayer );
+
+  // Check if the layer is published, raise not found if it is not
+  checkLayerIsAccessible( mapLayer, context );
+
+  // Check the tile, levels deeper than 30 overflow the tile indexes
+  const int tileMatrix { match.captured( QStringLiteral( "tileMatrix" ) ).toInt() };
+  const qint64 tileRow { match.captured( QStringLiteral( "tileRow" ) ).toLongLong() };
+  const qint64 tileCol { match.captured( QStringLiteral( "tileCol" ) ).toLongLong() };
+  if ( tileMatrix > 30 || tileRow >= ( Q_INT64_C( 1 ) << tileMatrix ) || tileCol >= ( Q_INT64_C( 1 ) << tileMatrix ) )
+  {
+    throw QgsServerApiNotFoundError( QStringLiteral( "Tile %1/%2/%3 was not found" ).arg( tileMatrix ).arg( tileRow ).arg( tileCol ) );
+  }
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+  QgsAccessControl *accessControl = context.serverInterface()->accessControls();
+  //scoped pointer to restore all original layer filters (subsetStrings) when pointer goes out of scope
+  std::unique_ptr< QgsOWSServerFilterRestorer > filterRestorer( new QgsOWSServerFilterRestorer() );
+  if ( accessControl )
+  {
+    QgsOWSServerFilterRestorer::applyAccessControlLayerFilters( accessControl, mapLayer, filterRestorer->originalFilters() );
+  }
+#endif
+
+  QgsVectorTileEncoder encoder( QgsVectorTileEncoder::xyzTileExtent( tileMatrix, static_cast<int>( tileCol ), static_cast<int>( tileRow ) ),
+                                QgsCoordinateReferenceSystem::fromOgcWmsCrs( QStringLiteral( "EPSG:3857" ) ) );
+  encoder.setTransformContext( context.project()->transformContext() );
+  // Only the published attributes are written to the tile, whatever the provider fetches
+  QgsAttributeList attributes;
+  const QgsFields constFields { publishedFields( mapLayer, context ) };
+  for ( const QgsField &field : constFields )
+  {
+    attributes << mapLayer->fields().lookupField( field.name() );
+  }
+  encoder.addLayer( mapLayer, attributes, filteredRequest( mapLayer, context ), collectionId );
+
+  context.response()->setHeader( QStringLiteral( "Content-Type" ), QgsVectorTileEncoder::mimeType() );
+  context.response()->write( encoder.encode() );
+}
+
+json QgsWfs3CollectionTilesHandler::schema( const QgsServerApiContext &context ) const
+{
+  json data;
+  Q_ASSERT( context.project() );
+
+  const auto layers { QgsServerApiUtils::publishedWfsLayers<QgsVectorLayer>( context ) };
+  // Construct the context with collection id
+  for ( const auto &mapLayer : layers )
+  {
+    const QString shortName { mapLayer->shortName().isEmpty() ? mapLayer->name() : mapLayer->shortName() };
+    // Use layer id for operationId
+    const QString layerId { mapLayer->id() };
+    const std::string title { mapLayer->title().isEmpty() ? mapLayer->name().toStdString() : mapLayer->title().toStdString() };
+    const std::string path { QgsServerApiUtils::appendMapParameter( context.apiRootPath() + QStringLiteral( "collections/%1/tiles/WebMercatorQuad/{tileMatrix}/{tileRow}/{tileCol}" ).arg( shortName ), context.request()->url() ).toStdString() };
+
+    data[ path ] =
+    {
+      {
+        "get", {
+          { "tags", jsonTags() },
+          { "summary", "Retrieve a vector tile of the '" + title + "' feature collection"},
+          { "description", description() },
+          { "operationId", operationId() + '_' + layerId.toStdString() },
+          {
+            "parameters", {
+              {{ "name", "tileMatrix" }, { "in", "path" }, { "required", true }, { "description", "Zoom level of the tile" }, { "schema", {{ "type", "integer" }, { "minimum", 0 }, { "maximum", 30 }} }},
+              {{ "name", "tileRow" }, { "in", "path" }, { "required", true }, { "description", "Row of the tile, from the top" }, { "schema", {{ "type", "integer" }, { "minimum", 0 }} }},
+              {{ "name", "tileCol" }, { "in", "path" }, { "required", true }, { "description", "Column of the tile, from the left" }, { "schema", {{ "type", "integer" }, { "minimum", 0 }} }}
+            }
+          },
+          {
+            "responses", {
+              {
+                "200", {
+                  { "description", "A '" + title + "' vector tile, empty if the tile has no features." },
+                  {
+                    "content", {
+                      {
+                        QgsVectorTileEncoder::mimeType().toStdString(), {
+                          {
+                            "schema",  {
+                              { "type", "string" },
+                              { "format", "binary" }
+                            }
+                          }
+                        }
+                      }
+                    }
+                  }
+                }
+              },
+              defaultResponse()
+            }
+          }
+        }
+      }
+    };
+  }
+  return data;
+}
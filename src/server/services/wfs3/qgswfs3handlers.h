@@ -260,4 +260,22 @@ class QgsWfs3CollectionsFeatureHandler: public QgsWfs3AbstractItemsHandler
 };
 
 
+/**
+ * The QgsWfs3CollectionTilesHandler class serves the features of a
+ * collection as Mapbox Vector Tiles of the WebMercatorQuad tiling scheme
+ */
+class QgsWfs3CollectionTilesHandler: public QgsWfs3AbstractItemsHandler
+{
+  public:
+    void handleRequest( const QgsServerApiContext &context ) const override;
+    QRegularExpression path() const override { return QRegularExpression( R"re(/collections/(?<collectionId>[^/]+)/tiles/WebMercatorQuad/(?<tileMatrix>\d+)/(?<tileRow>\d+)/(?<tileCol>\d+)(\.mvt|\.pbf)?$)re" ); }
+    std::string operationId() const override { return "getTile"; }
+    std::string description() const override { return "Retrieve a vector tile of the features of a collection in the WebMercatorQuad tiling scheme, encoded as a Mapbox Vector Tile"; }
+    std::string summary() const override { return "Retrieve a vector tile"; }
+    std::string linkTitle() const override { return "Retrieve a vector tile"; }
+    QStringList tags() const override { return { QStringLiteral( "Tiles" ) }; }
+    QgsServerOgcApi::Rel linkType() const override { return QgsServerOgcApi::Rel::data; }
+    json schema( const QgsServerApiContext &context ) const override;
+};
+
 #endif // QGS_WFS3_HANDLERS_H
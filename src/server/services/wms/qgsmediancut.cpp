@@ -25,6 +25,11 @@
 #include <QMultiMap>
 #include <QHash>
 
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
 namespace QgsWms
 {
 
@@ -34,32 +39,116 @@ namespace QgsWms
   namespace
   {
 
+    // Maximum number of pixels used to build the histogram of an image
+    const int MAX_SAMPLES = 1 << 16;
+
+    // Size of the lookup table of the nearest palette colors
+    const int LOOKUP_BITS = 12;
+
+    // Step between the sampled rows and columns so that at most
+    // MAX_SAMPLES pixels are read
+    int sampleStep( const QImage &image )
+    {
+      const qint64 pixels = static_cast<qint64>( image.width() ) * image.height();
+      if ( pixels <= MAX_SAMPLES )
+        return 1;
+      return static_cast<int>( std::ceil( std::sqrt( static_cast<double>( pixels ) / MAX_SAMPLES ) ) );
+    }
+
     void imageColors( QHash<QRgb, int> &colors, const QImage &image )
     {
       colors.clear();
       int width = image.width();
       int height = image.height();
+      const int step = sampleStep( image );
 
       const QRgb *currentScanLine = nullptr;
       QHash<QRgb, int>::iterator colorIt;
-      for ( int i = 0; i < height; ++i )
+      for ( int i = 0; i < height; i += step )
       {
         currentScanLine = ( const QRgb * )( image.scanLine( i ) );
-        for ( int j = 0; j < width; ++j )
+        for ( int j = 0; j < width; )
         {
-          colorIt = colors.find( currentScanLine[j] );
+          // Count runs of the same color at once, rendered maps
+          // are mostly made of flat areas
+          const QRgb color = currentScanLine[j];
+          int count = 0;
+          for ( ; j < width && currentScanLine[j] == color; j += step )
+          {
+            ++count;
+          }
+
+          colorIt = colors.find( color );
           if ( colorIt == colors.end() )
           {
-            colors.insert( currentScanLine[j], 1 );
+            colors.insert( color, count );
           }
           else
           {
-            colorIt.value()++;
+            colorIt.value() += count;
           }
         }
       }
     }
 
+    // Same distance as the one used by QImage when converting to an indexed format
+    inline int colorDistance( QRgb c1, QRgb c2 )
+    {
+      return std::abs( qRed( c1 ) - qRed( c2 ) ) + std::abs( qGreen( c1 ) - qGreen( c2 ) )
+             + std::abs( qBlue( c1 ) - qBlue( c2 ) ) + std::abs( qAlpha( c1 ) - qAlpha( c2 ) );
+    }
+
+    int closestColor( QRgb color, const QVector<QRgb> &colorTable, int *distance = nullptr )
+    {
+      int index = 0;
+      int minDistance = std::numeric_limits<int>::max();
+      for ( int i = 0; i < colorTable.size(); ++i )
+      {
+        const int d = colorDistance( color, colorTable.at( i ) );
+        if ( d < minDistance )
+        {
+          minDistance = d;
+          index = i;
+          if ( d == 0 )
+            break;
+        }
+      }
+      if ( distance )
+        *distance = minDistance;
+      return index;
+    }
+
+    /**
+     * Direct mapped cache of the nearest palette color of the last
+     * colors looked up.
+     */
+    class ColorLookup
+    {
+      public:
+        explicit ColorLookup( const QVector<QRgb> &colorTable )
+          : mColorTable( colorTable )
+          , mColors( 1 << LOOKUP_BITS )
+          , mIndexes( 1 << LOOKUP_BITS, -1 )
+        {
+        }
+
+        int index( QRgb color )
+        {
+          const quint32 slot = ( color * 2654435761U ) >> ( 32 - LOOKUP_BITS );
+          if ( mIndexes[slot] < 0 || mColors[slot] != color )
+          {
+            mColors[slot] = color;
+            mIndexes[slot] = closestColor( color, mColorTable );
+          }
+          return mIndexes[slot];
+        }
+
+      private:
+        const QVector<QRgb> &mColorTable;
+        std::vector<QRgb> mColors;
+        std::vector<int> mIndexes;
+    };
+
     bool minMaxRange( const QgsColorBox &colorBox, int &redRange, int &greenRange, int &blueRange, int &alphaRange )
     {
       if ( colorBox.size() < 1 )
@@ -320,6 +409,64 @@ namespace QgsWms
     }
   }
 
+  bool colorTableFits( const QVector<QRgb> &colorTable, const QImage &inputImage, double meanDistance, int maxDistance )
+  {
+    if ( colorTable.isEmpty() )
+      return false;
+
+    QHash<QRgb, int> inputColors;
+    imageColors( inputColors, inputImage );
+
+    qint64 totalDistance = 0;
+    qint64 totalPixels = 0;
+    for ( auto inputColorIt = inputColors.constBegin(); inputColorIt != inputColors.constEnd(); ++inputColorIt )
+    {
+      int distance = 0;
+      closestColor( inputColorIt.key(), colorTable, &distance );
+      if ( distance > maxDistance )
+      {
+        return false;
+      }
+      totalDistance += static_cast<qint64>( distance ) * inputColorIt.value();
+      totalPixels += inputColorIt.value();
+    }
+
+    return totalPixels == 0 || static_cast<double>( totalDistance ) / totalPixels <= meanDistance;
+  }
+
+  QImage indexedImage( const QImage &inputImage, const QVector<QRgb> &colorTable )
+  {
+    const int width = inputImage.width();
+    const int height = inputImage.height();
+
+    QImage result( width, height, QImage::Format_Indexed8 );
+    result.setColorTable( colorTable );
+    result.setDotsPerMeterX( inputImage.dotsPerMeterX() );
+    result.setDotsPerMeterY( inputImage.dotsPerMeterY() );
+    if ( colorTable.isEmpty() || result.isNull() || width == 0 )
+      return result;
+
+    ColorLookup lookup( colorTable );
+    for ( int i = 0; i < height; ++i )
+    {
+      const QRgb *currentScanLine = ( const QRgb * )( inputImage.scanLine( i ) );
+      uchar *resultScanLine = result.scanLine( i );
+
+      QRgb lastColor = currentScanLine[0];
+      uchar lastIndex = static_cast<uchar>( lookup.index( lastColor ) );
+      for ( int j = 0; j < width; ++j )
+      {
+        if ( currentScanLine[j] != lastColor )
+        {
+          lastColor = currentScanLine[j];
+          lastIndex = static_cast<uchar>( lookup.index( lastColor ) );
+        }
+        resultScanLine[j] = lastIndex;
+      }
+    }
+    return result;
+  }
+
 } // namespace QgsWms
 
 
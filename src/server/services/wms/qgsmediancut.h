@@ -39,6 +39,26 @@ namespace QgsWms
    */
   void medianCut( QVector<QRgb> &colorTable, int nColors, const QImage &inputImage );
 
+  /**
+   * Returns TRUE if \a colorTable is close enough to the colors of
+   * \a inputImage to be reused for it: the mean distance between the pixels
+   * and their nearest color must not exceed \a meanDistance and no pixel
+   * may be farther than \a maxDistance. Distances are the sum of the
+   * differences of the four channels and are computed on a sample of the pixels.
+   * \since QGIS 3.10
+   */
+  bool colorTableFits( const QVector<QRgb> &colorTable, const QImage &inputImage, double meanDistance, int maxDistance );
+
+  /**
+   * Converts the ARGB32 \a inputImage to an indexed image using the
+   * nearest color of \a colorTable for each pixel.
+   *
+   * The result is the same as QImage::convertToFormat() but the nearest
+   * colors are looked up once per distinct color.
+   * \since QGIS 3.10
+   */
+  QImage indexedImage( const QImage &inputImage, const QVector<QRgb> &colorTable );
+
 } // namespace QgsWms
 
 #endif
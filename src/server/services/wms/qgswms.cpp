@@ -150,6 +150,10 @@ namespace QgsWms
         {
           writeGetPrint( mServerIface, project, version, request, response );
         }
+        else if ( QSTR_COMPARE( req, "GetPrintJob" ) )
+        {
+          writeGetPrintJob( mServerIface, project, version, request, response );
+        }
         else
         {
           // Operation not supported
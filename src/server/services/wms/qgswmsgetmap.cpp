@@ -54,7 +54,15 @@ namespace QgsWms
     if ( result )
     {
       const QString format = request.parameters().value( QStringLiteral( "FORMAT" ), QStringLiteral( "PNG" ) );
-      writeImage( response, *result, format, context.imageQuality() );
+      // Tiles of the same layers and styles usually share their colors
+      QString paletteKey;
+      if ( parameters.tiledAsBool() )
+      {
+        paletteKey = QStringLiteral( "%1|%2|%3" ).arg( project->fileName(),
+                     parameters.allLayersNickname().join( ',' ),
+                     parameters.allStyles().join( ',' ) );
+      }
+      writeImage( response, *result, format, context.imageQuality(), paletteKey );
     }
     else
     {
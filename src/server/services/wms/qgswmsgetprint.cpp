@@ -20,11 +20,112 @@
  ***************************************************************************/
 #include "qgswmsutils.h"
 #include "qgswmsgetprint.h"
+#include "qgswmsprintjobs.h"
 #include "qgswmsrenderer.h"
 #include "qgswmsserviceexception.h"
+#include "qgsconfigcache.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsrequesthandler.h"
+
+#include <QJsonDocument>
+#include <QJsonObject>
 
 namespace QgsWms
 {
+  namespace
+  {
+    void writePrint( QgsServerInterface *serverIface, const QgsProject *project,
+                     const QgsWmsParameters &parameters, QgsServerResponse &response )
+    {
+      // GetPrint supports svg/png/pdf
+      const QgsWmsParameters::Format format = parameters.format();
+      QString contentType;
+      switch ( format )
+      {
+        case QgsWmsParameters::PNG:
+          contentType = QStringLiteral( "image/png" );
+          break;
+        case QgsWmsParameters::JPG:
+          contentType = QStringLiteral( "image/jpeg" );
+          break;
+        case QgsWmsParameters::SVG:
+          contentType = QStringLiteral( "image/svg+xml" );
+          break;
+        case QgsWmsParameters::PDF:
+          contentType = QStringLiteral( "application/pdf" );
+          break;
+        default:
+          throw QgsBadRequestException( QgsServiceException::OGC_InvalidFormat,
+                                        parameters[QgsWmsParameter::FORMAT] );
+          break;
+      }
+
+      // prepare render context
+      QgsWmsRenderContext context( project, serverIface );
+      context.setFlag( QgsWmsRenderContext::UpdateExtent );
+      context.setFlag( QgsWmsRenderContext::UseOpacity );
+      context.setFlag( QgsWmsRenderContext::UseFilter );
+      context.setFlag( QgsWmsRenderContext::UseSelection );
+      context.setFlag( QgsWmsRenderContext::SetAccessControl );
+      context.setFlag( QgsWmsRenderContext::AddHighlightLayers );
+      context.setFlag( QgsWmsRenderContext::AddExternalLayers );
+      context.setParameters( parameters );
+
+      // rendering
+      QgsRenderer renderer( context );
+      const QByteArray print = renderer.getPrint();
+      response.setHeader( QStringLiteral( "Content-Type" ), contentType );
+      response.write( print );
+    }
+
+    void writePrintJob( const QgsServerRequest &request, const QString &id,
+                        QgsWmsPrintJobs::State state, QgsServerResponse &response )
+    {
+      // URL polling the job, only the project is kept from the request
+      QUrl url( request.originalUrl() );
+      const QString map = request.serverParameters().map();
+      QUrlQuery jobQuery;
+      if ( !map.isEmpty() )
+        jobQuery.addQueryItem( QStringLiteral( "MAP" ), map );
+      jobQuery.addQueryItem( QStringLiteral( "SERVICE" ), QStringLiteral( "WMS" ) );
+      jobQuery.addQueryItem( QStringLiteral( "REQUEST" ), QStringLiteral( "GetPrintJob" ) );
+      jobQuery.addQueryItem( QStringLiteral( "JOB" ), id );
+      url.setQuery( jobQuery );
+
+      QJsonObject job;
+      job.insert( QStringLiteral( "job" ), id );
+      job.insert( QStringLiteral( "status" ), QgsWmsPrintJobs::stateName( state ) );
+      job.insert( QStringLiteral( "href" ), url.toString() );
+
+      response.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "application/json" ) );
+      response.write( QJsonDocument( job ).toJson( QJsonDocument::Compact ) );
+    }
+
+    /**
+     * Installs the request handler of a print job for the plugins, the
+     * request state of the server interface is local to each thread
+     */
+    class PrintJobRequestScope
+    {
+      public:
+        PrintJobRequestScope( QgsServerInterface *serverIface, QgsRequestHandler *requestHandler, const QString &configFilePath )
+          : mServerIface( serverIface )
+        {
+          mServerIface->setRequestHandler( requestHandler );
+          mServerIface->setConfigFilePath( configFilePath );
+        }
+
+        ~PrintJobRequestScope()
+        {
+          mServerIface->clearRequestHandler();
+          mServerIface->setConfigFilePath( QString() );
+        }
+
+      private:
+        QgsServerInterface *mServerIface = nullptr;
+    };
+  }
+
   void writeGetPrint( QgsServerInterface *serverIface, const QgsProject *project,
                       const QString &, const QgsServerRequest &request,
                       QgsServerResponse &response )
@@ -32,43 +133,76 @@ namespace QgsWms
     // get wms parameters from query
     const QgsWmsParameters parameters( QUrlQuery( request.url() ) );
 
-    // GetPrint supports svg/png/pdf
-    const QgsWmsParameters::Format format = parameters.format();
-    QString contentType;
-    switch ( format )
+    // Projects which are not read from a file cannot be loaded by the job
+    if ( !parameters.asyncAsBool() || project->fileName().isEmpty() )
     {
-      case QgsWmsParameters::PNG:
-        contentType = QStringLiteral( "image/png" );
-        break;
-      case QgsWmsParameters::JPG:
-        contentType = QStringLiteral( "image/jpeg" );
-        break;
-      case QgsWmsParameters::SVG:
-        contentType = QStringLiteral( "image/svg+xml" );
-        break;
-      case QgsWmsParameters::PDF:
-        contentType = QStringLiteral( "application/pdf" );
+      writePrint( serverIface, project, parameters, response );
+      return;
+    }
+
+    // Asynchronous print, the job runs with a copy of the request so that
+    // the access control plugins find it on the thread of the job
+    const QString path = project->fileName();
+    const QUrl url = request.url();
+    const QgsServerRequest::Method method = request.method();
+    const QgsServerRequest::Headers headers = request.headers();
+    const QByteArray data = request.data();
+    const QString id = QgsWmsPrintJobs::instance()->submit( [serverIface, path, url, method, headers, data]( QgsServerResponse & jobResponse )
+    {
+      QByteArray jobData( data );
+      QgsBufferServerRequest jobRequest( url, method, headers, &jobData );
+      QgsRequestHandler requestHandler( jobRequest, jobResponse );
+      requestHandler.parseInput();
+      const PrintJobRequestScope requestScope( serverIface, &requestHandler, path );
+
+      // The job has its own copy of the project for the whole render: when
+      // the cached project is used by a request, lockProject() reads another
+      // copy instead of waiting, so the print never blocks the requests
+      std::unique_ptr<QgsConfigCache::ProjectLock> projectLock = QgsConfigCache::instance()->lockProject( path );
+      if ( !projectLock )
+      {
+        throw QgsServerException( QStringLiteral( "Project file error" ) );
+      }
+      writePrint( serverIface, projectLock->project(), QgsWmsParameters( QUrlQuery( jobRequest.url() ) ), jobResponse );
+    } );
+
+    response.setStatusCode( 202 );
+    writePrintJob( request, id, QgsWmsPrintJobs::Queued, response );
+  }
+
+  void writeGetPrintJob( QgsServerInterface *, const QgsProject *,
+                         const QString &, const QgsServerRequest &request,
+                         QgsServerResponse &response )
+  {
+    const QgsWmsParameters parameters( QUrlQuery( request.url() ) );
+    const QString id = parameters.job();
+    if ( id.isEmpty() )
+    {
+      throw QgsBadRequestException( QgsServiceException::QGIS_MissingParameterValue,
+                                    parameters[QgsWmsParameter::JOB] );
+    }
+
+    QgsWmsPrintJobs *jobs = QgsWmsPrintJobs::instance();
+    const QgsWmsPrintJobs::State state = jobs->state( id );
+    switch ( state )
+    {
+      case QgsWmsPrintJobs::Unknown:
+        throw QgsBadRequestException( QgsServiceException::QGIS_InvalidParameterValue,
+                                      parameters[QgsWmsParameter::JOB] );
+
+      case QgsWmsPrintJobs::Queued:
+      case QgsWmsPrintJobs::Running:
+        writePrintJob( request, id, state, response );
         break;
-      default:
-        throw QgsBadRequestException( QgsServiceException::OGC_InvalidFormat,
-                                      parameters[QgsWmsParameter::FORMAT] );
+
+      case QgsWmsPrintJobs::Finished:
+      case QgsWmsPrintJobs::Failed:
+        if ( !jobs->writeOutput( id, response ) )
+        {
+          throw QgsBadRequestException( QgsServiceException::QGIS_InvalidParameterValue,
+                                        parameters[QgsWmsParameter::JOB] );
+        }
         break;
     }
-
-    // prepare render context
-    QgsWmsRenderContext context( project, serverIface );
-    context.setFlag( QgsWmsRenderContext::UpdateExtent );
-    context.setFlag( QgsWmsRenderContext::UseOpacity );
-    context.setFlag( QgsWmsRenderContext::UseFilter );
-    context.setFlag( QgsWmsRenderContext::UseSelection );
-    context.setFlag( QgsWmsRenderContext::SetAccessControl );
-    context.setFlag( QgsWmsRenderContext::AddHighlightLayers );
-    context.setFlag( QgsWmsRenderContext::AddExternalLayers );
-    context.setParameters( parameters );
-
-    // rendering
-    QgsRenderer renderer( context );
-    response.setHeader( QStringLiteral( "Content-Type" ), contentType );
-    response.write( renderer.getPrint() );
   }
 } // namespace QgsWms
@@ -23,12 +23,22 @@ namespace QgsWms
 {
 
   /**
-   * Output GetPrint response
+   * Output GetPrint response. When the ASYNC parameter is set, the print
+   * is queued and the response describes the print job.
    */
   void writeGetPrint( QgsServerInterface *serverIface, const QgsProject *project,
                       const QString &version, const QgsServerRequest &request,
                       QgsServerResponse &response );
 
+  /**
+   * Output GetPrintJob response, the state of an asynchronous print or its
+   * output once finished.
+   * \since QGIS 3.10
+   */
+  void writeGetPrintJob( QgsServerInterface *serverIface, const QgsProject *project,
+                         const QString &version, const QgsServerRequest &request,
+                         QgsServerResponse &response );
+
 } // namespace QgsWms
 
 
@@ -229,6 +229,14 @@ namespace QgsWms
                                   QVariant( false ) );
     save( pTiled );
 
+    const QgsWmsParameter pAsync( QgsWmsParameter::ASYNC,
+                                  QVariant::Bool,
+                                  QVariant( false ) );
+    save( pAsync );
+
+    const QgsWmsParameter pJob( QgsWmsParameter::JOB );
+    save( pJob );
+
     const QgsWmsParameter pBoxSpace( QgsWmsParameter::BOXSPACE,
                                      QVariant::Double,
                                      QVariant( 2.0 ) );
@@ -960,6 +968,21 @@ namespace QgsWms
     return mWmsParameters[ QgsWmsParameter::TILED ].toBool();
   }
 
+  QString QgsWmsParameters::async() const
+  {
+    return mWmsParameters[ QgsWmsParameter::ASYNC ].toString();
+  }
+
+  bool QgsWmsParameters::asyncAsBool() const
+  {
+    return mWmsParameters[ QgsWmsParameter::ASYNC ].toBool();
+  }
+
+  QString QgsWmsParameters::job() const
+  {
+    return mWmsParameters[ QgsWmsParameter::JOB ].toString();
+  }
+
   QString QgsWmsParameters::showFeatureCount() const
   {
     return mWmsParameters[ QgsWmsParameter::SHOWFEATURECOUNT ].toString();
@@ -178,7 +178,9 @@ namespace QgsWms
         FORMAT_OPTIONS,
         SRCWIDTH,
         SRCHEIGHT,
-        TILED
+        TILED,
+        ASYNC,
+        JOB
       };
       Q_ENUM( Name )
 
@@ -643,6 +645,27 @@ namespace QgsWms
        */
       bool tiledAsBool() const;
 
+      /**
+       * Returns ASYNC parameter or an empty string if not defined.
+       * \since QGIS 3.10
+       */
+      QString async() const;
+
+      /**
+       * Returns ASYNC parameter as a boolean. When TRUE, GetPrint requests
+       * are queued and answered with the identifier of the print job.
+       * \throws QgsBadRequestException
+       * \since QGIS 3.10
+       */
+      bool asyncAsBool() const;
+
+      /**
+       * Returns JOB parameter, the identifier of a print job, or an empty
+       * string if not defined.
+       * \since QGIS 3.10
+       */
+      QString job() const;
+
       /**
        * Returns infoFormat. If the INFO_FORMAT parameter is not used, then the
        * default value is text/plain.
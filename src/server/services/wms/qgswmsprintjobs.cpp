@@ -0,0 +1,268 @@
+/***************************************************************************
+                              qgswmsprintjobs.cpp
+                              -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgswmsprintjobs.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsexception.h"
+#include "qgsmessagelog.h"
+#include "qgsserverexception.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThread>
+#include <QTextStream>
+#include <QUuid>
+
+#include <algorithm>
+
+///@cond PRIVATE
+namespace
+{
+  // Jobs not updated for an hour are removed
+  const int JOB_EXPIRY_SECONDS = 3600;
+
+  // The state of a running job is not updated during the render, queued and
+  // running jobs of other processes are only removed once these processes
+  // have certainly stopped
+  const int ACTIVE_JOB_EXPIRY_SECONDS = 24 * 3600;
+
+  class QgsWmsPrintJobTask : public QRunnable
+  {
+    public:
+      explicit QgsWmsPrintJobTask( const std::function<void()> &function )
+        : mFunction( function )
+      {}
+
+      void run() override
+      {
+        mFunction();
+      }
+
+    private:
+      std::function<void()> mFunction;
+  };
+}
+///@endcond
+
+namespace QgsWms
+{
+
+  QgsWmsPrintJobs::QgsWmsPrintJobs( const QString &directory, int maxThreads )
+    : mDirectory( directory )
+  {
+    mThreadPool.setMaxThreadCount( std::max( 1, maxThreads ) );
+  }
+
+  QgsWmsPrintJobs *QgsWmsPrintJobs::instance()
+  {
+    // Prints are heavy, leave half of the cores to the other requests
+    static QgsWmsPrintJobs sInstance( QDir::tempPath() + QStringLiteral( "/qgis_server_print_jobs" ),
+                                      QThread::idealThreadCount() / 2 );
+    return &sInstance;
+  }
+
+  QString QgsWmsPrintJobs::submit( const Job &job )
+  {
+    removeExpiredJobs();
+
+    // Identifiers are random, the output of a job is only available
+    // to the clients knowing its identifier
+    const QString id = QUuid::createUuid().toString().mid( 1, 36 );
+    if ( !QDir().mkpath( mDirectory ) )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "WMS: cannot create print jobs directory %1" ).arg( mDirectory ), QStringLiteral( "Server" ), Qgis::Critical );
+      throw QgsServerException( QStringLiteral( "Print job cannot be queued" ) );
+    }
+    setState( id, Queued );
+    {
+      QMutexLocker locker( &mActiveJobsMutex );
+      mActiveJobs.insert( id );
+    }
+
+    mThreadPool.start( new QgsWmsPrintJobTask( [this, id, job]
+    {
+      run( id, job );
+      QMutexLocker locker( &mActiveJobsMutex );
+      mActiveJobs.remove( id );
+    } ) );
+    return id;
+  }
+
+  void QgsWmsPrintJobs::run( const QString &id, const Job &job )
+  {
+    setState( id, Running );
+
+    QgsBufferServerResponse response;
+    bool failed = false;
+    try
+    {
+      job( response );
+    }
+    catch ( QgsServerException &ex )
+    {
+      response.clear();
+      response.write( ex );
+      failed = true;
+      QString format;
+      QgsMessageLog::logMessage( ex.formatResponse( format ), QStringLiteral( "Server" ), Qgis::Info );
+    }
+    catch ( QgsException &ex )
+    {
+      response.clear();
+      response.setStatusCode( 500 );
+      response.setHeader( QStringLiteral( "Content-Type" ), QStringLiteral( "text/plain" ) );
+      response.write( QStringLiteral( "Internal Server Error" ) );
+      failed = true;
+      QgsMessageLog::logMessage( ex.what(), QStringLiteral( "Server" ), Qgis::Critical );
+    }
+
+    QSaveFile file( filePath( id, QStringLiteral( "output" ) ) );
+    const QByteArray output = response.data();
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( output ) != output.size() || !file.commit() )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "WMS: cannot write output of print job %1" ).arg( id ), QStringLiteral( "Server" ), Qgis::Critical );
+      setState( id, Failed, 500, QStringLiteral( "text/plain" ) );
+      return;
+    }
+
+    setState( id, failed ? Failed : Finished, response.statusCode(), response.header( QStringLiteral( "Content-Type" ) ) );
+  }
+
+  QgsWmsPrintJobs::State QgsWmsPrintJobs::state( const QString &id ) const
+  {
+    State state = Unknown;
+    int statusCode = 0;
+    QString contentType;
+    readState( id, state, statusCode, contentType );
+    return state;
+  }
+
+  bool QgsWmsPrintJobs::writeOutput( const QString &id, QgsServerResponse &response ) const
+  {
+    State state = Unknown;
+    int statusCode = 0;
+    QString contentType;
+    if ( !readState( id, state, statusCode, contentType ) || ( state != Finished && state != Failed ) )
+      return false;
+
+    QFile file( filePath( id, QStringLiteral( "output" ) ) );
+    if ( !file.open( QIODevice::ReadOnly ) )
+      return false;
+
+    response.setStatusCode( statusCode );
+    if ( !contentType.isEmpty() )
+      response.setHeader( QStringLiteral( "Content-Type" ), contentType );
+    response.write( file.readAll() );
+    return true;
+  }
+
+  QString QgsWmsPrintJobs::stateName( State state )
+  {
+    switch ( state )
+    {
+      case Queued:
+        return QStringLiteral( "queued" );
+      case Running:
+        return QStringLiteral( "running" );
+      case Finished:
+        return QStringLiteral( "finished" );
+      case Failed:
+        return QStringLiteral( "failed" );
+      case Unknown:
+        break;
+    }
+    return QStringLiteral( "unknown" );
+  }
+
+  void QgsWmsPrintJobs::setState( const QString &id, State state, int statusCode, const QString &contentType )
+  {
+    // The state file is replaced atomically, other processes polling
+    // the job never read a partial state
+    QSaveFile file( filePath( id, QStringLiteral( "state" ) ) );
+    if ( file.open( QIODevice::WriteOnly | QIODevice::Text ) )
+    {
+      QTextStream stream( &file );
+      stream << static_cast<int>( state ) << '\n' << statusCode << '\n' << contentType << '\n';
+      stream.flush();
+    }
+    if ( !file.commit() )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "WMS: cannot write state of print job %1" ).arg( id ), QStringLiteral( "Server" ), Qgis::Warning );
+    }
+  }
+
+  bool QgsWmsPrintJobs::readState( const QString &id, State &state, int &statusCode, QString &contentType ) const
+  {
+    // Identifiers come from the clients, never use them unchecked in paths
+    static const QRegularExpression sIdRx( QStringLiteral( "^[0-9a-f]{8}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{4}-[0-9a-f]{12}$" ) );
+    if ( !sIdRx.match( id ).hasMatch() )
+      return false;
+
+    QFile file( filePath( id, QStringLiteral( "state" ) ) );
+    if ( !file.open( QIODevice::ReadOnly | QIODevice::Text ) )
+      return false;
+
+    QTextStream stream( &file );
+    bool ok = false;
+    const int value = stream.readLine().toInt( &ok );
+    if ( !ok || value < Queued || value > Failed )
+      return false;
+
+    state = static_cast<State>( value );
+    statusCode = stream.readLine().toInt();
+    contentType = stream.readLine();
+    return true;
+  }
+
+  QString QgsWmsPrintJobs::filePath( const QString &id, const QString &suffix ) const
+  {
+    return QStringLiteral( "%1/%2.%3" ).arg( mDirectory, id, suffix );
+  }
+
+  void QgsWmsPrintJobs::removeExpiredJobs()
+  {
+    QSet<QString> activeJobs;
+    {
+      QMutexLocker locker( &mActiveJobsMutex );
+      activeJobs = mActiveJobs;
+    }
+
+    const QDateTime now = QDateTime::currentDateTime();
+    const QFileInfoList files = QDir( mDirectory ).entryInfoList( QStringList() << QStringLiteral( "*.state" ), QDir::Files );
+    for ( const QFileInfo &info : files )
+    {
+      // The jobs of this process are kept until they are finished
+      const QString id = info.completeBaseName();
+      if ( activeJobs.contains( id ) )
+        continue;
+
+      State state = Unknown;
+      int statusCode = 0;
+      QString contentType;
+      const bool active = readState( id, state, statusCode, contentType ) && ( state == Queued || state == Running );
+      if ( info.lastModified().secsTo( now ) <= ( active ? ACTIVE_JOB_EXPIRY_SECONDS : JOB_EXPIRY_SECONDS ) )
+        continue;
+
+      QFile::remove( filePath( id, QStringLiteral( "output" ) ) );
+      QFile::remove( info.absoluteFilePath() );
+    }
+  }
+
+} // namespace QgsWms
@@ -0,0 +1,109 @@
+/***************************************************************************
+                              qgswmsprintjobs.h
+                              -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSWMSPRINTJOBS_H
+#define QGSWMSPRINTJOBS_H
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+
+#include <functional>
+
+class QgsServerResponse;
+
+namespace QgsWms
+{
+
+  /**
+   * \ingroup server
+   * Queue of the asynchronous GetPrint requests.
+   *
+   * Jobs are run by a thread pool of the server process so that long prints
+   * do not hold the thread serving the request. The state and the output of
+   * the jobs are stored in files, so that the polling requests can be
+   * answered by any server process sharing the temporary directory. Jobs are
+   * removed one hour after their last update, except the jobs still queued or
+   * running which are kept as long as their process runs them.
+   * \since QGIS 3.10
+   */
+  class QgsWmsPrintJobs
+  {
+    public:
+
+      //! State of a print job
+      enum State
+      {
+        Unknown, //!< The job does not exist or has expired
+        Queued, //!< The job waits for a thread
+        Running, //!< The job is being rendered
+        Finished, //!< The output of the job is available
+        Failed //!< The job failed, the exception report is available
+      };
+
+      /**
+       * Print job, writes the output of the print to the response. It is
+       * called from a thread of the pool and may throw a QgsServerException.
+       */
+      typedef std::function<void( QgsServerResponse &response )> Job;
+
+      /**
+       * Constructor for QgsWmsPrintJobs.
+       * \param directory the directory where the jobs are stored
+       * \param maxThreads the number of jobs run concurrently
+       */
+      QgsWmsPrintJobs( const QString &directory, int maxThreads );
+
+      //! Returns the print job queue of the server process
+      static QgsWmsPrintJobs *instance();
+
+      /**
+       * Queues \a job and returns its identifier.
+       */
+      QString submit( const Job &job );
+
+      /**
+       * Returns the state of the job \a id.
+       */
+      State state( const QString &id ) const;
+
+      /**
+       * Writes the output of the finished or failed job \a id to \a response.
+       * Returns FALSE if the output is not available.
+       */
+      bool writeOutput( const QString &id, QgsServerResponse &response ) const;
+
+      //! Returns the name of \a state as used in the job reports
+      static QString stateName( State state );
+
+    private:
+      void run( const QString &id, const Job &job );
+      void setState( const QString &id, State state, int statusCode = 200, const QString &contentType = QString() );
+      bool readState( const QString &id, State &state, int &statusCode, QString &contentType ) const;
+      QString filePath( const QString &id, const QString &suffix ) const;
+      void removeExpiredJobs();
+
+      QString mDirectory;
+      QThreadPool mThreadPool;
+
+      //! Jobs of this process which are queued or running
+      QSet<QString> mActiveJobs;
+      QMutex mActiveJobsMutex;
+  };
+
+} // namespace QgsWms
+
+#endif
@@ -64,6 +64,7 @@
 #include "qgsserverexception.h"
 #include "qgsexpressioncontextutils.h"
 #include "qgsfeaturestore.h"
+#include "qgsvectorlayerfeatureiterator.h"
 
 #include <QImage>
 #include <QPainter>
@@ -71,6 +72,7 @@
 #include <QTemporaryFile>
 #include <QDir>
 #include <QUrl>
+#include <QtConcurrentRun>
 #include <nlohmann/json.hpp>
 
 //for printing
@@ -1170,6 +1172,25 @@ namespace QgsWms
     //layers can have assigned a different name for GetCapabilities
     QHash<QString, QString> layerAliasMap = QgsServerProjectUtils::wmsFeatureInfoLayerAliasMap( *mProject );
 
+    // Query the features of all the vector layers concurrently, they are
+    // then written in the order of the query layers
+    QHash<QgsVectorLayer *, FeatureInfoQuery> vectorQueries;
+    for ( const QString &queryLayer : queryLayers )
+    {
+      for ( QgsMapLayer *layer : qgis::as_const( layers ) )
+      {
+        if ( queryLayer == mContext.layerNickname( *layer ) )
+        {
+          QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer );
+          if ( vectorLayer && layer->flags().testFlag( QgsMapLayer::Identifiable ) && !vectorQueries.contains( vectorLayer ) )
+          {
+            vectorQueries.insert( vectorLayer, featureInfoQuery( vectorLayer, infoPoint.get(), featureCount, mapSettings, renderContext, featuresRect != nullptr, filterGeom.get() ) );
+          }
+          break;
+        }
+      }
+    }
+
     for ( const QString &queryLayer : queryLayers )
     {
       bool validLayer = false;
@@ -1215,7 +1236,7 @@ namespace QgsWms
             QgsVectorLayer *vectorLayer = qobject_cast<QgsVectorLayer *>( layer );
             if ( vectorLayer )
             {
-              ( void )featureInfoFromVectorLayer( vectorLayer, infoPoint.get(), featureCount, result, layerElement, mapSettings, renderContext, version, featuresRect.get(), filterGeom.get() );
+              ( void )featureInfoFromVectorLayer( vectorLayer, vectorQueries.value( vectorLayer ), result, layerElement, mapSettings, renderContext, version, featuresRect.get() );
               break;
             }
           }
@@ -1337,22 +1358,15 @@ namespace QgsWms
     return result;
   }
 
-  bool QgsRenderer::featureInfoFromVectorLayer( QgsVectorLayer *layer,
+  QgsRenderer::FeatureInfoQuery QgsRenderer::featureInfoQuery( QgsVectorLayer *layer,
       const QgsPointXY *infoPoint,
       int nFeatures,
-      QDomDocument &infoDocument,
-      QDomElement &layerElement,
       const QgsMapSettings &mapSettings,
-      QgsRenderContext &renderContext,
-      const QString &version,
-      QgsRectangle *featureBBox,
-      QgsGeometry *filterGeom ) const
+      const QgsRenderContext &renderContext,
+      bool withFeatureBBox,
+      const QgsGeometry *filterGeom ) const
   {
-    if ( !layer )
-    {
-      return false;
-    }
-
+    FeatureInfoQuery query;
     QgsFeatureRequest fReq;
 
     // Transform filter geometry to layer CRS
@@ -1384,19 +1398,12 @@ namespace QgsWms
       searchRect = layerRect;
     }
 
-    //do a select with searchRect and go through all the features
-
-    QgsFeature feature;
-    QgsAttributes featureAttributes;
-    int featureCounter = 0;
     layer->updateFields();
     const QgsFields fields = layer->fields();
     bool addWktGeometry = ( QgsServerProjectUtils::wmsFeatureInfoAddWktGeometry( *mProject ) && mWmsParameters.withGeometry() );
-    bool segmentizeWktGeometry = QgsServerProjectUtils::wmsFeatureInfoSegmentizeWktGeometry( *mProject );
-    const QSet<QString> &excludedAttributes = layer->excludeAttributesWms();
 
-    bool hasGeometry = addWktGeometry || featureBBox || layerFilterGeom;
-    fReq.setFlags( ( ( hasGeometry ) ? QgsFeatureRequest::NoFlags : QgsFeatureRequest::NoGeometry ) | QgsFeatureRequest::ExactIntersect );
+    query.hasGeometry = addWktGeometry || withFeatureBBox || layerFilterGeom;
+    fReq.setFlags( ( ( query.hasGeometry ) ? QgsFeatureRequest::NoFlags : QgsFeatureRequest::NoGeometry ) | QgsFeatureRequest::ExactIntersect );
 
     if ( ! searchRect.isEmpty() )
     {
@@ -1423,45 +1430,98 @@ namespace QgsWms
     }
     attributes = mContext.accessControl()->layerAttributes( layer, attributes );
     fReq.setSubsetOfAttributes( attributes, layer->fields() );
+    query.attributes = attributes;
 #endif
 
-    QgsFeatureIterator fit = layer->getFeatures( fReq );
-    std::unique_ptr< QgsFeatureRenderer > r2( layer->renderer() ? layer->renderer()->clone() : nullptr );
-    if ( r2 )
-    {
-      r2->startRender( renderContext, layer->fields() );
-    }
+    // The layer source and renderer are copied so that the features are
+    // fetched and checked without touching the layer
+    std::shared_ptr< QgsAbstractFeatureSource > source( new QgsVectorLayerFeatureSource( layer ) );
+    std::shared_ptr< QgsFeatureRenderer > r2( layer->renderer() ? layer->renderer()->clone() : nullptr );
+    const bool noGeometry = layer->wkbType() == QgsWkbTypes::NoGeometry;
 
-    bool featureBBoxInitialized = false;
-    while ( fit.nextFeature( feature ) )
+    query.features = QtConcurrent::run( [source, r2, fReq, fields, renderContext, searchRect, noGeometry, nFeatures]
     {
-      if ( layer->wkbType() == QgsWkbTypes::NoGeometry && ! searchRect.isEmpty() )
+      QgsRenderContext context( renderContext );
+      if ( r2 )
       {
-        break;
+        r2->startRender( context, fields );
       }
 
-      ++featureCounter;
-      if ( featureCounter > nFeatures )
+      QgsFeatureList features;
+      QgsFeature feature;
+      int featureCounter = 0;
+      QgsFeatureIterator fit = source->getFeatures( fReq );
+      while ( fit.nextFeature( feature ) )
       {
-        break;
-      }
-
-      renderContext.expressionContext().setFeature( feature );
+        if ( noGeometry && ! searchRect.isEmpty() )
+        {
+          break;
+        }
 
-      if ( layer->wkbType() != QgsWkbTypes::NoGeometry && ! searchRect.isEmpty() )
-      {
-        if ( !r2 )
+        ++featureCounter;
+        if ( featureCounter > nFeatures )
         {
-          continue;
+          break;
         }
 
-        //check if feature is rendered at all
-        bool render = r2->willRenderFeature( feature, renderContext );
-        if ( !render )
+        if ( !noGeometry && ! searchRect.isEmpty() )
         {
-          continue;
+          if ( !r2 )
+          {
+            continue;
+          }
+
+          //check if feature is rendered at all
+          context.expressionContext().setFeature( feature );
+          bool render = r2->willRenderFeature( feature, context );
+          if ( !render )
+          {
+            continue;
+          }
         }
+
+        features << feature;
+      }
+
+      if ( r2 )
+      {
+        r2->stopRender( context );
       }
+      return features;
+    } );
+
+    return query;
+  }
+
+  bool QgsRenderer::featureInfoFromVectorLayer( QgsVectorLayer *layer,
+      const FeatureInfoQuery &query,
+      QDomDocument &infoDocument,
+      QDomElement &layerElement,
+      const QgsMapSettings &mapSettings,
+      QgsRenderContext &renderContext,
+      const QString &version,
+      QgsRectangle *featureBBox ) const
+  {
+    if ( !layer || query.features.isCanceled() )
+    {
+      return false;
+    }
+
+    QgsAttributes featureAttributes;
+    const QgsFields fields = layer->fields();
+    bool addWktGeometry = ( QgsServerProjectUtils::wmsFeatureInfoAddWktGeometry( *mProject ) && mWmsParameters.withGeometry() );
+    bool segmentizeWktGeometry = QgsServerProjectUtils::wmsFeatureInfoSegmentizeWktGeometry( *mProject );
+    const QSet<QString> &excludedAttributes = layer->excludeAttributesWms();
+    const bool hasGeometry = query.hasGeometry;
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    QStringList attributes = query.attributes;
+#endif
+
+    bool featureBBoxInitialized = false;
+    const QgsFeatureList features = query.features.result();
+    for ( const QgsFeature &feature : features )
+    {
+      renderContext.expressionContext().setFeature( feature );
 
       QgsRectangle box;
       if ( layer->wkbType() != QgsWkbTypes::NoGeometry && hasGeometry )
@@ -1598,10 +1658,6 @@ namespace QgsWms
         }
       }
     }
-    if ( r2 )
-    {
-      r2->stopRender( renderContext );
-    }
 
     return true;
   }
@@ -2495,7 +2551,7 @@ namespace QgsWms
       }
 
       // create vector layer
-      const QgsVectorLayer::LayerOptions options { QgsProject::instance()->transformContext() };
+      const QgsVectorLayer::LayerOptions options { mProject->transformContext() };
       std::unique_ptr<QgsVectorLayer> layer = qgis::make_unique<QgsVectorLayer>( url, param.mName, QLatin1Literal( "memory" ), options );
       if ( !layer->isValid() )
       {
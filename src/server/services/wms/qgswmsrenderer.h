@@ -25,7 +25,10 @@
 #include "qgswmsrendercontext.h"
 #include "qgsfeaturefilter.h"
 #include "qgslayertreemodellegendnode.h"
+#include "qgsfeature.h"
+#include "qgsfeaturerequest.h"
 #include <QDomDocument>
+#include <QFuture>
 #include <QMap>
 #include <QString>
 
@@ -183,31 +186,59 @@ namespace QgsWms
       QDomDocument featureInfoDocument( QList<QgsMapLayer *> &layers, const QgsMapSettings &mapSettings,
                                         const QImage *outputImage, const QString &version ) const;
 
+      //! Features of a vector layer selected for GetFeatureInfo
+      struct FeatureInfoQuery
+      {
+        //! Features matching the request, fetched in the background
+        QFuture<QgsFeatureList> features;
+        //! Whether the feature geometries are fetched
+        bool hasGeometry = false;
+        //! Attributes allowed by the access control
+        QStringList attributes;
+      };
+
       /**
-       * Appends feature info xml for the layer to the layer element of the
-       * feature info dom document.
+       * Starts the query of the features of a vector layer for GetFeatureInfo.
+       *
+       * The features are fetched from a copy of the layer source on the global
+       * thread pool, so that several layers can be queried concurrently.
        * \param layer The vector layer
        * \param infoPoint The point coordinates
        * \param nFeatures The number of features
+       * \param mapSettings Map settings with extent, CRS, ...
+       * \param renderContext Context used to check whether features are rendered
+       * \param withFeatureBBox TRUE if the bounding box of the features is needed
+       * \param filterGeom Geometry for filtering selected features
+       */
+      FeatureInfoQuery featureInfoQuery( QgsVectorLayer *layer,
+                                         const QgsPointXY *infoPoint,
+                                         int nFeatures,
+                                         const QgsMapSettings &mapSettings,
+                                         const QgsRenderContext &renderContext,
+                                         bool withFeatureBBox,
+                                         const QgsGeometry *filterGeom ) const;
+
+      /**
+       * Appends feature info xml for the layer to the layer element of the
+       * feature info dom document.
+       * \param layer The vector layer
+       * \param query The query of the layer features started with featureInfoQuery()
        * \param infoDocument Feature info document
        * \param layerElement Layer XML element
        * \param mapSettings Map settings with extent, CRS, ...
        * \param renderContext Context to use for feature rendering
        * \param version WMS version
        * \param featureBBox The bounding box of the selected features in output CRS
-       * \param filterGeom Geometry for filtering selected features
        * \returns TRUE in case of success
        */
       bool featureInfoFromVectorLayer( QgsVectorLayer *layer,
-                                       const QgsPointXY *infoPoint,
-                                       int nFeatures,
+                                       const FeatureInfoQuery &query,
                                        QDomDocument &infoDocument,
                                        QDomElement &layerElement,
                                        const QgsMapSettings &mapSettings,
                                        QgsRenderContext &renderContext,
                                        const QString &version,
-                                       QgsRectangle *featureBBox = nullptr,
-                                       QgsGeometry *filterGeom = nullptr ) const;
+                                       QgsRectangle *featureBBox = nullptr ) const;
 
       //! Appends feature info xml for the layer to the layer element of the dom document
       bool featureInfoFromRasterLayer( QgsRasterLayer *layer,
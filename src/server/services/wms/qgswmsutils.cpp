@@ -19,6 +19,8 @@
  *                                                                         *
  ***************************************************************************/
 
+#include <QCache>
+#include <QMutex>
 #include <QRegularExpression>
 
 #include "qgsmodule.h"
@@ -29,6 +31,44 @@
 
 namespace QgsWms
 {
+  namespace
+  {
+    // Palettes of the tiled 8 bit PNG images, by layers and styles
+    const int PALETTE_CACHE_SIZE = 256;
+
+    // Maximum mean and per color distance of the pixels of an image
+    // to a cached palette for the palette to be reused
+    const double PALETTE_MEAN_DISTANCE = 4.0;
+    const int PALETTE_MAX_DISTANCE = 48;
+
+    QMutex sPaletteMutex;
+    QCache<QString, QVector<QRgb> > sPalettes( PALETTE_CACHE_SIZE );
+
+    QVector<QRgb> colorTable( const QImage &img, const QString &paletteKey )
+    {
+      QVector<QRgb> colorTable;
+      if ( !paletteKey.isEmpty() )
+      {
+        {
+          QMutexLocker locker( &sPaletteMutex );
+          if ( QVector<QRgb> *palette = sPalettes.object( paletteKey ) )
+            colorTable = *palette;
+        }
+        if ( colorTableFits( colorTable, img, PALETTE_MEAN_DISTANCE, PALETTE_MAX_DISTANCE ) )
+          return colorTable;
+      }
+
+      medianCut( colorTable, 256, img );
+
+      if ( !paletteKey.isEmpty() )
+      {
+        QMutexLocker locker( &sPaletteMutex );
+        sPalettes.insert( paletteKey, new QVector<QRgb>( colorTable ) );
+      }
+      return colorTable;
+    }
+  }
+
   QUrl serviceUrl( const QgsServerRequest &request, const QgsProject *project )
   {
     QUrl href;
@@ -100,7 +140,7 @@ namespace QgsWms
 
   // Write image response
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality )
+                   int imageQuality, const QString &paletteKey )
   {
     ImageOutputFormat outputFormat = parseImageFormat( formatStr );
     QImage  result;
@@ -115,16 +155,11 @@ namespace QgsWms
         break;
       case PNG8:
       {
-        QVector<QRgb> colorTable;
-
         // Rendering is made with the format QImage::Format_ARGB32_Premultiplied
         // So we need to convert it in QImage::Format_ARGB32 in order to properly build
         // the color table.
         QImage img256 = img.convertToFormat( QImage::Format_ARGB32 );
-        medianCut( colorTable, 256, img256 );
-        result = img256.convertToFormat( QImage::Format_Indexed8, colorTable,
-                                         Qt::ColorOnly | Qt::ThresholdDither |
-                                         Qt::ThresholdAlphaDither | Qt::NoOpaqueDetection );
+        result = indexedImage( img256, colorTable( img256, paletteKey ) );
       }
       contentType = "image/png";
       saveFormat = "PNG";
@@ -59,9 +59,13 @@ namespace QgsWms
 
   /**
    * Write image response
+   *
+   * With 8 bit PNG output, the palette computed for the image is cached
+   * under \a paletteKey when it is not empty and reused for the next images
+   * written with the same key as long as it fits their colors (since QGIS 3.10).
    */
   void writeImage( QgsServerResponse &response, QImage &img, const QString &formatStr,
-                   int imageQuality = -1 );
+                   int imageQuality = -1, const QString &paletteKey = QString() );
 } // namespace QgsWms
 
 #endif
@@ -17,12 +17,257 @@
 #include "qgswmtsutils.h"
 #include "qgswmtsparameters.h"
 #include "qgswmtsgettile.h"
+#include "qgswmtstilecache.h"
+#include "qgsbufferserverrequest.h"
+#include "qgsbufferserverresponse.h"
+#include "qgsserverprojectutils.h"
+#include "qgsserverresponsecache.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectortileencoder.h"
 
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+#include "qgsfilterrestorer.h"
+#endif
+
+#include <QBuffer>
 #include <QImage>
 
+#include <algorithm>
+
 namespace QgsWmts
 {
 
+  namespace
+  {
+
+    QString tileContentType( const QgsWmtsParameters &params )
+    {
+      switch ( params.format() )
+      {
+        case QgsWmtsParameters::Format::JPG:
+          return QStringLiteral( "image/jpeg" );
+        case QgsWmtsParameters::Format::MVT:
+          return QgsVectorTileEncoder::mimeType();
+        default:
+          break;
+      }
+      return QStringLiteral( "image/png" );
+    }
+
+    // Key of a tile in the built-in cache, the version of the project when
+    // it was read and the access control rules are part of the key
+    QString tileCacheKey( const QgsProject *project, const tileRequestDef &tile, int col, int row,
+                          const QStringList &accessControlKey )
+    {
+      QStringList key;
+      key << project->fileName()
+          << QgsServerResponseCache::projectVersion( project ).toString( Qt::ISODateWithMs )
+          << tile.layer
+          << tile.format
+          << tile.tms.ref
+          << QString::number( tile.tileMatrix )
+          << QString::number( row )
+          << QString::number( col )
+          << accessControlKey;
+      return key.join( '|' );
+    }
+
+    // Most conservative of the project and server maximum WMS image sizes, -1 if none
+    int maxImageSize( int projectMax, int settingsMax )
+    {
+      if ( projectMax != -1 && settingsMax != -1 )
+        return std::min( projectMax, settingsMax );
+      return std::max( projectMax, settingsMax );
+    }
+
+    int wmsMaxWidth( const QgsProject *project, const QgsServerSettings &settings )
+    {
+      return maxImageSize( QgsServerProjectUtils::wmsMaxWidth( *project ), settings.wmsMaxWidth() );
+    }
+
+    int wmsMaxHeight( const QgsProject *project, const QgsServerSettings &settings )
+    {
+      return maxImageSize( QgsServerProjectUtils::wmsMaxHeight( *project ), settings.wmsMaxHeight() );
+    }
+
+    // Renders the metatile containing the requested tile with a single
+    // WMS GetMap request, stores its tiles in the cache and writes the
+    // requested one to the response
+    void writeMetatile( QgsServerInterface *serverIface, const QgsProject *project,
+                        const QgsWmtsParameters &params, const tileRequestDef &tile,
+                        QgsWmtsTileCache *tileCache, const QStringList &accessControlKey,
+                        QgsServerResponse &response )
+    {
+      const QgsServerSettings *settings = serverIface->serverSettings();
+      const int metatileSize = std::max( 1, settings->wmtsMetatileSize() );
+      int buffer = std::max( 0, settings->wmtsMetatileBuffer() );
+      const tileMatrixDef tm = tile.tms.tileMatrixList.at( tile.tileMatrix );
+
+      // The GetMap request must fit in the maximum WMS image size, the metatile
+      // and then its buffer are reduced if needed
+      int metatileCols = metatileSize;
+      int metatileRows = metatileSize;
+      const int maxWidth = wmsMaxWidth( project, *settings );
+      const int maxHeight = wmsMaxHeight( project, *settings );
+      if ( maxWidth > 0 )
+      {
+        metatileCols = std::max( 1, std::min( metatileCols, ( maxWidth - 2 * buffer ) / TILE_SIZE ) );
+        buffer = std::max( 0, std::min( buffer, ( maxWidth - metatileCols * TILE_SIZE ) / 2 ) );
+      }
+      if ( maxHeight > 0 )
+      {
+        metatileRows = std::max( 1, std::min( metatileRows, ( maxHeight - 2 * buffer ) / TILE_SIZE ) );
+        buffer = std::max( 0, std::min( buffer, ( maxHeight - metatileRows * TILE_SIZE ) / 2 ) );
+      }
+
+      const int col0 = ( tile.col / metatileCols ) * metatileCols;
+      const int row0 = ( tile.row / metatileRows ) * metatileRows;
+      const int cols = std::min( metatileCols, tm.col - col0 );
+      const int rows = std::min( metatileRows, tm.row - row0 );
+
+      // Always render a lossless image, tiles are encoded after slicing
+      QUrlQuery query = tilesWmsQueryItem( QStringLiteral( "GetMap" ), params, tile, col0, row0, cols, rows, buffer );
+      query.removeAllQueryItems( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT ) );
+      query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT ), QStringLiteral( "image/png" ) );
+
+      QgsServerParameters wmsParams( query );
+      QgsBufferServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
+      QgsBufferServerResponse wmsResponse;
+      QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
+      service->executeRequest( wmsRequest, wmsResponse, project );
+
+      const QByteArray wmsContent = wmsResponse.body() + wmsResponse.data();
+      QImage metatile;
+      if ( !wmsResponse.header( QStringLiteral( "Content-Type" ) ).startsWith( QStringLiteral( "image/" ) )
+           || !metatile.loadFromData( wmsContent, "PNG" ) )
+      {
+        // Forward the service exception
+        const QMap<QString, QString> headers = wmsResponse.headers();
+        for ( auto it = headers.constBegin(); it != headers.constEnd(); ++it )
+        {
+          response.setHeader( it.key(), it.value() );
+        }
+        if ( wmsResponse.statusCode() > 0 )
+        {
+          response.setStatusCode( wmsResponse.statusCode() );
+        }
+        response.write( wmsContent );
+        return;
+      }
+
+      const bool jpeg = params.format() == QgsWmtsParameters::Format::JPG;
+      const char *saveFormat = jpeg ? "JPEG" : "PNG";
+      const int quality = jpeg ? QgsServerProjectUtils::wmsImageQuality( *project ) : -1;
+
+      QByteArray requestedTile;
+      for ( int row = row0; row < row0 + rows; ++row )
+      {
+        for ( int col = col0; col < col0 + cols; ++col )
+        {
+          if ( !tileCache && ( row != tile.row || col != tile.col ) )
+            continue;
+
+          QImage image = metatile.copy( buffer + ( col - col0 ) * TILE_SIZE, buffer + ( row - row0 ) * TILE_SIZE, TILE_SIZE, TILE_SIZE );
+          if ( jpeg )
+          {
+            image = image.convertToFormat( QImage::Format_RGB32 );
+          }
+
+          QByteArray content;
+          QBuffer contentBuffer( &content );
+          contentBuffer.open( QIODevice::WriteOnly );
+          image.save( &contentBuffer, saveFormat, quality );
+
+          if ( tileCache )
+          {
+            tileCache->setTile( tileCacheKey( project, tile, col, row, accessControlKey ), content );
+          }
+          if ( row == tile.row && col == tile.col )
+          {
+            requestedTile = content;
+          }
+        }
+      }
+
+      response.setHeader( QStringLiteral( "Content-Type" ), tileContentType( params ) );
+      response.write( requestedTile );
+    }
+
+
+    // Encodes the features of the vector layers of the requested tile
+    // to a Mapbox Vector Tile, no WMS request is needed
+    void writeVectorTile( QgsServerInterface *serverIface, const QgsProject *project,
+                          const tileRequestDef &tile, QgsWmtsTileCache *tileCache,
+                          const QStringList &accessControlKey, QgsServerResponse &response )
+    {
+      const tileMatrixDef tm = tile.tms.tileMatrixList.at( tile.tileMatrix );
+      const double tileSize = tm.resolution * TILE_SIZE;
+      const double xMin = tm.left + tile.col * tileSize;
+      const double yMax = tm.top - tile.row * tileSize;
+
+      QgsVectorTileEncoder encoder( QgsRectangle( xMin, yMax - tileSize, xMin + tileSize, yMax ),
+                                    QgsCoordinateReferenceSystem::fromOgcWmsCrs( tile.tms.ref ) );
+      encoder.setTransformContext( project->transformContext() );
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+      QgsAccessControl *accessControl = serverIface->accessControls();
+      // Restores the original layer filters (subsetStrings) when going out of scope
+      QgsOWSServerFilterRestorer filterRestorer;
+#else
+      ( void )serverIface;
+#endif
+
+      for ( QgsVectorLayer *layer : wmtsVectorLayers( project, tile.layer ) )
+      {
+        if ( layer->hasScaleBasedVisibility() && !layer->isInScaleRange( tm.scaleDenominator ) )
+          continue;
+
+        QStringList attributes;
+        for ( const QgsField &field : layer->fields() )
+        {
+          if ( !layer->excludeAttributesWms().contains( field.name() ) )
+            attributes << field.name();
+        }
+
+        QgsFeatureRequest request;
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+        if ( accessControl )
+        {
+          if ( !accessControl->layerReadPermission( layer ) )
+            continue;
+          QgsOWSServerFilterRestorer::applyAccessControlLayerFilters( accessControl, layer, filterRestorer.originalFilters() );
+          accessControl->filterFeatures( layer, request );
+          attributes = accessControl->layerAttributes( layer, attributes );
+        }
+#endif
+        request.setSubsetOfAttributes( attributes, layer->fields() );
+
+        // Only the published attributes are written to the tile, whatever
+        // the provider fetches
+        QgsAttributeList attributeIndexes;
+        for ( const QString &attribute : qgis::as_const( attributes ) )
+        {
+          const int index = layer->fields().lookupField( attribute );
+          if ( index >= 0 )
+            attributeIndexes << index;
+        }
+
+        const QString name = layer->shortName().isEmpty() ? layer->name() : layer->shortName();
+        encoder.addLayer( layer, attributeIndexes, request, name );
+      }
+
+      const QByteArray content = encoder.encode();
+      if ( tileCache && !content.isEmpty() )
+      {
+        tileCache->setTile( tileCacheKey( project, tile, tile.col, tile.row, accessControlKey ), content );
+      }
+
+      response.setHeader( QStringLiteral( "Content-Type" ), QgsVectorTileEncoder::mimeType() );
+      response.write( content );
+    }
+
+  }
+
   void writeGetTile( QgsServerInterface *serverIface, const QgsProject *project,
                      const QString &version, const QgsServerRequest &request,
                      QgsServerResponse &response )
@@ -31,7 +276,8 @@ namespace QgsWmts
     const QgsWmtsParameters params( QUrlQuery( request.url() ) );
 
     // WMS query
-    QUrlQuery query = translateWmtsParamToWmsQueryItem( QStringLiteral( "GetMap" ), params, project, serverIface );
+    const tileRequestDef tile = parseTileRequest( params, project, serverIface );
+    QUrlQuery query = tilesWmsQueryItem( QStringLiteral( "GetMap" ), params, tile, tile.col, tile.row, 1, 1 );
 
     // Get cached image
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
@@ -66,10 +312,51 @@ namespace QgsWmts
     }
 #endif
 
-    QgsServerParameters wmsParams( query );
-    QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
-    QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
-    service->executeRequest( wmsRequest, response, project );
+    // Built-in tile cache, unusable if access control rules cannot be cached
+    const QgsServerSettings *settings = serverIface->serverSettings();
+    QgsWmtsTileCache *tileCache = QgsWmtsTileCache::instance( *settings );
+    QStringList accessControlKey;
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    if ( tileCache && serverIface->accessControls() && !serverIface->accessControls()->fillCacheKey( accessControlKey ) )
+    {
+      tileCache = nullptr;
+    }
+#endif
+
+    if ( tileCache )
+    {
+      const QByteArray content = tileCache->tile( tileCacheKey( project, tile, tile.col, tile.row, accessControlKey ) );
+      if ( !content.isEmpty() )
+      {
+        response.setHeader( QStringLiteral( "Content-Type" ), tileContentType( params ) );
+        response.write( content );
+        return;
+      }
+    }
+
+    if ( params.format() == QgsWmtsParameters::Format::MVT )
+    {
+      writeVectorTile( serverIface, project, tile, tileCache, accessControlKey, response );
+      return;
+    }
+
+    // The other tiles of a metatile are only rendered to be cached
+    if ( tileCache && settings->wmtsMetatileSize() > 1 )
+    {
+      writeMetatile( serverIface, project, params, tile, tileCache, accessControlKey, response );
+    }
+    else
+    {
+      QgsServerParameters wmsParams( query );
+      QgsServerRequest wmsRequest( "?" + query.query( QUrl::FullyDecoded ) );
+      QgsService *service = serverIface->serviceRegistry()->getService( wmsParams.service(), wmsParams.version() );
+      service->executeRequest( wmsRequest, response, project );
+
+      if ( tileCache && response.header( QStringLiteral( "Content-Type" ) ).startsWith( QStringLiteral( "image/" ) ) )
+      {
+        tileCache->setTile( tileCacheKey( project, tile, tile.col, tile.row, accessControlKey ), response.data() );
+      }
+    }
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
     if ( cacheManager )
     {
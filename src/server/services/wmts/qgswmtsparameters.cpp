@@ -191,6 +191,10 @@ namespace QgsWmts
          || fStr.compare( QLatin1String( "jpeg" ), Qt::CaseInsensitive ) == 0
          || fStr.compare( QLatin1String( "image/jpeg" ), Qt::CaseInsensitive ) == 0 )
       f = Format::JPG;
+    else if ( fStr.compare( QLatin1String( "mvt" ), Qt::CaseInsensitive ) == 0
+              || fStr.compare( QLatin1String( "pbf" ), Qt::CaseInsensitive ) == 0
+              || fStr.compare( QLatin1String( "application/vnd.mapbox-vector-tile" ), Qt::CaseInsensitive ) == 0 )
+      f = Format::MVT;
 
     return f;
   }
@@ -162,7 +162,8 @@ namespace QgsWmts
         TEXT,
         XML,
         HTML,
-        GML
+        GML,
+        MVT
       };
 
       /**
@@ -0,0 +1,214 @@
+/***************************************************************************
+                              qgswmtstilecache.cpp
+                            -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgswmtstilecache.h"
+#include "qgsserversettings.h"
+#include "qgsmessagelog.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <memory>
+
+namespace QgsWmts
+{
+
+  namespace
+  {
+    // Share of the maximum directory size kept when it is pruned
+    const double PRUNE_RATIO = 0.8;
+  }
+
+  QgsWmtsTileCache::QgsWmtsTileCache( const QString &directory, qint64 memorySize, qint64 diskSize, int maxAge )
+    : mDirectory( directory )
+    , mDiskSize( diskSize )
+    , mMaxAge( maxAge )
+  {
+    // QCache costs are int, count kilobytes
+    mMemoryCache.setMaxCost( static_cast<int>( std::min<qint64>( memorySize / 1024, std::numeric_limits<int>::max() ) ) );
+  }
+
+  QgsWmtsTileCache *QgsWmtsTileCache::instance( const QgsServerSettings &settings )
+  {
+    const QString directory = settings.wmtsCacheDirectory();
+    const qint64 memorySize = settings.wmtsCacheSize();
+    if ( directory.isEmpty() && memorySize <= 0 )
+      return nullptr;
+    const qint64 diskSize = std::max<qint64>( 0, settings.wmtsCacheDiskSize() );
+    const int maxAge = std::max( 0, settings.wmtsCacheMaxAge() );
+
+    // One cache per configuration, settings may be reloaded at runtime
+    static QMutex sMutex;
+    static std::map< QString, std::unique_ptr< QgsWmtsTileCache > > sCaches;
+
+    const QString configuration = QStringLiteral( "%1|%2|%3|%4" ).arg( directory ).arg( memorySize ).arg( diskSize ).arg( maxAge );
+    QMutexLocker locker( &sMutex );
+    std::unique_ptr< QgsWmtsTileCache > &cache = sCaches[ configuration ];
+    if ( !cache )
+      cache.reset( new QgsWmtsTileCache( directory, memorySize, diskSize, maxAge ) );
+    return cache.get();
+  }
+
+  QByteArray QgsWmtsTileCache::tile( const QString &key )
+  {
+    {
+      QMutexLocker locker( &mMutex );
+      if ( Tile *tile = mMemoryCache.object( key ) )
+      {
+        if ( !isExpired( tile->created ) )
+          return tile->content;
+        mMemoryCache.remove( key );
+      }
+    }
+
+    if ( mDirectory.isEmpty() )
+      return QByteArray();
+
+    const QString path = filePath( key );
+    const QDateTime created = QFileInfo( path ).lastModified();
+    if ( !created.isValid() )
+      return QByteArray();
+    if ( isExpired( created ) )
+    {
+      // Another process may remove it at the same time
+      QFile::remove( path );
+      return QByteArray();
+    }
+
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+      return QByteArray();
+
+    const QByteArray content = file.readAll();
+    if ( !content.isEmpty() && mMemoryCache.maxCost() > 0 )
+    {
+      QMutexLocker locker( &mMutex );
+      mMemoryCache.insert( key, new Tile { content, created }, content.size() / 1024 + 1 );
+    }
+    return content;
+  }
+
+  void QgsWmtsTileCache::setTile( const QString &key, const QByteArray &content )
+  {
+    if ( content.isEmpty() )
+      return;
+
+    if ( mMemoryCache.maxCost() > 0 )
+    {
+      QMutexLocker locker( &mMutex );
+      mMemoryCache.insert( key, new Tile { content, QDateTime::currentDateTime() }, content.size() / 1024 + 1 );
+    }
+
+    if ( mDirectory.isEmpty() )
+      return;
+
+    // Several processes may write the same tile, QSaveFile replaces
+    // the file atomically so that readers never get a partial tile
+    const QString path = filePath( key );
+    if ( !QDir().mkpath( QFileInfo( path ).absolutePath() ) )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "WMTS: cannot create cache directory for %1" ).arg( path ), QStringLiteral( "Server" ), Qgis::Warning );
+      return;
+    }
+    QSaveFile file( path );
+    if ( !file.open( QIODevice::WriteOnly ) || file.write( content ) != content.size() || !file.commit() )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "WMTS: cannot write cached tile %1" ).arg( path ), QStringLiteral( "Server" ), Qgis::Warning );
+      return;
+    }
+
+    if ( mDiskSize <= 0 && mMaxAge <= 0 )
+      return;
+
+    // A single thread prunes the directory at a time, the others keep serving tiles
+    {
+      QMutexLocker locker( &mMutex );
+      if ( mDiskUsage >= 0 )
+        mDiskUsage += content.size();
+      const bool oversized = mDiskSize > 0 && ( mDiskUsage < 0 || mDiskUsage > mDiskSize );
+      const bool outdated = mMaxAge > 0 && ( !mLastPrune.isValid() || mLastPrune.secsTo( QDateTime::currentDateTime() ) > mMaxAge );
+      if ( mPruning || ( !oversized && !outdated ) )
+        return;
+      mPruning = true;
+    }
+
+    const qint64 usage = pruneDirectory();
+
+    QMutexLocker locker( &mMutex );
+    mDiskUsage = usage;
+    mLastPrune = QDateTime::currentDateTime();
+    mPruning = false;
+  }
+
+  bool QgsWmtsTileCache::isExpired( const QDateTime &created ) const
+  {
+    return mMaxAge > 0 && created.secsTo( QDateTime::currentDateTime() ) > mMaxAge;
+  }
+
+  qint64 QgsWmtsTileCache::pruneDirectory() const
+  {
+    // The directory may be shared with other processes, its content is listed
+    // again instead of relying on what this process wrote
+    QList<QFileInfo> files;
+    qint64 usage = 0;
+    QDirIterator it( mDirectory, QStringList() << QStringLiteral( "*.tile" ), QDir::Files, QDirIterator::Subdirectories );
+    while ( it.hasNext() )
+    {
+      it.next();
+      const QFileInfo fileInfo = it.fileInfo();
+      if ( isExpired( fileInfo.lastModified() ) )
+      {
+        QFile::remove( fileInfo.absoluteFilePath() );
+        continue;
+      }
+      files << fileInfo;
+      usage += fileInfo.size();
+    }
+
+    if ( mDiskSize > 0 && usage > mDiskSize )
+    {
+      // Oldest tiles first
+      std::sort( files.begin(), files.end(), []( const QFileInfo & f1, const QFileInfo & f2 )
+      {
+        return f1.lastModified() < f2.lastModified();
+      } );
+
+      const qint64 target = static_cast<qint64>( mDiskSize * PRUNE_RATIO );
+      for ( const QFileInfo &fileInfo : qgis::as_const( files ) )
+      {
+        if ( usage <= target )
+          break;
+        if ( QFile::remove( fileInfo.absoluteFilePath() ) )
+          usage -= fileInfo.size();
+      }
+    }
+    return usage;
+  }
+
+  QString QgsWmtsTileCache::filePath( const QString &key ) const
+  {
+    // Spread the tiles in sub-directories to keep them small
+    const QString hash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+    return QStringLiteral( "%1/%2/%3.tile" ).arg( mDirectory, hash.left( 2 ), hash.mid( 2 ) );
+  }
+
+} // namespace QgsWmts
@@ -0,0 +1,105 @@
+/***************************************************************************
+                              qgswmtstilecache.h
+                            -------------------------
+  begin                : September 2019
+  copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSWMTSTILECACHE_H
+#define QGSWMTSTILECACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QDateTime>
+#include <QMutex>
+#include <QString>
+
+class QgsServerSettings;
+
+namespace QgsWmts
+{
+
+  /**
+   * \ingroup server
+   * Built-in cache of the encoded WMTS tiles.
+   *
+   * Tiles are kept in memory by each server process and can also be stored
+   * in a directory shared by all the server processes. The oldest tiles are
+   * removed from the directory when it exceeds its maximum size, and tiles
+   * older than the maximum age are rendered again. The cache is thread safe.
+   * \since QGIS 3.10
+   */
+  class QgsWmtsTileCache
+  {
+    public:
+
+      /**
+       * Constructor for QgsWmtsTileCache.
+       * \param directory the directory of the disk cache, empty to disable it
+       * \param memorySize the size in bytes of the in-memory cache, 0 to disable it
+       * \param diskSize the maximum size in bytes of the directory, 0 for no limit
+       * \param maxAge the maximum age in seconds of the tiles, 0 for no limit
+       */
+      QgsWmtsTileCache( const QString &directory, qint64 memorySize, qint64 diskSize = 0, int maxAge = 0 );
+
+      /**
+       * Returns the cache configured by the server \a settings, or NULLPTR
+       * if the tile cache is disabled.
+       */
+      static QgsWmtsTileCache *instance( const QgsServerSettings &settings );
+
+      /**
+       * Returns the content of the tile stored for \a key, or an empty
+       * array if the tile is not cached.
+       */
+      QByteArray tile( const QString &key );
+
+      /**
+       * Stores the \a content of the tile for \a key.
+       */
+      void setTile( const QString &key, const QByteArray &content );
+
+    private:
+      //! A tile kept in memory
+      struct Tile
+      {
+        QByteArray content;
+        QDateTime created;
+      };
+
+      QString filePath( const QString &key ) const;
+
+      //! Returns TRUE if a tile created at \a created is too old to be served
+      bool isExpired( const QDateTime &created ) const;
+
+      /**
+       * Removes the expired tiles from the directory, then the oldest ones
+       * until its size is below the maximum size. The directory is scanned
+       * without holding the cache lock.
+       * \returns the size of the directory
+       */
+      qint64 pruneDirectory() const;
+
+      QMutex mMutex;
+      QCache<QString, Tile> mMemoryCache;
+      QString mDirectory;
+      qint64 mDiskSize = 0;
+      int mMaxAge = 0;
+
+      //! Size of the directory, -1 if unknown
+      qint64 mDiskUsage = -1;
+      QDateTime mLastPrune;
+      bool mPruning = false;
+  };
+
+} // namespace QgsWmts
+
+#endif
@@ -24,6 +24,8 @@
 #include "qgscoordinatereferencesystem.h"
 #include "qgslayertree.h"
 #include "qgssettings.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectortileencoder.h"
 
 
 namespace QgsWmts
@@ -35,7 +37,7 @@ namespace QgsWmts
     QgsCoordinateReferenceSystem wgs84 = QgsCoordinateReferenceSystem::fromOgcWmsCrs( GEO_EPSG_CRS_AUTHID );
 
     // Constant
-    int tileSize = 256;
+    int tileSize = TILE_SIZE;
     double POINTS_TO_M = 2.83464567 / 10000.0;
 
     QMap< QString, tileMatrixInfo> fixedTileMatrixInfoMap = populateFixedTileMatrixInfoMap();
@@ -415,6 +417,9 @@ namespace QgsWmts
       bool wmtsJpegProject = project->readBoolEntry( QStringLiteral( "WMTSJpegLayers" ), QStringLiteral( "Project" ) );
       if ( wmtsJpegProject )
         pLayer.formats << QStringLiteral( "image/jpeg" );
+      bool wmtsMvtProject = project->readBoolEntry( QStringLiteral( "WMTSMvtLayers" ), QStringLiteral( "Project" ) );
+      if ( wmtsMvtProject )
+        pLayer.formats << QgsVectorTileEncoder::mimeType();
 
       // Project is not queryable in WMS
       //pLayer.queryable = ( nonIdentifiableLayers.count() != project->count() );
@@ -430,6 +435,7 @@ namespace QgsWmts
 
       QStringList wmtsPngGroupNameList = project->readListEntry( QStringLiteral( "WMTSPngLayers" ), QStringLiteral( "Group" ) );
       QStringList wmtsJpegGroupNameList = project->readListEntry( QStringLiteral( "WMTSJpegLayers" ), QStringLiteral( "Group" ) );
+      QStringList wmtsMvtGroupNameList = project->readListEntry( QStringLiteral( "WMTSMvtLayers" ), QStringLiteral( "Group" ) );
 
       for ( const QString &gName : wmtsGroupNameList )
       {
@@ -501,6 +507,8 @@ namespace QgsWmts
           pLayer.formats << QStringLiteral( "image/png" );
         if ( wmtsJpegGroupNameList.contains( gName ) )
           pLayer.formats << QStringLiteral( "image/jpeg" );
+        if ( wmtsMvtGroupNameList.contains( gName ) )
+          pLayer.formats << QgsVectorTileEncoder::mimeType();
 
         wmtsLayers.append( pLayer );
       }
@@ -509,6 +517,7 @@ namespace QgsWmts
     QStringList wmtsLayerIdList = project->readListEntry( QStringLiteral( "WMTSLayers" ), QStringLiteral( "Layer" ) );
     QStringList wmtsPngLayerIdList = project->readListEntry( QStringLiteral( "WMTSPngLayers" ), QStringLiteral( "Layer" ) );
     QStringList wmtsJpegLayerIdList = project->readListEntry( QStringLiteral( "WMTSJpegLayers" ), QStringLiteral( "Layer" ) );
+    QStringList wmtsMvtLayerIdList = project->readListEntry( QStringLiteral( "WMTSMvtLayers" ), QStringLiteral( "Layer" ) );
 
     for ( const QString &lId : wmtsLayerIdList )
     {
@@ -550,6 +559,8 @@ namespace QgsWmts
         pLayer.formats << QStringLiteral( "image/png" );
       if ( wmtsJpegLayerIdList.contains( lId ) )
         pLayer.formats << QStringLiteral( "image/jpeg" );
+      if ( wmtsMvtLayerIdList.contains( lId ) && l->type() == QgsMapLayerType::VectorLayer )
+        pLayer.formats << QgsVectorTileEncoder::mimeType();
 
       pLayer.queryable = ( l->flags().testFlag( QgsMapLayer::Identifiable ) );
 
@@ -625,6 +636,12 @@ namespace QgsWmts
   QUrlQuery translateWmtsParamToWmsQueryItem( const QString &request, const QgsWmtsParameters &params,
       const QgsProject *project, QgsServerInterface *serverIface )
   {
+    const tileRequestDef tile = parseTileRequest( params, project, serverIface );
+    return tilesWmsQueryItem( request, params, tile, tile.col, tile.row, 1, 1 );
+  }
+
+  tileRequestDef parseTileRequest( const QgsWmtsParameters &params, const QgsProject *project, QgsServerInterface *serverIface )
+  {
 #ifndef HAVE_SERVER_PYTHON_PLUGINS
     ( void )serverIface;
 #endif
@@ -757,11 +774,27 @@ namespace QgsWmts
       throw QgsRequestNotWellFormedException( QStringLiteral( "TileCol is unknown" ) );
     }
 
+    tileRequestDef tile;
+    tile.layer = layer;
+    tile.format = format;
+    tile.tms = tms;
+    tile.tileMatrix = tm_idx;
+    tile.row = tr;
+    tile.col = tc;
+    return tile;
+  }
+
+  QUrlQuery tilesWmsQueryItem( const QString &request, const QgsWmtsParameters &params, const tileRequestDef &tile,
+                               int col, int row, int cols, int rows, int buffer )
+  {
+    const tileMatrixSetDef &tms = tile.tms;
+    const tileMatrixDef tm = tms.tileMatrixList.at( tile.tileMatrix );
+
     double res = tm.resolution;
-    double minx = tm.left + tc * ( tileSize * res );
-    double miny = tm.top - ( tr + 1 ) * ( tileSize * res );
-    double maxx = tm.left + ( tc + 1 ) * ( tileSize * res );
-    double maxy = tm.top - tr * ( tileSize * res );
+    double minx = tm.left + col * ( tileSize * res ) - buffer * res;
+    double miny = tm.top - ( row + rows ) * ( tileSize * res ) - buffer * res;
+    double maxx = tm.left + ( col + cols ) * ( tileSize * res ) + buffer * res;
+    double maxy = tm.top - row * ( tileSize * res ) + buffer * res;
     QString bbox;
     if ( tms.hasAxisInverted )
     {
@@ -786,13 +819,13 @@ namespace QgsWmts
     query.addQueryItem( QgsServerParameter::name( QgsServerParameter::SERVICE ), QStringLiteral( "WMS" ) );
     query.addQueryItem( QgsServerParameter::name( QgsServerParameter::VERSION_SERVICE ), QStringLiteral( "1.3.0" ) );
     query.addQueryItem( QgsServerParameter::name( QgsServerParameter::REQUEST ), request );
-    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::LAYERS ), layer );
+    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::LAYERS ), tile.layer );
     query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::STYLES ), QString() );
     query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::CRS ), tms.ref );
     query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::BBOX ), bbox );
-    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::WIDTH ), QStringLiteral( "256" ) );
-    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::HEIGHT ), QStringLiteral( "256" ) );
-    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT ), format );
+    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::WIDTH ), QString::number( cols * tileSize + 2 * buffer ) );
+    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::HEIGHT ), QString::number( rows * tileSize + 2 * buffer ) );
+    query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::FORMAT ), tile.format );
     if ( params.format() == QgsWmtsParameters::Format::PNG )
     {
       query.addQueryItem( QgsWmsParameterForWmts::name( QgsWmsParameterForWmts::TRANSPARENT ), QStringLiteral( "true" ) );
@@ -802,6 +835,74 @@ namespace QgsWmts
     return query;
   }
 
+  QList<QgsVectorLayer *> wmtsVectorLayers( const QgsProject *project, const QString &layerId )
+  {
+    QList<QgsMapLayer *> layers;
+
+    QString rootLayerId = QgsServerProjectUtils::wmsRootName( *project );
+    if ( rootLayerId.isEmpty() )
+    {
+      rootLayerId = project->title();
+    }
+
+    if ( project->readBoolEntry( QStringLiteral( "WMTSLayers" ), QStringLiteral( "Project" ) ) && layerId == rootLayerId )
+    {
+      if ( !project->readBoolEntry( QStringLiteral( "WMTSMvtLayers" ), QStringLiteral( "Project" ) ) )
+        return QList<QgsVectorLayer *>();
+
+      const QStringList restrictedLayers = QgsServerProjectUtils::wmsRestrictedLayers( *project );
+      for ( QgsLayerTreeLayer *treeLayer : project->layerTreeRoot()->findLayers() )
+      {
+        if ( treeLayer->layer() && !restrictedLayers.contains( treeLayer->layer()->name() ) )
+          layers << treeLayer->layer();
+      }
+    }
+    else
+    {
+      const QStringList wmtsGroupNameList = project->readListEntry( QStringLiteral( "WMTSLayers" ), QStringLiteral( "Group" ) );
+      const QStringList wmtsMvtGroupNameList = project->readListEntry( QStringLiteral( "WMTSMvtLayers" ), QStringLiteral( "Group" ) );
+      for ( const QString &gName : wmtsGroupNameList )
+      {
+        QgsLayerTreeGroup *treeGroup = project->layerTreeRoot()->findGroup( gName );
+        if ( !treeGroup || !wmtsMvtGroupNameList.contains( gName ) )
+          continue;
+
+        QString groupLayerId = treeGroup->customProperty( QStringLiteral( "wmsShortName" ) ).toString();
+        if ( groupLayerId.isEmpty() )
+          groupLayerId = gName;
+        if ( groupLayerId != layerId )
+          continue;
+
+        for ( QgsLayerTreeLayer *treeLayer : treeGroup->findLayers() )
+        {
+          if ( treeLayer->layer() )
+            layers << treeLayer->layer();
+        }
+        break;
+      }
+
+      const QStringList wmtsLayerIdList = project->readListEntry( QStringLiteral( "WMTSLayers" ), QStringLiteral( "Layer" ) );
+      const QStringList wmtsMvtLayerIdList = project->readListEntry( QStringLiteral( "WMTSMvtLayers" ), QStringLiteral( "Layer" ) );
+      for ( const QString &lId : wmtsLayerIdList )
+      {
+        QgsMapLayer *l = wmtsMvtLayerIdList.contains( lId ) ? project->mapLayer( lId ) : nullptr;
+        if ( l && layers.isEmpty() && ( l->shortName().isEmpty() ? l->name() : l->shortName() ) == layerId )
+          layers << l;
+      }
+    }
+
+    QList<QgsVectorLayer *> vectorLayers;
+    for ( QgsMapLayer *layer : qgis::as_const( layers ) )
+    {
+      if ( QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( layer ) )
+      {
+        if ( vl->isSpatial() )
+          vectorLayers << vl;
+      }
+    }
+    return vectorLayers;
+  }
+
   namespace
   {
 
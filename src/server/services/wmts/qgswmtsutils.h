@@ -25,6 +25,8 @@
 
 #include <QDomDocument>
 
+class QgsVectorLayer;
+
 /**
  * \ingroup server
  * WMTS implementation
@@ -98,6 +100,21 @@ namespace QgsWmts
     QMap< int, tileMatrixLimitDef > tileMatrixLimits;
   };
 
+  struct tileRequestDef
+  {
+    QString layer;
+
+    QString format;
+
+    tileMatrixSetDef tms;
+
+    int tileMatrix = 0;
+
+    int row = 0;
+
+    int col = 0;
+  };
+
   struct layerDef
   {
     QString id;
@@ -132,6 +149,9 @@ namespace QgsWmts
   const QString GML_NAMESPACE = QStringLiteral( "http://www.opengis.net/gml" );
   const QString OWS_NAMESPACE = QStringLiteral( "http://www.opengis.net/ows/1.1" );
 
+  //! Size in pixels of the tiles
+  const int TILE_SIZE = 256;
+
   tileMatrixInfo calculateTileMatrixInfo( const QString &crsStr, const QgsProject *project );
   tileMatrixSetDef calculateTileMatrixSet( tileMatrixInfo tmi, double minScale );
   double getProjectMinScale( const QgsProject *project );
@@ -146,6 +166,29 @@ namespace QgsWmts
   QUrlQuery translateWmtsParamToWmsQueryItem( const QString &request, const QgsWmtsParameters &params,
       const QgsProject *project, QgsServerInterface *serverIface );
 
+  /**
+   * Checks the WMTS parameters and returns the requested tile
+   * \since QGIS 3.10
+   */
+  tileRequestDef parseTileRequest( const QgsWmtsParameters &params, const QgsProject *project, QgsServerInterface *serverIface );
+
+  /**
+   * Translate a WMTS tile request to a WMS query item covering \a cols x \a rows
+   * tiles from \a col and \a row of the requested tile matrix, extended by
+   * \a buffer pixels on each side
+   * \since QGIS 3.10
+   */
+  QUrlQuery tilesWmsQueryItem( const QString &request, const QgsWmtsParameters &params, const tileRequestDef &tile,
+                               int col, int row, int cols, int rows, int buffer = 0 );
+
+  /**
+   * Returns the vector layers of the WMTS layer \a layerId, i.e. the layers
+   * of the project, of a group or a single layer. The list is empty if the
+   * WMTS layer is not published as vector tiles.
+   * \since QGIS 3.10
+   */
+  QList<QgsVectorLayer *> wmtsVectorLayers( const QgsProject *project, const QString &layerId );
+
 } // namespace QgsWmts
 
 #endif
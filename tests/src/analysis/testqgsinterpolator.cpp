@@ -15,8 +15,17 @@ Email                : nyall dot dawson at gmail dot com
 #include "qgstest.h"
 
 #include "qgsapplication.h"
+#include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsidwinterpolator.h"
+#include "qgsgridfilewriter.h"
 #include "DualEdgeTriangulation.h"
 
+#include <QMutex>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QThread>
+
 class TestQgsInterpolator : public QObject
 {
     Q_OBJECT
@@ -29,9 +38,40 @@ class TestQgsInterpolator : public QObject
     void init() ;// will be called before each testfunction is executed.
     void cleanup() ;// will be called after every testfunction.
     void dualEdge();
+    void locateTriangle();
+    void idwSearch();
+    void gridFileWriterThreads();
+
+  private:
+};
+
+///@cond PRIVATE
+//! Records the threads interpolating points, may declare itself thread safe
+class TestThreadsInterpolator : public QgsInterpolator
+{
+  public:
+    TestThreadsInterpolator( const QList<QgsInterpolator::LayerData> &layerData, bool threadSafe )
+      : QgsInterpolator( layerData )
+      , mThreadSafe( threadSafe )
+    {}
+
+    int interpolatePoint( double x, double, double &result, QgsFeedback * ) override
+    {
+      QMutexLocker locker( &mMutex );
+      threads << QThread::currentThread();
+      result = x;
+      return 0;
+    }
+
+    bool isThreadSafe() const override { return mThreadSafe; }
+
+    QSet< QThread * > threads;
 
   private:
+    bool mThreadSafe = false;
+    QMutex mMutex;
 };
+///@endcond
 
 void  TestQgsInterpolator::initTestCase()
 {
@@ -265,5 +305,134 @@ void TestQgsInterpolator::dualEdge()
 //  QVERIFY( tri.getSurroundingTriangles( 0 ).empty() );
 }
 
+void TestQgsInterpolator::locateTriangle()
+{
+  DualEdgeTriangulation tri;
+  tri.addPoint( QgsPoint( 1, 2, 3 ) );
+  tri.addPoint( QgsPoint( 3, 0, 4 ) );
+  tri.addPoint( QgsPoint( 4, 4, 5 ) );
+  tri.addPoint( QgsPoint( 2, 4, 6 ) );
+  tri.addPoint( QgsPoint( 2, 2, 7 ) );
+
+  int startEdge = -1;
+  int n1 = 0;
+  int n2 = 0;
+  int n3 = 0;
+  QVERIFY( !tri.locateTriangle( 2, 4.5, startEdge, n1, n2, n3 ) );
+  QVERIFY( !tri.locateTriangle( 1, 4, startEdge, n1, n2, n3 ) );
+  QCOMPARE( startEdge, -1 );
+
+  // must find the same triangles as getTriangle(), whatever the start edge
+  const QList< QgsPointXY > points = QList< QgsPointXY >() << QgsPointXY( 2, 3.5 ) << QgsPointXY( 2, 1.5 )
+                                     << QgsPointXY( 3.1, 1 ) << QgsPointXY( 2.5, 3.5 ) << QgsPointXY( 3.5, 3.5 );
+  for ( int i = 0; i < 2; ++i )
+  {
+    for ( const QgsPointXY &point : points )
+    {
+      QgsPoint p1( 0, 0, 0 );
+      QgsPoint p2( 0, 0, 0 );
+      QgsPoint p3( 0, 0, 0 );
+      int expected1 = 0;
+      int expected2 = 0;
+      int expected3 = 0;
+      QVERIFY( tri.getTriangle( point.x(), point.y(), p1, expected1, p2, expected2, p3, expected3 ) );
+      QVERIFY( tri.locateTriangle( point.x(), point.y(), startEdge, n1, n2, n3 ) );
+      QVERIFY( startEdge >= 0 );
+      QCOMPARE( QSet< int >() << n1 << n2 << n3, QSet< int >() << expected1 << expected2 << expected3 );
+    }
+  }
+}
+
+void TestQgsInterpolator::idwSearch()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?field=value:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsFeatureList features;
+  for ( int i = 0; i < 10; ++i )
+  {
+    for ( int j = 0; j < 10; ++j )
+    {
+      QgsFeature f( layer.fields() );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, j ) ) );
+      f.setAttributes( QgsAttributes() << i * 10.0 + j );
+      features << f;
+    }
+  }
+  QVERIFY( layer.dataProvider()->addFeatures( features ) );
+
+  QgsInterpolator::LayerData data;
+  data.source = &layer;
+  data.valueSource = QgsInterpolator::ValueAttribute;
+  data.interpolationAttribute = 0;
+
+  QgsIDWInterpolator unlimited( QList< QgsInterpolator::LayerData >() << data );
+  QgsIDWInterpolator allPoints( QList< QgsInterpolator::LayerData >() << data );
+  allPoints.setMaxPoints( 1000 );
+  QgsIDWInterpolator nearest( QList< QgsInterpolator::LayerData >() << data );
+  nearest.setMaxPoints( 1 );
+  QgsIDWInterpolator radius( QList< QgsInterpolator::LayerData >() << data );
+  radius.setSearchRadius( 0.75 );
+  QgsIDWInterpolator nearestInRadius( QList< QgsInterpolator::LayerData >() << data );
+  nearestInRadius.setSearchRadius( 1.5 );
+  nearestInRadius.setMaxPoints( 4 );
+
+  double result = 0;
+  double expected = 0;
+  // the kd-tree search using all the points must match the brute force interpolation
+  QCOMPARE( unlimited.interpolatePoint( 3.3, 4.6, expected ), 0 );
+  QCOMPARE( allPoints.interpolatePoint( 3.3, 4.6, result ), 0 );
+  QGSCOMPARENEAR( result, expected, 0.0000001 );
+  QCOMPARE( allPoints.interpolatePoint( 30, -20, result ), 0 );
+  QCOMPARE( unlimited.interpolatePoint( 30, -20, expected ), 0 );
+  QGSCOMPARENEAR( result, expected, 0.0000001 );
+
+  QCOMPARE( nearest.interpolatePoint( 3.3, 4.6, result ), 0 );
+  QCOMPARE( result, 35.0 );
+  QCOMPARE( nearest.interpolatePoint( 30, -20, result ), 0 );
+  QCOMPARE( result, 90.0 );
+  QCOMPARE( nearest.interpolatePoint( 7, 2, result ), 0 );
+  QCOMPARE( result, 72.0 );
+
+  // only 34 and 35 are within the radius, with the same weight
+  QCOMPARE( radius.interpolatePoint( 3, 4.5, result ), 0 );
+  QGSCOMPARENEAR( result, 34.5, 0.0000001 );
+  QCOMPARE( radius.interpolatePoint( 30, -20, result ), 1 );
+
+  // the four corners of the cell, with the same weight
+  QCOMPARE( nearestInRadius.interpolatePoint( 3.5, 4.5, result ), 0 );
+  QGSCOMPARENEAR( result, 39.5, 0.0000001 );
+}
+
+void TestQgsInterpolator::gridFileWriterThreads()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=EPSG:4326&field=value:double" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+  QgsInterpolator::LayerData data;
+  data.source = &layer;
+  data.valueSource = QgsInterpolator::ValueAttribute;
+  data.interpolationAttribute = 0;
+
+  QTemporaryDir dir;
+  QVERIFY( dir.isValid() );
+  const QgsRectangle extent( 0, 0, 100, 100 );
+
+  // interpolators which are not thread safe are only called from the calling thread
+  TestThreadsInterpolator serial( QList< QgsInterpolator::LayerData >() << data, false );
+  QgsGridFileWriter serialWriter( &serial, dir.filePath( QStringLiteral( "serial.asc" ) ), extent, 100, 100 );
+  QCOMPARE( serialWriter.writeFile(), 0 );
+  QCOMPARE( serial.threads, QSet< QThread * >() << QThread::currentThread() );
+
+  // the rows of thread safe interpolators are computed in parallel, with the same output
+  TestThreadsInterpolator parallel( QList< QgsInterpolator::LayerData >() << data, true );
+  QgsGridFileWriter parallelWriter( &parallel, dir.filePath( QStringLiteral( "parallel.asc" ) ), extent, 100, 100 );
+  QCOMPARE( parallelWriter.writeFile(), 0 );
+
+  QFile serialFile( dir.filePath( QStringLiteral( "serial.asc" ) ) );
+  QFile parallelFile( dir.filePath( QStringLiteral( "parallel.asc" ) ) );
+  QVERIFY( serialFile.open( QIODevice::ReadOnly ) );
+  QVERIFY( parallelFile.open( QIODevice::ReadOnly ) );
+  QCOMPARE( parallelFile.readAll(), serialFile.readAll() );
+}
+
 QGSTEST_MAIN( TestQgsInterpolator )
 #include "testqgsinterpolator.moc"
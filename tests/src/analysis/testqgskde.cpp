@@ -0,0 +1,288 @@
+/***************************************************************************
+     testqgskde.cpp
+     --------------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgskde.h"
+#include "qgsvectorlayer.h"
+#include "qgsgeometry.h"
+#include "qgsfeedback.h"
+
+#include <QDir>
+
+/**
+ * \ingroup UnitTests
+ * Tests for QgsKernelDensityEstimation. The surfaces are compared with a straightforward
+ * implementation adding the kernel of each point in turn, as the surfaces were calculated
+ * before being accumulated tile by tile.
+ */
+class TestQgsKernelDensityEstimation : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void testFixedRadius();
+    void testRadiusAndWeightFields();
+    void testCanceled();
+
+  private:
+
+    struct ReferencePoint
+    {
+      double x;
+      double y;
+      double radius;
+      double weight;
+    };
+
+    //! Returns a layer with points spread over several output tiles, many kernels overlapping tile boundaries
+    std::unique_ptr< QgsVectorLayer > pointLayer( QList< ReferencePoint > &points, bool variableRadius ) const;
+
+    //! Calculates the surface of \a points point by point, with the kernels and pixel positions of QgsKernelDensityEstimation
+    std::vector< float > referenceSurface( const QList< ReferencePoint > &points, const QgsKernelDensityEstimation::Parameters &parameters,
+                                           const QgsRectangle &bounds, int rows, int columns ) const;
+
+    void compareSurfaces( const QList< ReferencePoint > &points, QgsKernelDensityEstimation::Parameters parameters, const QString &name );
+
+    QString mTempPath;
+};
+
+void TestQgsKernelDensityEstimation::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  mTempPath = QDir::tempPath() + '/';
+}
+
+void TestQgsKernelDensityEstimation::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+std::unique_ptr< QgsVectorLayer > TestQgsKernelDensityEstimation::pointLayer( QList< ReferencePoint > &points, bool variableRadius ) const
+{
+  std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "MultiPoint?crs=EPSG:3857&field=radius:double&field=weight:double" ),
+      QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+
+  QgsFeatureList features;
+  quint32 seed = 12345;
+  auto random = [&seed]()
+  {
+    seed = seed * 1103515245 + 12345;
+    return static_cast< double >( ( seed >> 8 ) & 0xffff ) / 0xffff;
+  };
+  for ( int i = 0; i < 300; ++i )
+  {
+    QgsMultiPointXY multiPoint;
+    // clustered around the tile corners at 512 and 1024 pixels, and spread over the whole layer
+    const int partCount = i % 7 == 0 ? 3 : 1;
+    for ( int part = 0; part < partCount; ++part )
+    {
+      const double x = i % 2 ? 100 + random() * 1100 : 512 * ( 1 + i % 3 / 2 ) + ( random() - 0.5 ) * 80;
+      const double y = i % 2 ? 100 + random() * 1100 : 512 * ( 1 + i % 5 / 3 ) + ( random() - 0.5 ) * 80;
+      multiPoint << QgsPointXY( x, y );
+    }
+    const double radius = variableRadius ? 5 + random() * 40 : 30;
+    const double weight = 0.5 + random() * 3;
+
+    QgsFeature feature( layer->fields() );
+    feature.setGeometry( QgsGeometry::fromMultiPointXY( multiPoint ) );
+    feature.setAttributes( QgsAttributes() << radius << weight );
+    features << feature;
+    for ( const QgsPointXY &point : qgis::as_const( multiPoint ) )
+      points << ReferencePoint { point.x(), point.y(), radius, weight };
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+std::vector< float > TestQgsKernelDensityEstimation::referenceSurface( const QList< ReferencePoint > &points, const QgsKernelDensityEstimation::Parameters &parameters,
+    const QgsRectangle &bounds, int rows, int columns ) const
+{
+  const float noData = -9999;
+  const double pixelSize = parameters.pixelSize;
+  std::vector< float > surface( static_cast< std::size_t >( rows ) * columns, noData );
+
+  auto kernelValue = [&parameters]( double distance, double bandwidth )
+  {
+    switch ( parameters.shape )
+    {
+      case QgsKernelDensityEstimation::KernelQuartic:
+        if ( parameters.outputValues == QgsKernelDensityEstimation::OutputScaled )
+          return 116. / ( 5. * M_PI * std::pow( bandwidth, 2 ) ) * ( 15. / 16. ) * std::pow( 1. - std::pow( distance / bandwidth, 2 ), 2 );
+        return std::pow( 1. - std::pow( distance / bandwidth, 2 ), 2 );
+
+      case QgsKernelDensityEstimation::KernelTriangular:
+        if ( parameters.outputValues == QgsKernelDensityEstimation::OutputScaled )
+          return 3. / ( ( 1. + 2. * parameters.decayRatio ) * M_PI * std::pow( bandwidth, 2 ) ) * ( 1. - ( 1. - parameters.decayRatio ) * ( distance / bandwidth ) );
+        return 1. - ( 1. - parameters.decayRatio ) * ( distance / bandwidth );
+
+      default:
+        break;
+    }
+    return 0.0;
+  };
+
+  for ( const ReferencePoint &p : points )
+  {
+    ReferencePoint point = p;
+    if ( parameters.radiusField.isEmpty() )
+      point.radius = parameters.radius;
+    if ( parameters.weightField.isEmpty() )
+      point.weight = 1.0;
+
+    int buffer = point.radius / pixelSize;
+    if ( point.radius - ( pixelSize * buffer ) > 0.5 )
+      ++buffer;
+    const int blockSize = 2 * buffer + 1;
+
+    // kernels not completely inside the surface are not added
+    if ( ( point.x - bounds.xMinimum() ) / pixelSize - buffer <= -1 || ( bounds.yMaximum() - point.y ) / pixelSize - buffer <= -1 )
+      continue;
+    const unsigned int xPosition = ( ( point.x - bounds.xMinimum() ) / pixelSize ) - buffer;
+    const unsigned int yPosition = ( ( point.y - bounds.yMinimum() ) / pixelSize ) - buffer;
+    const unsigned int yPositionIO = ( ( bounds.yMaximum() - point.y ) / pixelSize ) - buffer;
+    if ( static_cast< int >( xPosition ) + blockSize > columns || static_cast< int >( yPositionIO ) + blockSize > rows )
+      continue;
+
+    for ( int xp = 0; xp < blockSize; xp++ )
+    {
+      for ( int yp = 0; yp < blockSize; yp++ )
+      {
+        const double pixelCentroidX = ( xPosition + xp + 0.5 ) * pixelSize + bounds.xMinimum();
+        const double pixelCentroidY = ( yPosition + yp + 0.5 ) * pixelSize + bounds.yMinimum();
+        const double distance = std::sqrt( std::pow( pixelCentroidX - point.x, 2.0 ) + std::pow( pixelCentroidY - point.y, 2.0 ) );
+        if ( distance > point.radius )
+          continue;
+
+        const double pixelValue = point.weight * kernelValue( distance, point.radius );
+        float &value = surface[ static_cast< std::size_t >( yPositionIO + yp ) * columns + xPosition + xp ];
+        if ( value == noData )
+          value = 0;
+        value += pixelValue;
+      }
+    }
+  }
+  return surface;
+}
+
+void TestQgsKernelDensityEstimation::compareSurfaces( const QList< ReferencePoint > &points, QgsKernelDensityEstimation::Parameters parameters, const QString &name )
+{
+  const QString outputFile = mTempPath + name + QStringLiteral( ".tif" );
+  QgsKernelDensityEstimation kde( parameters, outputFile, QStringLiteral( "GTiff" ) );
+  // kernels at the edges may not fit completely in the surface, they are skipped with an error
+  const QgsKernelDensityEstimation::Result result = kde.run();
+  QVERIFY( result == QgsKernelDensityEstimation::Success || result == QgsKernelDensityEstimation::RasterIoError );
+
+  gdal::dataset_unique_ptr dataset( GDALOpen( outputFile.toUtf8().constData(), GA_ReadOnly ) );
+  QVERIFY( dataset );
+  const int columns = GDALGetRasterXSize( dataset.get() );
+  const int rows = GDALGetRasterYSize( dataset.get() );
+  // the surface covers several tiles
+  QVERIFY( columns > 1024 );
+  QVERIFY( rows > 1024 );
+
+  double geoTransform[6];
+  QCOMPARE( GDALGetGeoTransform( dataset.get(), geoTransform ), CE_None );
+
+  // bounds of the surface, as calculated by QgsKernelDensityEstimation
+  double maxRadius = parameters.radius;
+  if ( !parameters.radiusField.isEmpty() )
+    maxRadius = parameters.source->maximumValue( parameters.source->fields().lookupField( parameters.radiusField ) ).toDouble();
+  QgsRectangle surfaceBounds = parameters.source->sourceExtent();
+  surfaceBounds.grow( maxRadius );
+  QCOMPARE( geoTransform[0], surfaceBounds.xMinimum() );
+  QCOMPARE( geoTransform[3], surfaceBounds.yMaximum() );
+
+  std::vector< float > surface( static_cast< std::size_t >( rows ) * columns );
+  QCOMPARE( GDALRasterIO( GDALGetRasterBand( dataset.get(), 1 ), GF_Read, 0, 0, columns, rows, surface.data(), columns, rows, GDT_Float32, 0, 0 ), CE_None );
+
+  const std::vector< float > expected = referenceSurface( points, parameters, surfaceBounds, rows, columns );
+  int differences = 0;
+  for ( std::size_t i = 0; i < surface.size(); ++i )
+  {
+    if ( surface[i] != expected[i] )
+      differences++;
+  }
+  QCOMPARE( differences, 0 );
+}
+
+void TestQgsKernelDensityEstimation::testFixedRadius()
+{
+  QList< ReferencePoint > points;
+  std::unique_ptr< QgsVectorLayer > layer = pointLayer( points, false );
+
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.source = layer.get();
+  parameters.radius = 30;
+  parameters.pixelSize = 1;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputRaw;
+  compareSurfaces( points, parameters, QStringLiteral( "kde_quartic_raw" ) );
+
+  parameters.shape = QgsKernelDensityEstimation::KernelTriangular;
+  parameters.decayRatio = 0.3;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputScaled;
+  compareSurfaces( points, parameters, QStringLiteral( "kde_triangular_scaled" ) );
+}
+
+void TestQgsKernelDensityEstimation::testRadiusAndWeightFields()
+{
+  QList< ReferencePoint > points;
+  std::unique_ptr< QgsVectorLayer > layer = pointLayer( points, true );
+
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.source = layer.get();
+  parameters.radius = 0;
+  parameters.radiusField = QStringLiteral( "radius" );
+  parameters.weightField = QStringLiteral( "weight" );
+  parameters.pixelSize = 0.8;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputScaled;
+  compareSurfaces( points, parameters, QStringLiteral( "kde_quartic_fields" ) );
+}
+
+void TestQgsKernelDensityEstimation::testCanceled()
+{
+  QList< ReferencePoint > points;
+  std::unique_ptr< QgsVectorLayer > layer = pointLayer( points, false );
+
+  QgsKernelDensityEstimation::Parameters parameters;
+  parameters.source = layer.get();
+  parameters.radius = 30;
+  parameters.pixelSize = 1;
+  parameters.shape = QgsKernelDensityEstimation::KernelQuartic;
+  parameters.decayRatio = 0;
+  parameters.outputValues = QgsKernelDensityEstimation::OutputRaw;
+
+  QgsKernelDensityEstimation kde( parameters, mTempPath + QStringLiteral( "kde_canceled.tif" ), QStringLiteral( "GTiff" ) );
+  QCOMPARE( kde.prepare(), QgsKernelDensityEstimation::Success );
+  QgsFeature f;
+  QgsFeatureIterator it = layer->getFeatures();
+  while ( it.nextFeature( f ) )
+    kde.addFeature( f );
+
+  // a canceled surface is not reported as written
+  QgsFeedback feedback;
+  feedback.cancel();
+  QCOMPARE( kde.finalise( &feedback ), QgsKernelDensityEstimation::Canceled );
+}
+
+QGSTEST_MAIN( TestQgsKernelDensityEstimation )
+#include "testqgskde.moc"
@@ -69,6 +69,7 @@ class TestQgsProcessingAlgs: public QObject
     void init() {} // will be called before each testfunction is executed.
     void cleanup() {} // will be called after every testfunction.
     void packageAlg();
+    void generateVectorTilesAlg();
     void renameLayerAlg();
     void loadLayerAlg();
     void parseGeoTags();
@@ -210,6 +211,46 @@ void TestQgsProcessingAlgs::packageAlg()
   QCOMPARE( polygonLayer->featureCount(), mPolygonLayer->featureCount() );
 }
 
+void TestQgsProcessingAlgs::generateVectorTilesAlg()
+{
+  std::unique_ptr< QgsProcessingAlgorithm > alg( QgsApplication::processingRegistry()->createAlgorithmById( QStringLiteral( "native:generatevectortiles" ) ) );
+  QVERIFY( alg != nullptr );
+
+  std::unique_ptr< QgsProcessingContext > context = qgis::make_unique< QgsProcessingContext >();
+  context->setProject( QgsProject::instance() );
+
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Point?crs=epsg:3857&field=name:string" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer->isValid() );
+  QgsFeature f;
+  f.setAttributes( QgsAttributes() << QStringLiteral( "a" ) );
+  // Far from the tile edges, in a single tile of each zoom level
+  f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( 6011252, 6011252 ) ) );
+  layer->dataProvider()->addFeature( f );
+  QgsProject::instance()->addMapLayer( layer );
+
+  const QString folder = QDir::tempPath() + QStringLiteral( "/generate_vector_tiles" );
+  QDir( folder ).removeRecursively();
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "LAYERS" ), QStringList() << layer->id() );
+  parameters.insert( QStringLiteral( "ZOOM_MIN" ), 0 );
+  parameters.insert( QStringLiteral( "ZOOM_MAX" ), 2 );
+  parameters.insert( QStringLiteral( "OUTPUT_DIRECTORY" ), folder );
+
+  bool ok = false;
+  QgsProcessingFeedback feedback;
+  QVariantMap results = alg->run( parameters, *context, &feedback, &ok );
+  QVERIFY( ok );
+
+  QCOMPARE( results.value( QStringLiteral( "TILES" ) ).toInt(), 3 );
+  QVERIFY( QFileInfo( folder + QStringLiteral( "/0/0/0.pbf" ) ).size() > 0 );
+  QVERIFY( QFileInfo( folder + QStringLiteral( "/1/1/0.pbf" ) ).size() > 0 );
+  QVERIFY( QFileInfo( folder + QStringLiteral( "/2/2/1.pbf" ) ).size() > 0 );
+  QVERIFY( !QFile::exists( folder + QStringLiteral( "/1/0/0.pbf" ) ) );
+
+  QgsProject::instance()->removeMapLayer( layer );
+}
+
 void TestQgsProcessingAlgs::renameLayerAlg()
 {
   const QgsProcessingAlgorithm *package( QgsApplication::processingRegistry()->algorithmById( QStringLiteral( "native:renamelayer" ) ) );
@@ -24,6 +24,8 @@
 #include "qgsproject.h"
 #include "qgsvectorlayerutils.h"
 
+#include <QThreadPool>
+
 /**
  * \ingroup UnitTests
  * This is a unit test for the zonal statistics class
@@ -42,6 +44,7 @@ class TestQgsZonalStatistics : public QObject
     void testReprojection();
     void testNoData();
     void testSmallPolygons();
+    void testParallelMatchesSequential();
 
   private:
     QgsVectorLayer *mVectorLayer = nullptr;
@@ -343,5 +346,88 @@ void TestQgsZonalStatistics::testSmallPolygons()
   QGSCOMPARENEAR( f.attribute( "nmean" ).toDouble(), 864.285638, 0.001 );
 }
 
+void TestQgsZonalStatistics::testParallelMatchesSequential()
+{
+  QString myDataPath( TEST_DATA_DIR ); //defined in CmakeLists.txt
+  QString myTestDataPath = myDataPath + "/zonalstatistics/";
+
+  std::unique_ptr< QgsRasterLayer > rasterLayer = qgis::make_unique< QgsRasterLayer >( myTestDataPath + "raster.tif", QStringLiteral( "raster" ), QStringLiteral( "gdal" ) );
+  QVERIFY( rasterLayer->isValid() );
+  const QgsRectangle extent = rasterLayer->extent();
+  const double pixelSize = rasterLayer->rasterUnitsPerPixelX();
+
+  // overlapping zones of various sizes, including zones smaller than a pixel, spread over the raster
+  QList< QgsGeometry > geometries;
+  const int gridSize = 12;
+  const double stepX = extent.width() / gridSize;
+  const double stepY = extent.height() / gridSize;
+  for ( int row = 0; row < gridSize; ++row )
+  {
+    for ( int col = 0; col < gridSize; ++col )
+    {
+      const double x = extent.xMinimum() + col * stepX;
+      const double y = extent.yMinimum() + row * stepY;
+      const double size = ( row + col ) % 3 == 0 ? pixelSize * 0.3 : stepX * ( 0.5 + ( row * col % 5 ) * 0.3 );
+      geometries << QgsGeometry::fromRect( QgsRectangle( x + stepX / 7, y + stepY / 5, x + stepX / 7 + size, y + stepY / 5 + size ) ).buffer( size / 4, 3 );
+    }
+  }
+
+  const QgsZonalStatistics::Statistics statistics = QgsZonalStatistics::Count | QgsZonalStatistics::Sum | QgsZonalStatistics::Median
+      | QgsZonalStatistics::StDev | QgsZonalStatistics::Min | QgsZonalStatistics::Max | QgsZonalStatistics::Majority | QgsZonalStatistics::Variety;
+  const QStringList statisticFields { QStringLiteral( "count" ), QStringLiteral( "sum" ), QStringLiteral( "median" ), QStringLiteral( "stdev" ),
+                                      QStringLiteral( "min" ), QStringLiteral( "max" ), QStringLiteral( "majority" ), QStringLiteral( "variety" ) };
+
+  auto zonesLayer = [&rasterLayer]( const QList< QgsGeometry > &geometries )
+  {
+    std::unique_ptr< QgsVectorLayer > layer = qgis::make_unique< QgsVectorLayer >( QStringLiteral( "Polygon?crs=%1" ).arg( rasterLayer->crs().authid() ), QStringLiteral( "zones" ), QStringLiteral( "memory" ) );
+    QgsFeatureList features;
+    for ( const QgsGeometry &geometry : geometries )
+    {
+      QgsFeature feature;
+      feature.setGeometry( geometry );
+      features << feature;
+    }
+    layer->dataProvider()->addFeatures( features );
+    return layer;
+  };
+
+  // sequential reference: each zone on its own, with a single worker thread
+  const int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+  QList< QgsAttributes > expected;
+  for ( const QgsGeometry &geometry : qgis::as_const( geometries ) )
+  {
+    std::unique_ptr< QgsVectorLayer > layer = zonesLayer( QList< QgsGeometry >() << geometry );
+    QgsZonalStatistics zs( layer.get(), rasterLayer.get(), QString(), 1, statistics );
+    QCOMPARE( zs.calculateStatistics( nullptr ), 0 );
+    QgsFeature f;
+    QVERIFY( layer->getFeatures().nextFeature( f ) );
+    expected << f.attributes();
+  }
+
+  // all zones at once, batched and processed concurrently
+  QThreadPool::globalInstance()->setMaxThreadCount( std::max( 4, maxThreadCount ) );
+  std::unique_ptr< QgsVectorLayer > layer = zonesLayer( geometries );
+  QgsZonalStatistics zs( layer.get(), rasterLayer.get(), QString(), 1, statistics );
+  const int result = zs.calculateStatistics( nullptr );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+  QCOMPARE( result, 0 );
+
+  QgsFeatureIterator it = layer->getFeatures( QgsFeatureRequest().addOrderBy( QStringLiteral( "$id" ) ) );
+  QgsFeature f;
+  int zone = 0;
+  while ( it.nextFeature( f ) )
+  {
+    for ( const QString &field : statisticFields )
+    {
+      const int index = f.fields().lookupField( field );
+      QVERIFY( index >= 0 );
+      QGSCOMPARENEAR( f.attribute( index ).toDouble(), expected.at( zone ).at( index ).toDouble(), 1e-9 );
+    }
+    zone++;
+  }
+  QCOMPARE( zone, geometries.size() );
+}
+
 QGSTEST_MAIN( TestQgsZonalStatistics )
 #include "testqgszonalstatistics.moc"
@@ -20,12 +20,18 @@
 #include "qgspoint.h"
 #include "qgslinestring.h"
 #include "qgsvectorlayer.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorfilewriter.h"
 #include <QEventLoop>
 #include <QObject>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
+#include <QThread>
 #include <QtConcurrentMap>
 #include "qgstest.h"
 
+#include <gdal.h>
+
 class TestQgsConnectionPool: public QObject
 {
     Q_OBJECT
@@ -34,6 +40,7 @@ class TestQgsConnectionPool: public QObject
     void initTestCase();
     void cleanupTestCase();
     void layersFromSameDatasetGPX();
+    void layersFromSameDatasetGPKG();
 
   private:
     struct ReadJob
@@ -53,6 +60,21 @@ class TestQgsConnectionPool: public QObject
       }
     }
 
+    //! Returns the number of GDAL datasets opened on \a fileName
+    static int openedDatasets( const QString &fileName )
+    {
+      GDALDatasetH *datasets = nullptr;
+      int count = 0;
+      GDALGetOpenDatasets( &datasets, &count );
+      int opened = 0;
+      for ( int i = 0; i < count; ++i )
+      {
+        if ( QString::fromUtf8( GDALGetDescription( datasets[i] ) ) == fileName )
+          opened++;
+      }
+      return opened;
+    }
+
 };
 
 void TestQgsConnectionPool::initTestCase()
@@ -140,5 +162,76 @@ void TestQgsConnectionPool::layersFromSameDatasetGPX()
   QFile( testFile.fileName() ).remove();
 }
 
+void TestQgsConnectionPool::layersFromSameDatasetGPKG()
+{
+  // Reads concurrently more layers of the same GeoPackage than the default
+  // number of connections of a pool, all the layers share the pool of the file
+  const int nLayers = 8;
+  const int nFeatures = 1000;
+  QTemporaryDir dir;
+  const QString fileName = dir.filePath( QStringLiteral( "test.gpkg" ) );
+
+  QgsVectorLayer memoryLayer( QStringLiteral( "Point?crs=epsg:4326&field=id:integer" ), QStringLiteral( "memory" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  for ( int i = 0; i < nFeatures; ++i )
+  {
+    QgsFeature f( memoryLayer.fields() );
+    f.setAttribute( 0, i );
+    f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( i, i ) ) );
+    features << f;
+  }
+  QVERIFY( memoryLayer.dataProvider()->addFeatures( features ) );
+
+  QgsVectorFileWriter::SaveVectorOptions options;
+  options.driverName = QStringLiteral( "GPKG" );
+  QList< QgsVectorLayer * > layers;
+  QList<ReadJob> jobs;
+  for ( int i = 0; i < nLayers; ++i )
+  {
+    options.layerName = QStringLiteral( "layer%1" ).arg( i );
+    options.actionOnExistingFile = i == 0 ? QgsVectorFileWriter::CreateOrOverwriteFile : QgsVectorFileWriter::CreateOrOverwriteLayer;
+    QCOMPARE( QgsVectorFileWriter::writeAsVectorFormat( &memoryLayer, fileName, options ), QgsVectorFileWriter::NoError );
+
+    QgsVectorLayer *layer = new QgsVectorLayer( fileName + "|layername=" + options.layerName, options.layerName, QStringLiteral( "ogr" ) );
+    QVERIFY( layer->isValid() );
+    layers << layer;
+    jobs << ReadJob( layer );
+  }
+
+  // The providers of the layers share the dataset of the file, the pool
+  // may already have one for the layer checks
+  QVERIFY( openedDatasets( fileName ) <= 2 );
+
+  // and their iterators share the connections of the pool of the file: read
+  // one after the other, the layers reuse the same read-only dataset
+  for ( QgsVectorLayer *layer : qgis::as_const( layers ) )
+  {
+    ReadJob job( layer );
+    processJob( job );
+    QCOMPARE( job.features.count(), nFeatures );
+    QCOMPARE( openedDatasets( fileName ), 2 );
+  }
+
+  QEventLoop evLoop;
+  QFutureWatcher<void> futureWatcher;
+  connect( &futureWatcher, SIGNAL( finished() ), &evLoop, SLOT( quit() ) );
+  futureWatcher.setFuture( QtConcurrent::map( jobs, processJob ) );
+  evLoop.exec();
+
+  // read concurrently, the pool opens at most a dataset per thread
+  QVERIFY( openedDatasets( fileName ) <= 1 + std::max( QgsApplication::instance()->maxConcurrentConnectionsPerPool(), QThread::idealThreadCount() ) );
+
+  for ( const ReadJob &job : qgis::as_const( jobs ) )
+  {
+    QCOMPARE( job.features.count(), nFeatures );
+    for ( int i = 0; i < nFeatures; ++i )
+    {
+      QCOMPARE( job.features.at( i ).attribute( QStringLiteral( "id" ) ).toInt(), i );
+      QCOMPARE( job.features.at( i ).geometry().asPoint(), QgsPointXY( i, i ) );
+    }
+  }
+  qDeleteAll( layers );
+}
+
 QGSTEST_MAIN( TestQgsConnectionPool )
 #include "testqgsconnectionpool.moc"
@@ -23,6 +23,8 @@
 #include <QFileInfo>
 #include <QDir>
 
+#include <gdal.h>
+
 //qgis includes...
 #include <qgis.h>
 #include <qgsapplication.h>
@@ -57,6 +59,7 @@ class TestQgsGdalProvider : public QObject
     void bandNameWithDescription(); // test band name for when description available (#16047)
     void interactionBetweenRasterChangeAndCache(); // test that updading a raster invalidates the GDAL dataset cache (#20104)
     void scale0(); //test when data has scale 0 (#20493)
+    void overviewSelection(); // test that overviews coarser than requested resolution are not used
 
   private:
     QString mTestDataDir;
@@ -358,5 +361,54 @@ void TestQgsGdalProvider::scale0()
   delete provider;
 }
 
+void TestQgsGdalProvider::overviewSelection()
+{
+  const QString filename = QStringLiteral( "/vsimem/overviews.tif" );
+
+  // Create 100x100 raster filled with 1 and a 2x overview which we fill with 2 so that we know
+  // from where the data were read
+  GDALDriverH driver = GDALGetDriverByName( "GTiff" );
+  GDALDatasetH dataset = GDALCreate( driver, filename.toUtf8().constData(), 100, 100, 1, GDT_Byte, nullptr );
+  QVERIFY( dataset );
+  double geoTransform[6] = { 0, 1, 0, 100, 0, -1 };
+  GDALSetGeoTransform( dataset, geoTransform );
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  GDALFillRaster( band, 1, 0 );
+  int overviewLevel = 2;
+  QCOMPARE( GDALBuildOverviews( dataset, "NEAREST", 1, &overviewLevel, 0, nullptr, nullptr, nullptr ), CE_None );
+  GDALRasterBandH overview = GDALGetOverview( band, 0 );
+  QVERIFY( overview );
+  GDALFillRaster( overview, 2, 0 );
+  GDALClose( dataset );
+
+  QgsDataProvider *provider = QgsProviderRegistry::instance()->createProvider( QStringLiteral( "gdal" ), filename, QgsDataProvider::ProviderOptions() );
+  QgsRasterDataProvider *rp = dynamic_cast< QgsRasterDataProvider * >( provider );
+  QVERIFY( rp );
+
+  // full resolution
+  std::unique_ptr< QgsRasterBlock > block( rp->block( 1, rp->extent(), 100, 100 ) );
+  QCOMPARE( block->value( 50, 50 ), 1.0 );
+
+  // overview resolution is coarser than requested, must not be used
+  block.reset( rp->block( 1, rp->extent(), 70, 70 ) );
+  QCOMPARE( block->value( 0, 0 ), 1.0 );
+  QCOMPARE( block->value( 35, 35 ), 1.0 );
+  QCOMPARE( block->value( 69, 69 ), 1.0 );
+
+  // overview resolution matches
+  block.reset( rp->block( 1, rp->extent(), 50, 50 ) );
+  QCOMPARE( block->value( 0, 0 ), 2.0 );
+  QCOMPARE( block->value( 25, 25 ), 2.0 );
+  QCOMPARE( block->value( 49, 49 ), 2.0 );
+
+  // zoomed out more, partial extent
+  block.reset( rp->block( 1, QgsRectangle( 10, 10, 60, 60 ), 10, 10 ) );
+  QCOMPARE( block->value( 0, 0 ), 2.0 );
+  QCOMPARE( block->value( 9, 9 ), 2.0 );
+
+  delete provider;
+  GDALDeleteDataset( driver, filename.toUtf8().constData() );
+}
+
 QGSTEST_MAIN( TestQgsGdalProvider )
 #include "testqgsgdalprovider.moc"
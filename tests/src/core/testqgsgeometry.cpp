@@ -151,6 +151,7 @@ class TestQgsGeometry : public QObject
 
     void reshapeGeometryLineMerge();
     void createCollectionOfType();
+    void geomFromTwkb();
 
     void minimalEnclosingCircle( );
     void splitGeometry();
@@ -17339,6 +17340,55 @@ void TestQgsGeometry::createCollectionOfType()
   QVERIFY( dynamic_cast< QgsMultiSurface *>( collect.get() ) );
 }
 
+void TestQgsGeometry::geomFromTwkb()
+{
+  // invalid
+  QVERIFY( !QgsGeometryFactory::geomFromTwkb( QByteArray() ) );
+  QVERIFY( !QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "0800" ) ) );
+  QVERIFY( !QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "02000202" ) ) );
+
+  // LINESTRING(1 1,5 5)
+  std::unique_ptr< QgsAbstractGeometry > geom( QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "02000202020808" ) ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->asWkt(), QStringLiteral( "LineString (1 1, 5 5)" ) );
+
+  // POINT(1.5 -2.25), precision 2
+  geom = QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "4100ac02c103" ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->asWkt(), QStringLiteral( "Point (1.5 -2.25)" ) );
+
+  // POINT(120 -30), precision -1
+  geom = QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "11001805" ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->asWkt(), QStringLiteral( "Point (120 -30)" ) );
+
+  // POINT Z (1 2 3)
+  geom = QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "010801020406" ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->asWkt(), QStringLiteral( "PointZ (1 2 3)" ) );
+
+  // POINT EMPTY
+  geom = QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "0110" ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->wkbType(), QgsWkbTypes::Point );
+  QVERIFY( geom->isEmpty() );
+
+  // POLYGON((0 0,2 0,2 2,0 0)) with bounding box
+  geom = QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "03010004000401040000040000040303" ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->asWkt(), QStringLiteral( "Polygon ((0 0, 2 0, 2 2, 0 0))" ) );
+
+  // MULTIPOINT(1 2,3 4) with id list
+  geom = QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "04040202040204040404" ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->asWkt(), QStringLiteral( "MultiPoint ((1 2),(3 4))" ) );
+
+  // GEOMETRYCOLLECTION(POINT(1 1),LINESTRING(1 1,3 3)), members reset the deltas
+  geom = QgsGeometryFactory::geomFromTwkb( QByteArray::fromHex( "070002010002020200020202040404" ) );
+  QVERIFY( geom );
+  QCOMPARE( geom->asWkt(), QStringLiteral( "GeometryCollection (Point (1 1),LineString (1 1, 3 3))" ) );
+}
+
 void TestQgsGeometry::minimalEnclosingCircle()
 {
   QgsGeometry geomTest;
@@ -0,0 +1,365 @@
+/***************************************************************************
+     testqgsvectortileencoder.cpp
+     --------------------------------------
+    Date                 : September 2019
+    Copyright            : (C) 2019 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsvectortileencoder.h"
+#include "qgsvectorlayer.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+
+#include <QPoint>
+
+/**
+ * Minimal MVT decoder, enough to check the encoded tiles
+ */
+class MvtReader
+{
+  public:
+
+    struct Feature
+    {
+      quint64 id = 0;
+      int type = 0;
+      QList<quint32> tags;
+      QList<quint32> geometry;
+    };
+
+    struct Layer
+    {
+      QString name;
+      int version = 0;
+      int extent = 0;
+      QStringList keys;
+      QList<QByteArray> values;
+      QList<Feature> features;
+    };
+
+    explicit MvtReader( const QByteArray &data )
+    {
+      int pos = 0;
+      while ( pos < data.size() )
+      {
+        int field, wireType;
+        readKey( data, pos, field, wireType );
+        const QByteArray message = readBytes( data, pos );
+        if ( field == 3 )
+          layers << readLayer( message );
+      }
+    }
+
+    QList<Layer> layers;
+
+    //! Returns the rings or lines of a geometry, in tile coordinates
+    static QList< QList<QPoint> > parts( const QList<quint32> &geometry )
+    {
+      QList< QList<QPoint> > result;
+      QPoint cursor;
+      int i = 0;
+      while ( i < geometry.size() )
+      {
+        const int command = geometry.at( i ) & 0x7;
+        const int count = static_cast<int>( geometry.at( i ) >> 3 );
+        ++i;
+        if ( command == 7 )
+          continue;
+        if ( command == 1 )
+          result << QList<QPoint>();
+        for ( int j = 0; j < count; ++j )
+        {
+          cursor += QPoint( unzigzag( geometry.at( i ) ), unzigzag( geometry.at( i + 1 ) ) );
+          i += 2;
+          result.last() << cursor;
+        }
+      }
+      return result;
+    }
+
+  private:
+
+    static int unzigzag( quint32 value )
+    {
+      return static_cast<int>( value >> 1 ) ^ -static_cast<int>( value & 1 );
+    }
+
+    static quint64 readVarint( const QByteArray &data, int &pos )
+    {
+      quint64 value = 0;
+      int shift = 0;
+      while ( pos < data.size() )
+      {
+        const quint8 byte = static_cast<quint8>( data.at( pos++ ) );
+        value |= static_cast<quint64>( byte & 0x7f ) << shift;
+        if ( !( byte & 0x80 ) )
+          break;
+        shift += 7;
+      }
+      return value;
+    }
+
+    static void readKey( const QByteArray &data, int &pos, int &field, int &wireType )
+    {
+      const quint64 key = readVarint( data, pos );
+      field = static_cast<int>( key >> 3 );
+      wireType = static_cast<int>( key & 0x7 );
+    }
+
+    static QByteArray readBytes( const QByteArray &data, int &pos )
+    {
+      const int size = static_cast<int>( readVarint( data, pos ) );
+      const QByteArray bytes = data.mid( pos, size );
+      pos += size;
+      return bytes;
+    }
+
+    static QList<quint32> readPacked( const QByteArray &data, int &pos )
+    {
+      const QByteArray packed = readBytes( data, pos );
+      QList<quint32> values;
+      int packedPos = 0;
+      while ( packedPos < packed.size() )
+        values << static_cast<quint32>( readVarint( packed, packedPos ) );
+      return values;
+    }
+
+    static Feature readFeature( const QByteArray &data )
+    {
+      Feature feature;
+      int pos = 0;
+      while ( pos < data.size() )
+      {
+        int field, wireType;
+        readKey( data, pos, field, wireType );
+        if ( field == 1 )
+          feature.id = readVarint( data, pos );
+        else if ( field == 2 )
+          feature.tags = readPacked( data, pos );
+        else if ( field == 3 )
+          feature.type = static_cast<int>( readVarint( data, pos ) );
+        else if ( field == 4 )
+          feature.geometry = readPacked( data, pos );
+      }
+      return feature;
+    }
+
+    static Layer readLayer( const QByteArray &data )
+    {
+      Layer layer;
+      int pos = 0;
+      while ( pos < data.size() )
+      {
+        int field, wireType;
+        readKey( data, pos, field, wireType );
+        if ( field == 1 )
+          layer.name = QString::fromUtf8( readBytes( data, pos ) );
+        else if ( field == 2 )
+          layer.features << readFeature( readBytes( data, pos ) );
+        else if ( field == 3 )
+          layer.keys << QString::fromUtf8( readBytes( data, pos ) );
+        else if ( field == 4 )
+          layer.values << readBytes( data, pos );
+        else if ( field == 5 )
+          layer.extent = static_cast<int>( readVarint( data, pos ) );
+        else if ( field == 15 )
+          layer.version = static_cast<int>( readVarint( data, pos ) );
+      }
+      return layer;
+    }
+};
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the vector tile encoder.
+ */
+class TestQgsVectorTileEncoder : public QObject
+{
+    Q_OBJECT
+  public:
+    TestQgsVectorTileEncoder() = default;
+
+  private slots:
+
+    void initTestCase(); // will be called before the first testfunction is executed.
+    void cleanupTestCase(); // will be called after the last testfunction was executed.
+    void init() {} // will be called before each testfunction is executed.
+    void cleanup() {} // will be called after every testfunction.
+
+    void xyzTileExtent();
+    void points();
+    void lines();
+    void polygons();
+    void outsideTile();
+
+  private:
+    // Tile of 4096 x 4096 map units, one map unit per tile coordinate
+    QgsVectorTileEncoder encoder() const
+    {
+      return QgsVectorTileEncoder( QgsRectangle( 0, 0, 4096, 4096 ), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+    }
+};
+
+void TestQgsVectorTileEncoder::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsVectorTileEncoder::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsVectorTileEncoder::xyzTileExtent()
+{
+  const double size = 20037508.3427892;
+  QgsRectangle extent = QgsVectorTileEncoder::xyzTileExtent( 0, 0, 0 );
+  QGSCOMPARENEAR( extent.xMinimum(), -size, 0.001 );
+  QGSCOMPARENEAR( extent.yMinimum(), -size, 0.001 );
+  QGSCOMPARENEAR( extent.xMaximum(), size, 0.001 );
+  QGSCOMPARENEAR( extent.yMaximum(), size, 0.001 );
+
+  extent = QgsVectorTileEncoder::xyzTileExtent( 1, 1, 0 );
+  QGSCOMPARENEAR( extent.xMinimum(), 0, 0.001 );
+  QGSCOMPARENEAR( extent.yMinimum(), 0, 0.001 );
+  QGSCOMPARENEAR( extent.xMaximum(), size, 0.001 );
+  QGSCOMPARENEAR( extent.yMaximum(), size, 0.001 );
+}
+
+void TestQgsVectorTileEncoder::points()
+{
+  QgsVectorLayer layer( QStringLiteral( "Point?crs=epsg:3857&field=name:string&field=count:integer" ), QStringLiteral( "points" ), QStringLiteral( "memory" ) );
+  QVERIFY( layer.isValid() );
+
+  QgsFeature f1( layer.fields() );
+  f1.setAttributes( QgsAttributes() << QStringLiteral( "a" ) << 5 );
+  f1.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Point (2048 1024)" ) ) );
+  QgsFeature f2( layer.fields() );
+  f2.setAttributes( QgsAttributes() << QStringLiteral( "b" ) << QVariant() );
+  f2.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Point (10 20)" ) ) );
+  QgsFeatureList features { f1, f2 };
+  layer.dataProvider()->addFeatures( features );
+
+  QgsVectorTileEncoder tile = encoder();
+  QVERIFY( tile.addLayer( &layer, layer.attributeList() ) );
+  QCOMPARE( tile.featureCount(), 2 );
+
+  const MvtReader reader( tile.encode() );
+  QCOMPARE( reader.layers.size(), 1 );
+  const MvtReader::Layer decoded = reader.layers.at( 0 );
+  QCOMPARE( decoded.name, QStringLiteral( "points" ) );
+  QCOMPARE( decoded.version, 2 );
+  QCOMPARE( decoded.extent, 4096 );
+  QCOMPARE( decoded.keys, QStringList() << QStringLiteral( "name" ) << QStringLiteral( "count" ) );
+  // "a", 5 and "b", null values are not written
+  QCOMPARE( decoded.values.size(), 3 );
+  QCOMPARE( decoded.features.size(), 2 );
+
+  for ( const MvtReader::Feature &feature : decoded.features )
+  {
+    QCOMPARE( feature.type, 1 );
+    const QList< QList<QPoint> > parts = MvtReader::parts( feature.geometry );
+    QCOMPARE( parts.size(), 1 );
+    QCOMPARE( parts.at( 0 ).size(), 1 );
+    // Tile coordinates grow downwards
+    if ( feature.tags.size() == 4 )
+      QCOMPARE( parts.at( 0 ).at( 0 ), QPoint( 2048, 3072 ) );
+    else
+      QCOMPARE( parts.at( 0 ).at( 0 ), QPoint( 10, 4076 ) );
+  }
+
+  // Attributes which are not listed are not written, even when fetched
+  QgsVectorTileEncoder subset = encoder();
+  QVERIFY( subset.addLayer( &layer, QgsAttributeList() << 1 ) );
+  QCOMPARE( subset.featureCount(), 2 );
+  const MvtReader::Layer decodedSubset = MvtReader( subset.encode() ).layers.at( 0 );
+  QCOMPARE( decodedSubset.keys, QStringList() << QStringLiteral( "count" ) );
+  QCOMPARE( decodedSubset.values.size(), 1 );
+}
+
+void TestQgsVectorTileEncoder::lines()
+{
+  QgsVectorTileEncoder tile = encoder();
+  QgsFeature feature;
+  feature.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString (-10000 2048, 1000 2048, 1000.2 2048.2, 10000 2048)" ) ) );
+  QVERIFY( tile.addFeature( QStringLiteral( "lines" ), feature, QgsAttributeList() ) );
+
+  const MvtReader reader( tile.encode() );
+  QCOMPARE( reader.layers.size(), 1 );
+  QCOMPARE( reader.layers.at( 0 ).features.size(), 1 );
+  const MvtReader::Feature decoded = reader.layers.at( 0 ).features.at( 0 );
+  QCOMPARE( decoded.type, 2 );
+
+  // Clipped to the buffer and vertices merged by the quantisation
+  const QList< QList<QPoint> > parts = MvtReader::parts( decoded.geometry );
+  QCOMPARE( parts.size(), 1 );
+  QCOMPARE( parts.at( 0 ).first(), QPoint( -64, 2048 ) );
+  QCOMPARE( parts.at( 0 ).last(), QPoint( 4160, 2048 ) );
+  QVERIFY( parts.at( 0 ).size() <= 3 );
+}
+
+void TestQgsVectorTileEncoder::polygons()
+{
+  QgsVectorTileEncoder tile = encoder();
+  QgsFeature feature;
+  // Counter clockwise exterior ring and clockwise hole in map coordinates
+  feature.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((100 100, 1000 100, 1000 1000, 100 1000, 100 100),(200 200, 200 300, 300 300, 300 200, 200 200))" ) ) );
+  QVERIFY( tile.addFeature( QStringLiteral( "polygons" ), feature, QgsAttributeList() ) );
+
+  // Degenerated once quantised
+  QgsFeature small;
+  small.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Polygon ((10 10, 10.1 10, 10.1 10.1, 10 10, 10 10))" ) ) );
+  QVERIFY( !tile.addFeature( QStringLiteral( "polygons" ), small, QgsAttributeList() ) );
+
+  const MvtReader reader( tile.encode() );
+  QCOMPARE( reader.layers.at( 0 ).features.size(), 1 );
+  const MvtReader::Feature decoded = reader.layers.at( 0 ).features.at( 0 );
+  QCOMPARE( decoded.type, 3 );
+
+  const QList< QList<QPoint> > rings = MvtReader::parts( decoded.geometry );
+  QCOMPARE( rings.size(), 2 );
+  for ( int i = 0; i < rings.size(); ++i )
+  {
+    // Closing points are implicit
+    QCOMPARE( rings.at( i ).size(), 4 );
+    qint64 area = 0;
+    for ( int j = 0; j < rings.at( i ).size(); ++j )
+    {
+      const QPoint p1 = rings.at( i ).at( j );
+      const QPoint p2 = rings.at( i ).at( ( j + 1 ) % rings.at( i ).size() );
+      area += static_cast<qint64>( p1.x() ) * p2.y() - static_cast<qint64>( p2.x() ) * p1.y();
+    }
+    // Exterior rings have a positive area in tile coordinates
+    QCOMPARE( area > 0, i == 0 );
+  }
+}
+
+void TestQgsVectorTileEncoder::outsideTile()
+{
+  QgsVectorTileEncoder tile = encoder();
+  QgsFeature feature;
+  feature.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Point (5000 5000)" ) ) );
+  QVERIFY( !tile.addFeature( QStringLiteral( "points" ), feature, QgsAttributeList() ) );
+  feature.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString (5000 5000, 6000 6000)" ) ) );
+  QVERIFY( !tile.addFeature( QStringLiteral( "lines" ), feature, QgsAttributeList() ) );
+
+  // Within the buffer
+  feature.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "Point (4120 2000)" ) ) );
+  QVERIFY( tile.addFeature( QStringLiteral( "points" ), feature, QgsAttributeList() ) );
+
+  QCOMPARE( tile.featureCount(), 1 );
+  QCOMPARE( MvtReader( tile.encode() ).layers.size(), 1 );
+  QVERIFY( encoder().encode().isEmpty() );
+}
+
+QGSTEST_MAIN( TestQgsVectorTileEncoder )
+#include "testqgsvectortileencoder.moc"
@@ -36,8 +36,9 @@ from qgis.core import (QgsFeature,
                        QgsProject,
                        QgsWkbTypes,
                        QgsDataProvider,
-                       QgsVectorDataProvider)
-from qgis.PyQt.QtCore import QCoreApplication, QVariant
+                       QgsVectorDataProvider,
+                       NULL)
+from qgis.PyQt.QtCore import QCoreApplication, QDate, QDateTime, QTime, QVariant
 from qgis.testing import start_app, unittest
 from qgis.utils import spatialite_connect
 from utilities import unitTestDataPath
@@ -1361,6 +1362,122 @@ class TestPyQgsOGRProviderGpkg(unittest.TestCase):
         fids = set([f['fid'] for f in vl.getFeatures()])
         self.assertEqual(len(fids), 1)
 
+    def testParallelFeatures(self):
+        """Test splitting a request into FID ranges"""
+
+        tmpfile = os.path.join(self.basetestpath, 'testParallelFeatures.gpkg')
+        ds = ogr.GetDriverByName('GPKG').CreateDataSource(tmpfile)
+        lyr = ds.CreateLayer('test', geom_type=ogr.wkbPoint)
+        for i in range(10):
+            f = ogr.Feature(lyr.GetLayerDefn())
+            f.SetGeometry(ogr.CreateGeometryFromWkt('POINT({} {})'.format(i, i)))
+            lyr.CreateFeature(f)
+        f = None
+        ds = None
+        vl = QgsVectorLayer('{}'.format(tmpfile) + "|layername=" + "test", 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+
+        iterators = vl.getParallelFeatures(QgsFeatureRequest(), 3)
+        self.assertEqual(len(iterators), 3)
+        fids = [[f.id() for f in it] for it in iterators]
+        self.assertEqual(sorted(sum(fids, [])), list(range(1, 11)))
+        self.assertTrue(all(fids))
+
+        # the spatial filter applies to each range
+        iterators = vl.getParallelFeatures(QgsFeatureRequest(QgsRectangle(-0.5, -0.5, 4.5, 4.5)), 3)
+        self.assertEqual(sorted(sum([[f.id() for f in it] for it in iterators], [])), list(range(1, 6)))
+
+        # requests with attribute filters or limits are not split
+        self.assertEqual(len(vl.getParallelFeatures(QgsFeatureRequest().setFilterExpression('fid > 2'), 3)), 1)
+        self.assertEqual(len(vl.getParallelFeatures(QgsFeatureRequest().setLimit(2), 3)), 1)
+
+        # layers with edits are not split
+        vl.startEditing()
+        vl.deleteFeature(1)
+        iterators = vl.getParallelFeatures(QgsFeatureRequest(), 3)
+        self.assertEqual(len(iterators), 1)
+        self.assertEqual(sorted([f.id() for f in iterators[0]]), list(range(2, 11)))
+        vl.rollBack()
+
+    def testReadFeaturesColumnBatches(self):
+        """Test reading all the value types of a layer, in batches of columns with GDAL >= 3.6"""
+
+        tmpfile = os.path.join(self.basetestpath, 'testReadFeaturesColumnBatches.gpkg')
+        ds = ogr.GetDriverByName('GPKG').CreateDataSource(tmpfile)
+        lyr = ds.CreateLayer('test', geom_type=ogr.wkbMultiPolygon)
+        lyr.CreateField(ogr.FieldDefn('int', ogr.OFTInteger))
+        lyr.CreateField(ogr.FieldDefn('int64', ogr.OFTInteger64))
+        lyr.CreateField(ogr.FieldDefn('real', ogr.OFTReal))
+        lyr.CreateField(ogr.FieldDefn('str', ogr.OFTString))
+        lyr.CreateField(ogr.FieldDefn('date', ogr.OFTDate))
+        lyr.CreateField(ogr.FieldDefn('datetime', ogr.OFTDateTime))
+        lyr.CreateField(ogr.FieldDefn('datetime_tz', ogr.OFTDateTime))
+        fld_defn = ogr.FieldDefn('bool', ogr.OFTInteger)
+        fld_defn.SetSubType(ogr.OFSTBoolean)
+        lyr.CreateField(fld_defn)
+        for i in range(5):
+            f = ogr.Feature(lyr.GetLayerDefn())
+            if i != 2:
+                f['int'] = i
+                f['int64'] = 1234567890123 + i
+                f['real'] = i + 0.5
+                f['str'] = 'été {}'.format(i)
+                f['date'] = '2019/09/{:02d}'.format(i + 1)
+                f['datetime'] = '2019/09/{:02d} 12:34:56'.format(i + 1)
+                # time zones differing between the features
+                f['datetime_tz'] = '2019/09/{:02d} 12:34:56{}'.format(i + 1, '+02' if i % 2 else '-05')
+                f['bool'] = i % 2
+                # a single polygon in a multipolygon layer
+                f.SetGeometry(ogr.CreateGeometryFromWkt('POLYGON(({0} {0},{0} {1},{1} {1},{0} {0}))'.format(i, i + 1)))
+            lyr.CreateFeature(f)
+        f = None
+        ds = None
+
+        vl = QgsVectorLayer('{}'.format(tmpfile) + "|layername=" + "test", 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+
+        features = {f.id(): f for f in vl.getFeatures()}
+        self.assertEqual(sorted(features.keys()), [1, 2, 3, 4, 5])
+        f = features[2]
+        self.assertEqual(f['fid'], 2)
+        self.assertEqual(f['int'], 1)
+        self.assertEqual(f['int64'], 1234567890124)
+        self.assertEqual(f['real'], 1.5)
+        self.assertEqual(f['str'], 'été 1')
+        self.assertEqual(f['date'], QDate(2019, 9, 2))
+        self.assertEqual(f['datetime'], QDateTime(QDate(2019, 9, 2), QTime(12, 34, 56)))
+        # the wall clock time is kept, as with the per-feature reads
+        self.assertEqual(f['datetime_tz'], QDateTime(QDate(2019, 9, 2), QTime(12, 34, 56)))
+        self.assertEqual(features[1]['datetime_tz'], QDateTime(QDate(2019, 9, 1), QTime(12, 34, 56)))
+        self.assertEqual(f['datetime_tz'], vl.getFeature(2)['datetime_tz'])
+        self.assertEqual(f['bool'], True)
+        self.assertEqual(features[1]['bool'], False)
+        self.assertEqual(f.geometry().asWkt(), 'MultiPolygon (((1 1, 1 2, 2 2, 1 1)))')
+
+        f = features[3]
+        self.assertFalse(f.hasGeometry())
+        for name in ('int', 'int64', 'real', 'str', 'date', 'datetime', 'datetime_tz', 'bool'):
+            self.assertEqual(f[name], NULL)
+
+        # filters and subsets of attributes
+        request = QgsFeatureRequest(QgsRectangle(2.5, 2.5, 3.5, 3.5)).setSubsetOfAttributes(['str'], vl.fields())
+        features = [f for f in vl.getFeatures(request)]
+        # the feature 3 has no geometry
+        self.assertEqual([f.id() for f in features], [4])
+        self.assertEqual(features[0]['str'], 'été 3')
+        self.assertEqual(features[0]['int'], NULL)
+
+        request = QgsFeatureRequest().setFilterExpression('"int" >= 3').setFlags(QgsFeatureRequest.NoGeometry)
+        features = [f for f in vl.getFeatures(request)]
+        self.assertEqual([f.id() for f in features], [4, 5])
+        self.assertFalse(features[0].hasGeometry())
+
+        # a second iteration reads the layer again
+        it = vl.getFeatures()
+        self.assertEqual(len([f for f in it]), 5)
+        it.rewind()
+        self.assertEqual(len([f for f in it]), 5)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -42,7 +42,9 @@ from qgis.core import (
     QgsCoordinateReferenceSystem,
     QgsProject,
     QgsWkbTypes,
-    QgsGeometry
+    QgsGeometry,
+    QgsFeatureSink,
+    QgsSimplifyMethod
 )
 from qgis.gui import QgsGui, QgsAttributeForm
 from qgis.PyQt.QtCore import QDate, QTime, QDateTime, QVariant, QDir, QObject, QByteArray
@@ -438,6 +440,149 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
         self.assertNotEqual(f[0]['obj_id'], NULL, f[0].attributes())
         vl.deleteFeatures([f[0].id()])
 
+    def testFastInsertCopy(self):
+        """
+        Test that features added with FastInsert are bulk loaded with COPY
+        """
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.copy_insert CASCADE')
+        self.execSQLCommand('CREATE TABLE qgis_test.copy_insert (pk serial PRIMARY KEY, name text, value integer DEFAULT 5, data bytea, geom geometry(MultiPoint, 4326))')
+        vl = QgsVectorLayer('{} sslmode=disable key=\'pk\' srid=4326 type=MULTIPOINT table="qgis_test"."copy_insert" (geom) sql='.format(self.dbconn), 'copy_insert', 'postgres')
+        self.assertTrue(vl.isValid())
+
+        features = []
+        for i in range(2500):
+            f = QgsFeature(vl.fields())
+            f['name'] = 'tab\there\nnew line\\{}'.format(i) if i % 2 else NULL
+            f['data'] = QByteArray(b'\x00\x01\\') if i % 2 else NULL
+            if i % 3:
+                f.setGeometry(QgsGeometry.fromWkt('Point({} 2)'.format(i)))
+            features.append(f)
+        self.assertTrue(vl.dataProvider().addFeatures(features, QgsFeatureSink.FastInsert)[0])
+
+        features = sorted(vl.getFeatures(), key=lambda f: f['pk'])
+        self.assertEqual(len(features), 2500)
+        self.assertEqual(features[0]['name'], NULL)
+        self.assertEqual(features[1]['name'], 'tab\there\nnew line\\1')
+        self.assertEqual(features[0]['value'], NULL)
+        self.assertEqual(features[0]['data'], NULL)
+        self.assertEqual(features[1]['data'], QByteArray(b'\x00\x01\\'))
+        self.assertTrue(features[0].geometry().isNull())
+        self.assertEqual(features[1].geometry().asWkt(), 'MultiPoint ((1 2))')
+        self.assertEqual(len(set(f['pk'] for f in features)), 2500)
+
+        # Values equal to the default clause are left to the default
+        default = vl.dataProvider().defaultValueClause(vl.fields().indexOf('value'))
+        self.assertEqual(default, '5')
+        f1 = QgsFeature(vl.fields())
+        f1['value'] = default
+        f2 = QgsFeature(vl.fields())
+        f2['value'] = default
+        self.assertTrue(vl.dataProvider().addFeatures([f1, f2], QgsFeatureSink.FastInsert)[0])
+        values = [f['value'] for f in sorted(vl.getFeatures(), key=lambda f: f['pk'])[-2:]]
+        self.assertEqual(values, [5, 5])
+
+        # NULL and other values are loaded as is
+        f1 = QgsFeature(vl.fields())
+        f1['value'] = 7
+        f2 = QgsFeature(vl.fields())
+        self.assertTrue(vl.dataProvider().addFeatures([f1, f2], QgsFeatureSink.FastInsert)[0])
+        values = [f['value'] for f in sorted(vl.getFeatures(), key=lambda f: f['pk'])[-2:]]
+        self.assertEqual(values, [7, NULL])
+
+        # Mixed values and defaults in a column fall back to INSERT
+        f1 = QgsFeature(vl.fields())
+        f1['value'] = 7
+        f2 = QgsFeature(vl.fields())
+        f2['value'] = default
+        f3 = QgsFeature(vl.fields())
+        self.assertTrue(vl.dataProvider().addFeatures([f1, f2, f3], QgsFeatureSink.FastInsert)[0])
+        values = [f['value'] for f in sorted(vl.getFeatures(), key=lambda f: f['pk'])[-3:]]
+        self.assertEqual(values, [7, 5, NULL])
+
+        # Views cannot be loaded with COPY, features are inserted
+        self.execSQLCommand('CREATE VIEW qgis_test.copy_insert_view AS SELECT pk, name, geom FROM qgis_test.copy_insert')
+        view = QgsVectorLayer('{} sslmode=disable key=\'pk\' srid=4326 type=MULTIPOINT table="qgis_test"."copy_insert_view" (geom) sql='.format(self.dbconn), 'copy_insert_view', 'postgres')
+        self.assertTrue(view.isValid())
+        f = QgsFeature(view.fields())
+        f['pk'] = 10000
+        f['name'] = 'view'
+        f.setGeometry(QgsGeometry.fromWkt('Point(3 4)'))
+        self.assertTrue(view.dataProvider().addFeatures([f], QgsFeatureSink.FastInsert)[0])
+        added = [f for f in vl.getFeatures() if f['pk'] == 10000]
+        self.assertEqual(len(added), 1)
+        self.assertEqual(added[0]['name'], 'view')
+        self.assertEqual(added[0]['value'], 5)
+
+    def testPrefetchFeatures(self):
+        """
+        Test fetching features in several batches, with and without prefetching
+        """
+        query = '(SELECT i, ST_SetSRID(ST_MakePoint(i, i), 4326)::geometry(Point, 4326) g FROM generate_series(1, 4500) i)'
+        uri = '{} table="{}" (g) key=\'i\''.format(self.dbconn, query)
+        try:
+            for prefetch in (True, False):
+                QgsSettings().setValue('PostgreSQL/prefetch_features', prefetch, QgsSettings.Providers)
+                vl = QgsVectorLayer(uri, 'prefetch', 'postgres')
+                self.assertTrue(vl.isValid())
+                self.assertEqual([f['i'] for f in vl.getFeatures()], list(range(1, 4501)))
+                self.assertEqual([f.geometry().asWkt() for f in vl.getFeatures(QgsFeatureRequest().setFilterExpression('i > 4498'))], ['Point (4499 4499)', 'Point (4500 4500)'])
+
+                # Rewind and close while the next batch is prefetched
+                it = vl.getFeatures()
+                self.assertEqual(next(it)['i'], 1)
+                it.rewind()
+                self.assertEqual(next(it)['i'], 1)
+                self.assertTrue(it.close())
+        finally:
+            QgsSettings().remove('PostgreSQL/prefetch_features', QgsSettings.Providers)
+
+    def testTwkbRendering(self):
+        """
+        Test fetching the geometries to render as TWKB
+        """
+        query = '(SELECT 1 AS i, ST_GeomFromText(\'LineString(1.23456 2.34567, 3.45678 4.56789)\', 4326)::geometry(LineString, 4326) g)'
+        uri = '{} table="{}" (g) key=\'i\''.format(self.dbconn, query)
+        vl = QgsVectorLayer(uri, 'twkb', 'postgres')
+        self.assertTrue(vl.isValid())
+
+        simplifyMethod = QgsSimplifyMethod()
+        simplifyMethod.setMethodType(QgsSimplifyMethod.OptimizeForRendering)
+        simplifyMethod.setForceLocalOptimization(True)
+        simplifyMethod.setThreshold(1)
+        simplifyMethod.setTolerance(0.01)
+        request = QgsFeatureRequest().setSimplifyMethod(simplifyMethod)
+        try:
+            QgsSettings().setValue('PostgreSQL/twkb_rendering', True, QgsSettings.Providers)
+            # coordinates are rounded to a tenth of a pixel
+            self.assertEqual([f.geometry().asWkt() for f in vl.getFeatures(request)], ['LineString (1.235 2.346, 3.457 4.568)'])
+            self.assertEqual([f.geometry().asWkt() for f in vl.getFeatures()], ['LineString (1.23456 2.34567, 3.45678 4.56789)'])
+            QgsSettings().setValue('PostgreSQL/twkb_rendering', False, QgsSettings.Providers)
+            self.assertEqual([f.geometry().asWkt() for f in vl.getFeatures(request)], ['LineString (1.23456 2.34567, 3.45678 4.56789)'])
+        finally:
+            QgsSettings().remove('PostgreSQL/twkb_rendering', QgsSettings.Providers)
+
+    def testParallelFeatures(self):
+        """
+        Test splitting a request into primary key ranges
+        """
+        query = '(SELECT i, ST_SetSRID(ST_MakePoint(i, i), 4326)::geometry(Point, 4326) g FROM generate_series(1, 100) i)'
+        uri = '{} table="{}" (g) key=\'i\''.format(self.dbconn, query)
+        vl = QgsVectorLayer(uri, 'parallel', 'postgres')
+        self.assertTrue(vl.isValid())
+
+        iterators = vl.getParallelFeatures(QgsFeatureRequest(), 4)
+        self.assertEqual(len(iterators), 4)
+        values = [[f['i'] for f in it] for it in iterators]
+        self.assertEqual(sorted(sum(values, [])), list(range(1, 101)))
+        self.assertTrue(all(values))
+
+        # filters are combined with the ranges
+        iterators = vl.getParallelFeatures(QgsFeatureRequest().setFilterExpression('i > 90'), 4)
+        self.assertEqual(sorted(sum([[f['i'] for f in it] for it in iterators], [])), list(range(91, 101)))
+
+        # requests with a limit are not split
+        self.assertEqual(len(vl.getParallelFeatures(QgsFeatureRequest().setLimit(2), 4)), 1)
+
     def testNull(self):
         """
         Asserts that 0, '' and NULL are treated as different values on insert
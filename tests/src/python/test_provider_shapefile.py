@@ -19,7 +19,7 @@ import osgeo.gdal
 import osgeo.ogr
 import sys
 
-from qgis.core import QgsApplication, QgsSettings, QgsFeature, QgsField, QgsGeometry, QgsVectorLayer, QgsFeatureRequest, QgsVectorDataProvider, QgsWkbTypes
+from qgis.core import QgsApplication, QgsSettings, QgsFeature, QgsField, QgsGeometry, QgsVectorLayer, QgsFeatureRequest, QgsVectorDataProvider, QgsWkbTypes, QgsAbstractFeatureIterator
 from qgis.PyQt.QtCore import QVariant
 from qgis.testing import start_app, unittest
 from utilities import unitTestDataPath
@@ -614,6 +614,17 @@ class TestPyQgsShapefileProvider(unittest.TestCase, ProviderTestCase):
             # force close of data provider
             vl.setDataSource('', 'test', 'ogr')
 
+    def testCompileFeatureIdFilter(self):
+        """Test that filters on the feature id are compiled to the OGR FID"""
+        file_path = os.path.join(TEST_DATA_DIR, 'provider', 'shapefile.shp')
+        vl = QgsVectorLayer('{}|layerid=0'.format(file_path), 'test', 'ogr')
+        self.assertTrue(vl.isValid())
+        self.enableCompiler()
+        it = vl.getFeatures(QgsFeatureRequest().setFilterExpression('$id > 2'))
+        self.assertEqual(it.compileStatus(), QgsAbstractFeatureIterator.Compiled)
+        self.assertEqual(sorted([f.id() for f in it]), [3, 4])
+        self.disableCompiler()
+
     def testCreateAttributeIndex(self):
         tmpdir = tempfile.mkdtemp()
         self.dirs_to_cleanup.append(tmpdir)
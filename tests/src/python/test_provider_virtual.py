@@ -23,6 +23,7 @@ from qgis.core import (QgsVectorLayer,
                        QgsVirtualLayerDefinitionUtils,
                        QgsWkbTypes,
                        QgsProject,
+                       QgsSettings,
                        QgsVectorLayerJoinInfo
                        )
 
@@ -1034,6 +1035,136 @@ class TestQgsVirtualLayerProvider(unittest.TestCase, ProviderTestCase):
 
         QgsProject.instance().removeMapLayer(ml)
 
+    def testConstraintsPushedToSource(self):
+        ml = QgsVectorLayer("Point?srid=EPSG:4326&field=a:int&field=b:string", "mem_constraints", "memory")
+        self.assertEqual(ml.isValid(), True)
+        QgsProject.instance().addMapLayer(ml)
+
+        ml.startEditing()
+        for i in range(10):
+            f = QgsFeature(ml.fields())
+            f.setGeometry(QgsGeometry.fromWkt('POINT({} 0)'.format(i)))
+            f.setAttributes([i, 'odd' if i % 2 else 'even'])
+            ml.addFeatures([f])
+        ml.commitChanges()
+
+        def values(query):
+            df = QgsVirtualLayerDefinition()
+            df.setQuery(query)
+            vl = QgsVectorLayer(df.toString(), "vl", "virtual")
+            self.assertEqual(vl.isValid(), True)
+            return [f.attributes() for f in vl.getFeatures()]
+
+        # several comparisons on attributes
+        self.assertEqual(values("select a from mem_constraints where a >= 2 and a < 8 and b = 'odd' order by a"), [[3], [5], [7]])
+        self.assertEqual(values("select a from mem_constraints where a > 2.5 and a <= 4 order by a"), [[3], [4]])
+        self.assertEqual(values("select a from mem_constraints where b = 'none'"), [])
+
+        # IN list
+        self.assertEqual(values("select a from mem_constraints where a in (1, 4, 12) order by a"), [[1], [4]])
+        self.assertEqual(values("select a from mem_constraints where a in (1, 4, 5) and b = 'even' order by a"), [[4]])
+
+        # LIMIT and OFFSET
+        self.assertEqual(len(values("select a from mem_constraints limit 3")), 3)
+        self.assertEqual(values("select a from mem_constraints where a >= 4 order by a limit 2 offset 1"), [[5], [6]])
+        self.assertEqual(len(values("select a from mem_constraints where b = 'odd' limit 2 offset 2")), 2)
+
+        # LIMIT and OFFSET with an ORDER BY which differs from the order of the source
+        ml_desc = QgsVectorLayer("Point?srid=EPSG:4326&field=a:int", "mem_constraints_desc", "memory")
+        self.assertEqual(ml_desc.isValid(), True)
+        QgsProject.instance().addMapLayer(ml_desc)
+        features = []
+        for i in reversed(range(10)):
+            f = QgsFeature(ml_desc.fields())
+            f.setGeometry(QgsGeometry.fromWkt('POINT({} 0)'.format(i)))
+            f.setAttributes([i])
+            features.append(f)
+        self.assertTrue(ml_desc.dataProvider().addFeatures(features)[0])
+        self.assertEqual(values("select a from mem_constraints_desc limit 2"), [[9], [8]])
+        self.assertEqual(values("select a from mem_constraints_desc order by a limit 3"), [[0], [1], [2]])
+        self.assertEqual(values("select a from mem_constraints_desc order by a limit 2 offset 3"), [[3], [4]])
+        self.assertEqual(values("select a from mem_constraints_desc where a > 2 order by a limit 2"), [[3], [4]])
+        QgsProject.instance().removeMapLayer(ml_desc)
+
+        # rtree filter combined with a comparison
+        self.assertEqual(values("select a from mem_constraints where a > 3 and _search_frame_ = BuildMbr(2.5, -1, 6.5, 1) order by a"), [[4], [5], [6]])
+
+        # join keys
+        self.assertEqual(values("select m1.a as a1, m2.a as a2 from mem_constraints m1, mem_constraints m2 where m2.a = m1.a + 1 and m1.a > 6 order by m1.a"),
+                         [[7, 8], [8, 9]])
+
+        QgsProject.instance().removeMapLayer(ml)
+
+    def testNativeQueryEngine(self):
+        ml1 = QgsVectorLayer("Point?srid=EPSG:4326&field=id:int&field=name:string", "native_points", "memory")
+        ml2 = QgsVectorLayer("Polygon?srid=EPSG:4326&field=pid:int&field=label:string", "native_polygons", "memory")
+        QgsProject.instance().addMapLayers([ml1, ml2])
+
+        ml1.startEditing()
+        for i in range(10):
+            f = QgsFeature(ml1.fields())
+            f.setGeometry(QgsGeometry.fromWkt('POINT({} 0)'.format(i)))
+            f.setAttributes([i, 'p{}'.format(i)])
+            ml1.addFeatures([f])
+        ml1.commitChanges()
+
+        ml2.startEditing()
+        for i, wkt in enumerate(['POLYGON((-0.5 -1,2.5 -1,2.5 1,-0.5 1,-0.5 -1))', 'POLYGON((1.5 -1,5.5 -1,5.5 1,1.5 1,1.5 -1))', 'POLYGON((20 20,21 20,21 21,20 21,20 20))']):
+            f = QgsFeature(ml2.fields())
+            f.setGeometry(QgsGeometry.fromWkt(wkt))
+            f.setAttributes([i * 2, 'poly{}'.format(i)])
+            ml2.addFeatures([f])
+        ml2.commitChanges()
+
+        queries = ["select id, name, geometry from native_points where id >= 3 and name <> 'p5'",
+                   "select * from native_points where name like 'P1%' or id between 7 and 8",
+                   "select p.id, p.geometry, g.label from native_points p join native_polygons g on p.id = g.pid",
+                   "select p.id, g.label, p.geometry from native_points p, native_polygons g where ST_Intersects(p.geometry, g.geometry) and g.pid > 0",
+                   "select p.name, g.label, g.geometry from native_points p join native_polygons g on ST_Intersects(g.geometry, p.geometry)",
+                   "select count(*), count(distinct label) as labels, sum(pid), avg(pid) as a, min(label), max(pid) from native_polygons where pid > 0",
+                   "select count(*) as n, count(distinct g.label) as labels, max(p.name) as m from native_points p join native_polygons g on ST_Intersects(p.geometry, g.geometry)",
+                   "select count(*) as n, count(name) as c from native_points where id > 100",
+                   # not supported natively, run by SQLite
+                   "select label, count(*) as c from native_polygons g, native_points p where ST_Intersects(p.geometry, g.geometry) group by label"]
+
+        def features(query, native):
+            QgsSettings().setValue('virtual/native_query_engine', native)
+            df = QgsVirtualLayerDefinition()
+            df.setQuery(query)
+            vl = QgsVectorLayer(df.toString(), "vl", "virtual")
+            QgsSettings().remove('virtual/native_query_engine')
+            self.assertTrue(vl.isValid())
+            result = sorted([(f.attributes(), f.geometry().asWkt() if f.hasGeometry() else None) for f in vl.getFeatures()])
+            return [f.name() for f in vl.fields()], vl.wkbType(), vl.featureCount(), result
+
+        for query in queries:
+            expected = features(query, False)
+            self.assertTrue(expected[3], query)
+            self.assertEqual(features(query, True), expected, query)
+
+        # filter rectangle
+        QgsSettings().setValue('virtual/native_query_engine', True)
+        vl = QgsVectorLayer("?query=%s&uid=id" % toPercent("select p.id, p.geometry, g.label from native_points p join native_polygons g on ST_Intersects(p.geometry, g.geometry)"), "vl", "virtual")
+        QgsSettings().remove('virtual/native_query_engine')
+        self.assertTrue(vl.isValid())
+        req = QgsFeatureRequest().setFilterRect(QgsRectangle(1.5, -1, 3.5, 1))
+        self.assertEqual(sorted([(f.id(), f['label']) for f in vl.getFeatures(req)]),
+                         [(2, 'poly0'), (2, 'poly1'), (3, 'poly1')])
+        self.assertEqual(sorted([f['label'] for f in vl.getFeatures(QgsFeatureRequest().setFilterFid(1))]), ['poly0'])
+        self.assertEqual(sorted([(f.id(), f['label']) for f in vl.getFeatures(QgsFeatureRequest().setFilterFids([1, 3, 42]))]),
+                         [(1, 'poly0'), (3, 'poly1')])
+
+        # without id column, ids are row numbers
+        QgsSettings().setValue('virtual/native_query_engine', True)
+        vl = QgsVectorLayer("?query=%s" % toPercent("select id, name from native_points where id >= 2"), "vl", "virtual")
+        QgsSettings().remove('virtual/native_query_engine')
+        self.assertTrue(vl.isValid())
+        self.assertEqual(sorted([(f.id(), f['name']) for f in vl.getFeatures(QgsFeatureRequest().setFilterFids([0, 3]))]),
+                         [(0, 'p2'), (3, 'p5')])
+        self.assertEqual([f for f in vl.getFeatures(QgsFeatureRequest().setFilterFids([]))], [])
+
+        QgsProject.instance().removeMapLayers([ml1.id(), ml2.id()])
+
     def testUpdatedFields(self):
         """Test when referenced layer update its fields
         https://github.com/qgis/QGIS/issues/28712
@@ -19,7 +19,7 @@ import tempfile
 # Needed on Qt 5 so that the serialization of XML is consistent among all executions
 os.environ['QT_HASH_SEED'] = '1'
 
-from qgis.PyQt.QtCore import QCoreApplication, Qt, QObject, QDateTime
+from qgis.PyQt.QtCore import QCoreApplication, Qt, QObject, QDateTime, QUrl
 
 from qgis.core import (
     QgsWkbTypes,
@@ -35,6 +35,9 @@ from qgis.core import (
     QgsExpression,
     QgsExpressionContextUtils,
     QgsExpressionContext,
+    QgsNetworkAccessManager,
+    QgsNetworkReplyContent,
+    QgsNetworkRequestParameters,
 )
 from qgis.testing import (start_app,
                           unittest
@@ -1286,6 +1289,122 @@ class TestPyQgsWFSProvider(unittest.TestCase, ProviderTestCase):
         values = [f['id'] for f in vl.getFeatures()]
         self.assertEqual(values, [1000, 2000])
 
+    def testWFS20PagingConcurrentPages(self):
+        """Test WFS 2.0 paging with the next pages requested in advance"""
+
+        endpoint = self.__class__.basetestpath + '/fake_qgis_http_endpoint_WFS_2.0_paging_concurrent'
+
+        with open(sanitize(endpoint, '?SERVICE=WFS?REQUEST=GetCapabilities?ACCEPTVERSIONS=2.0.0,1.1.0,1.0.0'), 'wb') as f:
+            f.write("""
+<wfs:WFS_Capabilities version="2.0.0" xmlns="http://www.opengis.net/wfs/2.0" xmlns:wfs="http://www.opengis.net/wfs/2.0" xmlns:ows="http://www.opengis.net/ows/1.1" xmlns:gml="http://schemas.opengis.net/gml/3.2" xmlns:fes="http://www.opengis.net/fes/2.0">
+  <OperationsMetadata>
+    <Operation name="GetFeature">
+      <Constraint name="CountDefault">
+        <NoValues/>
+        <DefaultValue>2</DefaultValue>
+      </Constraint>
+    </Operation>
+    <Constraint name="ImplementsResultPaging">
+      <NoValues/>
+      <DefaultValue>TRUE</DefaultValue>
+    </Constraint>
+  </OperationsMetadata>
+  <FeatureTypeList>
+    <FeatureType>
+      <Name>my:typename</Name>
+      <Title>Title</Title>
+      <Abstract>Abstract</Abstract>
+      <DefaultCRS>urn:ogc:def:crs:EPSG::4326</DefaultCRS>
+      <WGS84BoundingBox>
+        <LowerCorner>-71.123 66.33</LowerCorner>
+        <UpperCorner>-65.32 78.3</UpperCorner>
+      </WGS84BoundingBox>
+    </FeatureType>
+  </FeatureTypeList>
+</wfs:WFS_Capabilities>""".encode('UTF-8'))
+
+        with open(sanitize(endpoint, '?SERVICE=WFS&REQUEST=DescribeFeatureType&VERSION=2.0.0&TYPENAMES=my:typename&TYPENAME=my:typename'), 'wb') as f:
+            f.write("""
+<xsd:schema xmlns:my="http://my" xmlns:gml="http://www.opengis.net/gml/3.2" xmlns:xsd="http://www.w3.org/2001/XMLSchema" elementFormDefault="qualified" targetNamespace="http://my">
+  <xsd:import namespace="http://www.opengis.net/gml/3.2"/>
+  <xsd:complexType name="typenameType">
+    <xsd:complexContent>
+      <xsd:extension base="gml:AbstractFeatureType">
+        <xsd:sequence>
+          <xsd:element maxOccurs="1" minOccurs="0" name="id" nillable="true" type="xsd:int"/>
+          <xsd:element maxOccurs="1" minOccurs="0" name="geometryProperty" nillable="true" type="gml:GeometryPropertyType"/>
+        </xsd:sequence>
+      </xsd:extension>
+    </xsd:complexContent>
+  </xsd:complexType>
+  <xsd:element name="typename" substitutionGroup="gml:_Feature" type="my:typenameType"/>
+</xsd:schema>
+""".encode('UTF-8'))
+
+        # 11 features in pages of 2, the server doesn't report the number of matched features
+        # The pages following the last one may be requested in advance
+        for startindex in range(0, 18, 2):
+            members = ''
+            for i in range(startindex, min(startindex + 2, 11)):
+                members += """
+  <wfs:member>
+    <my:typename gml:id="typename.%d">
+      <my:geometryProperty><gml:Point srsName="urn:ogc:def:crs:EPSG::4326" gml:id="typename.geom.%d"><gml:pos>66.33 -70.332</gml:pos></gml:Point></my:geometryProperty>
+      <my:id>%d</my:id>
+    </my:typename>
+  </wfs:member>""" % (i, i, i + 1)
+            with open(sanitize(endpoint, '?SERVICE=WFS&REQUEST=GetFeature&VERSION=2.0.0&TYPENAMES=my:typename&TYPENAME=my:typename&STARTINDEX=%d&COUNT=2&SRSNAME=urn:ogc:def:crs:EPSG::4326' % startindex), 'wb') as f:
+                f.write(("""
+<wfs:FeatureCollection xmlns:wfs="http://www.opengis.net/wfs/2.0"
+                       xmlns:gml="http://www.opengis.net/gml/3.2"
+                       xmlns:my="http://my"
+                       numberMatched="unknown" numberReturned="%d" timeStamp="2016-03-25T14:51:48.998Z">%s
+</wfs:FeatureCollection>""" % (max(0, min(2, 11 - startindex)), members)).encode('UTF-8'))
+
+        vl = QgsVectorLayer("url='http://" + endpoint + "' typename='my:typename'", 'test', 'WFS')
+        self.assertTrue(vl.isValid())
+
+        # Network events of the pages, in the order they occur in the downloader thread
+        events = []
+
+        def startIndex(url):
+            match = re.search(r'STARTINDEX=(\d+)', url.toString(QUrl.FullyDecoded))
+            return int(match.group(1)) if match else None
+
+        def requestCreated(request):
+            events.append(('created', startIndex(request.request().url())))
+
+        def requestFinished(reply):
+            events.append(('finished', startIndex(reply.request().url())))
+
+        nam = QgsNetworkAccessManager.instance()
+        nam.requestAboutToBeCreated[QgsNetworkRequestParameters].connect(requestCreated)
+        nam.finished[QgsNetworkReplyContent].connect(requestFinished)
+
+        # Features are returned in the order of the pages
+        values = [f['id'] for f in vl.getFeatures()]
+        self.assertEqual(values, list(range(1, 12)))
+        self.assertEqual(vl.featureCount(), 11)
+
+        for i in range(10):
+            QCoreApplication.processEvents()
+        nam.requestAboutToBeCreated[QgsNetworkRequestParameters].disconnect(requestCreated)
+        nam.finished[QgsNetworkReplyContent].disconnect(requestFinished)
+
+        # Once the second page is requested, the following ones are requested
+        # before it is received
+        self.assertIn(('finished', 2), events)
+        for startindex in (4, 6, 8):
+            self.assertIn(('created', startindex), events)
+            self.assertLess(events.index(('created', startindex)), events.index(('finished', 2)))
+
+        # Same result with a single request at a time
+        vl.dataProvider().reloadData()
+        QgsSettings().setValue('wfs/concurrent_page_requests', 1)
+        values = [f['id'] for f in vl.getFeatures()]
+        QgsSettings().remove('wfs/concurrent_page_requests')
+        self.assertEqual(values, list(range(1, 12)))
+
     def testWFSGetOnlyFeaturesInViewExtent(self):
         """Test 'get only features in view extent' """
 
@@ -4148,6 +4267,95 @@ java.io.IOExceptionCannot do natural order without a primary key, please add it
         values = [f['INTFIELD'] for f in vl.getFeatures()]
         self.assertEqual(values, [1, 2])
 
+    def testPersistentCache(self):
+        """Test that the cache is kept across sessions when wfs/persistent_cache_max_age is set"""
+
+        endpoint = self.__class__.basetestpath + '/fake_qgis_http_endpoint_persistent_cache'
+
+        with open(sanitize(endpoint, '?SERVICE=WFS?REQUEST=GetCapabilities?ACCEPTVERSIONS=2.0.0,1.1.0,1.0.0'), 'wb') as f:
+            f.write("""
+<wfs:WFS_Capabilities version="2.0.0" xmlns="http://www.opengis.net/wfs/2.0" xmlns:wfs="http://www.opengis.net/wfs/2.0" xmlns:ows="http://www.opengis.net/ows/1.1" xmlns:gml="http://schemas.opengis.net/gml/3.2" xmlns:fes="http://www.opengis.net/fes/2.0">
+  <FeatureTypeList>
+    <FeatureType>
+      <Name>my:typename</Name>
+      <DefaultCRS>urn:ogc:def:crs:EPSG::4326</DefaultCRS>
+      <WGS84BoundingBox>
+        <LowerCorner>-80 60</LowerCorner>
+        <UpperCorner>-50 80</UpperCorner>
+      </WGS84BoundingBox>
+    </FeatureType>
+  </FeatureTypeList>
+</wfs:WFS_Capabilities>""".encode('UTF-8'))
+
+        with open(sanitize(endpoint, '?SERVICE=WFS&REQUEST=DescribeFeatureType&VERSION=2.0.0&TYPENAMES=my:typename&TYPENAME=my:typename'), 'wb') as f:
+            f.write("""
+<xsd:schema xmlns:my="http://my" xmlns:gml="http://www.opengis.net/gml/3.2" xmlns:xsd="http://www.w3.org/2001/XMLSchema" elementFormDefault="qualified" targetNamespace="http://my">
+  <xsd:import namespace="http://www.opengis.net/gml/3.2"/>
+  <xsd:complexType name="typenameType">
+    <xsd:complexContent>
+      <xsd:extension base="gml:AbstractFeatureType">
+        <xsd:sequence>
+          <xsd:element maxOccurs="1" minOccurs="0" name="intfield" nillable="true" type="xsd:int"/>
+          <xsd:element maxOccurs="1" minOccurs="0" name="geometryProperty" nillable="true" type="gml:PointPropertyType"/>
+        </xsd:sequence>
+      </xsd:extension>
+    </xsd:complexContent>
+  </xsd:complexType>
+  <xsd:element name="typename" substitutionGroup="gml:_Feature" type="my:typenameType"/>
+</xsd:schema>
+""".encode('UTF-8'))
+
+        get_feature = sanitize(endpoint, '?SERVICE=WFS&REQUEST=GetFeature&VERSION=2.0.0&TYPENAMES=my:typename&TYPENAME=my:typename&SRSNAME=urn:ogc:def:crs:EPSG::4326')
+        with open(get_feature, 'wb') as f:
+            f.write("""
+<wfs:FeatureCollection xmlns:wfs="http://www.opengis.net/wfs/2.0"
+                       xmlns:gml="http://www.opengis.net/gml/3.2"
+                       xmlns:my="http://my"
+                       numberMatched="2" numberReturned="2" timeStamp="2016-03-25T14:51:48.998Z">
+  <wfs:member>
+    <my:typename gml:id="typename.1">
+      <my:intfield>1</my:intfield>
+      <my:geometryProperty><gml:Point srsName="urn:ogc:def:crs:EPSG::4326" gml:id="typename.geom.1"><gml:pos>70 -65</gml:pos></gml:Point></my:geometryProperty>
+    </my:typename>
+  </wfs:member>
+  <wfs:member>
+    <my:typename gml:id="typename.2">
+      <my:intfield>2</my:intfield>
+      <my:geometryProperty><gml:Point srsName="urn:ogc:def:crs:EPSG::4326" gml:id="typename.geom.2"><gml:pos>72 -60</gml:pos></gml:Point></my:geometryProperty>
+    </my:typename>
+  </wfs:member>
+</wfs:FeatureCollection>""".encode('UTF-8'))
+
+        QgsSettings().setValue('wfs/persistent_cache_max_age', 3600)
+        try:
+            vl = QgsVectorLayer("url='http://" + endpoint + "' typename='my:typename'", 'test', 'WFS')
+            self.assertTrue(vl.isValid())
+            self.assertEqual([(f.id(), f['intfield']) for f in vl.getFeatures()], [(1, 1), (2, 2)])
+            vl = None
+
+            # The next session does not download the features again
+            os.unlink(get_feature)
+            vl = QgsVectorLayer("url='http://" + endpoint + "' typename='my:typename'", 'test', 'WFS')
+            self.assertTrue(vl.isValid())
+            features = [f for f in vl.getFeatures()]
+            self.assertEqual([(f.id(), f['intfield']) for f in features], [(1, 1), (2, 2)])
+            self.assertEqual(features[1].geometry().asWkt(), 'Point (-60 72)')
+            self.assertEqual(vl.featureCount(), 2)
+            self.assertEqual([f['intfield'] for f in vl.getFeatures(QgsRectangle(-61, 71, -59, 73))], [2])
+
+            # Another layer with the same source does not share the cache in use
+            vl2 = QgsVectorLayer("url='http://" + endpoint + "' typename='my:typename'", 'test', 'WFS')
+            self.assertTrue(vl2.isValid())
+            self.assertEqual([f for f in vl2.getFeatures()], [])
+            vl2 = None
+
+            # A reload downloads the features again
+            vl.dataProvider().reloadData()
+            self.assertEqual([f for f in vl.getFeatures()], [])
+            vl = None
+        finally:
+            QgsSettings().setValue('wfs/persistent_cache_max_age', 0)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,78 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsRasterProjector.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'agent'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+
+import qgis  # NOQA
+
+import os
+
+from qgis.core import (QgsCoordinateReferenceSystem,
+                       QgsCoordinateTransform,
+                       QgsCoordinateTransformContext,
+                       QgsRasterLayer,
+                       QgsRasterProjector)
+
+from qgis.testing import start_app, unittest
+from utilities import unitTestDataPath
+
+start_app()
+
+
+class TestQgsRasterProjector(unittest.TestCase):
+
+    def projectedBlock(self, layer, destCrs, precision, extent, width, height):
+        projector = QgsRasterProjector()
+        projector.setCrs(layer.crs(), destCrs, QgsCoordinateTransformContext())
+        projector.setPrecision(precision)
+        projector.setInput(layer.dataProvider())
+        return projector.block(1, extent, width, height)
+
+    def testApproximateMatchesExact(self):
+        layer = QgsRasterLayer(os.path.join(unitTestDataPath(), 'landsat.tif'), 'landsat')
+        self.assertTrue(layer.isValid())
+
+        destCrs = QgsCoordinateReferenceSystem('EPSG:4326')
+        ct = QgsCoordinateTransform(layer.crs(), destCrs, QgsCoordinateTransformContext())
+        extent = ct.transformBoundingBox(layer.extent())
+        width = 100
+        height = 80
+
+        exact = self.projectedBlock(layer, destCrs, QgsRasterProjector.Exact, extent, width, height)
+        approximate = self.projectedBlock(layer, destCrs, QgsRasterProjector.Approximate, extent, width, height)
+        self.assertTrue(exact.isValid())
+        self.assertTrue(approximate.isValid())
+        self.assertEqual(exact.width(), width)
+        self.assertEqual(exact.height(), height)
+
+        # approximation tolerance is one destination pixel, so only few pixels on edges may differ
+        different = 0
+        for row in range(height):
+            for col in range(width):
+                if exact.value(row, col) != approximate.value(row, col):
+                    different += 1
+        self.assertLess(different, width * height * 0.05)
+
+    def testRepeatedBlocks(self):
+        """ the second request uses cached approximation grid and must give the same result """
+        layer = QgsRasterLayer(os.path.join(unitTestDataPath(), 'landsat.tif'), 'landsat')
+        self.assertTrue(layer.isValid())
+
+        destCrs = QgsCoordinateReferenceSystem('EPSG:3857')
+        ct = QgsCoordinateTransform(layer.crs(), destCrs, QgsCoordinateTransformContext())
+        extent = ct.transformBoundingBox(layer.extent())
+
+        first = self.projectedBlock(layer, destCrs, QgsRasterProjector.Approximate, extent, 64, 64)
+        second = self.projectedBlock(layer, destCrs, QgsRasterProjector.Approximate, extent, 64, 64)
+        self.assertEqual(first.data(), second.data())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -13,9 +13,12 @@ __copyright__ = 'Copyright 2015, The QGIS Project'
 print('CTEST_FULL_OUTPUT')
 
 from qgis.testing import unittest
+import json
+import time
 import urllib.request
 import urllib.parse
 import urllib.error
+import xml.etree.ElementTree as ET
 from test_qgsserver_accesscontrol import TestQgsServerAccessControl
 
 
@@ -447,6 +450,73 @@ class TestQgsServerAccessControlWMS(TestQgsServerAccessControl):
             str(response).find("<qgs:pk>1</qgs:pk>") != -1,
             "Unexpected result in GetFeatureInfo\n%s" % response)
 
+    def _get_feature_info_layers(self, restricted, query_layers, x, y):
+        """Returns the layers of a text/xml GetFeatureInfo with their features
+        as a list of (layer name, [{attribute name: value}])"""
+        query_string = "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "VERSION": "1.1.1",
+            "REQUEST": "GetFeatureInfo",
+            "LAYERS": "Hello,Hello_SubsetString",
+            "QUERY_LAYERS": query_layers,
+            "STYLES": "",
+            "FORMAT": "image/png",
+            "BBOX": "-16817707,-6318936.5,5696513,16195283.5",
+            "HEIGHT": "500",
+            "WIDTH": "500",
+            "SRS": "EPSG:3857",
+            "FEATURE_COUNT": "10",
+            "INFO_FORMAT": "text/xml",
+            "X": x,
+            "Y": y
+        }.items())])
+
+        if restricted:
+            response, headers = self._get_restricted(query_string)
+        else:
+            response, headers = self._get_fullaccess(query_string)
+        self.assertEqual(
+            headers.get("Content-Type"), "text/xml; charset=utf-8",
+            "Content type for GetFeatureInfo is wrong: %s\n%s" % (headers.get("Content-Type"), response))
+
+        layers = []
+        for layer in ET.fromstring(response).findall("Layer"):
+            features = []
+            for feature in layer.findall("Feature"):
+                features.append({a.get("name"): a.get("value") for a in feature.findall("Attribute")})
+            layers.append((layer.get("name"), features))
+        return layers
+
+    def test_wms_getfeatureinfo_multiple_layers(self):
+        # The layers are queried concurrently, the result keeps the order of
+        # QUERY_LAYERS and the filters of the access control of each layer
+        for query_layers in (["Hello", "Hello_SubsetString"], ["Hello_SubsetString", "Hello"]):
+            layers = self._get_feature_info_layers(False, ",".join(query_layers), "56", "144")
+            self.assertEqual([name for name, features in layers], query_layers)
+            for name, features in layers:
+                colors = {f["pk"]: f["color"] for f in features}  # spellok
+                self.assertEqual(colors.get("1"), "red", name)
+
+            # the color attribute is not authorized
+            layers = self._get_feature_info_layers(True, ",".join(query_layers), "56", "144")
+            self.assertEqual([name for name, features in layers], query_layers)
+            for name, features in layers:
+                self.assertEqual([f["pk"] for f in features], ["1"], name)
+                self.assertNotIn("color", features[0], name)  # spellok
+
+            layers = self._get_feature_info_layers(False, ",".join(query_layers), "146", "160")
+            self.assertEqual([name for name, features in layers], query_layers)
+            for name, features in layers:
+                self.assertIn("2", [f["pk"] for f in features], name)
+
+            # the feature 2 is filtered out by the expression of Hello and
+            # the subset string of Hello_SubsetString
+            layers = self._get_feature_info_layers(True, ",".join(query_layers), "146", "160")
+            self.assertEqual([name for name, features in layers], query_layers)
+            for name, features in layers:
+                self.assertEqual(features, [], name)
+
 
 # # Subset String # #
 
@@ -898,6 +968,56 @@ class TestQgsServerAccessControlWMS(TestQgsServerAccessControl):
             str(response).find("<qgs:pk>") != -1,
             "Unexpected result from GetFeatureInfo Hello/2\n%s" % response)
 
+    def _get_print_job(self, layers):
+        """Queues an asynchronous GetPrint of the restricted user and returns
+        the output of the job"""
+        query_string = "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "VERSION": "1.1.1",
+            "REQUEST": "GetPrint",
+            "TEMPLATE": "layoutA4",
+            "FORMAT": "png",
+            "ASYNC": "true",
+            "map0:EXTENT": "-16817707,-6318936.5,5696513,16195283.5",
+            "LAYERS": layers,
+            "CRS": "EPSG:3857"
+        }.items())])
+        response, headers = self._get_restricted(query_string)
+        self.assertEqual(headers.get("Content-Type"), "application/json")
+        job = json.loads(response.decode('utf-8'))
+
+        query_string = "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "REQUEST": "GetPrintJob",
+            "JOB": job['job']
+        }.items())])
+
+        # The job is rendered by another thread
+        for i in range(600):
+            response, headers = self._get_restricted(query_string)
+            if headers.get("Content-Type") != "application/json":
+                break
+            self.assertIn(json.loads(response.decode('utf-8'))['status'], ('queued', 'running'))
+            time.sleep(0.1)
+        return response, headers
+
+    def test_wms_getprint_async(self):
+        # The access control of the plugin is applied by the thread of the job
+        response, headers = self._get_print_job("Hello")
+        self.assertEqual(
+            headers.get("Content-Type"), "image/png",
+            "Content type for asynchronous GetPrint is wrong: %s\n%s" % (headers.get("Content-Type"), response))
+
+        response, headers = self._get_print_job("Country,Hello")
+        self.assertEqual(
+            headers.get("Content-Type"), "text/xml; charset=utf-8",
+            "Content type for asynchronous GetPrint is wrong: %s" % headers.get("Content-Type"))
+        self.assertTrue(
+            str(response).find('<ServiceException code="Security">') != -1,
+            "Not allowed do an asynchronous GetPrint on Country\n%s" % response)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -32,7 +32,7 @@ from qgis.server import (
     QgsServerApiUtils,
     QgsServiceRegistry
 )
-from qgis.core import QgsProject, QgsRectangle
+from qgis.core import QgsFeature, QgsGeometry, QgsPointXY, QgsProject, QgsRectangle, QgsVectorLayer
 from qgis.PyQt import QtCore
 
 from qgis.testing import unittest
@@ -380,6 +380,64 @@ class QgsServerAPITest(QgsServerAPITestBase):
         self.assertEqual(response.statusCode(), 400) # Bad request
         self.assertEqual(response.body(), b'[{"code":"Bad request error","description":"Argument \'limit\' is not valid. Number of features to retrieve [0-10000]"}]') # Bad request
 
+    def test_wfs3_collection_items_cursor(self):
+        """Test WFS3 API cursor paging"""
+        project = QgsProject()
+        project.read(unitTestDataPath('qgis_server') + '/test_project_api.qgs')
+
+        def items(query):
+            request = QgsBufferServerRequest('http://server.qgis.org/wfs3/collections/testlayer%20èé/items?' + query)
+            response = QgsBufferServerResponse()
+            self.server.handleRequest(request, response, project)
+            self.assertEqual(response.statusCode(), 200)
+            j = json.loads(bytes(response.body()))
+            next_links = [l['href'] for l in j['links'] if l['rel'] == 'next']
+            return [f['id'] for f in j['features']], next_links
+
+        self.assertEqual(items('limit=1'), ([0], ['http://server.qgis.org/wfs3/collections/testlayer èé/items?&cursor=0&limit=1']))
+        self.assertEqual(items('cursor=0&limit=1'), ([1], ['http://server.qgis.org/wfs3/collections/testlayer èé/items?&cursor=1&limit=1']))
+        self.assertEqual(items('cursor=1&limit=1'), ([2], []))
+        self.assertEqual(items('cursor=0&limit=2'), ([1, 2], []))
+
+        request = QgsBufferServerRequest('http://server.qgis.org/wfs3/collections/testlayer%20èé/items?limit=1&offset=1&cursor=0')
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response, project)
+        self.assertEqual(response.statusCode(), 400) # Bad request
+        self.assertEqual(response.body(), b'[{"code":"Bad request error","description":"cursor cannot be combined with offset"}]') # Bad request
+        request = QgsBufferServerRequest('http://server.qgis.org/wfs3/collections/testlayer%20èé/items?limit=1&cursor=abc')
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response, project)
+        self.assertEqual(response.statusCode(), 400) # Bad request
+        self.assertEqual(response.body(), b'[{"code":"Bad request error","description":"cursor is not valid"}]') # Bad request
+
+    def test_wfs3_collection_items_cursor_not_ordered(self):
+        """Test WFS3 API offset paging of the collections which cannot be ordered by key"""
+        layer = QgsVectorLayer('Point?crs=epsg:4326&field=name:string', 'memorylayer', 'memory')
+        features = []
+        for i in range(3):
+            f = QgsFeature(layer.fields())
+            f.setAttributes(['f%s' % i])
+            f.setGeometry(QgsGeometry.fromPointXY(QgsPointXY(i, i)))
+            features.append(f)
+        self.assertTrue(layer.dataProvider().addFeatures(features)[0])
+        project = QgsProject()
+        project.addMapLayer(layer)
+        project.writeEntry('WFSLayers', '/', [layer.id()])
+
+        request = QgsBufferServerRequest('http://server.qgis.org/wfs3/collections/memorylayer/items?limit=1')
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response, project)
+        self.assertEqual(response.statusCode(), 200)
+        j = json.loads(bytes(response.body()))
+        self.assertEqual([f['properties']['name'] for f in j['features']], ['f0'])
+        self.assertEqual([l['href'] for l in j['links'] if l['rel'] == 'next'], ['http://server.qgis.org/wfs3/collections/memorylayer/items?&offset=1&limit=1'])
+
+        request = QgsBufferServerRequest('http://server.qgis.org/wfs3/collections/memorylayer/items?limit=1&cursor=0')
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response, project)
+        self.assertEqual(response.statusCode(), 400) # Bad request
+        self.assertEqual(response.body(), b'[{"code":"Bad request error","description":"cursor is not supported by this collection"}]') # Bad request
+
     def test_wfs3_collection_items_bbox(self):
         """Test WFS3 API bbox"""
         project = QgsProject()
@@ -0,0 +1,225 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the built-in response cache of QgsServer.
+
+From build dir, run: ctest -R PyQgsServerResponseCache -V
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+"""
+__author__ = 'agent'
+__date__ = '18/10/2026'
+__copyright__ = 'Copyright 2026, The QGIS Project'
+
+import qgis  # NOQA
+
+import os
+import shutil
+import tempfile
+import time
+import urllib.parse
+
+from qgis.testing import unittest
+from qgis.PyQt.QtCore import QByteArray
+from qgis.server import QgsServerRequest, QgsBufferServerRequest, QgsBufferServerResponse, QgsServerCacheFilter
+
+from test_qgsserver import QgsServerTestBase
+
+
+class RenderCounter(QgsServerCacheFilter):
+
+    """Counts the legends rendered by the WMS service, which looks them up
+    in the plugin caches first"""
+
+    def __init__(self, server_iface):
+        super().__init__(server_iface)
+        self.count = 0
+
+    def getCachedImage(self, project, request, key):
+        self.count += 1
+        return QByteArray()
+
+    def setCachedImage(self, img, project, request, key):
+        return False
+
+
+class TestQgsServerResponseCache(QgsServerTestBase):
+
+    """QGIS Server response cache tests"""
+
+    renderCounter = None
+
+    def setUp(self):
+        super().setUp()
+        # Plugin caches are registered for the lifetime of the server
+        if TestQgsServerResponseCache.renderCounter is None:
+            TestQgsServerResponseCache.renderCounter = RenderCounter(self.server.serverInterface())
+            self.server.serverInterface().registerServerCache(TestQgsServerResponseCache.renderCounter, 100)
+        self.cacheDirectory = tempfile.mkdtemp()
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_SIZE', str(10 * 1024 * 1024))
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_DIRECTORY', self.cacheDirectory)
+
+    def tearDown(self):
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_SIZE', '0')
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_DIRECTORY', '')
+        shutil.rmtree(self.cacheDirectory, True)
+
+    def _request(self, qs, headers={}):
+        request = QgsBufferServerRequest(qs, QgsServerRequest.GetMethod, headers)
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(request, response)
+        return response
+
+    def _legend_query(self, **params):
+        query = {
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "VERSION": "1.1.1",
+            "REQUEST": "GetLegendGraphic",
+            "LAYER": "Hello",
+            "FORMAT": "image/png"
+        }
+        query.update(params)
+        return "?" + "&".join(["%s=%s" % i for i in query.items()])
+
+    def test_etag(self):
+        qs = self._legend_query()
+        response = self._request(qs)
+        self.assertEqual(response.statusCode(), 200)
+        self.assertEqual(response.headers()['Content-Type'], 'image/png')
+        etag = response.headers()['ETag']
+        self.assertTrue(etag.startswith('"'))
+        self.assertIn('Last-Modified', response.headers())
+        self.assertTrue(bytes(response.body()))
+
+        other = self._request(self._legend_query(LAYER="Country"))
+        self.assertNotEqual(other.headers()['ETag'], etag)
+
+    def test_cache_hit(self):
+        renders = self.renderCounter.count
+        qs = self._legend_query()
+        response = self._request(qs)
+        self.assertEqual(response.statusCode(), 200)
+        content = bytes(response.body())
+        self.assertTrue(content)
+        self.assertEqual(self.renderCounter.count, renders + 1)
+
+        # Same parameters in another order, served from the cache without rendering
+        cached = self._request(self._legend_query(FORMAT="image/png", LAYER="Hello"))
+        self.assertEqual(cached.statusCode(), 200)
+        self.assertEqual(cached.headers()['ETag'], response.headers()['ETag'])
+        self.assertEqual(bytes(cached.body()), content)
+        self.assertEqual(self.renderCounter.count, renders + 1)
+
+        # Other parameters are rendered
+        self._request(self._legend_query(LAYER="Country"))
+        self.assertEqual(self.renderCounter.count, renders + 2)
+
+    def test_conditional_requests(self):
+        qs = self._legend_query()
+        etag = self._request(qs).headers()['ETag']
+
+        response = self._request(qs, {'If-None-Match': etag})
+        self.assertEqual(response.statusCode(), 304)
+        self.assertEqual(bytes(response.body()), b'')
+        self.assertEqual(response.headers()['ETag'], etag)
+
+        response = self._request(qs, {'If-None-Match': '"other", ' + etag})
+        self.assertEqual(response.statusCode(), 304)
+
+        response = self._request(qs, {'If-None-Match': '"other"'})
+        self.assertEqual(response.statusCode(), 200)
+        self.assertTrue(bytes(response.body()))
+
+    def test_disk_cache(self):
+        renders = self.renderCounter.count
+        qs = self._legend_query()
+        content = bytes(self._request(qs).body())
+        self.assertEqual(self.renderCounter.count, renders + 1)
+
+        files = []
+        for root, dirs, names in os.walk(self.cacheDirectory):
+            files += [n for n in names if n.endswith('.response')]
+        self.assertEqual(len(files), 1)
+
+        # Served from the disk cache only
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_SIZE', '0')
+        response = self._request(qs)
+        self.assertIn('ETag', response.headers())
+        self.assertEqual(bytes(response.body()), content)
+        self.assertEqual(self.renderCounter.count, renders + 1)
+
+    def test_disk_cache_prune(self):
+        # The oldest responses are removed when the directory is too large
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_SIZE', '0')
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_DISK_SIZE', '1')
+        try:
+            response = self._request(self._legend_query())
+            self.assertEqual(response.statusCode(), 200)
+            files = []
+            for root, dirs, names in os.walk(self.cacheDirectory):
+                files += [n for n in names if n.endswith('.response')]
+            self.assertEqual(files, [])
+        finally:
+            self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_DISK_SIZE', str(50 * 1024 * 1024))
+
+    def test_max_age(self):
+        self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_SIZE', '0')
+        try:
+            renders = self.renderCounter.count
+            qs = self._legend_query()
+            content = bytes(self._request(qs).body())
+            self.assertEqual(self.renderCounter.count, renders + 1)
+
+            files = []
+            for root, dirs, names in os.walk(self.cacheDirectory):
+                files += [os.path.join(root, n) for n in names if n.endswith('.response')]
+            self.assertEqual(len(files), 1)
+
+            # Responses older than the default maximum age are executed again
+            old = time.time() - 7200
+            os.utime(files[0], (old, old))
+            response = self._request(qs)
+            self.assertEqual(bytes(response.body()), content)
+            self.assertEqual(self.renderCounter.count, renders + 2)
+            self.assertGreater(os.path.getmtime(files[0]), old)
+
+            # Without maximum age, they are served until the project changes
+            self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_MAX_AGE', '0')
+            os.utime(files[0], (old, old))
+            response = self._request(qs)
+            self.assertEqual(bytes(response.body()), content)
+            self.assertEqual(self.renderCounter.count, renders + 2)
+        finally:
+            self.server.putenv('QGIS_SERVER_RESPONSE_CACHE_MAX_AGE', '3600')
+
+    def test_not_cached(self):
+        # Feature info is not cached
+        qs = "?" + "&".join(["%s=%s" % i for i in {
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "VERSION": "1.1.1",
+            "REQUEST": "GetFeatureInfo",
+            "LAYERS": "Country",
+            "QUERY_LAYERS": "Country",
+            "STYLES": "",
+            "FORMAT": "image/png",
+            "INFO_FORMAT": "text/xml",
+            "BBOX": "-16817707,-4710778,5696513,14587125",
+            "SRS": "EPSG:3857",
+            "WIDTH": "500",
+            "HEIGHT": "500",
+            "X": "250",
+            "Y": "250"
+        }.items()])
+        response = self._request(qs)
+        self.assertNotIn('ETag', response.headers())
+
+        # Errors are not cached
+        response = self._request(self._legend_query(LAYER="Unknown"))
+        self.assertNotIn('ETag', response.headers())
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -131,6 +131,16 @@ class TestQgsServerSettings(unittest.TestCase):
         self.assertEqual(self.settings.cacheDirectory(), "/tmp/fake")
         os.environ.pop(env)
 
+    def test_env_project_prewarm(self):
+        env = "QGIS_SERVER_PROJECT_PREWARM"
+
+        self.assertEqual(self.settings.projectPrewarm(), [])
+
+        os.environ[env] = os.pathsep.join(["/tmp/a.qgs", "", "/tmp/b.qgz"])
+        self.settings.load()
+        self.assertEqual(self.settings.projectPrewarm(), ["/tmp/a.qgs", "/tmp/b.qgz"])
+        os.environ.pop(env)
+
     def test_priority(self):
         env = "QGIS_OPTIONS_PATH"
         dpath = "conf0"
@@ -28,7 +28,13 @@ from qgis.server import QgsServerRequest
 
 from qgis.testing import unittest
 from qgis.PyQt.QtCore import QSize
-from qgis.core import QgsVectorLayer
+from qgis.core import (
+    NULL,
+    QgsFeature,
+    QgsGeometry,
+    QgsProject,
+    QgsVectorLayer,
+)
 
 import osgeo.gdal  # NOQA
 
@@ -137,6 +143,144 @@ class TestQgsServerWFS(QgsServerTestBase):
         for id, req in tests:
             self.wfs_getfeature_compare(id, req)
 
+    def _streamed_features_project(self):
+        """Returns a project with two layers, one of them with values to be escaped"""
+        project = QgsProject()
+        points = QgsVectorLayer('Point?crs=EPSG:4326&field=name:string&field=id:integer&field=note:string&field=value:double', 'points', 'memory')
+        f1 = QgsFeature(points.fields())
+        f1.setAttributes(['a < b & c', 1, 'He said "hi" > bye', 1.5])
+        f1.setGeometry(QgsGeometry.fromWkt('Point (1 2)'))
+        f2 = QgsFeature(points.fields())
+        f2.setAttributes(['line\r\nbreak\ttab', 2, NULL, NULL])
+        self.assertTrue(points.dataProvider().addFeatures([f1, f2]))
+
+        lines = QgsVectorLayer('LineString?crs=EPSG:4326&field=label:string', 'lines', 'memory')
+        f3 = QgsFeature(lines.fields())
+        f3.setAttributes(['x/y'])
+        f3.setGeometry(QgsGeometry.fromWkt('LineString (0 0, 10 5)'))
+        self.assertTrue(lines.dataProvider().addFeatures([f3]))
+
+        project.addMapLayers([points, lines])
+        project.writeEntry('WFSLayers', '/', [points.id(), lines.id()])
+        return project
+
+    def test_getfeature_streamed_output(self):
+        """Test that the features are written as the DOM documents and the
+        JSON exporter wrote them before the output was streamed"""
+        project = self._streamed_features_project()
+        qs = '?SERVICE=WFS&VERSION=1.1.0&REQUEST=GetFeature&TYPENAME=points,lines&OUTPUTFORMAT='
+
+        points_attributes = [
+            b'  <qgs:name>&lt;![CDATA[a &lt; b &amp; c]]&gt;</qgs:name>',
+            b'  <qgs:id>1</qgs:id>',
+            b'  <qgs:note>He said "hi" > bye</qgs:note>',
+            b'  <qgs:value>1.5</qgs:value>',
+            b' </qgs:points>',
+            b'</gml:featureMember>',
+            b'<gml:featureMember>',
+        ]
+        null_attributes = [
+            b'  <qgs:name>line&#xd;\nbreak\ttab</qgs:name>',
+            b'  <qgs:id>2</qgs:id>',
+            b'  <qgs:note xsi:nil="true"></qgs:note>',
+            b'  <qgs:value xsi:nil="true"></qgs:value>',
+            b' </qgs:points>',
+            b'</gml:featureMember>',
+            b'<gml:featureMember>',
+        ]
+
+        header, body = self._execute_request_project(qs + 'GML2', project)
+        self.assertIn(b'Content-Type: text/xml; subtype=gml/2.1.2; charset=utf-8', header)
+        expected = b'\n'.join([
+            b'<gml:featureMember>',
+            b' <qgs:points fid="points.1">',
+            b'  <gml:boundedBy>',
+            b'   <gml:Box srsName="EPSG:4326">',
+            b'    <gml:coordinates cs="," ts=" ">1,2 1,2</gml:coordinates>',
+            b'   </gml:Box>',
+            b'  </gml:boundedBy>',
+            b'  <qgs:geometry>',
+            b'   <Point xmlns="http://www.opengis.net/gml" srsName="EPSG:4326">',
+            b'    <coordinates xmlns="http://www.opengis.net/gml" cs="," ts=" ">1,2</coordinates>',
+            b'   </Point>',
+            b'  </qgs:geometry>',
+        ] + points_attributes + [
+            b' <qgs:points fid="points.2">',
+        ] + null_attributes + [
+            b' <qgs:lines fid="lines.1">',
+            b'  <gml:boundedBy>',
+            b'   <gml:Box srsName="EPSG:4326">',
+            b'    <gml:coordinates cs="," ts=" ">0,0 10,5</gml:coordinates>',
+            b'   </gml:Box>',
+            b'  </gml:boundedBy>',
+            b'  <qgs:geometry>',
+            b'   <LineString xmlns="http://www.opengis.net/gml" srsName="EPSG:4326">',
+            b'    <coordinates xmlns="http://www.opengis.net/gml" cs="," ts=" ">0,0 10,5</coordinates>',
+            b'   </LineString>',
+            b'  </qgs:geometry>',
+            b'  <qgs:label>x/y</qgs:label>',
+            b' </qgs:lines>',
+            b'</gml:featureMember>',
+            b'</wfs:FeatureCollection>',
+            b''
+        ])
+        self.assertEqual(body[body.index(b'<gml:featureMember>'):], expected)
+
+        header, body = self._execute_request_project(qs + 'GML3', project)
+        self.assertIn(b'Content-Type: text/xml; subtype=gml/3.1.1; charset=utf-8', header)
+        expected = b'\n'.join([
+            b'<gml:featureMember>',
+            b' <qgs:points gml:id="points.1">',
+            b'  <gml:boundedBy>',
+            b'   <gml:Envelope srsName="EPSG:4326">',
+            b'    <gml:lowerCorner>1 2</gml:lowerCorner>',
+            b'    <gml:upperCorner>1 2</gml:upperCorner>',
+            b'   </gml:Envelope>',
+            b'  </gml:boundedBy>',
+            b'  <qgs:geometry>',
+            b'   <Point xmlns="http://www.opengis.net/gml" srsName="EPSG:4326">',
+            b'    <pos xmlns="http://www.opengis.net/gml" srsDimension="2">1 2</pos>',
+            b'   </Point>',
+            b'  </qgs:geometry>',
+        ] + points_attributes + [
+            b' <qgs:points gml:id="points.2">',
+        ] + null_attributes + [
+            b' <qgs:lines gml:id="lines.1">',
+            b'  <gml:boundedBy>',
+            b'   <gml:Envelope srsName="EPSG:4326">',
+            b'    <gml:lowerCorner>0 0</gml:lowerCorner>',
+            b'    <gml:upperCorner>10 5</gml:upperCorner>',
+            b'   </gml:Envelope>',
+            b'  </gml:boundedBy>',
+            b'  <qgs:geometry>',
+            b'   <LineString xmlns="http://www.opengis.net/gml" srsName="EPSG:4326">',
+            b'    <posList xmlns="http://www.opengis.net/gml" srsDimension="2">0 0 10 5</posList>',
+            b'   </LineString>',
+            b'  </qgs:geometry>',
+            b'  <qgs:label>x/y</qgs:label>',
+            b' </qgs:lines>',
+            b'</gml:featureMember>',
+            b'</wfs:FeatureCollection>',
+            b''
+        ])
+        self.assertEqual(body[body.index(b'<gml:featureMember>'):], expected)
+
+        # Properties are sorted by name, as by QgsJsonExporter
+        header, body = self._execute_request_project(qs + 'GeoJSON', project)
+        self.assertIn(b'Content-Type: application/vnd.geo+json; charset=utf-8', header)
+        expected = b'\n'.join([
+            b'  {"geometry":{"coordinates":[1.0,2.0],"type":"Point"},"id":"points.1",'
+            b'"properties":{"id":1,"name":"a < b & c","note":"He said \\"hi\\" > bye","value":1.5},"type":"Feature"}',
+            b' ,{"geometry":null,"id":"points.2",'
+            b'"properties":{"id":2,"name":"line\\r\\nbreak\\ttab","note":null,"value":null},"type":"Feature"}',
+            b' ,{"bbox":[0.0,0.0,10.0,5.0],"geometry":{"coordinates":[[0.0,0.0],[10.0,5.0]],"type":"LineString"},"id":"lines.1",'
+            b'"properties":{"label":"x/y"},"type":"Feature"}',
+            b' ]',
+            b'}'
+        ])
+        features = b'"features": [\n'
+        self.assertEqual(body[body.index(features) + len(features):], expected)
+
     def test_wfs_getcapabilities_100_url(self):
         """Check that URL in GetCapabilities response is complete"""
         # empty url in project
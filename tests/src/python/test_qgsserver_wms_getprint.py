@@ -20,12 +20,14 @@ import os
 os.environ['QT_HASH_SEED'] = '1'
 
 import re
+import json
+import time
 import urllib.request
 import urllib.parse
 import urllib.error
 
 from qgis.testing import unittest
-from qgis.PyQt.QtCore import QSize
+from qgis.PyQt.QtCore import QDir, QSize
 from qgis.PyQt.QtGui import QImage, QPainter
 from qgis.PyQt.QtSvg import QSvgRenderer, QSvgGenerator
 
@@ -252,6 +254,94 @@ class TestQgsServerWMSGetPrint(QgsServerTestBase):
         r, h = self._result(self._execute_request(qs))
         self._pdf_diff_error(r, h, "WMS_GetPrint_Basic_Pdf", dpi=300)
 
+    def test_wms_getprint_async(self):
+        qs = "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "VERSION": "1.1.1",
+            "REQUEST": "GetPrint",
+            "TEMPLATE": "layoutA4",
+            "FORMAT": "png",
+            "ASYNC": "true",
+            "map0:EXTENT": "-33626185.498,-13032965.185,33978427.737,16020257.031",
+            "LAYERS": "Country,Hello",
+            "CRS": "EPSG:3857"
+        }.items())])
+
+        r, h = self._result(self._execute_request(qs))
+        self.assertEqual(h['Content-Type'], 'application/json')
+        job = json.loads(r.decode('utf-8'))
+        self.assertEqual(job['status'], 'queued')
+        self.assertIn('REQUEST=GetPrintJob', job['href'])
+
+        qs = "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "REQUEST": "GetPrintJob",
+            "JOB": job['job']
+        }.items())])
+
+        # Poll the job until the print is available
+        for i in range(600):
+            r, h = self._result(self._execute_request(qs))
+            if h['Content-Type'] != 'application/json':
+                break
+            self.assertIn(json.loads(r.decode('utf-8'))['status'], ('queued', 'running'))
+            time.sleep(0.1)
+        self._img_diff_error(r, h, "WMS_GetPrint_Basic")
+
+        # Unknown jobs are reported
+        qs = "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectPath),
+            "SERVICE": "WMS",
+            "REQUEST": "GetPrintJob",
+            "JOB": "00000000-0000-0000-0000-000000000000"
+        }.items())])
+        r, h = self._result(self._execute_request(qs))
+        self.assertIn(b'InvalidParameterValue', r)
+
+    def test_wms_getprint_async_expired_jobs(self):
+        # Jobs of other processes, not updated for two hours
+        directory = os.path.join(QDir.tempPath(), 'qgis_server_print_jobs')
+        os.makedirs(directory, exist_ok=True)
+        running = os.path.join(directory, '11111111-1111-1111-1111-111111111111.state')
+        finished = os.path.join(directory, '22222222-2222-2222-2222-222222222222.state')
+        finished_output = os.path.join(directory, '22222222-2222-2222-2222-222222222222.output')
+        with open(running, 'w') as f:
+            f.write('2\n200\n\n')
+        with open(finished, 'w') as f:
+            f.write('3\n200\nimage/png\n')
+        with open(finished_output, 'wb') as f:
+            f.write(b'output')
+        old = time.time() - 7200
+        for path in (running, finished, finished_output):
+            os.utime(path, (old, old))
+
+        try:
+            qs = "?" + "&".join(["%s=%s" % i for i in list({
+                "MAP": urllib.parse.quote(self.projectPath),
+                "SERVICE": "WMS",
+                "VERSION": "1.1.1",
+                "REQUEST": "GetPrint",
+                "TEMPLATE": "layoutA4",
+                "FORMAT": "png",
+                "ASYNC": "true",
+                "map0:EXTENT": "-33626185.498,-13032965.185,33978427.737,16020257.031",
+                "LAYERS": "Country,Hello",
+                "CRS": "EPSG:3857"
+            }.items())])
+            r, h = self._result(self._execute_request(qs))
+            self.assertEqual(h['Content-Type'], 'application/json')
+
+            # The running job is still rendered by its process
+            self.assertTrue(os.path.exists(running))
+            self.assertFalse(os.path.exists(finished))
+            self.assertFalse(os.path.exists(finished_output))
+        finally:
+            for path in (running, finished, finished_output):
+                if os.path.exists(path):
+                    os.remove(path)
+
     def test_wms_getprint_style(self):
         # default style
         qs = "?" + "&".join(["%s=%s" % i for i in list({
@@ -20,6 +20,9 @@ import os
 os.environ['QT_HASH_SEED'] = '1'
 
 import re
+import shutil
+import tempfile
+import time
 import urllib.request
 import urllib.parse
 import urllib.error
@@ -28,11 +31,12 @@ from qgis.server import QgsServerRequest
 
 from qgis.testing import unittest
 from qgis.PyQt.QtCore import QSize
+from qgis.PyQt.QtGui import QImage
 
 import osgeo.gdal  # NOQA
 
 from test_qgsserver import QgsServerTestBase
-from qgis.core import QgsProject
+from qgis.core import QgsMapLayer, QgsProject
 
 # Strip path and content length because path may vary
 RE_STRIP_UNCHECKABLE = b'MAP=[^"]+|Content-Length: \d+|timeStamp="[^"]+"'
@@ -221,6 +225,192 @@ class TestQgsServerWMTS(QgsServerTestBase):
         r, h = self._result(self._execute_request(qs))
         self._img_diff_error(r, h, "WMTS_GetTile_Hello_4326_0", 20000)
 
+    def _gettile_query(self, matrix, row, col):
+        return "?" + "&".join(["%s=%s" % i for i in list({
+            "MAP": urllib.parse.quote(self.projectGroupsPath),
+            "SERVICE": "WMTS",
+            "VERSION": "1.0.0",
+            "REQUEST": "GetTile",
+            "LAYER": "QGIS Server Hello World",
+            "STYLE": "",
+            "TILEMATRIXSET": "EPSG:3857",
+            "TILEMATRIX": str(matrix),
+            "TILEROW": str(row),
+            "TILECOL": str(col),
+            "FORMAT": "image/png"
+        }.items())])
+
+    def _cached_tiles(self, directory):
+        tiles = []
+        for root, dirs, files in os.walk(directory):
+            for name in files:
+                if name.endswith('.tile'):
+                    with open(os.path.join(root, name), 'rb') as f:
+                        tiles.append(f.read())
+        return tiles
+
+    def test_wmts_gettile_metatile(self):
+        # Tile matrix 1 has 2 x 2 tiles, all sliced from a single metatile
+        # and stored in the tile cache once the first one is requested
+        cache_dir = tempfile.mkdtemp()
+        self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '2')
+        self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', cache_dir)
+        try:
+            r, h = self._result(self._execute_request(self._gettile_query(1, 0, 0)))
+            self.assertEqual(h['Content-Type'], 'image/png')
+            self.assertEqual(QImage.fromData(r).size(), QSize(256, 256))
+
+            tiles = self._cached_tiles(cache_dir)
+            self.assertEqual(len(tiles), 4)
+            self.assertIn(r, tiles)
+
+            # The other tiles are served from the cache
+            for row, col in ((0, 1), (1, 0), (1, 1)):
+                cached, h = self._result(self._execute_request(self._gettile_query(1, row, col)))
+                self.assertEqual(h['Content-Type'], 'image/png')
+                self.assertIn(cached, tiles)
+                tiles.remove(cached)
+            self.assertEqual(len(self._cached_tiles(cache_dir)), 4)
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '1')
+            self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', '')
+            shutil.rmtree(cache_dir, True)
+
+    def test_wmts_gettile_metatile_max_size(self):
+        # Metatiles are reduced to the maximum WMS image size
+        cache_dir = tempfile.mkdtemp()
+        self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '2')
+        self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', cache_dir)
+        self.server.putenv('QGIS_SERVER_WMS_MAX_WIDTH', '300')
+        self.server.putenv('QGIS_SERVER_WMS_MAX_HEIGHT', '300')
+        try:
+            r, h = self._result(self._execute_request(self._gettile_query(1, 1, 1)))
+            self.assertEqual(h['Content-Type'], 'image/png')
+            self.assertEqual(QImage.fromData(r).size(), QSize(256, 256))
+            self.assertEqual(self._cached_tiles(cache_dir), [r])
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '1')
+            self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', '')
+            self.server.putenv('QGIS_SERVER_WMS_MAX_WIDTH', '-1')
+            self.server.putenv('QGIS_SERVER_WMS_MAX_HEIGHT', '-1')
+            shutil.rmtree(cache_dir, True)
+
+    def test_wmts_gettile_metatile_no_cache(self):
+        # Without a tile cache, only the requested tile is rendered
+        self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '2')
+        try:
+            r, h = self._result(self._execute_request(self._gettile_query(1, 0, 0)))
+            self.assertEqual(h['Content-Type'], 'image/png')
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_METATILE_SIZE', '1')
+
+        r2, h = self._result(self._execute_request(self._gettile_query(1, 0, 0)))
+        self.assertEqual(r2, r)
+
+    def test_wmts_gettile_cache_prune(self):
+        # The oldest tiles are removed when the directory is too large
+        cache_dir = tempfile.mkdtemp()
+        self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', cache_dir)
+        self.server.putenv('QGIS_SERVER_WMTS_CACHE_DISK_SIZE', '1')
+        try:
+            r, h = self._result(self._execute_request(self._gettile_query(1, 0, 0)))
+            self.assertEqual(h['Content-Type'], 'image/png')
+            self.assertEqual(self._cached_tiles(cache_dir), [])
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', '')
+            self.server.putenv('QGIS_SERVER_WMTS_CACHE_DISK_SIZE', str(500 * 1024 * 1024))
+            shutil.rmtree(cache_dir, True)
+
+        # Expired tiles are rendered again
+        cache_dir = tempfile.mkdtemp()
+        self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', cache_dir)
+        self.server.putenv('QGIS_SERVER_WMTS_CACHE_MAX_AGE', '3600')
+        try:
+            r, h = self._result(self._execute_request(self._gettile_query(1, 0, 0)))
+            tiles = []
+            for root, dirs, files in os.walk(cache_dir):
+                tiles += [os.path.join(root, name) for name in files if name.endswith('.tile')]
+            self.assertEqual(len(tiles), 1)
+
+            # Replace the cached tile with an outdated one
+            with open(tiles[0], 'wb') as f:
+                f.write(b'outdated')
+            old = time.time() - 7200
+            os.utime(tiles[0], (old, old))
+            r2, h = self._result(self._execute_request(self._gettile_query(1, 0, 0)))
+            self.assertEqual(r2, r)
+        finally:
+            self.server.putenv('QGIS_SERVER_WMTS_CACHE_DIRECTORY', '')
+            self.server.putenv('QGIS_SERVER_WMTS_CACHE_MAX_AGE', '0')
+            shutil.rmtree(cache_dir, True)
+
+    def test_wmts_gettile_mvt(self):
+        project = QgsProject()
+        project.read(self.projectGroupsPath)
+
+        qs = "https://www.qgis.org/?" + "&".join(["%s=%s" % i for i in list({
+            "SERVICE": "WMTS",
+            "VERSION": "1.0.0",
+            "REQUEST": "GetTile",
+            "LAYER": "QGIS Server Hello World",
+            "STYLE": "",
+            "TILEMATRIXSET": "EPSG:3857",
+            "TILEMATRIX": "0",
+            "TILEROW": "0",
+            "TILECOL": "0",
+            "FORMAT": "application/vnd.mapbox-vector-tile"
+        }.items())])
+
+        # Vector tiles are not published by default
+        r, h = self._result(self._execute_request_project(qs, project))
+        self.assertEqual(h['Content-Type'], 'application/vnd.mapbox-vector-tile')
+        self.assertEqual(r, b'')
+
+        self.assertTrue(project.writeEntry('WMTSMvtLayers', 'Project', True))
+        r, h = self._result(self._execute_request_project(qs, project))
+        self.assertEqual(h['Content-Type'], 'application/vnd.mapbox-vector-tile')
+        # Tile message with its layers
+        self.assertTrue(len(r) > 0)
+        self.assertEqual(r[0:1], b'\x1a')
+
+    def test_wmts_gettile_mvt_excluded_attributes(self):
+        project = QgsProject()
+        project.read(self.projectGroupsPath)
+        self.assertTrue(project.writeEntry('WMTSMvtLayers', 'Project', True))
+
+        # Primary keys are fetched by the providers even when they are not requested
+        excluded = set()
+        for layer in project.mapLayers().values():
+            if layer.type() != QgsMapLayer.VectorLayer:
+                continue
+            pk_names = set(layer.fields().at(i).name() for i in layer.dataProvider().pkAttributeIndexes())
+            layer.setExcludeAttributesWms(pk_names)
+            excluded |= pk_names
+        self.assertTrue(excluded)
+
+        qs = "https://www.qgis.org/?" + "&".join(["%s=%s" % i for i in list({
+            "SERVICE": "WMTS",
+            "VERSION": "1.0.0",
+            "REQUEST": "GetTile",
+            "LAYER": "QGIS Server Hello World",
+            "STYLE": "",
+            "TILEMATRIXSET": "EPSG:3857",
+            "TILEMATRIX": "0",
+            "TILEROW": "0",
+            "TILECOL": "0",
+            "FORMAT": "application/vnd.mapbox-vector-tile"
+        }.items())])
+        r, h = self._result(self._execute_request_project(qs, project))
+        self.assertEqual(h['Content-Type'], 'application/vnd.mapbox-vector-tile')
+
+        # Keys of the tile layers are strings of field 3
+        def key(name):
+            return b'\x1a' + bytes([len(name)]) + name.encode('utf-8')
+
+        self.assertIn(key('name'), r)
+        for name in excluded:
+            self.assertNotIn(key(name), r)
+
     def test_wmts_gettile_invalid_parameters(self):
         qs = "?" + "&".join(["%s=%s" % i for i in list({
             "MAP": urllib.parse.quote(self.projectGroupsPath),
@@ -0,0 +1,305 @@
+/***************************************************************************
+     testqgsconfigcache.cpp
+     --------------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QRegularExpression>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+
+#include <vector>
+
+//qgis includes...
+#include "qgsconfigcache.h"
+#include "qgsproject.h"
+#include "qgsserver.h"
+
+/**
+ * \ingroup UnitTests
+ * Unit tests for the server config cache, used by the threads serving requests
+ */
+class TestQgsConfigCache : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // The threads share the cache, a copy of a project is used by a single thread at a time
+    void testSharedBetweenThreads();
+
+    // A locked project does not block the other requests, for the same project or not
+    void testProjectLock();
+
+    // A changed project is served until the new one is read
+    void testReloadKeepsProject();
+
+    // Projects are read when the server is initialized
+    void testPrewarm();
+
+  private:
+    //! Copies a project and its layer to \a directory, returns the path of the project
+    QString copyProject( const QTemporaryDir &directory ) const;
+
+    //! Replaces the title and the layer data source of the project of \a path
+    void changeProject( const QString &path, const QString &title, const QString &dataSource ) const;
+
+    //! Waits for the project reloads and hands them over to the cache
+    void waitForReloads() const;
+};
+
+namespace
+{
+  //! Threads using the projects, to check that a project is used by a single thread at a time
+  struct ProjectUsers
+  {
+    QMutex mutex;
+    QHash<const QgsProject *, int> users;
+    bool shared = false;
+  };
+
+  //! Locks a project a few times, recording the projects used
+  class LockingThread : public QThread
+  {
+    public:
+      LockingThread( const QString &path, ProjectUsers &users )
+        : mPath( path )
+        , mUsers( users )
+      {}
+
+      QgsConfigCache *cache = nullptr;
+      QList<const QgsProject *> projects;
+
+    protected:
+      void run() override
+      {
+        cache = QgsConfigCache::instance();
+        for ( int i = 0; i < 5; ++i )
+        {
+          std::unique_ptr<QgsConfigCache::ProjectLock> lock = cache->lockProject( mPath );
+          if ( !lock )
+            continue;
+          projects << lock->project();
+
+          {
+            QMutexLocker locker( &mUsers.mutex );
+            if ( ++mUsers.users[ lock->project() ] > 1 )
+              mUsers.shared = true;
+          }
+          msleep( 20 );
+          {
+            QMutexLocker locker( &mUsers.mutex );
+            --mUsers.users[ lock->project() ];
+          }
+        }
+      }
+
+    private:
+      QString mPath;
+      ProjectUsers &mUsers;
+  };
+}
+
+void TestQgsConfigCache::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsConfigCache::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsConfigCache::testSharedBetweenThreads()
+{
+  const QString path = QStringLiteral( "%1/qgis_server/test_project.qgs" ).arg( TEST_DATA_DIR );
+  QgsConfigCache::instance()->removeEntry( path );
+
+  ProjectUsers users;
+  std::vector< std::unique_ptr< LockingThread > > threads;
+  for ( int i = 0; i < 4; ++i )
+  {
+    threads.emplace_back( new LockingThread( path, users ) );
+    threads.back()->start();
+  }
+  for ( const auto &thread : threads )
+    QVERIFY( thread->wait( 60000 ) );
+
+  const QgsProject *project = QgsConfigCache::instance()->project( path );
+  QVERIFY( project );
+  QSet<const QgsProject *> projects;
+  for ( const auto &thread : threads )
+  {
+    QCOMPARE( thread->cache, QgsConfigCache::instance() );
+    QCOMPARE( thread->projects.count(), 5 );
+    for ( const QgsProject *threadProject : qgis::as_const( thread->projects ) )
+    {
+      QCOMPARE( threadProject->fileName(), path );
+      projects << threadProject;
+    }
+  }
+  // the copies are kept for the next requests, at most one per thread
+  QVERIFY( projects.contains( project ) );
+  QVERIFY( projects.count() <= 4 );
+  // a copy is not shared by concurrent requests
+  QVERIFY( !users.shared );
+
+  QgsConfigCache::instance()->removeEntry( path );
+}
+
+void TestQgsConfigCache::testProjectLock()
+{
+  const QString path1 = QStringLiteral( "%1/qgis_server/test_project.qgs" ).arg( TEST_DATA_DIR );
+  const QString path2 = QStringLiteral( "%1/qgis_server/test_project_wfs.qgs" ).arg( TEST_DATA_DIR );
+
+  std::unique_ptr<QgsConfigCache::ProjectLock> lock1 = QgsConfigCache::instance()->lockProject( path1 );
+  QVERIFY( lock1 );
+
+  // another project is available while the first one is locked
+  ProjectUsers users;
+  LockingThread other( path2, users );
+  other.start();
+  QVERIFY( other.wait( 60000 ) );
+  QCOMPARE( other.projects.count(), 5 );
+  QVERIFY( other.projects.first() != lock1->project() );
+
+  // the same project is served from another copy while it is locked
+  LockingThread same( path1, users );
+  same.start();
+  QVERIFY( same.wait( 60000 ) );
+  QCOMPARE( same.projects.count(), 5 );
+  for ( const QgsProject *project : qgis::as_const( same.projects ) )
+  {
+    QVERIFY( project != lock1->project() );
+    QCOMPARE( project->fileName(), path1 );
+  }
+
+  // the locked project is still served when removed from the cache meanwhile
+  const QgsProject *project = lock1->project();
+  QgsConfigCache::instance()->removeEntry( path1 );
+  QCOMPARE( lock1->project(), project );
+  QVERIFY( !project->fileName().isEmpty() );
+
+  lock1.reset();
+
+  QgsConfigCache::instance()->removeEntry( path1 );
+  QgsConfigCache::instance()->removeEntry( path2 );
+}
+
+QString TestQgsConfigCache::copyProject( const QTemporaryDir &directory ) const
+{
+  const QString dataDir = QStringLiteral( "%1/qgis_server/" ).arg( TEST_DATA_DIR );
+  const QStringList files = QStringList() << QStringLiteral( "test_project_wfs.qgs" ) << QStringLiteral( "testlayer.shp" )
+                            << QStringLiteral( "testlayer.shx" ) << QStringLiteral( "testlayer.dbf" ) << QStringLiteral( "testlayer.prj" );
+  for ( const QString &file : files )
+  {
+    if ( !QFile::copy( dataDir + file, directory.filePath( file ) ) )
+      return QString();
+  }
+  return directory.filePath( QStringLiteral( "test_project_wfs.qgs" ) );
+}
+
+void TestQgsConfigCache::changeProject( const QString &path, const QString &title, const QString &dataSource ) const
+{
+  QFile file( path );
+  QVERIFY( file.open( QIODevice::ReadOnly ) );
+  QString content = QString::fromUtf8( file.readAll() );
+  file.close();
+
+  // the project title comes first, then the one of the layer
+  const QRegularExpressionMatch match = QRegularExpression( QStringLiteral( "<title>[^<]*</title>" ) ).match( content );
+  QVERIFY( match.hasMatch() );
+  content.replace( match.capturedStart(), match.capturedLength(), QStringLiteral( "<title>%1</title>" ).arg( title ) );
+  content.replace( QRegularExpression( QStringLiteral( "<datasource>[^<]*</datasource>" ) ), QStringLiteral( "<datasource>%1</datasource>" ).arg( dataSource ) );
+  QVERIFY( file.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+  QVERIFY( file.write( content.toUtf8() ) > 0 );
+}
+
+void TestQgsConfigCache::waitForReloads() const
+{
+  // the file system watcher may start another reload meanwhile
+  for ( int i = 0; i < 3; ++i )
+  {
+    QThreadPool::globalInstance()->waitForDone();
+    QCoreApplication::processEvents();
+  }
+}
+
+void TestQgsConfigCache::testReloadKeepsProject()
+{
+  QTemporaryDir directory;
+  QVERIFY( directory.isValid() );
+  const QString path = copyProject( directory );
+  QVERIFY( !path.isEmpty() );
+
+  QgsConfigCache *cache = QgsConfigCache::instance();
+  const QgsProject *project = cache->project( path );
+  QVERIFY( project );
+  QCOMPARE( project->title(), QStringLiteral( "QGIS Test Project" ) );
+
+  // Changes are notified by the file system watcher, which is not waited for
+  changeProject( path, QStringLiteral( "Changed Project" ), QStringLiteral( "./testlayer.shp" ) );
+  QVERIFY( QMetaObject::invokeMethod( cache, "reloadChangedEntry", Qt::DirectConnection, Q_ARG( QString, path ) ) );
+
+  // the cached project is served while the new one is read, and until
+  // the reloaded project is handed over to the cache
+  QCOMPARE( cache->project( path ), project );
+  QThreadPool::globalInstance()->waitForDone();
+  QCOMPARE( cache->project( path ), project );
+  QCOMPARE( project->title(), QStringLiteral( "QGIS Test Project" ) );
+
+  waitForReloads();
+  const QgsProject *reloaded = cache->project( path );
+  QVERIFY( reloaded );
+  QCOMPARE( reloaded->title(), QStringLiteral( "Changed Project" ) );
+
+  // a project with invalid layers does not replace the cached one
+  changeProject( path, QStringLiteral( "Invalid Project" ), QStringLiteral( "./missing.shp" ) );
+  QVERIFY( QMetaObject::invokeMethod( cache, "reloadChangedEntry", Qt::DirectConnection, Q_ARG( QString, path ) ) );
+  waitForReloads();
+  QVERIFY( cache->project( path ) );
+  QCOMPARE( cache->project( path )->title(), QStringLiteral( "Changed Project" ) );
+
+  cache->removeEntry( path );
+}
+
+void TestQgsConfigCache::testPrewarm()
+{
+  QTemporaryDir directory;
+  QVERIFY( directory.isValid() );
+  const QString path = copyProject( directory );
+  QVERIFY( !path.isEmpty() );
+
+  qputenv( "QGIS_SERVER_PROJECT_PREWARM", path.toLocal8Bit() );
+  QgsServer server;
+
+  // The project is in the cache before any request, it is still served
+  // once its file is removed
+  QVERIFY( QFile::remove( path ) );
+  const QgsProject *project = QgsConfigCache::instance()->project( path );
+  QVERIFY( project );
+  QCOMPARE( project->title(), QStringLiteral( "QGIS Test Project" ) );
+
+  server.putenv( QStringLiteral( "QGIS_SERVER_PROJECT_PREWARM" ), QString() );
+  QgsConfigCache::instance()->removeEntry( path );
+}
+
+QGSTEST_MAIN( TestQgsConfigCache )
+#include "testqgsconfigcache.moc"
@@ -0,0 +1,257 @@
+/***************************************************************************
+     test_qgsserver_wms_mediancut.cpp
+     --------------------------------
+    Date                 : October 2026
+    Copyright            : (C) 2026 by the QGIS Development Team
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgstest.h"
+#include "qgsmediancut.h"
+#include "qgswmsutils.h"
+#include "qgsbufferserverresponse.h"
+
+#include <QSet>
+
+/**
+ * \ingroup UnitTests
+ * This is a unit test for the median cut color reduction of 8 bit PNG images
+ */
+class TestQgsServerWmsMedianCut : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void palette_weighted_colors();
+    void palette_small_image();
+    void palette_reduced_small_image();
+    void palette_large_image();
+    void palette_shared_by_tiles();
+
+  private:
+    //! Returns an image with a gradient of \a width x \a height colors and flat areas
+    QImage testImage( int width, int height ) const;
+
+    //! Compares the indexed image with the one of QImage using the same palette
+    void compareIndexedImage( const QImage &image, const QVector<QRgb> &colorTable );
+
+    //! Writes \a image as an 8 bit PNG with the \a paletteKey and returns the color table of the PNG
+    QVector<QRgb> writtenColorTable( QImage image, const QString &paletteKey );
+};
+
+void TestQgsServerWmsMedianCut::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsServerWmsMedianCut::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QImage TestQgsServerWmsMedianCut::testImage( int width, int height ) const
+{
+  QImage image( width, height, QImage::Format_ARGB32 );
+  for ( int y = 0; y < height; ++y )
+  {
+    for ( int x = 0; x < width; ++x )
+    {
+      QRgb color;
+      if ( x < width / 4 )
+        color = qRgba( 255, 255, 255, 255 );
+      else if ( y < height / 4 )
+        color = qRgba( 0, 0, 0, 0 );
+      else
+        color = qRgba( x * 255 / width, y * 255 / height, ( x + y ) % 64, 200 + ( x % 56 ) );
+      image.setPixel( x, y, color );
+    }
+  }
+  return image;
+}
+
+void TestQgsServerWmsMedianCut::compareIndexedImage( const QImage &image, const QVector<QRgb> &colorTable )
+{
+  const QImage indexed = QgsWms::indexedImage( image, colorTable );
+  const QImage expected = image.convertToFormat( QImage::Format_Indexed8, colorTable, Qt::ThresholdDither );
+
+  QCOMPARE( indexed.format(), QImage::Format_Indexed8 );
+  QCOMPARE( indexed.size(), image.size() );
+  QCOMPARE( indexed.colorTable(), colorTable );
+
+  int differences = 0;
+  for ( int y = 0; y < image.height(); ++y )
+  {
+    for ( int x = 0; x < image.width(); ++x )
+    {
+      if ( indexed.pixelIndex( x, y ) != expected.pixelIndex( x, y ) )
+        differences++;
+    }
+  }
+  QCOMPARE( differences, 0 );
+}
+
+QVector<QRgb> TestQgsServerWmsMedianCut::writtenColorTable( QImage image, const QString &paletteKey )
+{
+  QgsBufferServerResponse response;
+  QgsWms::writeImage( response, image, QStringLiteral( "image/png; mode=8bit" ), -1, paletteKey );
+  response.finish();
+
+  const QImage written = QImage::fromData( response.body(), "PNG" );
+  if ( written.format() != QImage::Format_Indexed8 )
+    return QVector<QRgb>();
+  return written.colorTable();
+}
+
+void TestQgsServerWmsMedianCut::palette_weighted_colors()
+{
+  // 12 red and 4 blue pixels
+  QImage image( 4, 4, QImage::Format_ARGB32 );
+  image.fill( qRgba( 255, 0, 0, 255 ) );
+  for ( int x = 0; x < 4; ++x )
+    image.setPixel( x, 3, qRgba( 0, 0, 255, 255 ) );
+
+  // a single color, the mean of the pixels
+  QVector<QRgb> colorTable;
+  QgsWms::medianCut( colorTable, 1, image );
+  QCOMPARE( colorTable.size(), 1 );
+  QCOMPARE( colorTable.at( 0 ), qRgba( 191, 0, 63, 255 ) );
+
+  // 8 red, 4 green and 4 blue pixels, green and blue end in the same box
+  for ( int x = 0; x < 4; ++x )
+    image.setPixel( x, 2, qRgba( 0, 255, 0, 255 ) );
+  QgsWms::medianCut( colorTable, 2, image );
+  QCOMPARE( colorTable.size(), 2 );
+  QCOMPARE( colorTable.toList().toSet(), QSet<QRgb>() << qRgba( 255, 0, 0, 255 ) << qRgba( 0, 127, 127, 255 ) );
+
+  compareIndexedImage( image, colorTable );
+}
+
+void TestQgsServerWmsMedianCut::palette_small_image()
+{
+  // fewer colors than the palette, all of them are kept
+  QImage image( 32, 32, QImage::Format_ARGB32 );
+  QSet<QRgb> colors;
+  for ( int y = 0; y < 32; ++y )
+  {
+    for ( int x = 0; x < 32; ++x )
+    {
+      const QRgb color = qRgba( ( x / 2 ) * 16, ( y / 2 ) * 16, 128, x < 16 ? 255 : 128 );
+      image.setPixel( x, y, color );
+      colors << color;
+    }
+  }
+  QCOMPARE( colors.size(), 256 );
+
+  QVector<QRgb> colorTable;
+  QgsWms::medianCut( colorTable, 256, image );
+  QCOMPARE( colorTable.size(), 256 );
+  QCOMPARE( colorTable.toList().toSet(), colors );
+
+  // the indexed image has the colors of the input image
+  const QImage indexed = QgsWms::indexedImage( image, colorTable );
+  for ( int y = 0; y < 32; ++y )
+  {
+    for ( int x = 0; x < 32; ++x )
+      QCOMPARE( indexed.pixel( x, y ), image.pixel( x, y ) );
+  }
+  compareIndexedImage( image, colorTable );
+}
+
+void TestQgsServerWmsMedianCut::palette_reduced_small_image()
+{
+  // 65536 pixels, the histogram is built from all of them
+  const QImage image = testImage( 256, 256 );
+
+  QVector<QRgb> colorTable;
+  QgsWms::medianCut( colorTable, 256, image );
+  QCOMPARE( colorTable.size(), 256 );
+
+  // flat areas keep their exact color
+  QVERIFY( colorTable.contains( qRgba( 255, 255, 255, 255 ) ) );
+  QVERIFY( colorTable.contains( qRgba( 0, 0, 0, 0 ) ) );
+
+  // the palette fits the image it is computed from
+  QVERIFY( QgsWms::colorTableFits( colorTable, image, 32, 255 ) );
+  compareIndexedImage( image, colorTable );
+}
+
+void TestQgsServerWmsMedianCut::palette_large_image()
+{
+  // 262144 pixels, the histogram is built from every other row and column
+  const QImage image = testImage( 512, 512 );
+
+  QImage sampled( 256, 256, QImage::Format_ARGB32 );
+  for ( int y = 0; y < 256; ++y )
+  {
+    for ( int x = 0; x < 256; ++x )
+      sampled.setPixel( x, y, image.pixel( 2 * x, 2 * y ) );
+  }
+
+  QVector<QRgb> colorTable;
+  QgsWms::medianCut( colorTable, 256, image );
+  QVector<QRgb> sampledColorTable;
+  QgsWms::medianCut( sampledColorTable, 256, sampled );
+
+  // same palette as the one of the sampled pixels
+  QCOMPARE( colorTable.size(), 256 );
+  QCOMPARE( colorTable, sampledColorTable );
+  QVERIFY( colorTable.contains( qRgba( 255, 255, 255, 255 ) ) );
+  QVERIFY( colorTable.contains( qRgba( 0, 0, 0, 0 ) ) );
+
+  compareIndexedImage( image, colorTable );
+}
+
+void TestQgsServerWmsMedianCut::palette_shared_by_tiles()
+{
+  // 256 colors, the palette has all of them
+  QImage tile1( 32, 32, QImage::Format_ARGB32 );
+  for ( int y = 0; y < 32; ++y )
+  {
+    for ( int x = 0; x < 32; ++x )
+      tile1.setPixel( x, y, qRgba( ( x / 2 ) * 16, ( y / 2 ) * 16, 128, x < 16 ? 255 : 128 ) );
+  }
+
+  // the next tile of the same layers has a few new colors close to the ones of the palette
+  QImage tile2 = tile1.copy();
+  for ( int x = 0; x < 4; ++x )
+    tile2.setPixel( x, 0, qRgba( 2, 0, 130, 255 ) );
+
+  // a tile with colors far from the palette
+  QImage tile3( 32, 32, QImage::Format_ARGB32 );
+  tile3.fill( qRgba( 255, 0, 0, 255 ) );
+
+  const QString paletteKey = QStringLiteral( "project.qgs|points,lines|default,default" );
+  const QVector<QRgb> colorTable1 = writtenColorTable( tile1, paletteKey );
+  QCOMPARE( colorTable1.size(), 256 );
+
+  // the palette of the first tile is reused for the second one
+  QCOMPARE( writtenColorTable( tile2, paletteKey ), colorTable1 );
+
+  // without a key, a palette is computed for the second tile
+  const QVector<QRgb> colorTable2 = writtenColorTable( tile2, QString() );
+  QVERIFY( colorTable2 != colorTable1 );
+
+  // same with another key
+  QCOMPARE( writtenColorTable( tile2, QStringLiteral( "project.qgs|points|default" ) ), colorTable2 );
+
+  // the cached palette does not fit the colors of the third tile, a new one is computed
+  const QVector<QRgb> colorTable3 = writtenColorTable( tile3, paletteKey );
+  QVERIFY( colorTable3 != colorTable1 );
+  QVERIFY( colorTable3.contains( qRgba( 255, 0, 0, 255 ) ) );
+
+  // and cached for the next tiles
+  QCOMPARE( writtenColorTable( tile3, paletteKey ), colorTable3 );
+}
+
+QGSTEST_MAIN( TestQgsServerWmsMedianCut )
+#include "test_qgsserver_wms_mediancut.moc"